@@ -0,0 +1,274 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_adpcm_encoder.h"
+
+static const char *TAG = "ADPCM_ENCODER";
+
+static const int16_t ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+static const int8_t ima_index_table[8] = {
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+typedef struct {
+    int32_t predictor;
+    int index;
+} ima_state_t;
+
+typedef struct audio_adpcm_encoder {
+    int channels;
+    int block_align;
+    int block_samples; // per channel, the first one is stored in the block header
+    int16_t *pcm;      // one block of interleaved input
+    int fill;          // bytes of pcm collected so far
+    ima_state_t state[2];
+} audio_adpcm_encoder_t;
+
+int audio_adpcm_block_align(int sample_rate, int channels)
+{
+    int align = sample_rate <= 11025 ? 256 : (sample_rate <= 22050 ? 512 : 1024);
+    return align * channels;
+}
+
+int audio_adpcm_block_frames(int block_align, int channels)
+{
+    return (block_align - 4 * channels) * 2 / channels + 1;
+}
+
+static inline void _put_le16(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void _put_le32(uint8_t *p, uint32_t v)
+{
+    _put_le16(p, v);
+    _put_le16(p + 2, v >> 16);
+}
+
+void audio_adpcm_wav_header(uint8_t *hdr, int sample_rate, int channels, uint32_t data_size)
+{
+    int block_align = audio_adpcm_block_align(sample_rate, channels);
+    int block_samples = audio_adpcm_block_frames(block_align, channels);
+    uint32_t blocks = data_size / block_align;
+
+    memcpy(hdr, "RIFF", 4);
+    _put_le32(hdr + 4, AUDIO_ADPCM_WAV_HEADER_SIZE - 8 + data_size);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    _put_le32(hdr + 16, 20);
+    _put_le16(hdr + 20, 0x11);
+    _put_le16(hdr + 22, channels);
+    _put_le32(hdr + 24, sample_rate);
+    _put_le32(hdr + 28, (uint32_t)((uint64_t)sample_rate * block_align / block_samples));
+    _put_le16(hdr + 32, block_align);
+    _put_le16(hdr + 34, AUDIO_ADPCM_WAV_BITS);
+    _put_le16(hdr + 36, 2);
+    _put_le16(hdr + 38, block_samples);
+    memcpy(hdr + 40, "fact", 4);
+    _put_le32(hdr + 44, 4);
+    _put_le32(hdr + 48, blocks * block_samples);
+    memcpy(hdr + 52, "data", 4);
+    _put_le32(hdr + 56, data_size);
+}
+
+static inline uint8_t _ima_encode(ima_state_t *st, int16_t sample)
+{
+    int step = ima_step_table[st->index];
+    int diff = sample - st->predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    // the decoder rebuilds the same delta from the code bits
+    int delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+    st->predictor += (code & 8) ? -delta : delta;
+    if (st->predictor > INT16_MAX) {
+        st->predictor = INT16_MAX;
+    } else if (st->predictor < INT16_MIN) {
+        st->predictor = INT16_MIN;
+    }
+    st->index += ima_index_table[code & 7];
+    if (st->index < 0) {
+        st->index = 0;
+    } else if (st->index > 88) {
+        st->index = 88;
+    }
+    return code;
+}
+
+static void _adpcm_encode_block(audio_adpcm_encoder_t *enc, uint8_t *out)
+{
+    int ch = enc->channels;
+    for (int c = 0; c < ch; c++) {
+        // each block restarts from its first sample, the step index carries over
+        ima_state_t *st = &enc->state[c];
+        st->predictor = enc->pcm[c];
+        _put_le16(out, (uint16_t)enc->pcm[c]);
+        out[2] = st->index;
+        out[3] = 0;
+        out += 4;
+    }
+    // groups of 8 samples per channel, 4 bytes each, low nibble first
+    for (int i = 1; i < enc->block_samples; i += 8) {
+        for (int c = 0; c < ch; c++) {
+            const int16_t *s = enc->pcm + i * ch + c;
+            for (int k = 0; k < 8; k += 2) {
+                uint8_t lo = _ima_encode(&enc->state[c], s[k * ch]);
+                uint8_t hi = _ima_encode(&enc->state[c], s[(k + 1) * ch]);
+                *out++ = lo | (hi << 4);
+            }
+        }
+    }
+}
+
+static esp_err_t _adpcm_open(audio_element_handle_t self)
+{
+    audio_adpcm_encoder_t *enc = (audio_adpcm_encoder_t *)audio_element_getdata(self);
+    enc->pcm = audio_calloc(enc->block_samples * enc->channels, sizeof(int16_t));
+    AUDIO_MEM_CHECK(TAG, enc->pcm, return ESP_ERR_NO_MEM);
+    enc->fill = 0;
+    memset(enc->state, 0, sizeof(enc->state));
+    return ESP_OK;
+}
+
+static int _adpcm_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_adpcm_encoder_t *enc = (audio_adpcm_encoder_t *)audio_element_getdata(self);
+    int block_bytes = enc->block_samples * enc->channels * sizeof(int16_t);
+    // collect straight into the block, in_buffer only carries the encoded output
+    int r_size = audio_element_input(self, (char *)enc->pcm + enc->fill, block_bytes - enc->fill);
+    if (r_size > 0) {
+        enc->fill += r_size;
+        if (enc->fill < block_bytes) {
+            return r_size;
+        }
+    } else if (r_size == AEL_IO_DONE && enc->fill >= enc->channels * (int)sizeof(int16_t)) {
+        // pad the last block with its final frame
+        int frame = enc->channels * sizeof(int16_t);
+        enc->fill -= enc->fill % frame;
+        for (int pos = enc->fill; pos < block_bytes; pos += frame) {
+            memcpy((char *)enc->pcm + pos, (char *)enc->pcm + enc->fill - frame, frame);
+        }
+    } else {
+        return r_size;
+    }
+    _adpcm_encode_block(enc, (uint8_t *)in_buffer);
+    enc->fill = 0;
+    int w_size = audio_element_output(self, in_buffer, enc->block_align);
+    return r_size > 0 ? w_size : r_size;
+}
+
+static esp_err_t _adpcm_close(audio_element_handle_t self)
+{
+    audio_adpcm_encoder_t *enc = (audio_adpcm_encoder_t *)audio_element_getdata(self);
+    audio_free(enc->pcm);
+    enc->pcm = NULL;
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _adpcm_destroy(audio_element_handle_t self)
+{
+    audio_adpcm_encoder_t *enc = (audio_adpcm_encoder_t *)audio_element_getdata(self);
+    audio_free(enc);
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_adpcm_encoder_init(audio_adpcm_encoder_cfg_t *config)
+{
+    if (config->channels < 1 || config->channels > 2 || config->sample_rate <= 0) {
+        ESP_LOGE(TAG, "Unsupported format %d/%d", config->sample_rate, config->channels);
+        return NULL;
+    }
+    audio_element_handle_t el;
+    audio_adpcm_encoder_t *enc = audio_calloc(1, sizeof(audio_adpcm_encoder_t));
+
+    AUDIO_MEM_CHECK(TAG, enc, return NULL);
+
+    enc->channels = config->channels;
+    enc->block_align = audio_adpcm_block_align(config->sample_rate, config->channels);
+    enc->block_samples = audio_adpcm_block_frames(enc->block_align, config->channels);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _adpcm_open;
+    cfg.close = _adpcm_close;
+    cfg.process = _adpcm_process;
+    cfg.destroy = _adpcm_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = enc->block_align;
+    cfg.tag = "adpcm";
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _adpcm_init_exit);
+    audio_element_setdata(el, enc);
+    audio_element_set_music_info(el, config->sample_rate, config->channels, AUDIO_ADPCM_WAV_BITS);
+    return el;
+_adpcm_init_exit:
+    audio_free(enc);
+    return NULL;
+}
@@ -0,0 +1,99 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_ADPCM_ENCODER_H_
+#define _AUDIO_ADPCM_ENCODER_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_ADPCM_ENCODER_TASK_STACK (2560)
+#define AUDIO_ADPCM_ENCODER_TASK_CORE (1)
+#define AUDIO_ADPCM_ENCODER_TASK_PRIO (5)
+#define AUDIO_ADPCM_ENCODER_RINGBUFFER_SIZE (4 * 1024)
+#define AUDIO_ADPCM_WAV_HEADER_SIZE (60)
+#define AUDIO_ADPCM_WAV_BITS (4)
+
+/**
+ * @brief   IMA-ADPCM encoder configuration, 16 bit PCM in
+ */
+typedef struct {
+    int sample_rate;   /*!< Input sample rate, picks the block size */
+    int channels;      /*!< Input channels, 1 or 2 */
+    int out_rb_size;   /*!< Size of output ringbuffer */
+    int task_stack;    /*!< Task stack size */
+    int task_core;     /*!< Task running in core (0 or 1) */
+    int task_prio;     /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext; /*!< Try to allocate stack in external memory */
+} audio_adpcm_encoder_cfg_t;
+
+#define AUDIO_ADPCM_ENCODER_CFG_DEFAULT()                   \
+{                                                           \
+    .sample_rate = 16000,                                   \
+    .channels = 1,                                          \
+    .out_rb_size = AUDIO_ADPCM_ENCODER_RINGBUFFER_SIZE,     \
+    .task_stack = AUDIO_ADPCM_ENCODER_TASK_STACK,           \
+    .task_core = AUDIO_ADPCM_ENCODER_TASK_CORE,             \
+    .task_prio = AUDIO_ADPCM_ENCODER_TASK_PRIO,             \
+    .stack_in_ext = false,                                  \
+}
+
+/**
+ * @brief      Bytes per encoded block for the rate and channels, as in the WAV `nBlockAlign`
+ */
+int audio_adpcm_block_align(int sample_rate, int channels);
+
+/**
+ * @brief      Frames encoded in one block, as in the WAV `wSamplesPerBlock`
+ */
+int audio_adpcm_block_frames(int block_align, int channels);
+
+/**
+ * @brief      Fill the WAV header of an IMA-ADPCM file, RIFF, `fmt ` (format 0x11), `fact`
+ *             and `data` chunks
+ *
+ * @param      hdr        Buffer of AUDIO_ADPCM_WAV_HEADER_SIZE bytes
+ * @param      data_size  Bytes of whole blocks following the header
+ */
+void audio_adpcm_wav_header(uint8_t *hdr, int sample_rate, int channels, uint32_t data_size);
+
+/**
+ * @brief      Create an Audio Element that encodes 16 bit PCM to IMA-ADPCM blocks as laid
+ *             out in WAV files, 4 bits per sample. The last block is padded with its final
+ *             sample when the stream ends.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_adpcm_encoder_init(audio_adpcm_encoder_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_arena.h"
+
+#if defined(ESP_PLATFORM) || defined(AUDIO_HOST)
+#include "freertos/FreeRTOS.h"
+static portMUX_TYPE arena_lock = portMUX_INITIALIZER_UNLOCKED;
+#define ARENA_LOCK() portENTER_CRITICAL(&arena_lock)
+#define ARENA_UNLOCK() portEXIT_CRITICAL(&arena_lock)
+#else
+#define ARENA_LOCK()
+#define ARENA_UNLOCK()
+#endif
+
+#define ARENA_MAGIC (0xA0D1A0D1)
+#define ARENA_ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+typedef struct arena_page {
+    struct arena_page *next;
+    void *free_list;
+    uint16_t used;
+    uint8_t cls;
+} arena_page_t;
+
+typedef struct arena_block {
+    size_t size;
+    union {
+        struct arena_block *next; /* free block */
+        size_t magic;             /* allocated block */
+    };
+} arena_block_t;
+
+#define PAGE_HDR_SIZE ARENA_ROUND_UP(sizeof(arena_page_t), AUDIO_ARENA_SMALL_MIN)
+#define BLOCK_HDR_SIZE sizeof(arena_block_t)
+#define BLOCK_MIN_SPLIT (BLOCK_HDR_SIZE + 32)
+
+static struct {
+    uint8_t *base;
+    size_t size;
+
+    uint8_t *slab_base;
+    int page_num;
+    int page_carved;
+    arena_page_t *free_pages;
+    arena_page_t *partial[AUDIO_ARENA_SMALL_CLASSES];
+
+    uint8_t *heap_base;
+    size_t heap_size;
+    arena_block_t *free_blocks;
+
+    size_t used;
+    size_t peak;
+    int alloc_count;
+    int fail_count;
+} arena;
+
+static int arena_class(size_t size)
+{
+    int cls = 0;
+    size_t obj = AUDIO_ARENA_SMALL_MIN;
+    while (obj < size) {
+        obj <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static void arena_account(long delta)
+{
+    arena.used += delta;
+    if (arena.used > arena.peak) {
+        arena.peak = arena.used;
+    }
+    arena.alloc_count += delta > 0 ? 1 : -1;
+}
+
+static arena_page_t *arena_page_new(int cls)
+{
+    arena_page_t *page = arena.free_pages;
+    if (page) {
+        arena.free_pages = page->next;
+    } else if (arena.page_carved < arena.page_num) {
+        page = (arena_page_t *)(arena.slab_base + arena.page_carved * AUDIO_ARENA_PAGE_SIZE);
+        arena.page_carved++;
+    } else {
+        return NULL;
+    }
+    size_t obj = AUDIO_ARENA_SMALL_MIN << cls;
+    page->next = NULL;
+    page->free_list = NULL;
+    page->used = 0;
+    page->cls = cls;
+    for (uint8_t *p = (uint8_t *)page + AUDIO_ARENA_PAGE_SIZE - obj; p >= (uint8_t *)page + PAGE_HDR_SIZE; p -= obj) {
+        *(void **)p = page->free_list;
+        page->free_list = p;
+    }
+    return page;
+}
+
+static void arena_page_unlink(arena_page_t *page)
+{
+    arena_page_t **link = &arena.partial[page->cls];
+    while (*link && *link != page) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = page->next;
+    }
+}
+
+static void *arena_small_malloc(size_t size)
+{
+    int cls = arena_class(size);
+    arena_page_t *page = arena.partial[cls];
+    if (page == NULL) {
+        page = arena_page_new(cls);
+        if (page == NULL) {
+            return NULL;
+        }
+        arena.partial[cls] = page;
+    }
+    void *obj = page->free_list;
+    page->free_list = *(void **)obj;
+    page->used++;
+    if (page->free_list == NULL) {
+        arena.partial[cls] = page->next;
+    }
+    arena_account(AUDIO_ARENA_SMALL_MIN << cls);
+    return obj;
+}
+
+static void arena_small_free(void *ptr)
+{
+    size_t offset = (uint8_t *)ptr - arena.slab_base;
+    arena_page_t *page = (arena_page_t *)(arena.slab_base + offset / AUDIO_ARENA_PAGE_SIZE * AUDIO_ARENA_PAGE_SIZE);
+    bool was_full = page->free_list == NULL;
+    *(void **)ptr = page->free_list;
+    page->free_list = ptr;
+    page->used--;
+    arena_account(-(long)(AUDIO_ARENA_SMALL_MIN << page->cls));
+    if (page->used == 0) {
+        if (!was_full) {
+            arena_page_unlink(page);
+        }
+        page->next = arena.free_pages;
+        arena.free_pages = page;
+    } else if (was_full) {
+        page->next = arena.partial[page->cls];
+        arena.partial[page->cls] = page;
+    }
+}
+
+static void *arena_block_malloc(size_t size)
+{
+    size_t need = ARENA_ROUND_UP(size + BLOCK_HDR_SIZE, AUDIO_ARENA_ALIGN);
+    arena_block_t **link = &arena.free_blocks;
+    while (*link && (*link)->size < need) {
+        link = &(*link)->next;
+    }
+    arena_block_t *block = *link;
+    if (block == NULL) {
+        return NULL;
+    }
+    if (block->size - need >= BLOCK_MIN_SPLIT) {
+        arena_block_t *rest = (arena_block_t *)((uint8_t *)block + need);
+        rest->size = block->size - need;
+        rest->next = block->next;
+        *link = rest;
+        block->size = need;
+    } else {
+        *link = block->next;
+    }
+    block->magic = ARENA_MAGIC;
+    arena_account(block->size);
+    return (uint8_t *)block + BLOCK_HDR_SIZE;
+}
+
+static void arena_block_free(void *ptr)
+{
+    arena_block_t *block = (arena_block_t *)((uint8_t *)ptr - BLOCK_HDR_SIZE);
+    if (block->magic != ARENA_MAGIC) {
+        return;
+    }
+    arena_account(-(long)block->size);
+
+    arena_block_t *prev = NULL;
+    arena_block_t *next = arena.free_blocks;
+    while (next && next < block) {
+        prev = next;
+        next = next->next;
+    }
+    if (next && (uint8_t *)block + block->size == (uint8_t *)next) {
+        block->size += next->size;
+        next = next->next;
+    }
+    block->next = next;
+    if (prev && (uint8_t *)prev + prev->size == (uint8_t *)block) {
+        prev->size += block->size;
+        prev->next = next;
+    } else if (prev) {
+        prev->next = block;
+    } else {
+        arena.free_blocks = block;
+    }
+}
+
+static bool arena_in_slab(const void *ptr)
+{
+    return (const uint8_t *)ptr >= arena.slab_base && (const uint8_t *)ptr < arena.heap_base;
+}
+
+static size_t arena_usable_size(void *ptr)
+{
+    if (arena_in_slab(ptr)) {
+        size_t offset = (uint8_t *)ptr - arena.slab_base;
+        arena_page_t *page = (arena_page_t *)(arena.slab_base + offset / AUDIO_ARENA_PAGE_SIZE * AUDIO_ARENA_PAGE_SIZE);
+        return AUDIO_ARENA_SMALL_MIN << page->cls;
+    }
+    arena_block_t *block = (arena_block_t *)((uint8_t *)ptr - BLOCK_HDR_SIZE);
+    return block->size - BLOCK_HDR_SIZE;
+}
+
+void audio_arena_init(void *base, size_t size)
+{
+    memset(&arena, 0, sizeof(arena));
+    uint8_t *start = (uint8_t *)ARENA_ROUND_UP((uintptr_t)base, AUDIO_ARENA_ALIGN);
+    size -= start - (uint8_t *)base;
+    size = size / AUDIO_ARENA_ALIGN * AUDIO_ARENA_ALIGN;
+    if (size < AUDIO_ARENA_PAGE_SIZE * 2) {
+        return;
+    }
+    arena.base = start;
+    arena.size = size;
+    arena.slab_base = start;
+    arena.page_num = size / AUDIO_ARENA_SLAB_SHARE / AUDIO_ARENA_PAGE_SIZE;
+    if (arena.page_num == 0) {
+        arena.page_num = 1;
+    }
+    arena.heap_base = start + arena.page_num * AUDIO_ARENA_PAGE_SIZE;
+    arena.heap_size = size - arena.page_num * AUDIO_ARENA_PAGE_SIZE;
+    arena.free_blocks = (arena_block_t *)arena.heap_base;
+    arena.free_blocks->size = arena.heap_size;
+    arena.free_blocks->next = NULL;
+}
+
+bool audio_arena_ready(void)
+{
+    return arena.base != NULL;
+}
+
+void *audio_arena_malloc(size_t size)
+{
+    if (arena.base == NULL || size == 0) {
+        return NULL;
+    }
+    void *ptr = NULL;
+    ARENA_LOCK();
+    if (size <= AUDIO_ARENA_SMALL_MAX) {
+        ptr = arena_small_malloc(size);
+    }
+    if (ptr == NULL) {
+        ptr = arena_block_malloc(size);
+    }
+    if (ptr == NULL) {
+        arena.fail_count++;
+    }
+    ARENA_UNLOCK();
+    return ptr;
+}
+
+void *audio_arena_calloc(size_t nmemb, size_t size)
+{
+    if (size && nmemb > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = audio_arena_malloc(nmemb * size);
+    if (ptr) {
+        memset(ptr, 0, nmemb * size);
+    }
+    return ptr;
+}
+
+void *audio_arena_realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return audio_arena_malloc(size);
+    }
+    size_t usable = arena_usable_size(ptr);
+    if (size <= usable) {
+        return ptr;
+    }
+    void *data = audio_arena_malloc(size);
+    if (data) {
+        memcpy(data, ptr, usable);
+        audio_arena_free(ptr);
+    }
+    return data;
+}
+
+void audio_arena_free(void *ptr)
+{
+    if (!audio_arena_contains(ptr)) {
+        return;
+    }
+    ARENA_LOCK();
+    if (arena_in_slab(ptr)) {
+        arena_small_free(ptr);
+    } else {
+        arena_block_free(ptr);
+    }
+    ARENA_UNLOCK();
+}
+
+bool audio_arena_contains(const void *ptr)
+{
+    return arena.base != NULL && (const uint8_t *)ptr >= arena.base && (const uint8_t *)ptr < arena.base + arena.size;
+}
+
+void audio_arena_get_stats(audio_arena_stats_t *stats)
+{
+    memset(stats, 0, sizeof(audio_arena_stats_t));
+    ARENA_LOCK();
+    size_t heap_free = 0;
+    size_t largest = 0;
+    for (arena_block_t *block = arena.free_blocks; block; block = block->next) {
+        heap_free += block->size;
+        if (block->size > largest) {
+            largest = block->size;
+        }
+    }
+    stats->largest_free = largest ? largest - BLOCK_HDR_SIZE : 0;
+    stats->size = arena.size;
+    stats->used = arena.used;
+    stats->peak = arena.peak;
+    stats->free = arena.size - arena.used;
+    stats->fragmentation = heap_free ? 100 - (int)((uint64_t)largest * 100 / heap_free) : 0;
+    stats->alloc_count = arena.alloc_count;
+    stats->fail_count = arena.fail_count;
+    ARENA_UNLOCK();
+}
+
+void audio_arena_reset_peak(void)
+{
+    ARENA_LOCK();
+    arena.peak = arena.used;
+    ARENA_UNLOCK();
+}
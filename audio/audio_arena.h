@@ -0,0 +1,112 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_ARENA_H_
+#define _AUDIO_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_ARENA_ALIGN (8)
+#define AUDIO_ARENA_PAGE_SIZE (4096)
+#define AUDIO_ARENA_SMALL_MIN (16)
+#define AUDIO_ARENA_SMALL_MAX (1024)
+#define AUDIO_ARENA_SMALL_CLASSES (7)
+#define AUDIO_ARENA_SLAB_SHARE (8)
+
+/**
+ * @brief   Audio arena statistics
+ */
+typedef struct {
+    size_t size;          /*!< Size of the region owned by the arena */
+    size_t used;          /*!< Bytes in use, including headers and size class rounding */
+    size_t peak;          /*!< Highest `used` since init or `audio_arena_reset_peak` */
+    size_t free;          /*!< Bytes available for new allocations */
+    size_t largest_free;  /*!< Largest block available for a ringbuffer */
+    int fragmentation;    /*!< 100 - largest_free * 100 / free of the block heap, in percent */
+    int alloc_count;      /*!< Live allocations */
+    int fail_count;       /*!< Allocations the arena could not serve */
+} audio_arena_stats_t;
+
+/**
+ * @brief      Hand a memory region to the audio arena. The first 1/AUDIO_ARENA_SLAB_SHARE
+ *             of it is used for the size class pools of small objects (element structs,
+ *             ringbuffer handles), the rest is a coalescing block heap for ringbuffers.
+ *
+ * @param      base  Start of the region
+ * @param      size  Size of the region in bytes
+ */
+void audio_arena_init(void *base, size_t size);
+
+/**
+ * @brief      Whether `audio_arena_init` has been called with a usable region
+ */
+bool audio_arena_ready(void);
+
+/**
+ * @brief      Allocate from the arena
+ *
+ * @return     The memory, NULL if the arena can not serve the request
+ */
+void *audio_arena_malloc(size_t size);
+
+/**
+ * @brief      Allocate zeroed memory from the arena
+ */
+void *audio_arena_calloc(size_t nmemb, size_t size);
+
+/**
+ * @brief      Resize an arena allocation, the memory is left untouched on failure
+ */
+void *audio_arena_realloc(void *ptr, size_t size);
+
+/**
+ * @brief      Release an arena allocation
+ */
+void audio_arena_free(void *ptr);
+
+/**
+ * @brief      Whether the pointer belongs to the arena
+ */
+bool audio_arena_contains(const void *ptr);
+
+/**
+ * @brief      Get the arena statistics
+ */
+void audio_arena_get_stats(audio_arena_stats_t *stats);
+
+/**
+ * @brief      Restart the peak usage measurement from the current usage
+ */
+void audio_arena_reset_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "py/mphal.h"
+#include "py/objtuple.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#include "audio_async.h"
+
+typedef struct {
+    mp_obj_base_t base;
+    mp_obj_t obj;
+    audio_async_event_t *event;
+    uint32_t seen;
+    audio_async_check_t check;
+    mp_obj_t arg;
+} audio_async_wait_obj_t;
+
+const mp_obj_type_t audio_async_wait_type;
+
+void audio_async_event_set(audio_async_event_t *event)
+{
+    event->count++;
+    // the poll loop sleeps on a task notification between ticks, wake it now
+    xTaskNotifyGive(mp_main_task_handle);
+}
+
+mp_obj_t audio_async_wait_new(mp_obj_t obj, audio_async_event_t *event, audio_async_check_t check, mp_obj_t arg)
+{
+    audio_async_wait_obj_t *self = m_new_obj(audio_async_wait_obj_t);
+    self->base.type = &audio_async_wait_type;
+    self->obj = obj;
+    self->event = event;
+    self->seen = event->count;
+    self->check = check;
+    self->arg = arg;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t audio_async_io_queue(void)
+{
+    static const char *const names[] = { "asyncio.core", "uasyncio.core" };
+    mp_obj_t from = MP_OBJ_NEW_QSTR(MP_QSTR__io_queue);
+    mp_obj_t fromlist = mp_obj_new_tuple(1, &from);
+    for (int i = 0; i < MP_ARRAY_SIZE(names); i++) {
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            mp_obj_t core = mp_import_name(qstr_from_str(names[i]), fromlist, MP_OBJ_NEW_SMALL_INT(0));
+            mp_obj_t queue = mp_load_attr(core, MP_QSTR__io_queue);
+            nlr_pop();
+            return queue;
+        }
+    }
+    mp_raise_msg(&mp_type_ImportError, MP_ERROR_TEXT("asyncio is not available"));
+}
+
+STATIC mp_obj_t audio_async_wait_iternext(mp_obj_t self_in)
+{
+    audio_async_wait_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    // take the count before checking, an event set in between makes the poll return at once
+    self->seen = self->event->count;
+    mp_obj_t ret = self->check(self->obj, self->arg);
+    if (ret != MP_OBJ_NULL) {
+        return mp_make_stop_iteration(ret);
+    }
+    // same as the asyncio streams: park the task on the IO queue until we poll readable
+    mp_obj_t dest[3];
+    mp_load_method(audio_async_io_queue(), MP_QSTR_queue_read, dest);
+    dest[2] = self_in;
+    mp_call_method_n_kw(1, 0, dest);
+    return mp_const_none;
+}
+
+STATIC mp_uint_t audio_async_wait_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode)
+{
+    audio_async_wait_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (request == MP_STREAM_POLL) {
+        return self->event->count != self->seen ? (arg & MP_STREAM_POLL_RD) : 0;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+STATIC const mp_stream_p_t audio_async_wait_stream_p = {
+    .ioctl = audio_async_wait_ioctl,
+};
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_async_wait_type,
+    MP_QSTR_wait,
+    MP_TYPE_FLAG_ITER_IS_ITERNEXT,
+    iter, audio_async_wait_iternext,
+    protocol, &audio_async_wait_stream_p
+    );
@@ -0,0 +1,75 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_ASYNC_H_
+#define _AUDIO_ASYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "py/obj.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Change counter of an object, each awaitable compares it with the value it last saw
+ */
+typedef struct {
+    volatile uint32_t count;
+} audio_async_event_t;
+
+/**
+ * @brief      Check whether a wait is over, called on the MicroPython thread
+ *
+ * @param      obj   The object being waited on
+ * @param      arg   The argument given to `audio_async_wait_new`
+ *
+ * @return     The result of the await, MP_OBJ_NULL to keep waiting
+ */
+typedef mp_obj_t (*audio_async_check_t)(mp_obj_t obj, mp_obj_t arg);
+
+/**
+ * @brief      Mark the event and wake the MicroPython task, safe to call from any task
+ */
+void audio_async_event_set(audio_async_event_t *event);
+
+/**
+ * @brief      Create an awaitable that completes when `check` returns a result,
+ *             re-checking each time the event is set. The awaitable itself is polled
+ *             by the uasyncio IO queue, so any number of them may wait on one object
+ *
+ * @param      obj    The object to wait on
+ * @param      event  The event of the object
+ * @param      check  The completion check
+ * @param      arg    Passed to the check, may be MP_OBJ_NULL
+ */
+mp_obj_t audio_async_wait_new(mp_obj_t obj, audio_async_event_t *event, audio_async_check_t check, mp_obj_t arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,514 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "extmod/vfs.h"
+#include "py/objtuple.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_probe.h"
+#include "modaudio.h"
+
+static const char *TAG = "AUDIO_CATALOG";
+
+#define CATALOG_MAGIC (0x54414341) // "ACAT"
+#define CATALOG_VERSION (1)
+#define CATALOG_DB_NAME "/.catalog"
+#define CATALOG_PATH_MAX (256)
+#define CATALOG_DEPTH_MAX (8)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t data_size;
+} catalog_head_t;
+
+// followed by the path, the title, the artist and the album, padded to 4 bytes
+typedef struct {
+    uint32_t size;
+    uint32_t mtime;
+    int32_t duration_ms;
+    uint32_t bitrate;
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t bits;
+    uint8_t type;
+    uint8_t estimated;
+    uint16_t path_len;
+    uint8_t tag_len[3];
+    uint8_t reserved[3];
+} catalog_rec_t;
+
+typedef struct _audio_catalog_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t root;
+    mp_obj_t db;
+    uint8_t *data;
+    size_t data_size;
+    uint32_t *index;
+    size_t count;
+    bool saved;
+} audio_catalog_obj_t;
+
+typedef struct {
+    audio_catalog_obj_t *self;
+    vstr_t out;
+    uint32_t *table;
+    size_t table_mask;
+    size_t count;
+    size_t reused;
+    size_t changed;
+    size_t probed;
+    char path[CATALOG_PATH_MAX];
+} catalog_scan_t;
+
+STATIC const qstr probe_formats[] = {
+    [AUDIO_PROBE_UNKNOWN] = MP_QSTR_,
+    [AUDIO_PROBE_MP3] = MP_QSTR_mp3,
+    [AUDIO_PROBE_WAV] = MP_QSTR_wav,
+    [AUDIO_PROBE_AMR] = MP_QSTR_amr,
+    [AUDIO_PROBE_AMRWB] = MP_QSTR_amrwb,
+    [AUDIO_PROBE_OGG] = MP_QSTR_ogg,
+    [AUDIO_PROBE_OPUS] = MP_QSTR_opus,
+    [AUDIO_PROBE_AAC] = MP_QSTR_aac,
+};
+
+STATIC const qstr probe_info_fields[] = {
+    MP_QSTR_uri, MP_QSTR_format, MP_QSTR_duration, MP_QSTR_bitrate, MP_QSTR_rate, MP_QSTR_channels, MP_QSTR_bits,
+    MP_QSTR_estimated, MP_QSTR_title, MP_QSTR_artist, MP_QSTR_album
+};
+
+STATIC mp_obj_t catalog_new_tag(const char *tag, size_t len)
+{
+    return len > 0 ? mp_obj_new_str(tag, len) : mp_const_none;
+}
+
+STATIC mp_obj_t catalog_new_info(mp_obj_t uri, const catalog_rec_t *rec, const char **tags)
+{
+    mp_obj_t items[11] = {
+        uri,
+        rec->type != AUDIO_PROBE_UNKNOWN ? MP_OBJ_NEW_QSTR(probe_formats[rec->type]) : mp_const_none,
+        mp_obj_new_int(rec->duration_ms),
+        mp_obj_new_int(rec->bitrate),
+        mp_obj_new_int(rec->sample_rate),
+        MP_OBJ_NEW_SMALL_INT(rec->channels),
+        MP_OBJ_NEW_SMALL_INT(rec->bits),
+        mp_obj_new_bool(rec->estimated),
+        catalog_new_tag(tags[0], rec->tag_len[0]),
+        catalog_new_tag(tags[1], rec->tag_len[1]),
+        catalog_new_tag(tags[2], rec->tag_len[2]),
+    };
+    return mp_obj_new_attrtuple(probe_info_fields, 11, items);
+}
+
+STATIC void catalog_rec_fill(catalog_rec_t *rec, const audio_probe_info_t *info)
+{
+    rec->duration_ms = info->duration_ms;
+    rec->bitrate = info->bitrate;
+    rec->sample_rate = info->sample_rate;
+    rec->channels = info->channels;
+    rec->bits = info->bits;
+    rec->type = info->type;
+    rec->estimated = info->estimated;
+    rec->tag_len[0] = strlen(info->title);
+    rec->tag_len[1] = strlen(info->artist);
+    rec->tag_len[2] = strlen(info->album);
+}
+
+STATIC mp_obj_t audio_probe(mp_obj_t uri_in)
+{
+    audio_probe_info_t info;
+    if (!audio_probe_info_uri(mp_obj_str_get_str(uri_in), &info)) {
+        return mp_const_none;
+    }
+    catalog_rec_t rec = { 0 };
+    catalog_rec_fill(&rec, &info);
+    const char *tags[3] = { info.title, info.artist, info.album };
+    return catalog_new_info(uri_in, &rec, tags);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(audio_probe_obj, audio_probe);
+
+STATIC size_t catalog_rec_size(const catalog_rec_t *rec)
+{
+    size_t size = sizeof(catalog_rec_t) + rec->path_len + rec->tag_len[0] + rec->tag_len[1] + rec->tag_len[2];
+    return (size + 3) & ~3;
+}
+
+STATIC const catalog_rec_t *catalog_rec(audio_catalog_obj_t *self, size_t i)
+{
+    return (const catalog_rec_t *)(self->data + self->index[i]);
+}
+
+STATIC mp_obj_t catalog_entry(const catalog_rec_t *rec)
+{
+    const char *path = (const char *)(rec + 1);
+    const char *tags[3] = { path + rec->path_len };
+    tags[1] = tags[0] + rec->tag_len[0];
+    tags[2] = tags[1] + rec->tag_len[1];
+    return catalog_new_info(mp_obj_new_str(path, rec->path_len), rec, tags);
+}
+
+// check the records and build the offsets, false if the data is damaged
+STATIC bool catalog_index(audio_catalog_obj_t *self, uint8_t *data, size_t data_size, size_t count)
+{
+    if (count > data_size / sizeof(catalog_rec_t)) {
+        return false;
+    }
+    uint32_t *index = m_new_maybe(uint32_t, count > 0 ? count : 1);
+    if (index == NULL) {
+        return false;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        const catalog_rec_t *rec = (const catalog_rec_t *)(data + offset);
+        if (data_size - offset < sizeof(catalog_rec_t) || data_size - offset < catalog_rec_size(rec)) {
+            m_del(uint32_t, index, count > 0 ? count : 1);
+            return false;
+        }
+        index[i] = offset;
+        offset += catalog_rec_size(rec);
+    }
+    if (offset != data_size) {
+        m_del(uint32_t, index, count > 0 ? count : 1);
+        return false;
+    }
+    self->data = data;
+    self->data_size = data_size;
+    self->index = index;
+    self->count = count;
+    return true;
+}
+
+STATIC mp_obj_t catalog_open(mp_obj_t path, qstr mode)
+{
+    mp_obj_t file = MP_OBJ_NULL;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t args[2] = { path, MP_OBJ_NEW_QSTR(mode) };
+        file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
+        nlr_pop();
+    } else {
+        file = MP_OBJ_NULL;
+    }
+    return file;
+}
+
+STATIC void catalog_load(audio_catalog_obj_t *self)
+{
+    mp_obj_t file = catalog_open(self->db, MP_QSTR_rb);
+    if (file == MP_OBJ_NULL) {
+        // not scanned yet
+        return;
+    }
+    catalog_head_t head;
+    if (mp_stream_posix_read(file, &head, sizeof(head)) == sizeof(head)
+        && head.magic == CATALOG_MAGIC && head.version == CATALOG_VERSION) {
+        uint8_t *data = m_new_maybe(uint8_t, head.data_size);
+        if (data != NULL && (mp_stream_posix_read(file, data, head.data_size) != head.data_size
+                             || !catalog_index(self, data, head.data_size, head.count))) {
+            m_del(uint8_t, data, head.data_size);
+        }
+    }
+    mp_stream_close(file);
+    self->saved = self->data != NULL;
+    if (self->data == NULL) {
+        ESP_LOGW(TAG, "%s is damaged, it will be rebuilt", mp_obj_str_get_str(self->db));
+    }
+}
+
+STATIC void catalog_save(audio_catalog_obj_t *self)
+{
+    // write a copy and rename it, a power cut keeps the previous catalog
+    char tmp[CATALOG_PATH_MAX + 16];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", mp_obj_str_get_str(self->db));
+    mp_obj_t tmp_obj = mp_obj_new_str(tmp, strlen(tmp));
+    mp_obj_t args[2] = { tmp_obj, MP_OBJ_NEW_QSTR(MP_QSTR_wb) };
+    mp_obj_t file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
+    catalog_head_t head = {
+        .magic = CATALOG_MAGIC,
+        .version = CATALOG_VERSION,
+        .count = self->count,
+        .data_size = self->data_size,
+    };
+    bool ok = mp_stream_posix_write(file, &head, sizeof(head)) == sizeof(head)
+              && mp_stream_posix_write(file, self->data, self->data_size) == self->data_size;
+    mp_stream_close(file);
+    if (!ok) {
+        mp_vfs_remove(tmp_obj);
+        mp_raise_OSError(MP_EIO);
+    }
+    mp_vfs_rename(tmp_obj, self->db);
+}
+
+STATIC uint32_t catalog_hash(const char *path, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (len--) {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+STATIC void catalog_scan_table(catalog_scan_t *scan)
+{
+    audio_catalog_obj_t *self = scan->self;
+    size_t size = 16;
+    while (size < self->count * 2) {
+        size <<= 1;
+    }
+    scan->table = m_new0(uint32_t, size);
+    scan->table_mask = size - 1;
+    for (size_t i = 0; i < self->count; i++) {
+        const catalog_rec_t *rec = catalog_rec(self, i);
+        size_t slot = catalog_hash((const char *)(rec + 1), rec->path_len) & scan->table_mask;
+        while (scan->table[slot] != 0) {
+            slot = (slot + 1) & scan->table_mask;
+        }
+        scan->table[slot] = i + 1;
+    }
+}
+
+STATIC const catalog_rec_t *catalog_scan_find(catalog_scan_t *scan, size_t len)
+{
+    size_t slot = catalog_hash(scan->path, len) & scan->table_mask;
+    for (; scan->table[slot] != 0; slot = (slot + 1) & scan->table_mask) {
+        const catalog_rec_t *rec = catalog_rec(scan->self, scan->table[slot] - 1);
+        if (rec->path_len == len && memcmp(rec + 1, scan->path, len) == 0) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+STATIC void catalog_scan_file(catalog_scan_t *scan, size_t len)
+{
+    mp_obj_tuple_t *stat = MP_OBJ_TO_PTR(mp_vfs_stat(mp_obj_new_str(scan->path, len)));
+    uint32_t size = mp_obj_get_int_truncated(stat->items[6]);
+    uint32_t mtime = mp_obj_get_int_truncated(stat->items[8]);
+    const catalog_rec_t *old = catalog_scan_find(scan, len);
+    if (old != NULL && old->size == size && old->mtime == mtime) {
+        vstr_add_strn(&scan->out, (const char *)old, catalog_rec_size(old));
+        scan->reused++;
+        scan->count++;
+        return;
+    }
+    scan->changed += old != NULL;
+
+    // unknown formats are kept too, they are not probed again until they change
+    audio_probe_info_t info;
+    audio_probe_info_uri(scan->path, &info);
+    catalog_rec_t rec = {
+        .size = size,
+        .mtime = mtime,
+        .path_len = len,
+    };
+    catalog_rec_fill(&rec, &info);
+    size_t rec_size = catalog_rec_size(&rec);
+    uint8_t *buf = (uint8_t *)vstr_add_len(&scan->out, rec_size);
+    memset(buf, 0, rec_size);
+    memcpy(buf, &rec, sizeof(rec));
+    buf += sizeof(rec);
+    memcpy(buf, scan->path, len);
+    buf += len;
+    const char *tags[3] = { info.title, info.artist, info.album };
+    for (int i = 0; i < 3; i++) {
+        memcpy(buf, tags[i], rec.tag_len[i]);
+        buf += rec.tag_len[i];
+    }
+    scan->probed++;
+    scan->count++;
+}
+
+STATIC void catalog_scan_dir(catalog_scan_t *scan, size_t len, int depth)
+{
+    mp_obj_t path = mp_obj_new_str(scan->path, len);
+    mp_obj_t iter = mp_vfs_ilistdir(1, &path);
+    mp_obj_t next;
+    while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        mp_obj_t *items;
+        size_t n;
+        mp_obj_get_array(next, &n, &items);
+        size_t name_len;
+        const char *name = mp_obj_str_get_data(items[0], &name_len);
+        // hidden entries hold the catalog itself
+        if (name[0] == '.' || len + 1 + name_len >= CATALOG_PATH_MAX) {
+            continue;
+        }
+        size_t sub = len + 1 + name_len;
+        scan->path[len] = '/';
+        memcpy(scan->path + len + 1, name, name_len);
+        scan->path[sub] = '\0';
+        if (mp_obj_get_int(items[1]) == MP_S_IFDIR) {
+            if (depth < CATALOG_DEPTH_MAX) {
+                catalog_scan_dir(scan, sub, depth + 1);
+            }
+        } else if (audio_probe_suffix(scan->path) != AUDIO_PROBE_UNKNOWN) {
+            catalog_scan_file(scan, sub);
+        }
+    }
+}
+
+STATIC mp_obj_t audio_catalog_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_root,
+        ARG_db,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_root, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_db, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    size_t root_len;
+    const char *root = mp_obj_str_get_data(args[ARG_root].u_obj, &root_len);
+    while (root_len > 1 && root[root_len - 1] == '/') {
+        root_len--;
+    }
+    if (root_len == 0 || root_len + sizeof(CATALOG_DB_NAME) >= CATALOG_PATH_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid root"));
+    }
+
+    audio_catalog_obj_t *self = m_new_obj(audio_catalog_obj_t);
+    memset(self, 0, sizeof(audio_catalog_obj_t));
+    self->base.type = type;
+    self->root = mp_obj_new_str(root, root_len);
+    if (args[ARG_db].u_obj != mp_const_none) {
+        self->db = args[ARG_db].u_obj;
+        if (strlen(mp_obj_str_get_str(self->db)) >= CATALOG_PATH_MAX) {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid db"));
+        }
+    } else {
+        char db[CATALOG_PATH_MAX];
+        snprintf(db, sizeof(db), "%.*s" CATALOG_DB_NAME, (int)root_len, root);
+        self->db = mp_obj_new_str(db, strlen(db));
+    }
+    catalog_load(self);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC const qstr catalog_update_fields[] = {
+    MP_QSTR_count, MP_QSTR_probed, MP_QSTR_removed, MP_QSTR_elapsed_ms
+};
+
+STATIC mp_obj_t audio_catalog_update(mp_obj_t self_in)
+{
+    audio_catalog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int64_t start = esp_timer_get_time();
+    catalog_scan_t scan = { .self = self };
+    vstr_init(&scan.out, self->data_size > 0 ? self->data_size : 256);
+    catalog_scan_table(&scan);
+    size_t root_len;
+    const char *root = mp_obj_str_get_data(self->root, &root_len);
+    memcpy(scan.path, root, root_len);
+    scan.path[root_len] = '\0';
+    catalog_scan_dir(&scan, root_len, 0);
+
+    size_t removed = self->count - scan.reused - scan.changed;
+    m_del(uint32_t, scan.table, scan.table_mask + 1);
+    // the previous records go with the next collection
+    if (!catalog_index(self, (uint8_t *)scan.out.buf, scan.out.len, scan.count)) {
+        mp_raise_OSError(MP_EIO);
+    }
+    if (scan.probed > 0 || removed > 0 || !self->saved) {
+        catalog_save(self);
+        self->saved = true;
+    }
+    int elapsed_ms = (esp_timer_get_time() - start) / 1000;
+    ESP_LOGI(TAG, "%d files, %d probed, %d removed in %d ms", (int)scan.count, (int)scan.probed, (int)removed, elapsed_ms);
+    mp_obj_t items[4] = {
+        mp_obj_new_int(scan.count),
+        mp_obj_new_int(scan.probed),
+        mp_obj_new_int(removed),
+        mp_obj_new_int(elapsed_ms),
+    };
+    return mp_obj_new_attrtuple(catalog_update_fields, 4, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_catalog_update_obj, audio_catalog_update);
+
+STATIC mp_obj_t audio_catalog_find(mp_obj_t self_in, mp_obj_t uri_in)
+{
+    audio_catalog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t len;
+    const char *uri = mp_obj_str_get_data(uri_in, &len);
+    for (size_t i = 0; i < self->count; i++) {
+        const catalog_rec_t *rec = catalog_rec(self, i);
+        if (rec->path_len == len && memcmp(rec + 1, uri, len) == 0) {
+            return catalog_entry(rec);
+        }
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(audio_catalog_find_obj, audio_catalog_find);
+
+STATIC mp_obj_t audio_catalog_unary_op(mp_unary_op_t op, mp_obj_t self_in)
+{
+    audio_catalog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL:
+            return mp_obj_new_bool(self->count != 0);
+        case MP_UNARY_OP_LEN:
+            return MP_OBJ_NEW_SMALL_INT(self->count);
+        default:
+            return MP_OBJ_NULL;
+    }
+}
+
+STATIC mp_obj_t audio_catalog_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value)
+{
+    if (value != MP_OBJ_SENTINEL) {
+        // the entries are read only
+        return MP_OBJ_NULL;
+    }
+    audio_catalog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t i = mp_get_index(self->base.type, self->count, index, false);
+    return catalog_entry(catalog_rec(self, i));
+}
+
+STATIC const mp_rom_map_elem_t catalog_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&audio_catalog_update_obj) },
+    { MP_ROM_QSTR(MP_QSTR_find), MP_ROM_PTR(&audio_catalog_find_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(catalog_locals_dict, catalog_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_catalog_type,
+    MP_QSTR_Catalog,
+    MP_TYPE_FLAG_NONE,
+    make_new, audio_catalog_make_new,
+    unary_op, audio_catalog_unary_op,
+    subscr, audio_catalog_subscr,
+    locals_dict, &catalog_locals_dict
+    );
@@ -0,0 +1,245 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_decimator.h"
+
+static const char *TAG = "DECIMATOR";
+
+typedef struct audio_decimator {
+    int factor;
+    int src_ch;
+    int dest_ch;
+    int taps;
+    int keep; // taps - 1, none without a filter
+    int buf_sz;
+    int16_t *coef;    // Q15, symmetric so it is used as is for the forward dot product
+    int16_t *hist[2]; // keep carried samples followed by the current block
+    int hist_len;
+    int phase;        // samples of the block to skip before the next output
+    uint32_t max_frames;
+    uint32_t frames_out;
+} audio_decimator_t;
+
+bool audio_decimator_supported(int src_rate, int src_ch, int dest_rate, int dest_ch)
+{
+    if (src_rate <= 0 || dest_rate <= 0 || src_rate % dest_rate != 0) {
+        return false;
+    }
+    if (src_ch < 1 || src_ch > 2 || (dest_ch != 1 && dest_ch != src_ch)) {
+        return false;
+    }
+    return src_rate / dest_rate <= AUDIO_DECIMATOR_MAX_FACTOR;
+}
+
+static float _decimator_tap(int n, int taps, int factor)
+{
+    // Blackman windowed sinc, cut-off just under the output Nyquist frequency
+    const float fc = 0.45f / factor;
+    float x = n - (taps - 1) * 0.5f;
+    float h = x == 0 ? 2 * fc : sinf(2 * (float)M_PI * fc * x) / ((float)M_PI * x);
+    float a = 2 * (float)M_PI * n / (taps - 1);
+    return h * (0.42f - 0.5f * cosf(a) + 0.08f * cosf(2 * a));
+}
+
+static void _decimator_design(int16_t *coef, int taps, int factor)
+{
+    float sum = 0;
+    for (int n = 0; n < taps; n++) {
+        sum += _decimator_tap(n, taps, factor);
+    }
+    // unity gain at DC
+    for (int n = 0; n < taps; n++) {
+        coef[n] = (int16_t)lrintf(_decimator_tap(n, taps, factor) * 32767 / sum);
+    }
+}
+
+static inline int16_t _decimator_dot(const int16_t *x, const int16_t *h, int taps)
+{
+    // taps is a multiple of the phase length, a fixed trip count the compiler unrolls
+    // and vectorises into 16 bit multiply-adds
+    int32_t acc = 1 << 14;
+    for (int b = 0; b < taps; b += AUDIO_DECIMATOR_TAPS_PER_PHASE) {
+        for (int k = 0; k < AUDIO_DECIMATOR_TAPS_PER_PHASE; k++) {
+            acc += x[b + k] * h[b + k];
+        }
+    }
+    int32_t y = acc >> 15;
+    return y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y);
+}
+
+static esp_err_t _decimator_open(audio_element_handle_t self)
+{
+    audio_decimator_t *dec = (audio_decimator_t *)audio_element_getdata(self);
+    int frames = dec->buf_sz / (dec->src_ch * sizeof(int16_t));
+    dec->hist_len = dec->keep + frames;
+    for (int c = 0; c < dec->dest_ch; c++) {
+        dec->hist[c] = audio_calloc(dec->hist_len, sizeof(int16_t));
+        AUDIO_MEM_CHECK(TAG, dec->hist[c], return ESP_ERR_NO_MEM);
+    }
+    dec->phase = 0;
+    dec->frames_out = 0;
+    return ESP_OK;
+}
+
+static int _decimator_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_decimator_t *dec = (audio_decimator_t *)audio_element_getdata(self);
+    int frame_size = dec->src_ch * sizeof(int16_t);
+    // whole frames only, a partial one only shows up at the end of the stream and is dropped
+    int r_size = audio_element_input(self, in_buffer, in_len - in_len % frame_size);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    int frames = r_size / frame_size;
+    const int16_t *in = (const int16_t *)in_buffer;
+    int16_t *out = (int16_t *)in_buffer;
+    int keep = dec->keep;
+
+    for (int c = 0; c < dec->dest_ch; c++) {
+        int16_t *x = dec->hist[c] + keep;
+        if (dec->src_ch == dec->dest_ch) {
+            for (int i = 0; i < frames; i++) {
+                x[i] = in[i * dec->src_ch + c];
+            }
+        } else {
+            for (int i = 0; i < frames; i++) {
+                x[i] = (in[2 * i] + in[2 * i + 1]) >> 1;
+            }
+        }
+    }
+    // the output never outgrows the input, write it back over the input buffer
+    int avail = keep + frames;
+    int pos = keep + dec->phase;
+    int n = 0;
+    for (; pos < avail; pos += dec->factor, n++) {
+        for (int c = 0; c < dec->dest_ch; c++) {
+            const int16_t *x = dec->hist[c] + pos - keep;
+            out[n * dec->dest_ch + c] = dec->taps ? _decimator_dot(x, dec->coef, dec->taps) : x[0];
+        }
+    }
+    dec->phase = pos - avail;
+    for (int c = 0; c < dec->dest_ch && keep > 0; c++) {
+        memmove(dec->hist[c], dec->hist[c] + frames, keep * sizeof(int16_t));
+    }
+    bool last = false;
+    if (dec->max_frames && dec->frames_out + n >= dec->max_frames) {
+        n = dec->max_frames - dec->frames_out;
+        last = true;
+    }
+    dec->frames_out += n;
+    if (n > 0) {
+        int w_size = audio_element_output(self, in_buffer, n * dec->dest_ch * sizeof(int16_t));
+        if (w_size <= 0) {
+            return w_size;
+        }
+    }
+    // finishing marks the output done, the encoder and writer then close cleanly
+    return last ? AEL_IO_DONE : r_size;
+}
+
+static esp_err_t _decimator_close(audio_element_handle_t self)
+{
+    audio_decimator_t *dec = (audio_decimator_t *)audio_element_getdata(self);
+    for (int c = 0; c < 2; c++) {
+        audio_free(dec->hist[c]);
+        dec->hist[c] = NULL;
+    }
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _decimator_destroy(audio_element_handle_t self)
+{
+    audio_decimator_t *dec = (audio_decimator_t *)audio_element_getdata(self);
+    audio_free(dec->coef);
+    audio_free(dec);
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_decimator_init(audio_decimator_cfg_t *config)
+{
+    if (!audio_decimator_supported(config->src_rate, config->src_ch, config->dest_rate, config->dest_ch)) {
+        ESP_LOGE(TAG, "Unsupported conversion %d/%d to %d/%d", config->src_rate, config->src_ch, config->dest_rate, config->dest_ch);
+        return NULL;
+    }
+    audio_element_handle_t el;
+    audio_decimator_t *dec = audio_calloc(1, sizeof(audio_decimator_t));
+
+    AUDIO_MEM_CHECK(TAG, dec, return NULL);
+
+    dec->factor = config->src_rate / config->dest_rate;
+    dec->src_ch = config->src_ch;
+    dec->dest_ch = config->dest_ch;
+    dec->max_frames = config->max_frames;
+    // a factor of 1 only folds the channels
+    dec->taps = dec->factor > 1 ? dec->factor * AUDIO_DECIMATOR_TAPS_PER_PHASE : 0;
+    if (dec->taps) {
+        dec->keep = dec->taps - 1;
+        dec->coef = audio_calloc(dec->taps, sizeof(int16_t));
+        AUDIO_MEM_CHECK(TAG, dec->coef, goto _decimator_init_exit);
+        _decimator_design(dec->coef, dec->taps, dec->factor);
+    }
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _decimator_open;
+    cfg.close = _decimator_close;
+    cfg.process = _decimator_process;
+    cfg.destroy = _decimator_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = config->buf_sz;
+    if (cfg.buffer_len == 0) {
+        cfg.buffer_len = AUDIO_DECIMATOR_BUF_SIZE;
+    }
+    cfg.tag = "decimator";
+    dec->buf_sz = cfg.buffer_len;
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _decimator_init_exit);
+    audio_element_setdata(el, dec);
+    audio_element_set_music_info(el, config->dest_rate, config->dest_ch, 16);
+    return el;
+_decimator_init_exit:
+    audio_free(dec->coef);
+    audio_free(dec);
+    return NULL;
+}
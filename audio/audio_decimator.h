@@ -0,0 +1,101 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_DECIMATOR_H_
+#define _AUDIO_DECIMATOR_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_DECIMATOR_MAX_FACTOR (8)
+#define AUDIO_DECIMATOR_TAPS_PER_PHASE (16)
+#define AUDIO_DECIMATOR_BUF_SIZE (2048)
+#define AUDIO_DECIMATOR_TASK_STACK (2560)
+#define AUDIO_DECIMATOR_TASK_CORE (1)
+#define AUDIO_DECIMATOR_TASK_PRIO (5)
+#define AUDIO_DECIMATOR_RINGBUFFER_SIZE (4 * 1024)
+
+/**
+ * @brief   Decimator configuration, 16 bit PCM in and out
+ */
+typedef struct {
+    int src_rate;         /*!< Input sample rate, an integer multiple of dest_rate */
+    int src_ch;           /*!< Input channels, 1 or 2 */
+    int dest_rate;        /*!< Output sample rate */
+    int dest_ch;          /*!< Output channels, 1 or src_ch */
+    uint32_t max_frames;  /*!< End the stream after this many output frames, 0 for no limit */
+    int buf_sz;           /*!< Audio Element Buffer size */
+    int out_rb_size;      /*!< Size of output ringbuffer */
+    int task_stack;       /*!< Task stack size */
+    int task_core;        /*!< Task running in core (0 or 1) */
+    int task_prio;        /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;    /*!< Try to allocate stack in external memory */
+} audio_decimator_cfg_t;
+
+#define AUDIO_DECIMATOR_CFG_DEFAULT()                   \
+{                                                       \
+    .src_rate = 48000,                                  \
+    .src_ch = 2,                                        \
+    .dest_rate = 16000,                                 \
+    .dest_ch = 1,                                       \
+    .max_frames = 0,                                    \
+    .buf_sz = AUDIO_DECIMATOR_BUF_SIZE,                 \
+    .out_rb_size = AUDIO_DECIMATOR_RINGBUFFER_SIZE,     \
+    .task_stack = AUDIO_DECIMATOR_TASK_STACK,           \
+    .task_core = AUDIO_DECIMATOR_TASK_CORE,             \
+    .task_prio = AUDIO_DECIMATOR_TASK_PRIO,             \
+    .stack_in_ext = false,                              \
+}
+
+/**
+ * @brief      Check that the conversion is an integer-ratio decimation the element handles
+ *
+ * @return     true when `audio_decimator_init` accepts the rates and channels
+ */
+bool audio_decimator_supported(int src_rate, int src_ch, int dest_rate, int dest_ch);
+
+/**
+ * @brief      Create an Audio Element that low-pass filters and decimates 16 bit PCM by
+ *             src_rate / dest_rate, folding stereo to mono when dest_ch is 1.
+ *             Only every factor-th output of the FIR is computed, so the cost is
+ *             AUDIO_DECIMATOR_TAPS_PER_PHASE * factor multiply-accumulates per output sample
+ *             and channel, taken in blocks of AUDIO_DECIMATOR_TAPS_PER_PHASE the compiler
+ *             unrolls, and vectorises on targets with SIMD.
+ *             With max_frames set the element finishes once that many frames are out,
+ *             which ends the downstream elements with exactly that length.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle, NULL when the conversion is not supported
+ */
+audio_element_handle_t audio_decimator_init(audio_decimator_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,884 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "py/mpthread.h"
+#include "py/objstr.h"
+#include "py/runtime.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "esp_audio.h"
+#include "ringbuf.h"
+
+#include "audio_hal.h"
+#include "board.h"
+#include "filter_resample.h"
+
+#include "http_stream.h"
+#include "i2s_stream.h"
+#include "raw_stream.h"
+#include "vfs_stream.h"
+
+#include "amr_decoder.h"
+#include "amrnb_encoder.h"
+#include "mp3_decoder.h"
+#include "wav_decoder.h"
+#include "wav_encoder.h"
+
+#include "audio_async.h"
+#include "audio_mem_stats.h"
+#include "audio_placement.h"
+#include "audio_stack.h"
+
+#define GRAPH_MAX_ELEMENTS (8)
+#define GRAPH_MAX_TAPS (4)
+#define GRAPH_TAG_LEN (16)
+#define GRAPH_TAP_RB_SIZE (8 * 1024)
+#define GRAPH_TASK_STACK (3072)
+#define GRAPH_TASK_PRIO (5)
+#define GRAPH_CMD_QUIT (0x7f00)
+
+static const char *TAG = "AUDIO_GRAPH";
+
+enum {
+    GRAPH_CODEC_MP3,
+    GRAPH_CODEC_WAV,
+    GRAPH_CODEC_AMR,
+};
+
+typedef enum {
+    GRAPH_EL_I2S,
+    GRAPH_EL_VFS,
+    GRAPH_EL_HTTP,
+    GRAPH_EL_RAW,
+    GRAPH_EL_RESAMPLE,
+    GRAPH_EL_DECODER,
+    GRAPH_EL_ENCODER,
+} graph_el_kind_t;
+
+typedef struct {
+    char tag[GRAPH_TAG_LEN];
+    graph_el_kind_t kind;
+    audio_stream_type_t type;
+    audio_element_handle_t el;
+} graph_element_t;
+
+// A ringbuffer fed by a multi output of an element of another pipeline, owned by the reading side
+typedef struct {
+    ringbuf_handle_t rb;
+    mp_obj_t src;
+    audio_element_handle_t src_el;
+    int index;
+} graph_tap_t;
+
+const mp_obj_type_t audio_graph_type;
+
+// Elements are registered once under their tag and kept until deinit, link() may be called
+// again with another selection of tags to rebuild the chain without recreating them
+typedef struct _audio_graph_obj_t {
+    mp_obj_base_t base;
+    char name[GRAPH_TAG_LEN];
+
+    audio_pipeline_handle_t pipeline;
+    graph_element_t elements[GRAPH_MAX_ELEMENTS];
+    int element_num;
+    int link[GRAPH_MAX_ELEMENTS];
+    int link_num;
+    bool linked;
+    bool ran;
+    graph_tap_t taps[GRAPH_MAX_TAPS];
+    int tap_num;
+
+    audio_event_iface_handle_t evt;
+    SemaphoreHandle_t task_done;
+    volatile int status;
+    volatile int err;
+    audio_async_event_t event;
+} audio_graph_obj_t;
+
+STATIC audio_graph_obj_t *graph_get(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->pipeline == NULL) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("pipeline deinitialized"));
+    }
+    return self;
+}
+
+STATIC graph_element_t *graph_find(audio_graph_obj_t *self, const char *tag)
+{
+    for (int i = 0; i < self->element_num; i++) {
+        if (strcmp(self->elements[i].tag, tag) == 0) {
+            return &self->elements[i];
+        }
+    }
+    return NULL;
+}
+
+STATIC graph_element_t *graph_find_obj(audio_graph_obj_t *self, mp_obj_t tag_in)
+{
+    graph_element_t *item = graph_find(self, mp_obj_str_get_str(tag_in));
+    if (item == NULL) {
+        mp_raise_msg_varg(&mp_type_KeyError, MP_ERROR_TEXT("no element %s"), mp_obj_str_get_str(tag_in));
+    }
+    return item;
+}
+
+STATIC audio_element_handle_t graph_last(audio_graph_obj_t *self)
+{
+    return self->link_num > 0 ? self->elements[self->link[self->link_num - 1]].el : NULL;
+}
+
+STATIC void graph_set_status(audio_graph_obj_t *self, int status, int err)
+{
+    self->status = status;
+    self->err = err;
+    audio_async_event_set(&self->event);
+}
+
+STATIC void graph_task(void *arg)
+{
+    audio_graph_obj_t *self = (audio_graph_obj_t *)arg;
+
+    while (1) {
+        audio_event_iface_msg_t msg;
+        if (audio_event_iface_listen(self->evt, &msg, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        if (msg.source == (void *)self && msg.cmd == GRAPH_CMD_QUIT) {
+            break;
+        }
+        if (msg.source_type != AUDIO_ELEMENT_TYPE_ELEMENT) {
+            continue;
+        }
+        audio_element_handle_t last = graph_last(self);
+        if (msg.cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO && last != NULL && msg.source != (void *)last) {
+            // an I2S writer at the end of the chain follows the format of the decoded data
+            graph_element_t *out = &self->elements[self->link[self->link_num - 1]];
+            if (out->kind == GRAPH_EL_I2S && out->type == AUDIO_STREAM_WRITER) {
+                audio_element_info_t music_info = { 0 };
+                audio_element_getinfo(msg.source, &music_info);
+                audio_element_setinfo(last, &music_info);
+                i2s_stream_set_clk(last, music_info.sample_rates, music_info.bits, music_info.channels);
+            }
+            continue;
+        }
+        if (msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+            ESP_LOGW(TAG, "%s: %s error %d", self->name, audio_element_get_tag(msg.source), status);
+            graph_set_status(self, AUDIO_STATUS_ERROR, status);
+        } else if (msg.source == (void *)last) {
+            if (status == AEL_STATUS_STATE_RUNNING) {
+                graph_set_status(self, AUDIO_STATUS_RUNNING, 0);
+            } else if (status == AEL_STATUS_STATE_PAUSED) {
+                graph_set_status(self, AUDIO_STATUS_PAUSED, 0);
+            } else if (status == AEL_STATUS_STATE_STOPPED) {
+                graph_set_status(self, AUDIO_STATUS_STOPPED, 0);
+            } else if (status == AEL_STATUS_STATE_FINISHED) {
+                graph_set_status(self, AUDIO_STATUS_FINISHED, 0);
+            }
+        }
+    }
+
+    xSemaphoreGive(self->task_done);
+    vTaskDelete(NULL);
+}
+
+STATIC mp_obj_t audio_graph_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_name,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_name, MP_ARG_OBJ, { .u_obj = MP_OBJ_NEW_QSTR(MP_QSTR_pipeline) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    audio_graph_obj_t *self = m_new_obj_with_finaliser(audio_graph_obj_t);
+    self->base.type = type;
+    strncpy(self->name, mp_obj_str_get_str(args[ARG_name].u_obj), sizeof(self->name) - 1);
+    self->status = AUDIO_STATUS_STOPPED;
+
+    audio_board_handle_t board_handle = audio_board_init();
+    audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->pipeline = audio_pipeline_init(&pipeline_cfg);
+
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    self->evt = audio_event_iface_init(&evt_cfg);
+    self->task_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(graph_task, "graph_evt", GRAPH_TASK_STACK, self, GRAPH_TASK_PRIO, NULL, 1);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC graph_element_t *graph_add_begin(audio_graph_obj_t *self, mp_obj_t tag_in)
+{
+    const char *tag = mp_obj_str_get_str(tag_in);
+    if (strlen(tag) == 0 || strlen(tag) >= GRAPH_TAG_LEN) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid tag"));
+    }
+    if (graph_find(self, tag) != NULL) {
+        mp_raise_ValueError(MP_ERROR_TEXT("tag already registered"));
+    }
+    if (self->element_num >= GRAPH_MAX_ELEMENTS) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("too many elements"));
+    }
+    graph_element_t *item = &self->elements[self->element_num];
+    memset(item, 0, sizeof(graph_element_t));
+    strcpy(item->tag, tag);
+    audio_mem_stats_subsystem("pipeline");
+    audio_placement_enter(item->tag, AUDIO_PLACE_KIND_BUF);
+    return item;
+}
+
+STATIC mp_obj_t graph_add_end(audio_graph_obj_t *self, graph_element_t *item)
+{
+    audio_placement_exit();
+    audio_mem_stats_subsystem(NULL);
+    if (item->el == NULL) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("element init failed"));
+    }
+    audio_pipeline_register(self->pipeline, item->el, item->tag);
+    if (item->kind != GRAPH_EL_RAW) {
+        audio_stack_track(item->el);
+    }
+    self->element_num++;
+    return mp_obj_new_str(item->tag, strlen(item->tag));
+}
+
+STATIC audio_stream_type_t graph_stream_type(mp_int_t mode)
+{
+    if (mode != AUDIO_STREAM_READER && mode != AUDIO_STREAM_WRITER) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid mode"));
+    }
+    return mode;
+}
+
+STATIC mp_obj_t audio_graph_i2s(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_tag,
+        ARG_mode,
+        ARG_rate,
+        ARG_multi_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tag, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_mode, MP_ARG_INT, { .u_int = AUDIO_STREAM_READER } },
+        { MP_QSTR_rate, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 48000 } },
+        { MP_QSTR_multi_out, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_graph_obj_t *self = graph_get(pos_args[0]);
+
+    audio_stream_type_t type = graph_stream_type(args[ARG_mode].u_int);
+    graph_element_t *item = graph_add_begin(self, args[ARG_tag].u_obj);
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = type;
+    // the driver is shared with audio.player and audio.recorder
+    i2s_cfg.uninstall_drv = false;
+    i2s_cfg.i2s_config.sample_rate = args[ARG_rate].u_int;
+    i2s_cfg.multi_out_num = args[ARG_multi_out].u_int;
+    i2s_cfg.task_core = 1;
+    i2s_cfg.task_stack = audio_stack_size(item->tag, "i2s", i2s_cfg.task_stack);
+    i2s_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, i2s_cfg.stack_in_ext);
+    item->el = i2s_stream_init(&i2s_cfg);
+    item->kind = GRAPH_EL_I2S;
+    item->type = type;
+    return graph_add_end(self, item);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_i2s_obj, 2, audio_graph_i2s);
+
+STATIC mp_obj_t audio_graph_stream_helper(graph_el_kind_t kind, size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_tag,
+        ARG_mode,
+        ARG_uri,
+        ARG_size,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tag, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_mode, MP_ARG_INT, { .u_int = AUDIO_STREAM_READER } },
+        { MP_QSTR_uri, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_size, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_graph_obj_t *self = graph_get(pos_args[0]);
+
+    audio_stream_type_t type = graph_stream_type(args[ARG_mode].u_int);
+    graph_element_t *item = graph_add_begin(self, args[ARG_tag].u_obj);
+    if (kind == GRAPH_EL_VFS) {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = type;
+        vfs_cfg.task_core = 1;
+        vfs_cfg.task_stack = audio_stack_size(item->tag, "vfs", vfs_cfg.task_stack);
+        vfs_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, vfs_cfg.stack_in_ext);
+        item->el = vfs_stream_init(&vfs_cfg);
+    } else if (kind == GRAPH_EL_HTTP) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = type;
+        http_cfg.task_core = 1;
+        http_cfg.task_stack = audio_stack_size(item->tag, "http", http_cfg.task_stack);
+        http_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, http_cfg.stack_in_ext);
+        item->el = http_stream_init(&http_cfg);
+    } else {
+        // raw streams have no task, Python reads or writes them with readinto() and write()
+        raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+        raw_cfg.type = type;
+        if (args[ARG_size].u_int > 0) {
+            raw_cfg.out_rb_size = args[ARG_size].u_int;
+        }
+        item->el = raw_stream_init(&raw_cfg);
+    }
+    if (item->el != NULL && args[ARG_uri].u_obj != mp_const_none) {
+        audio_element_set_uri(item->el, mp_obj_str_get_str(args[ARG_uri].u_obj));
+    }
+    item->kind = kind;
+    item->type = type;
+    return graph_add_end(self, item);
+}
+
+STATIC mp_obj_t audio_graph_vfs(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return audio_graph_stream_helper(GRAPH_EL_VFS, n_args, pos_args, kw_args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_vfs_obj, 2, audio_graph_vfs);
+
+STATIC mp_obj_t audio_graph_http(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return audio_graph_stream_helper(GRAPH_EL_HTTP, n_args, pos_args, kw_args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_http_obj, 2, audio_graph_http);
+
+STATIC mp_obj_t audio_graph_raw(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return audio_graph_stream_helper(GRAPH_EL_RAW, n_args, pos_args, kw_args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_raw_obj, 2, audio_graph_raw);
+
+STATIC mp_obj_t audio_graph_resample(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_tag,
+        ARG_src_rate,
+        ARG_src_ch,
+        ARG_dest_rate,
+        ARG_dest_ch,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tag, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_src_rate, MP_ARG_INT, { .u_int = 48000 } },
+        { MP_QSTR_src_ch, MP_ARG_INT, { .u_int = 2 } },
+        { MP_QSTR_dest_rate, MP_ARG_INT, { .u_int = 16000 } },
+        { MP_QSTR_dest_ch, MP_ARG_INT, { .u_int = 1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_graph_obj_t *self = graph_get(pos_args[0]);
+
+    graph_element_t *item = graph_add_begin(self, args[ARG_tag].u_obj);
+    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+    rsp_cfg.src_rate = args[ARG_src_rate].u_int;
+    rsp_cfg.src_ch = args[ARG_src_ch].u_int;
+    rsp_cfg.dest_rate = args[ARG_dest_rate].u_int;
+    rsp_cfg.dest_ch = args[ARG_dest_ch].u_int;
+    rsp_cfg.task_core = 1;
+    rsp_cfg.task_stack = audio_stack_size(item->tag, "rsp", rsp_cfg.task_stack);
+    rsp_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, rsp_cfg.stack_in_ext);
+    item->el = rsp_filter_init(&rsp_cfg);
+    item->kind = GRAPH_EL_RESAMPLE;
+    return graph_add_end(self, item);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_resample_obj, 2, audio_graph_resample);
+
+STATIC mp_obj_t audio_graph_decoder(mp_obj_t self_in, mp_obj_t tag_in, mp_obj_t codec_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    int codec = mp_obj_get_int(codec_in);
+    if (codec < GRAPH_CODEC_MP3 || codec > GRAPH_CODEC_AMR) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid codec"));
+    }
+
+    graph_element_t *item = graph_add_begin(self, tag_in);
+    if (codec == GRAPH_CODEC_MP3) {
+        mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+        mp3_cfg.task_core = 1;
+        mp3_cfg.task_stack = audio_stack_size(item->tag, "mp3_dec", mp3_cfg.task_stack);
+        mp3_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, mp3_cfg.stack_in_ext);
+        item->el = mp3_decoder_init(&mp3_cfg);
+    } else if (codec == GRAPH_CODEC_WAV) {
+        wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+        wav_cfg.task_core = 1;
+        wav_cfg.task_stack = audio_stack_size(item->tag, "wav_dec", wav_cfg.task_stack);
+        wav_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, wav_cfg.stack_in_ext);
+        item->el = wav_decoder_init(&wav_cfg);
+    } else {
+        amr_decoder_cfg_t amr_cfg = DEFAULT_AMR_DECODER_CONFIG();
+        amr_cfg.task_core = 1;
+        amr_cfg.task_stack = audio_stack_size(item->tag, "amr_dec", amr_cfg.task_stack);
+        amr_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, amr_cfg.stack_in_ext);
+        item->el = amr_decoder_init(&amr_cfg);
+    }
+    item->kind = GRAPH_EL_DECODER;
+    return graph_add_end(self, item);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(audio_graph_decoder_obj, audio_graph_decoder);
+
+STATIC mp_obj_t audio_graph_encoder(mp_obj_t self_in, mp_obj_t tag_in, mp_obj_t codec_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    int codec = mp_obj_get_int(codec_in);
+    if (codec != GRAPH_CODEC_WAV && codec != GRAPH_CODEC_AMR) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid codec"));
+    }
+
+    graph_element_t *item = graph_add_begin(self, tag_in);
+    if (codec == GRAPH_CODEC_WAV) {
+        wav_encoder_cfg_t wav_cfg = DEFAULT_WAV_ENCODER_CONFIG();
+        wav_cfg.task_core = 1;
+        wav_cfg.task_stack = audio_stack_size(item->tag, "wav_enc", wav_cfg.task_stack);
+        wav_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, wav_cfg.stack_in_ext);
+        item->el = wav_encoder_init(&wav_cfg);
+    } else {
+        amrnb_encoder_cfg_t amr_cfg = DEFAULT_AMRNB_ENCODER_CONFIG();
+        amr_cfg.task_core = 1;
+        amr_cfg.task_stack = audio_stack_size(item->tag, "amrnb_enc", amr_cfg.task_stack);
+        amr_cfg.stack_in_ext = audio_placement_stack_in_ext(item->tag, amr_cfg.stack_in_ext);
+        item->el = amrnb_encoder_init(&amr_cfg);
+    }
+    item->kind = GRAPH_EL_ENCODER;
+    return graph_add_end(self, item);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(audio_graph_encoder_obj, audio_graph_encoder);
+
+STATIC void graph_halt(audio_graph_obj_t *self)
+{
+    if (!self->ran) {
+        return;
+    }
+    MP_THREAD_GIL_EXIT();
+    audio_pipeline_stop(self->pipeline);
+    audio_pipeline_wait_for_stop(self->pipeline);
+    MP_THREAD_GIL_ENTER();
+}
+
+STATIC mp_obj_t audio_graph_link(mp_obj_t self_in, mp_obj_t tags_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(tags_in, &len, &items);
+    if (len < 1 || len > GRAPH_MAX_ELEMENTS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid link"));
+    }
+    const char *link_tag[GRAPH_MAX_ELEMENTS];
+    int link[GRAPH_MAX_ELEMENTS];
+    for (size_t i = 0; i < len; i++) {
+        graph_element_t *item = graph_find_obj(self, items[i]);
+        link[i] = item - self->elements;
+        link_tag[i] = item->tag;
+    }
+
+    graph_halt(self);
+    audio_mem_stats_subsystem("pipeline");
+    audio_placement_enter(self->name, AUDIO_PLACE_KIND_RB);
+    esp_err_t ret;
+    if (self->linked) {
+        // keep the registered elements, only the chain and its ringbuffers change
+        audio_pipeline_breakup_elements(self->pipeline, NULL);
+        ret = audio_pipeline_relink(self->pipeline, link_tag, len);
+    } else {
+        ret = audio_pipeline_link(self->pipeline, link_tag, len);
+    }
+    audio_placement_exit();
+    audio_mem_stats_subsystem(NULL);
+    if (ret != ESP_OK) {
+        self->link_num = 0;
+        self->linked = false;
+        return mp_obj_new_bool(false);
+    }
+    memcpy(self->link, link, len * sizeof(int));
+    self->link_num = len;
+    self->linked = true;
+    audio_pipeline_set_listener(self->pipeline, self->evt);
+    return mp_obj_new_bool(true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(audio_graph_link_obj, audio_graph_link);
+
+STATIC void graph_reset(audio_graph_obj_t *self)
+{
+    audio_pipeline_reset_ringbuffer(self->pipeline);
+    audio_pipeline_reset_elements(self->pipeline);
+    audio_pipeline_change_state(self->pipeline, AEL_STATE_INIT);
+    for (int i = 0; i < self->tap_num; i++) {
+        rb_reset(self->taps[i].rb);
+    }
+}
+
+STATIC mp_obj_t audio_graph_run(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    if (!self->linked) {
+        return mp_obj_new_bool(false);
+    }
+    if (self->ran) {
+        graph_halt(self);
+        graph_reset(self);
+    }
+    self->status = AUDIO_STATUS_RUNNING;
+    self->err = 0;
+    self->ran = true;
+    return mp_obj_new_bool(audio_pipeline_run(self->pipeline) == ESP_OK);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_run_obj, audio_graph_run);
+
+STATIC mp_obj_t audio_graph_stop(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    graph_halt(self);
+    audio_stack_sample();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_stop_obj, audio_graph_stop);
+
+STATIC mp_obj_t audio_graph_reset(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    graph_halt(self);
+    graph_reset(self);
+    self->ran = false;
+    self->status = AUDIO_STATUS_STOPPED;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_reset_obj, audio_graph_reset);
+
+STATIC mp_obj_t audio_graph_connect(size_t n_args, const mp_obj_t *args)
+{
+    // connect(tag, index, pipeline, dest_tag)
+    audio_graph_obj_t *self = graph_get(args[0]);
+    graph_element_t *src = graph_find_obj(self, args[1]);
+    int index = mp_obj_get_int(args[2]);
+    if (!mp_obj_is_type(args[3], &audio_graph_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("expected a Pipeline"));
+    }
+    audio_graph_obj_t *dest = graph_get(args[3]);
+    graph_element_t *dst = graph_find_obj(dest, args[4]);
+    if (dest->tap_num >= GRAPH_MAX_TAPS) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("too many connections"));
+    }
+    // like link(), the ringbuffers of running elements are not swapped under their tasks
+    graph_halt(self);
+    graph_halt(dest);
+
+    audio_mem_stats_subsystem("pipeline");
+    audio_placement_enter(dest->name, AUDIO_PLACE_KIND_RB);
+    ringbuf_handle_t rb = rb_create(GRAPH_TAP_RB_SIZE, 1);
+    audio_placement_exit();
+    audio_mem_stats_subsystem(NULL);
+    if (rb == NULL) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("no memory"));
+    }
+    if (audio_element_set_multi_output_ringbuf(src->el, rb, index) != ESP_OK) {
+        rb_destroy(rb);
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid output index"));
+    }
+    audio_element_set_input_ringbuf(dst->el, rb);
+
+    graph_tap_t *tap = &dest->taps[dest->tap_num++];
+    tap->rb = rb;
+    tap->src = MP_OBJ_FROM_PTR(self);
+    tap->src_el = src->el;
+    tap->index = index;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_graph_connect_obj, 5, 5, audio_graph_connect);
+
+STATIC mp_obj_t audio_graph_uri(size_t n_args, const mp_obj_t *args)
+{
+    audio_graph_obj_t *self = graph_get(args[0]);
+    graph_element_t *item = graph_find_obj(self, args[1]);
+    if (n_args == 2) {
+        char *uri = audio_element_get_uri(item->el);
+        return uri ? mp_obj_new_str(uri, strlen(uri)) : mp_const_none;
+    }
+    audio_element_set_uri(item->el, mp_obj_str_get_str(args[2]));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_graph_uri_obj, 2, 3, audio_graph_uri);
+
+STATIC mp_obj_t audio_graph_info(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_tag,
+        ARG_rate,
+        ARG_channels,
+        ARG_bits,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tag, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_rate, MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_channels, MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_bits, MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_graph_obj_t *self = graph_get(pos_args[0]);
+    graph_element_t *item = graph_find_obj(self, args[ARG_tag].u_obj);
+
+    // writers of container formats take the header fields from the element info
+    audio_element_info_t info;
+    audio_element_getinfo(item->el, &info);
+    if (args[ARG_rate].u_int > 0) {
+        info.sample_rates = args[ARG_rate].u_int;
+    }
+    if (args[ARG_channels].u_int > 0) {
+        info.channels = args[ARG_channels].u_int;
+    }
+    if (args[ARG_bits].u_int > 0) {
+        info.bits = args[ARG_bits].u_int;
+    }
+    audio_element_setinfo(item->el, &info);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_graph_info_obj, 2, audio_graph_info);
+
+STATIC mp_obj_t audio_graph_stats(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    mp_obj_t stats = mp_obj_new_dict(self->element_num);
+    for (int i = 0; i < self->element_num; i++) {
+        graph_element_t *item = &self->elements[i];
+        audio_element_info_t info;
+        audio_element_getinfo(item->el, &info);
+        ringbuf_handle_t rb = audio_element_get_input_ringbuf(item->el);
+
+        mp_obj_t dict = mp_obj_new_dict(7);
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_state), mp_obj_new_int(audio_element_get_state(item->el)));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_rate), mp_obj_new_int(info.sample_rates));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_channels), mp_obj_new_int(info.channels));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_bits), mp_obj_new_int(info.bits));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_pos), mp_obj_new_int_from_ll(info.byte_pos));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_total), mp_obj_new_int_from_ll(info.total_bytes));
+        if (rb != NULL) {
+            mp_obj_t fill[2] = { mp_obj_new_int(rb_bytes_filled(rb)), mp_obj_new_int(rb_get_size(rb)) };
+            mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_rb), mp_obj_new_tuple(2, fill));
+        }
+        mp_obj_dict_store(stats, mp_obj_new_str(item->tag, strlen(item->tag)), dict);
+    }
+    return stats;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_stats_obj, audio_graph_stats);
+
+STATIC mp_obj_t audio_graph_state(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t state[2] = { mp_obj_new_int(self->status), mp_obj_new_int(self->err) };
+    return mp_obj_new_tuple(2, state);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_state_obj, audio_graph_state);
+
+STATIC mp_obj_t audio_graph_raw_rw(mp_obj_t self_in, mp_obj_t tag_in, mp_obj_t buf_in, bool write)
+{
+    audio_graph_obj_t *self = graph_get(self_in);
+    graph_element_t *item = graph_find_obj(self, tag_in);
+    if (item->kind != GRAPH_EL_RAW) {
+        mp_raise_TypeError(MP_ERROR_TEXT("not a raw element"));
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, write ? MP_BUFFER_READ : MP_BUFFER_WRITE);
+    int ret;
+    MP_THREAD_GIL_EXIT();
+    if (write) {
+        ret = raw_stream_write(item->el, bufinfo.buf, bufinfo.len);
+    } else {
+        ret = raw_stream_read(item->el, bufinfo.buf, bufinfo.len);
+    }
+    MP_THREAD_GIL_ENTER();
+    return mp_obj_new_int(ret);
+}
+
+STATIC mp_obj_t audio_graph_readinto(mp_obj_t self_in, mp_obj_t tag_in, mp_obj_t buf_in)
+{
+    return audio_graph_raw_rw(self_in, tag_in, buf_in, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(audio_graph_readinto_obj, audio_graph_readinto);
+
+STATIC mp_obj_t audio_graph_write(mp_obj_t self_in, mp_obj_t tag_in, mp_obj_t buf_in)
+{
+    return audio_graph_raw_rw(self_in, tag_in, buf_in, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(audio_graph_write_obj, audio_graph_write);
+
+STATIC mp_obj_t graph_check_end(mp_obj_t self_in, mp_obj_t arg)
+{
+    audio_graph_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int status = self->status;
+    if (status == AUDIO_STATUS_STOPPED || status == AUDIO_STATUS_FINISHED || status == AUDIO_STATUS_ERROR) {
+        return audio_graph_state(self_in);
+    }
+    return MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t audio_graph_wait(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return audio_async_wait_new(self_in, &self->event, graph_check_end, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_wait_obj, audio_graph_wait);
+
+STATIC mp_obj_t audio_graph_deinit(mp_obj_t self_in)
+{
+    audio_graph_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->pipeline == NULL) {
+        return mp_const_none;
+    }
+    // the pipelines feeding our taps write into ringbuffers destroyed below, stop them and
+    // detach the outputs before ours goes
+    for (int i = 0; i < self->tap_num; i++) {
+        graph_tap_t *tap = &self->taps[i];
+        audio_graph_obj_t *src = MP_OBJ_TO_PTR(tap->src);
+        if (src->pipeline == NULL || src == self) {
+            continue;
+        }
+        graph_halt(src);
+        if (audio_element_set_multi_output_ringbuf(tap->src_el, NULL, tap->index) == ESP_OK) {
+            continue;
+        }
+        // the output can't be cleared, the ringbuffer lives on with the source pipeline
+        // and is destroyed by its deinit
+        if (src->tap_num < GRAPH_MAX_TAPS) {
+            graph_tap_t *kept = &src->taps[src->tap_num++];
+            kept->rb = tap->rb;
+            kept->src = MP_OBJ_FROM_PTR(self);
+            kept->src_el = NULL;
+            kept->index = tap->index;
+        } else {
+            ESP_LOGW(TAG, "%s: leaking the tap of %s", self->name, src->name);
+        }
+        tap->rb = NULL;
+    }
+    MP_THREAD_GIL_EXIT();
+    audio_pipeline_stop(self->pipeline);
+    audio_pipeline_wait_for_stop(self->pipeline);
+    audio_pipeline_terminate(self->pipeline);
+
+    audio_event_iface_msg_t msg = {
+        .source = self,
+        .cmd = GRAPH_CMD_QUIT,
+    };
+    audio_event_iface_cmd(self->evt, &msg);
+    xSemaphoreTake(self->task_done, portMAX_DELAY);
+    vSemaphoreDelete(self->task_done);
+    MP_THREAD_GIL_ENTER();
+
+    for (int i = 0; i < self->element_num; i++) {
+        audio_stack_untrack(self->elements[i].el);
+    }
+    audio_pipeline_remove_listener(self->pipeline);
+    audio_event_iface_destroy(self->evt);
+    // deinit releases the registered elements too
+    audio_pipeline_deinit(self->pipeline);
+    for (int i = 0; i < self->tap_num; i++) {
+        if (self->taps[i].rb != NULL) {
+            rb_destroy(self->taps[i].rb);
+        }
+    }
+
+    self->pipeline = NULL;
+    self->evt = NULL;
+    self->task_done = NULL;
+    self->element_num = 0;
+    self->link_num = 0;
+    self->tap_num = 0;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_graph_deinit_obj, audio_graph_deinit);
+
+STATIC const mp_rom_map_elem_t graph_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_i2s), MP_ROM_PTR(&audio_graph_i2s_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vfs), MP_ROM_PTR(&audio_graph_vfs_obj) },
+    { MP_ROM_QSTR(MP_QSTR_http), MP_ROM_PTR(&audio_graph_http_obj) },
+    { MP_ROM_QSTR(MP_QSTR_raw), MP_ROM_PTR(&audio_graph_raw_obj) },
+    { MP_ROM_QSTR(MP_QSTR_resample), MP_ROM_PTR(&audio_graph_resample_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decoder), MP_ROM_PTR(&audio_graph_decoder_obj) },
+    { MP_ROM_QSTR(MP_QSTR_encoder), MP_ROM_PTR(&audio_graph_encoder_obj) },
+    { MP_ROM_QSTR(MP_QSTR_link), MP_ROM_PTR(&audio_graph_link_obj) },
+    { MP_ROM_QSTR(MP_QSTR_connect), MP_ROM_PTR(&audio_graph_connect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run), MP_ROM_PTR(&audio_graph_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&audio_graph_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&audio_graph_reset_obj) },
+    { MP_ROM_QSTR(MP_QSTR_uri), MP_ROM_PTR(&audio_graph_uri_obj) },
+    { MP_ROM_QSTR(MP_QSTR_info), MP_ROM_PTR(&audio_graph_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&audio_graph_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_state), MP_ROM_PTR(&audio_graph_state_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&audio_graph_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&audio_graph_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&audio_graph_wait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&audio_graph_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&audio_graph_deinit_obj) },
+
+    // audio_stream_type_t
+    { MP_ROM_QSTR(MP_QSTR_READER), MP_ROM_INT(AUDIO_STREAM_READER) },
+    { MP_ROM_QSTR(MP_QSTR_WRITER), MP_ROM_INT(AUDIO_STREAM_WRITER) },
+
+    { MP_ROM_QSTR(MP_QSTR_MP3), MP_ROM_INT(GRAPH_CODEC_MP3) },
+    { MP_ROM_QSTR(MP_QSTR_WAV), MP_ROM_INT(GRAPH_CODEC_WAV) },
+    { MP_ROM_QSTR(MP_QSTR_AMR), MP_ROM_INT(GRAPH_CODEC_AMR) },
+
+    // esp_audio_status_t
+    { MP_ROM_QSTR(MP_QSTR_STATUS_RUNNING), MP_ROM_INT(AUDIO_STATUS_RUNNING) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_PAUSED), MP_ROM_INT(AUDIO_STATUS_PAUSED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_STOPPED), MP_ROM_INT(AUDIO_STATUS_STOPPED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_FINISHED), MP_ROM_INT(AUDIO_STATUS_FINISHED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_ERROR), MP_ROM_INT(AUDIO_STATUS_ERROR) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(graph_locals_dict, graph_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_graph_type,
+    MP_QSTR_Pipeline,
+    MP_TYPE_FLAG_NONE,
+    make_new, audio_graph_make_new,
+    locals_dict, &graph_locals_dict
+    );
@@ -0,0 +1,271 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_mem_stats.h"
+
+#if defined(ESP_PLATFORM) || defined(AUDIO_HOST)
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+#define STATS_LOCK() portENTER_CRITICAL(&stats_lock)
+#define STATS_UNLOCK() portEXIT_CRITICAL(&stats_lock)
+#define STATS_TABLE_ALLOC(size) heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define STATS_TABLE_FREE(ptr) heap_caps_free(ptr)
+#else
+#define STATS_LOCK()
+#define STATS_UNLOCK()
+#define STATS_TABLE_ALLOC(size) calloc(1, size)
+#define STATS_TABLE_FREE(ptr) free(ptr)
+#endif
+
+#define OWNER_TAG_LEN (16)
+#define OWNER_NONE (0xff)
+
+typedef struct {
+    char tag[OWNER_TAG_LEN];
+    uint8_t subsystem;
+    audio_mem_counter_t counter;
+} audio_mem_owner_t;
+
+typedef struct {
+    char name[OWNER_TAG_LEN];
+    audio_mem_counter_t counter;
+} audio_mem_subsystem_t;
+
+typedef struct {
+    void *ptr;
+    uint32_t size : 24;
+    uint32_t owner : 8;
+} audio_mem_entry_t;
+
+static audio_mem_owner_t owners[AUDIO_MEM_STATS_MAX_OWNERS];
+static int owner_num = 0;
+static audio_mem_subsystem_t subsystems[AUDIO_MEM_STATS_MAX_SUBSYSTEMS];
+static int subsystem_num = 0;
+static uint8_t current_subsystem = OWNER_NONE;
+static audio_mem_counter_t total;
+
+static audio_mem_entry_t *table = NULL;
+static bool table_failed = false;
+// allocations that found no slot, they are left out of the counters since their free can't be matched
+static int untracked = 0;
+
+static uint32_t stats_hash(void *ptr)
+{
+    return (uint32_t)(((uintptr_t)ptr >> 3) * 2654435761u) & (AUDIO_MEM_STATS_TABLE_SIZE - 1);
+}
+
+static void counter_add(audio_mem_counter_t *counter, long bytes, int count)
+{
+    counter->bytes += bytes;
+    counter->count += count;
+    if (counter->bytes > counter->peak) {
+        counter->peak = counter->bytes;
+    }
+}
+
+static void stats_account(uint8_t owner, long bytes, int count)
+{
+    counter_add(&total, bytes, count);
+    if (owner == OWNER_NONE) {
+        return;
+    }
+    counter_add(&owners[owner].counter, bytes, count);
+    if (owners[owner].subsystem != OWNER_NONE) {
+        counter_add(&subsystems[owners[owner].subsystem].counter, bytes, count);
+    }
+}
+
+static uint8_t stats_owner(const char *tag)
+{
+    if (tag == NULL) {
+        return OWNER_NONE;
+    }
+    for (int i = 0; i < owner_num; i++) {
+        if (strncmp(owners[i].tag, tag, OWNER_TAG_LEN - 1) == 0) {
+            return i;
+        }
+    }
+    if (owner_num >= AUDIO_MEM_STATS_MAX_OWNERS) {
+        return OWNER_NONE;
+    }
+    audio_mem_owner_t *owner = &owners[owner_num];
+    memset(owner, 0, sizeof(audio_mem_owner_t));
+    strncpy(owner->tag, tag, OWNER_TAG_LEN - 1);
+    owner->subsystem = current_subsystem;
+    return owner_num++;
+}
+
+void audio_mem_stats_subsystem(const char *name)
+{
+    STATS_LOCK();
+    current_subsystem = OWNER_NONE;
+    if (name) {
+        for (int i = 0; i < subsystem_num; i++) {
+            if (strncmp(subsystems[i].name, name, OWNER_TAG_LEN - 1) == 0) {
+                current_subsystem = i;
+            }
+        }
+        if (current_subsystem == OWNER_NONE && subsystem_num < AUDIO_MEM_STATS_MAX_SUBSYSTEMS) {
+            memset(&subsystems[subsystem_num], 0, sizeof(audio_mem_subsystem_t));
+            strncpy(subsystems[subsystem_num].name, name, OWNER_TAG_LEN - 1);
+            current_subsystem = subsystem_num++;
+        }
+    }
+    STATS_UNLOCK();
+}
+
+void audio_mem_stats_alloc(void *ptr, size_t size, const char *tag)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    if (table == NULL && !table_failed) {
+        // allocated outside the lock, the task that loses the race frees its copy
+        audio_mem_entry_t *fresh = STATS_TABLE_ALLOC(AUDIO_MEM_STATS_TABLE_SIZE * sizeof(audio_mem_entry_t));
+        STATS_LOCK();
+        if (table == NULL) {
+            table = fresh;
+            table_failed = fresh == NULL;
+            fresh = NULL;
+        }
+        STATS_UNLOCK();
+        if (fresh) {
+            STATS_TABLE_FREE(fresh);
+        }
+    }
+    STATS_LOCK();
+    bool stored = false;
+    uint8_t owner = stats_owner(tag);
+    if (table) {
+        uint32_t i = stats_hash(ptr);
+        for (int n = 0; n < AUDIO_MEM_STATS_TABLE_SIZE; n++, i = (i + 1) & (AUDIO_MEM_STATS_TABLE_SIZE - 1)) {
+            if (table[i].ptr == ptr) {
+                // freed behind our back and handed out again, drop the stale entry
+                stats_account(table[i].owner, -(long)table[i].size, -1);
+            } else if (table[i].ptr != NULL) {
+                continue;
+            }
+            table[i].ptr = ptr;
+            table[i].size = size;
+            table[i].owner = owner;
+            stored = true;
+            break;
+        }
+    }
+    if (stored) {
+        stats_account(owner, size, 1);
+    } else {
+        untracked++;
+    }
+    STATS_UNLOCK();
+}
+
+void audio_mem_stats_free(void *ptr)
+{
+    if (ptr == NULL || table == NULL) {
+        return;
+    }
+    STATS_LOCK();
+    uint32_t mask = AUDIO_MEM_STATS_TABLE_SIZE - 1;
+    uint32_t i = stats_hash(ptr);
+    int n = 0;
+    while (table[i].ptr != ptr && table[i].ptr != NULL && n++ < AUDIO_MEM_STATS_TABLE_SIZE) {
+        i = (i + 1) & mask;
+    }
+    if (table[i].ptr == ptr) {
+        stats_account(table[i].owner, -(long)table[i].size, -1);
+        // backward shift deletion keeps the probe sequences intact, the hole ends the scan
+        // even when the table was full
+        table[i].ptr = NULL;
+        uint32_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (table[j].ptr == NULL) {
+                break;
+            }
+            uint32_t k = stats_hash(table[j].ptr);
+            if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+                table[i] = table[j];
+                table[j].ptr = NULL;
+                i = j;
+            }
+        }
+    }
+    STATS_UNLOCK();
+}
+
+void audio_mem_stats_total(audio_mem_counter_t *counter)
+{
+    STATS_LOCK();
+    *counter = total;
+    STATS_UNLOCK();
+}
+
+int audio_mem_stats_untracked(void)
+{
+    return untracked;
+}
+
+bool audio_mem_stats_owner(int index, const char **tag, const char **subsystem, audio_mem_counter_t *counter)
+{
+    if (index < 0 || index >= owner_num) {
+        return false;
+    }
+    STATS_LOCK();
+    *tag = owners[index].tag;
+    *subsystem = owners[index].subsystem == OWNER_NONE ? NULL : subsystems[owners[index].subsystem].name;
+    *counter = owners[index].counter;
+    STATS_UNLOCK();
+    return true;
+}
+
+bool audio_mem_stats_subsystem_get(int index, const char **name, audio_mem_counter_t *counter)
+{
+    if (index < 0 || index >= subsystem_num) {
+        return false;
+    }
+    STATS_LOCK();
+    *name = subsystems[index].name;
+    *counter = subsystems[index].counter;
+    STATS_UNLOCK();
+    return true;
+}
+
+void audio_mem_stats_reset_peak(void)
+{
+    STATS_LOCK();
+    total.peak = total.bytes;
+    for (int i = 0; i < owner_num; i++) {
+        owners[i].counter.peak = owners[i].counter.bytes;
+    }
+    for (int i = 0; i < subsystem_num; i++) {
+        subsystems[i].counter.peak = subsystems[i].counter.bytes;
+    }
+    STATS_UNLOCK();
+}
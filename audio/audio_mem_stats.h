@@ -0,0 +1,103 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_MEM_STATS_H_
+#define _AUDIO_MEM_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_MEM_STATS_MAX_OWNERS (24)
+#define AUDIO_MEM_STATS_MAX_SUBSYSTEMS (4)
+#define AUDIO_MEM_STATS_TABLE_SIZE (1024)
+
+/**
+ * @brief   Allocation counters of an owner (element tag or subsystem)
+ */
+typedef struct {
+    size_t bytes; /*!< Bytes currently allocated */
+    size_t peak;  /*!< Highest `bytes` since the last reset */
+    int count;    /*!< Live allocations */
+} audio_mem_counter_t;
+
+/**
+ * @brief      Set the subsystem ("player", "recorder", ...) that owns the tags seen for the
+ *             first time from now on, NULL to stop binding
+ */
+void audio_mem_stats_subsystem(const char *name);
+
+/**
+ * @brief      Record an allocation made by `tag`
+ */
+void audio_mem_stats_alloc(void *ptr, size_t size, const char *tag);
+
+/**
+ * @brief      Record the release of an allocation, unknown pointers are ignored
+ */
+void audio_mem_stats_free(void *ptr);
+
+/**
+ * @brief      Get the counters of all allocations
+ */
+void audio_mem_stats_total(audio_mem_counter_t *counter);
+
+/**
+ * @brief      Number of allocations left out of the counters because the table was full
+ *             or could not be allocated, raise AUDIO_MEM_STATS_TABLE_SIZE when it is not 0
+ */
+int audio_mem_stats_untracked(void);
+
+/**
+ * @brief      Iterate over the owner tags
+ *
+ * @param      index      Index of the owner, from 0
+ * @param      tag        Returns the owner tag
+ * @param      subsystem  Returns the subsystem name, NULL if not bound
+ * @param      counter    Returns the counters
+ *
+ * @return     false when index is out of range
+ */
+bool audio_mem_stats_owner(int index, const char **tag, const char **subsystem, audio_mem_counter_t *counter);
+
+/**
+ * @brief      Iterate over the subsystems
+ *
+ * @return     false when index is out of range
+ */
+bool audio_mem_stats_subsystem_get(int index, const char **name, audio_mem_counter_t *counter);
+
+/**
+ * @brief      Restart all peak measurements from the current usage
+ */
+void audio_mem_stats_reset_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_meter.h"
+
+static const char *TAG = "METER";
+
+#define METER_HALF (AUDIO_METER_FFT_SIZE / 2)
+// a full scale sine in the middle of a bin comes out of the FFT below at 1/8 amplitude
+#define METER_BIN_GAIN (8)
+
+// Q15 twiddles for the 256 point transform, the 128 point one uses every other entry
+static int16_t meter_cos[METER_HALF];
+static int16_t meter_sin[METER_HALF];
+static int16_t meter_hann[AUDIO_METER_FFT_SIZE];
+static bool meter_tables_ready;
+
+typedef struct {
+    audio_meter_t *meter;
+    int channels;
+    int rate;
+} audio_meter_el_t;
+
+static void _meter_tables(void)
+{
+    if (meter_tables_ready) {
+        return;
+    }
+    for (int k = 0; k < METER_HALF; k++) {
+        float a = 2.0f * (float)M_PI * k / AUDIO_METER_FFT_SIZE;
+        meter_cos[k] = (int16_t)lrintf(32767.0f * cosf(a));
+        meter_sin[k] = (int16_t)lrintf(32767.0f * sinf(a));
+    }
+    for (int n = 0; n < AUDIO_METER_FFT_SIZE; n++) {
+        float a = 2.0f * (float)M_PI * n / AUDIO_METER_FFT_SIZE;
+        meter_hann[n] = (int16_t)lrintf(16383.5f * (1.0f - cosf(a)));
+    }
+    meter_tables_ready = true;
+}
+
+static uint32_t _meter_isqrt(uint32_t x)
+{
+    uint32_t r = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+// radix-2 complex FFT over METER_HALF points, halving every stage so nothing overflows
+static void _meter_fft(int16_t *re, int16_t *im)
+{
+    for (int i = 1, j = 0; i < METER_HALF; i++) {
+        int bit = METER_HALF >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            int16_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    for (int len = 2; len <= METER_HALF; len <<= 1) {
+        int half = len >> 1;
+        int step = AUDIO_METER_FFT_SIZE / len;
+        for (int j = 0; j < half; j++) {
+            int32_t wr = meter_cos[j * step];
+            int32_t wi = -meter_sin[j * step];
+            for (int a = j; a < METER_HALF; a += len) {
+                int b = a + half;
+                int32_t tr = (re[b] * wr - im[b] * wi) >> 15;
+                int32_t ti = (re[b] * wi + im[b] * wr) >> 15;
+                int32_t ar = re[a];
+                int32_t ai = im[a];
+                re[b] = (int16_t)((ar - tr) >> 1);
+                im[b] = (int16_t)((ai - ti) >> 1);
+                re[a] = (int16_t)((ar + tr) >> 1);
+                im[a] = (int16_t)((ai + ti) >> 1);
+            }
+        }
+    }
+}
+
+// The real input is packed two samples per complex point, so the 256 point spectrum
+// costs a 128 point transform plus one split pass.
+static void _meter_spectrum(audio_meter_t *meter, int16_t *bands)
+{
+    int pos = meter->hist_pos;
+    for (int n = 0; n < METER_HALF; n++) {
+        int i0 = (pos + 2 * n) & (AUDIO_METER_FFT_SIZE - 1);
+        int i1 = (pos + 2 * n + 1) & (AUDIO_METER_FFT_SIZE - 1);
+        // halved so the butterflies stay in range whatever the phase
+        meter->re[n] = (int16_t)((meter->hist[i0] * meter_hann[2 * n]) >> 16);
+        meter->im[n] = (int16_t)((meter->hist[i1] * meter_hann[2 * n + 1]) >> 16);
+    }
+    _meter_fft(meter->re, meter->im);
+
+    int band = 0;
+    int level = 0;
+    for (int k = meter->edges[0]; k < meter->edges[meter->bands_num]; k++) {
+        int32_t zr = meter->re[k];
+        int32_t zi = meter->im[k];
+        int32_t cr = meter->re[METER_HALF - k];
+        int32_t ci = -meter->im[METER_HALF - k];
+        // even and odd sample spectra, then X[k] = E[k] + W^k O[k]
+        int32_t er = (zr + cr) >> 1;
+        int32_t ei = (zi + ci) >> 1;
+        int32_t or_ = (zi - ci) >> 1;
+        int32_t oi = (cr - zr) >> 1;
+        int32_t wr = meter_cos[k];
+        int32_t wi = -meter_sin[k];
+        int32_t xr = (er + ((or_ * wr - oi * wi) >> 15)) >> 1;
+        int32_t xi = (ei + ((or_ * wi + oi * wr) >> 15)) >> 1;
+        int mag = (int)_meter_isqrt((uint32_t)(xr * xr) + (uint32_t)(xi * xi)) * METER_BIN_GAIN;
+        if (mag > level) {
+            level = mag;
+        }
+        if (k + 1 == meter->edges[band + 1]) {
+            bands[band++] = (int16_t)(level > 32767 ? 32767 : level);
+            level = 0;
+        }
+    }
+}
+
+static void _meter_publish(audio_meter_t *meter, int samples)
+{
+    int16_t bands[AUDIO_METER_MAX_BANDS];
+    if (meter->bands_num) {
+        _meter_spectrum(meter, bands);
+    }
+    int rms = (int)_meter_isqrt((uint32_t)(meter->sum / samples));
+    audio_meter_levels_t *lv = &meter->levels;
+    // readers retry while seq is odd or changed under them
+    lv->seq++;
+    lv->peak = (int16_t)(meter->peak > 32767 ? 32767 : meter->peak);
+    lv->rms = (int16_t)(rms > 32767 ? 32767 : rms);
+    for (int b = 0; b < meter->bands_num; b++) {
+        lv->bands[b] = bands[b];
+    }
+    lv->seq++;
+    meter->count = 0;
+    meter->peak = 0;
+    meter->sum = 0;
+}
+
+void audio_meter_setup(audio_meter_t *meter, int bands, int interval_ms)
+{
+    _meter_tables();
+    memset(meter, 0, sizeof(audio_meter_t));
+    if (bands < 0) {
+        bands = 0;
+    } else if (bands > AUDIO_METER_MAX_BANDS) {
+        bands = AUDIO_METER_MAX_BANDS;
+    }
+    meter->bands_num = bands;
+    meter->levels.bands_num = bands;
+    meter->interval_ms = interval_ms > AUDIO_METER_MIN_INTERVAL_MS ? interval_ms : AUDIO_METER_MIN_INTERVAL_MS;
+    // log spaced from the first bin to Nyquist, at least one bin each
+    meter->edges[0] = 1;
+    for (int b = 1; b <= bands; b++) {
+        int edge = (int)lrintf(powf((float)METER_HALF, (float)b / bands));
+        if (edge <= meter->edges[b - 1]) {
+            edge = meter->edges[b - 1] + 1;
+        }
+        if (edge > METER_HALF - (bands - b)) {
+            edge = METER_HALF - (bands - b);
+        }
+        meter->edges[b] = (uint8_t)edge;
+    }
+}
+
+void audio_meter_feed(audio_meter_t *meter, const int16_t *pcm, int frames, int channels, int rate)
+{
+    if (rate != meter->rate) {
+        meter->rate = rate;
+        meter->window = rate * meter->interval_ms / 1000;
+        meter->count = 0;
+        meter->peak = 0;
+        meter->sum = 0;
+    }
+    while (frames > 0) {
+        int n = meter->window - meter->count;
+        if (n > frames) {
+            n = frames;
+        }
+        int samples = n * channels;
+        // two accumulators to keep the multiplies independent
+        int peak = meter->peak;
+        uint64_t sum0 = 0;
+        uint64_t sum1 = 0;
+        int i = 0;
+        for (; i + 1 < samples; i += 2) {
+            int32_t x0 = pcm[i];
+            int32_t x1 = pcm[i + 1];
+            sum0 += (uint32_t)(x0 * x0);
+            sum1 += (uint32_t)(x1 * x1);
+            x0 = x0 < 0 ? -x0 : x0;
+            x1 = x1 < 0 ? -x1 : x1;
+            peak = x0 > peak ? x0 : peak;
+            peak = x1 > peak ? x1 : peak;
+        }
+        if (i < samples) {
+            int32_t x0 = pcm[i];
+            sum0 += (uint32_t)(x0 * x0);
+            x0 = x0 < 0 ? -x0 : x0;
+            peak = x0 > peak ? x0 : peak;
+        }
+        meter->peak = peak;
+        meter->sum += sum0 + sum1;
+        meter->count += n;
+
+        if (meter->bands_num) {
+            int pos = meter->hist_pos;
+            for (int f = 0; f < n; f++) {
+                const int16_t *s = pcm + f * channels;
+                meter->hist[pos] = channels == 2 ? (int16_t)((s[0] + s[1]) >> 1) : s[0];
+                pos = (pos + 1) & (AUDIO_METER_FFT_SIZE - 1);
+            }
+            meter->hist_pos = pos;
+        }
+        if (meter->count >= meter->window) {
+            _meter_publish(meter, meter->count * channels);
+        }
+        pcm += samples;
+        frames -= n;
+    }
+}
+
+static int _meter_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_meter_el_t *el = (audio_meter_el_t *)audio_element_getdata(self);
+    int frame_size = el->channels * sizeof(int16_t);
+    // whole frames only, a partial one only shows up at the end of the stream
+    int r_size = audio_element_input(self, in_buffer, in_len - in_len % frame_size);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    audio_meter_feed(el->meter, (const int16_t *)in_buffer, r_size / frame_size, el->channels, el->rate);
+    return audio_element_output(self, in_buffer, r_size);
+}
+
+static esp_err_t _meter_close(audio_element_handle_t self)
+{
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _meter_destroy(audio_element_handle_t self)
+{
+    audio_meter_el_t *el = (audio_meter_el_t *)audio_element_getdata(self);
+    audio_free(el);
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_meter_init(audio_meter_cfg_t *config)
+{
+    if (config->meter == NULL || config->channels < 1 || config->channels > 2 || config->sample_rate < 1000) {
+        ESP_LOGE(TAG, "Unsupported format %d/%d", config->sample_rate, config->channels);
+        return NULL;
+    }
+    audio_element_handle_t el;
+    audio_meter_el_t *meter_el = audio_calloc(1, sizeof(audio_meter_el_t));
+
+    AUDIO_MEM_CHECK(TAG, meter_el, return NULL);
+
+    meter_el->meter = config->meter;
+    meter_el->channels = config->channels;
+    meter_el->rate = config->sample_rate;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.close = _meter_close;
+    cfg.process = _meter_process;
+    cfg.destroy = _meter_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = config->buf_sz;
+    cfg.tag = "meter";
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _meter_init_exit);
+    audio_element_setdata(el, meter_el);
+    return el;
+_meter_init_exit:
+    audio_free(meter_el);
+    return NULL;
+}
+
+void audio_meter_slot_set(audio_meter_slot_t *slot, audio_meter_t *meter)
+{
+    slot->meter = meter;
+    // a feed that started before the swap may still hold the old meter
+    while (slot->busy) {
+        vTaskDelay(1);
+    }
+}
+
+void audio_meter_slot_feed(audio_meter_slot_t *slot, const int16_t *pcm, int frames, int channels, int rate)
+{
+    slot->busy = true;
+    audio_meter_t *meter = slot->meter;
+    if (meter != NULL) {
+        audio_meter_feed(meter, pcm, frames, channels, rate);
+    }
+    slot->busy = false;
+}
+
+static int _meter_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    audio_meter_slot_t *slot = (audio_meter_slot_t *)context;
+    if (slot->meter != NULL && slot->channels > 0) {
+        int frame_size = slot->channels * sizeof(int16_t);
+        audio_meter_slot_feed(slot, (const int16_t *)buffer, len / frame_size, slot->channels, slot->rate);
+    }
+    return slot->write(self, buffer, len, ticks_to_wait, NULL);
+}
+
+esp_err_t audio_meter_hook_writer(audio_element_handle_t el, audio_meter_slot_t *slot)
+{
+    stream_func write = audio_element_get_write_cb(el);
+    if (write == NULL) {
+        ESP_LOGE(TAG, "%s has no write callback", audio_element_get_tag(el));
+        return ESP_FAIL;
+    }
+    if (write != _meter_write) {
+        slot->write = write;
+    }
+    return audio_element_set_write_cb(el, _meter_write, slot);
+}
@@ -0,0 +1,162 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_METER_H_
+#define _AUDIO_METER_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_METER_FFT_BITS (8)
+#define AUDIO_METER_FFT_SIZE (1 << AUDIO_METER_FFT_BITS)
+#define AUDIO_METER_MAX_BANDS (16)
+#define AUDIO_METER_MIN_INTERVAL_MS (10)
+#define AUDIO_METER_BUF_SIZE (2048)
+#define AUDIO_METER_TASK_STACK (2048)
+#define AUDIO_METER_TASK_CORE (1)
+#define AUDIO_METER_TASK_PRIO (5)
+#define AUDIO_METER_RINGBUFFER_SIZE (4 * 1024)
+
+/**
+ * @brief   Published levels, all 16 bit so the whole struct reads as one int16 array.
+ *          seq is odd while an update is being written.
+ */
+typedef struct {
+    volatile int16_t seq;                           /*!< Update counter */
+    volatile int16_t peak;                          /*!< Largest magnitude over the interval, 0..32767 */
+    volatile int16_t rms;                           /*!< RMS over the interval, 0..32767 */
+    volatile int16_t bands_num;                     /*!< Number of valid entries in bands */
+    volatile int16_t bands[AUDIO_METER_MAX_BANDS];  /*!< Sine amplitude of the loudest bin per band, 0..32767 */
+} audio_meter_levels_t;
+
+/**
+ * @brief   Meter state, levels comes first so its address is the meter's
+ */
+typedef struct audio_meter {
+    audio_meter_levels_t levels;
+    int interval_ms;
+    int bands_num;
+    uint8_t edges[AUDIO_METER_MAX_BANDS + 1];  // FFT bin range of each band
+    // the interval in progress
+    int rate;
+    int window;
+    int count;
+    int peak;
+    uint64_t sum;
+    // last FFT_SIZE mono samples and the FFT work area
+    int hist_pos;
+    int16_t hist[AUDIO_METER_FFT_SIZE];
+    int16_t re[AUDIO_METER_FFT_SIZE / 2];
+    int16_t im[AUDIO_METER_FFT_SIZE / 2];
+} audio_meter_t;
+
+/**
+ * @brief   A meter slot read by an output task, see audio_meter_slot_set()
+ */
+typedef struct {
+    audio_meter_t *volatile meter;
+    volatile bool busy;
+    int rate;            /*!< Format of the hooked writer's data */
+    int channels;
+    stream_func write;   /*!< The writer's own callback, set by audio_meter_hook_writer() */
+} audio_meter_slot_t;
+
+/**
+ * @brief   Meter element configuration, 16 bit PCM in and the same out
+ */
+typedef struct {
+    audio_meter_t *meter; /*!< Where the levels go, must outlive the element */
+    int channels;         /*!< Input channels, 1 or 2 */
+    int sample_rate;      /*!< Input sample rate */
+    int buf_sz;           /*!< Audio Element Buffer size */
+    int out_rb_size;      /*!< Size of output ringbuffer */
+    int task_stack;       /*!< Task stack size */
+    int task_core;        /*!< Task running in core (0 or 1) */
+    int task_prio;        /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;    /*!< Try to allocate stack in external memory */
+} audio_meter_cfg_t;
+
+#define AUDIO_METER_CFG_DEFAULT()                   \
+{                                                   \
+    .meter = NULL,                                  \
+    .channels = 1,                                  \
+    .sample_rate = 16000,                           \
+    .buf_sz = AUDIO_METER_BUF_SIZE,                 \
+    .out_rb_size = AUDIO_METER_RINGBUFFER_SIZE,     \
+    .task_stack = AUDIO_METER_TASK_STACK,           \
+    .task_core = AUDIO_METER_TASK_CORE,             \
+    .task_prio = AUDIO_METER_TASK_PRIO,             \
+    .stack_in_ext = false,                          \
+}
+
+/**
+ * @brief      Set up a meter, the memory is owned by the caller
+ *
+ * @param      meter        The meter
+ * @param      bands        Spectrum bands, log spaced over a 256 point FFT, 0 for peak and RMS only
+ * @param      interval_ms  Time between updates of the levels
+ */
+void audio_meter_setup(audio_meter_t *meter, int bands, int interval_ms);
+
+/**
+ * @brief      Measure 16 bit PCM, publishes the levels every interval. Stereo is
+ *             measured over both channels and analysed as the mono mix.
+ */
+void audio_meter_feed(audio_meter_t *meter, const int16_t *pcm, int frames, int channels, int rate);
+
+/**
+ * @brief      Create an Audio Element that passes its input on unchanged and feeds it to a meter
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_meter_init(audio_meter_cfg_t *config);
+
+/**
+ * @brief      Swap the meter of a slot, returns once the previous meter is no longer in use
+ */
+void audio_meter_slot_set(audio_meter_slot_t *slot, audio_meter_t *meter);
+
+/**
+ * @brief      Feed the meter of a slot if there is one
+ */
+void audio_meter_slot_feed(audio_meter_slot_t *slot, const int16_t *pcm, int frames, int channels, int rate);
+
+/**
+ * @brief      Meter the output of a callback-writing element, such as an I2S writer,
+ *             by wrapping its write callback. The slot must outlive the element, and the
+ *             wrapped callback is called without its context, which the ADF stream
+ *             writers don't use.
+ */
+esp_err_t audio_meter_hook_writer(audio_element_handle_t el, audio_meter_slot_t *slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "driver/i2s.h"
+#include "esp_log.h"
+
+#include "audio_mem.h"
+
+#include "audio_pcm_out.h"
+#include "audio_placement.h"
+#include "audio_stack.h"
+
+static const char *TAG = "AUDIO_PCM_OUT";
+
+// the largest source frame is 32 bit stereo, 16 bit stereo output never needs more room
+#define PCM_OUT_MAX_FRAME_SIZE (8)
+
+typedef struct {
+    audio_pcm_out_cfg_t cfg;
+    uint8_t *buf;
+    int frame_size;
+    volatile bool running;
+    volatile bool stopping;
+    volatile bool paused;
+    volatile int bytes;
+    SemaphoreHandle_t done;
+} audio_pcm_out_t;
+
+static audio_pcm_out_t pcm_out;
+
+bool audio_pcm_out_supported(int channels, int bits)
+{
+    return (channels == 1 || channels == 2) && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+}
+
+int audio_pcm_out_convert(uint8_t *buf, int frames, int channels, int bits)
+{
+    int samples = frames * channels;
+    int16_t *out = (int16_t *)buf;
+    if (bits == 8) {
+        // growing, convert from the end
+        for (int i = samples - 1; i >= 0; i--) {
+            out[i] = (int16_t)((buf[i] - 128) * 256);
+        }
+    } else if (bits == 24 || bits == 32) {
+        // shrinking, keep the high 16 bits from the start
+        int step = bits / 8;
+        for (int i = 0; i < samples; i++) {
+            const uint8_t *in = buf + i * step + step - 2;
+            out[i] = (int16_t)(in[0] | (in[1] << 8));
+        }
+    }
+    if (channels == 1) {
+        for (int i = frames - 1; i >= 0; i--) {
+            out[2 * i + 1] = out[i];
+            out[2 * i] = out[i];
+        }
+    }
+    return frames * 2 * sizeof(int16_t);
+}
+
+static void audio_pcm_out_task(void *arg)
+{
+    audio_pcm_out_cfg_t *cfg = &pcm_out.cfg;
+    int chunk = AUDIO_PCM_OUT_FRAMES * pcm_out.frame_size;
+    int have = 0;
+    bool paused = false;
+    audio_pcm_out_status_t status = AUDIO_PCM_OUT_FINISHED;
+
+    while (!pcm_out.stopping) {
+        if (pcm_out.paused) {
+            if (!paused) {
+                i2s_zero_dma_buffer(cfg->i2s_port);
+                paused = true;
+            }
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+        paused = false;
+
+        int rlen = cfg->read(pcm_out.buf + have, chunk - have, cfg->ctx);
+        if (rlen < 0) {
+            status = AUDIO_PCM_OUT_ERROR;
+            break;
+        }
+        if (rlen == 0) {
+            break;
+        }
+        have += rlen;
+        int frames = have / pcm_out.frame_size;
+        if (frames == 0) {
+            continue;
+        }
+        // a partial frame would be overwritten by a growing conversion, keep it aside
+        uint8_t rest[PCM_OUT_MAX_FRAME_SIZE];
+        int rest_len = have - frames * pcm_out.frame_size;
+        memcpy(rest, pcm_out.buf + frames * pcm_out.frame_size, rest_len);
+
+        int out_len = audio_pcm_out_convert(pcm_out.buf, frames, cfg->channels, cfg->bits);
+        if (cfg->meter != NULL) {
+            audio_meter_slot_feed(cfg->meter, (const int16_t *)pcm_out.buf, frames, 2, cfg->sample_rate);
+        }
+        size_t written = 0;
+        if (i2s_write(cfg->i2s_port, pcm_out.buf, out_len, &written, portMAX_DELAY) != ESP_OK) {
+            status = AUDIO_PCM_OUT_ERROR;
+            break;
+        }
+        if (cfg->mirror != NULL) {
+            audio_tee_slot_feed(cfg->mirror, (const char *)pcm_out.buf, out_len, cfg->sample_rate);
+        }
+        pcm_out.bytes += frames * pcm_out.frame_size;
+
+        memcpy(pcm_out.buf, rest, rest_len);
+        have = rest_len;
+    }
+    if (pcm_out.stopping) {
+        status = AUDIO_PCM_OUT_STOPPED;
+        i2s_zero_dma_buffer(cfg->i2s_port);
+    }
+    ESP_LOGD(TAG, "end %d, %d bytes", status, pcm_out.bytes);
+
+    audio_stack_sample_tag("pcm");
+    if (cfg->done) {
+        cfg->done(status, cfg->ctx);
+    }
+    audio_free(pcm_out.buf);
+    pcm_out.buf = NULL;
+    // a start() right after stop() returns must see the task gone
+    pcm_out.running = false;
+    xSemaphoreGive(pcm_out.done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_pcm_out_start(const audio_pcm_out_cfg_t *cfg)
+{
+    if (pcm_out.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cfg->read == NULL || !audio_pcm_out_supported(cfg->channels, cfg->bits)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pcm_out.done == NULL) {
+        pcm_out.done = xSemaphoreCreateBinary();
+    }
+    // drop the notification of a task that ended by itself
+    xSemaphoreTake(pcm_out.done, 0);
+
+    memcpy(&pcm_out.cfg, cfg, sizeof(audio_pcm_out_cfg_t));
+    pcm_out.frame_size = cfg->channels * cfg->bits / 8;
+    pcm_out.bytes = 0;
+    pcm_out.stopping = false;
+    pcm_out.paused = false;
+
+    audio_placement_enter("pcm", AUDIO_PLACE_KIND_BUF);
+    pcm_out.buf = audio_calloc(1, AUDIO_PCM_OUT_FRAMES * PCM_OUT_MAX_FRAME_SIZE);
+    audio_placement_exit();
+    if (pcm_out.buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2s_set_clk(cfg->i2s_port, cfg->sample_rate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
+
+    pcm_out.running = true;
+    int stack = audio_stack_size("pcm", NULL, cfg->task_stack);
+    if (xTaskCreatePinnedToCore(audio_pcm_out_task, "pcm", stack, NULL, cfg->task_prio, NULL, cfg->task_core) != pdPASS) {
+        ESP_LOGE(TAG, "task create failed");
+        pcm_out.running = false;
+        audio_free(pcm_out.buf);
+        pcm_out.buf = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pcm_out_stop(void)
+{
+    if (!pcm_out.running) {
+        return ESP_OK;
+    }
+    pcm_out.stopping = true;
+    xSemaphoreTake(pcm_out.done, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t audio_pcm_out_pause(bool pause)
+{
+    if (!pcm_out.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pcm_out.paused = pause;
+    return ESP_OK;
+}
+
+bool audio_pcm_out_running(void)
+{
+    return pcm_out.running;
+}
+
+bool audio_pcm_out_paused(void)
+{
+    return pcm_out.running && pcm_out.paused;
+}
+
+int audio_pcm_out_bytes(void)
+{
+    return pcm_out.bytes;
+}
+
+int audio_pcm_out_time(void)
+{
+    if (pcm_out.frame_size == 0 || pcm_out.cfg.sample_rate == 0) {
+        return 0;
+    }
+    return (int)((int64_t)pcm_out.bytes / pcm_out.frame_size * 1000 / pcm_out.cfg.sample_rate);
+}
@@ -0,0 +1,160 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_PCM_OUT_H_
+#define _AUDIO_PCM_OUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "audio_meter.h"
+#include "audio_tee.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_PCM_OUT_FRAMES (512)
+#define AUDIO_PCM_OUT_TASK_STACK (3072)
+#define AUDIO_PCM_OUT_TASK_PRIO (23)
+#define AUDIO_PCM_OUT_TASK_CORE (1)
+
+/**
+ * @brief   Why the output task ended
+ */
+typedef enum {
+    AUDIO_PCM_OUT_FINISHED,
+    AUDIO_PCM_OUT_STOPPED,
+    AUDIO_PCM_OUT_ERROR,
+} audio_pcm_out_status_t;
+
+/**
+ * @brief      Fill the buffer with source PCM, called from the output task
+ *
+ * @return     Number of bytes read, 0 at the end of the source, negative on error
+ */
+typedef int (*audio_pcm_out_read_cb)(uint8_t *buf, int len, void *ctx);
+
+/**
+ * @brief      Called from the output task once before it exits
+ */
+typedef void (*audio_pcm_out_done_cb)(audio_pcm_out_status_t status, void *ctx);
+
+/**
+ * @brief   PCM output configuration
+ */
+typedef struct {
+    int i2s_port;               /*!< I2S port the driver is installed on */
+    int sample_rate;            /*!< Sample rate, the driver clock is set to it */
+    int channels;               /*!< Source channels, 1 or 2 */
+    int bits;                   /*!< Source bits per sample, 8, 16, 24 or 32 */
+    audio_pcm_out_read_cb read; /*!< Source of the PCM data */
+    audio_pcm_out_done_cb done; /*!< End notification, may be NULL */
+    void *ctx;                  /*!< Passed to the callbacks */
+    audio_meter_slot_t *meter;  /*!< Fed with the converted output, may be NULL */
+    audio_tee_slot_t *mirror;   /*!< Fed with what was written to I2S, may be NULL */
+    int task_stack;             /*!< Task stack size */
+    int task_prio;              /*!< Task priority */
+    int task_core;              /*!< Task core */
+} audio_pcm_out_cfg_t;
+
+#define AUDIO_PCM_OUT_CFG_DEFAULT() {             \
+    .i2s_port = 0,                                \
+    .sample_rate = 48000,                         \
+    .channels = 2,                                \
+    .bits = 16,                                   \
+    .read = NULL,                                 \
+    .done = NULL,                                 \
+    .ctx = NULL,                                  \
+    .meter = NULL,                                \
+    .mirror = NULL,                               \
+    .task_stack = AUDIO_PCM_OUT_TASK_STACK,       \
+    .task_prio = AUDIO_PCM_OUT_TASK_PRIO,         \
+    .task_core = AUDIO_PCM_OUT_TASK_CORE,         \
+}
+
+/**
+ * @brief      Check whether a source format can be written without a decoder
+ */
+bool audio_pcm_out_supported(int channels, int bits);
+
+/**
+ * @brief      Convert whole frames in place to 16 bit stereo
+ *
+ * @param      buf       The frames, must have room for the converted data
+ * @param      frames    Number of frames
+ * @param      channels  Source channels, 1 or 2
+ * @param      bits      Source bits per sample, 8 bit samples are unsigned
+ *
+ * @return     Size of the converted data in bytes
+ */
+int audio_pcm_out_convert(uint8_t *buf, int frames, int channels, int bits);
+
+/**
+ * @brief      Start writing PCM to the I2S driver from a dedicated task,
+ *             nothing else may write to the driver until the task ends
+ *
+ * @param      cfg   The configuration
+ *
+ * @return     ESP_ERR_INVALID_STATE if already running
+ */
+esp_err_t audio_pcm_out_start(const audio_pcm_out_cfg_t *cfg);
+
+/**
+ * @brief      Stop the output and wait for the task to end
+ */
+esp_err_t audio_pcm_out_stop(void);
+
+/**
+ * @brief      Pause or resume the output
+ */
+esp_err_t audio_pcm_out_pause(bool pause);
+
+/**
+ * @brief      Check whether the output task is running
+ */
+bool audio_pcm_out_running(void);
+
+/**
+ * @brief      Check whether the output is paused
+ */
+bool audio_pcm_out_paused(void);
+
+/**
+ * @brief      Number of source bytes written since the start
+ */
+int audio_pcm_out_bytes(void);
+
+/**
+ * @brief      Playing time since the start in ms
+ */
+int audio_pcm_out_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,603 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "py/mpthread.h"
+#include "py/runtime.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "audio_common.h"
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "esp_audio.h"
+
+#include "audio_hal.h"
+#include "board.h"
+
+#include "amr_decoder.h"
+#include "mp3_decoder.h"
+#include "wav_decoder.h"
+
+#include "http_stream.h"
+#include "i2s_stream.h"
+#include "vfs_stream.h"
+
+#include "audio_async.h"
+#include "audio_mem_stats.h"
+#include "audio_placement.h"
+#include "audio_stack.h"
+
+#define PIPELINE_PLAYER_TASK_STACK (3072)
+#define PIPELINE_PLAYER_TASK_PRIO (5)
+#define PIPELINE_PLAYER_CMD_QUIT (0x7f00)
+
+static const char *TAG = "PIPELINE_PLAYER";
+
+enum {
+    PIPELINE_SOURCE_HTTP,
+    PIPELINE_SOURCE_FILE,
+};
+
+enum {
+    PIPELINE_CODEC_MP3,
+    PIPELINE_CODEC_WAV,
+    PIPELINE_CODEC_AMR,
+};
+
+const mp_obj_type_t audio_pipeline_player_type;
+
+// A fixed reader->decoder->i2s pipeline for deployments that play a single format, the
+// elements are created once and reused for every uri, events are handled by a background task
+typedef struct _audio_pipeline_player_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t callback;
+
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t reader;
+    audio_element_handle_t decoder;
+    audio_element_handle_t writer;
+    audio_event_iface_handle_t evt;
+    SemaphoreHandle_t task_done;
+
+    esp_audio_state_t state;
+    audio_async_event_t event;
+    // set by play until the writer reports running, the stop of the previous uri may still be queued
+    volatile bool starting;
+
+    int create_us;
+    int create_bytes;
+    int64_t start_time;
+    int start_us;
+} audio_pipeline_player_obj_t;
+
+STATIC void pipeline_player_set_state(audio_pipeline_player_obj_t *self, esp_audio_status_t status, int err_msg)
+{
+    self->state.status = status;
+    self->state.err_msg = err_msg;
+    audio_async_event_set(&self->event);
+    if (self->callback != mp_const_none) {
+        mp_obj_dict_t *dict = mp_obj_new_dict(3);
+
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_status), MP_OBJ_TO_PTR(mp_obj_new_int(status)));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_err_msg), MP_OBJ_TO_PTR(mp_obj_new_int(err_msg)));
+        mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_media_src), MP_OBJ_TO_PTR(mp_obj_new_int(self->state.media_src)));
+
+        mp_sched_schedule(self->callback, dict);
+    }
+}
+
+STATIC int pipeline_player_error(int ael_status)
+{
+    switch (ael_status) {
+        case AEL_STATUS_ERROR_OPEN:
+            return ESP_ERR_AUDIO_OPEN;
+        case AEL_STATUS_ERROR_INPUT:
+            return ESP_ERR_AUDIO_INPUT;
+        case AEL_STATUS_ERROR_PROCESS:
+            return ESP_ERR_AUDIO_PROCESS;
+        case AEL_STATUS_ERROR_OUTPUT:
+            return ESP_ERR_AUDIO_OUTPUT;
+        case AEL_STATUS_ERROR_CLOSE:
+            return ESP_ERR_AUDIO_CLOSE;
+        case AEL_STATUS_ERROR_TIMEOUT:
+            return ESP_ERR_AUDIO_TIMEOUT;
+        default:
+            return ESP_ERR_AUDIO_UNKNOWN;
+    }
+}
+
+STATIC void pipeline_player_task(void *arg)
+{
+    audio_pipeline_player_obj_t *self = (audio_pipeline_player_obj_t *)arg;
+
+    while (1) {
+        audio_event_iface_msg_t msg;
+        if (audio_event_iface_listen(self->evt, &msg, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        if (msg.source == (void *)self && msg.cmd == PIPELINE_PLAYER_CMD_QUIT) {
+            break;
+        }
+        if (msg.source_type != AUDIO_ELEMENT_TYPE_ELEMENT) {
+            continue;
+        }
+
+        if (msg.source == (void *)self->decoder && msg.cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
+            audio_element_info_t music_info = { 0 };
+            audio_element_getinfo(self->decoder, &music_info);
+            ESP_LOGI(TAG, "music info, sample_rates=%d, bits=%d, ch=%d",
+                music_info.sample_rates, music_info.bits, music_info.channels);
+            audio_element_setinfo(self->writer, &music_info);
+            i2s_stream_set_clk(self->writer, music_info.sample_rates, music_info.bits, music_info.channels);
+            if (self->start_time) {
+                self->start_us = (int)(esp_timer_get_time() - self->start_time);
+                self->start_time = 0;
+            }
+            continue;
+        }
+
+        if (msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+            ESP_LOGW(TAG, "%s error %d", audio_element_get_tag(msg.source), status);
+            self->starting = false;
+            pipeline_player_set_state(self, AUDIO_STATUS_ERROR, pipeline_player_error(status));
+        } else if (msg.source == (void *)self->writer) {
+            // the last element tells the state of the whole pipeline
+            if (status == AEL_STATUS_STATE_RUNNING) {
+                self->starting = false;
+                pipeline_player_set_state(self, AUDIO_STATUS_RUNNING, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (status == AEL_STATUS_STATE_PAUSED) {
+                pipeline_player_set_state(self, AUDIO_STATUS_PAUSED, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (self->starting) {
+                continue;
+            } else if (status == AEL_STATUS_STATE_STOPPED) {
+                pipeline_player_set_state(self, AUDIO_STATUS_STOPPED, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (status == AEL_STATUS_STATE_FINISHED) {
+                pipeline_player_set_state(self, AUDIO_STATUS_FINISHED, ESP_ERR_AUDIO_NO_ERROR);
+            }
+        }
+    }
+
+    audio_stack_sample_tag("pl_evt");
+    xSemaphoreGive(self->task_done);
+    vTaskDelete(NULL);
+}
+
+STATIC audio_element_handle_t pipeline_player_create_reader(int source)
+{
+    audio_element_handle_t reader = NULL;
+    audio_placement_enter("pl_in", AUDIO_PLACE_KIND_BUF);
+    if (source == PIPELINE_SOURCE_HTTP) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = AUDIO_STREAM_READER;
+        http_cfg.task_core = 1;
+        http_cfg.task_stack = audio_stack_size("pl_in", "http", http_cfg.task_stack);
+        http_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_in", http_cfg.stack_in_ext);
+        reader = http_stream_init(&http_cfg);
+    } else {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_READER;
+        vfs_cfg.task_core = 1;
+        vfs_cfg.task_stack = audio_stack_size("pl_in", "vfs", vfs_cfg.task_stack);
+        vfs_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_in", vfs_cfg.stack_in_ext);
+        reader = vfs_stream_init(&vfs_cfg);
+    }
+    audio_placement_exit();
+    return reader;
+}
+
+STATIC audio_element_handle_t pipeline_player_create_decoder(int codec)
+{
+    audio_element_handle_t decoder = NULL;
+    audio_placement_enter("pl_dec", AUDIO_PLACE_KIND_BUF);
+    switch (codec) {
+        case PIPELINE_CODEC_MP3: {
+            mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+            mp3_cfg.task_core = 1;
+            mp3_cfg.task_stack = audio_stack_size("pl_dec", "mp3_dec", mp3_cfg.task_stack);
+            mp3_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_dec", mp3_cfg.stack_in_ext);
+            decoder = mp3_decoder_init(&mp3_cfg);
+            break;
+        }
+        case PIPELINE_CODEC_WAV: {
+            wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+            wav_cfg.task_core = 1;
+            wav_cfg.task_stack = audio_stack_size("pl_dec", "wav_dec", wav_cfg.task_stack);
+            wav_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_dec", wav_cfg.stack_in_ext);
+            decoder = wav_decoder_init(&wav_cfg);
+            break;
+        }
+        case PIPELINE_CODEC_AMR: {
+            amr_decoder_cfg_t amr_cfg = DEFAULT_AMR_DECODER_CONFIG();
+            amr_cfg.task_core = 1;
+            amr_cfg.task_stack = audio_stack_size("pl_dec", "amr_dec", amr_cfg.task_stack);
+            amr_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_dec", amr_cfg.stack_in_ext);
+            decoder = amr_decoder_init(&amr_cfg);
+            break;
+        }
+        default:
+            break;
+    }
+    audio_placement_exit();
+    return decoder;
+}
+
+STATIC void pipeline_player_create(audio_pipeline_player_obj_t *self, int source, int codec)
+{
+    int64_t start = esp_timer_get_time();
+    size_t heap = esp_get_free_heap_size();
+    audio_mem_stats_subsystem("pipeline_player");
+
+    audio_board_handle_t board_handle = audio_board_init();
+    audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_DECODE, AUDIO_HAL_CTRL_START);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->pipeline = audio_pipeline_init(&pipeline_cfg);
+
+    self->reader = pipeline_player_create_reader(source);
+    self->decoder = pipeline_player_create_decoder(codec);
+
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_WRITER;
+    i2s_cfg.task_core = 1;
+    // the driver is shared with audio.player and audio.recorder
+    i2s_cfg.uninstall_drv = false;
+    i2s_cfg.task_stack = audio_stack_size("pl_i2s", NULL, i2s_cfg.task_stack);
+    i2s_cfg.stack_in_ext = audio_placement_stack_in_ext("pl_i2s", i2s_cfg.stack_in_ext);
+    audio_placement_enter("pl_i2s", AUDIO_PLACE_KIND_BUF);
+    self->writer = i2s_stream_init(&i2s_cfg);
+    audio_placement_exit();
+
+    audio_pipeline_register(self->pipeline, self->reader, "pl_in");
+    audio_pipeline_register(self->pipeline, self->decoder, "pl_dec");
+    audio_pipeline_register(self->pipeline, self->writer, "pl_i2s");
+    audio_stack_track(self->reader);
+    audio_stack_track(self->decoder);
+    audio_stack_track(self->writer);
+
+    audio_placement_enter("pipeline_player", AUDIO_PLACE_KIND_RB);
+    const char *link_tag[3] = {"pl_in", "pl_dec", "pl_i2s"};
+    audio_pipeline_link(self->pipeline, &link_tag[0], 3);
+    audio_placement_exit();
+
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    self->evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(self->pipeline, self->evt);
+
+    self->task_done = xSemaphoreCreateBinary();
+    int stack = audio_stack_size("pl_evt", NULL, PIPELINE_PLAYER_TASK_STACK);
+    xTaskCreatePinnedToCore(pipeline_player_task, "pl_evt", stack, self, PIPELINE_PLAYER_TASK_PRIO, NULL, 1);
+
+    audio_mem_stats_subsystem(NULL);
+    self->create_us = (int)(esp_timer_get_time() - start);
+    self->create_bytes = (int)(heap - esp_get_free_heap_size());
+    ESP_LOGI(TAG, "pipeline player created in %d us, %d bytes", self->create_us, self->create_bytes);
+}
+
+STATIC mp_obj_t audio_pipeline_player_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_callback,
+        ARG_source,
+        ARG_codec,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_callback, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_source, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = PIPELINE_SOURCE_HTTP } },
+        { MP_QSTR_codec, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = PIPELINE_CODEC_MP3 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_source].u_int != PIPELINE_SOURCE_HTTP && args[ARG_source].u_int != PIPELINE_SOURCE_FILE) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid source"));
+    }
+    if (args[ARG_codec].u_int < PIPELINE_CODEC_MP3 || args[ARG_codec].u_int > PIPELINE_CODEC_AMR) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid codec"));
+    }
+
+    audio_pipeline_player_obj_t *self = m_new_obj_with_finaliser(audio_pipeline_player_obj_t);
+    self->base.type = type;
+    self->callback = args[ARG_callback].u_obj;
+    self->state.status = AUDIO_STATUS_STOPPED;
+    pipeline_player_create(self, args[ARG_source].u_int, args[ARG_codec].u_int);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC bool pipeline_player_active(audio_pipeline_player_obj_t *self)
+{
+    return self->state.status == AUDIO_STATUS_RUNNING || self->state.status == AUDIO_STATUS_PAUSED;
+}
+
+STATIC void pipeline_player_halt(audio_pipeline_player_obj_t *self)
+{
+    MP_THREAD_GIL_EXIT();
+    audio_pipeline_stop(self->pipeline);
+    audio_pipeline_wait_for_stop(self->pipeline);
+    MP_THREAD_GIL_ENTER();
+}
+
+STATIC mp_obj_t audio_pipeline_player_play_helper(audio_pipeline_player_obj_t *self, mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_uri,
+        ARG_pos,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_uri, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_pos, MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (self->pipeline == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    if (pipeline_player_active(self)) {
+        pipeline_player_halt(self);
+    }
+    // switching the uri reuses the elements, only their state and ringbuffers are reset
+    if (args[ARG_uri].u_obj != mp_const_none) {
+        audio_element_set_uri(self->reader, mp_obj_str_get_str(args[ARG_uri].u_obj));
+    } else if (audio_element_get_uri(self->reader) == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_INVALID_PARAMETER);
+    }
+    audio_element_info_t info;
+    audio_element_getinfo(self->reader, &info);
+    info.byte_pos = args[ARG_pos].u_int;
+    audio_element_setinfo(self->reader, &info);
+    audio_pipeline_reset_ringbuffer(self->pipeline);
+    audio_pipeline_reset_elements(self->pipeline);
+    audio_pipeline_change_state(self->pipeline, AEL_STATE_INIT);
+
+    self->state.status = AUDIO_STATUS_RUNNING;
+    self->state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+    self->start_time = esp_timer_get_time();
+    self->starting = true;
+    if (audio_pipeline_run(self->pipeline) != ESP_OK) {
+        self->starting = false;
+        self->state.status = AUDIO_STATUS_ERROR;
+        self->state.err_msg = ESP_ERR_AUDIO_FAIL;
+        return mp_obj_new_int(ESP_ERR_AUDIO_FAIL);
+    }
+    return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+}
+
+STATIC mp_obj_t audio_pipeline_player_play(mp_uint_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
+{
+    return audio_pipeline_player_play_helper(args[0], n_args - 1, args + 1, kw_args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_pipeline_player_play_obj, 1, audio_pipeline_player_play);
+
+STATIC mp_obj_t audio_pipeline_player_stop(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    if (self->pipeline == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    if (pipeline_player_active(self)) {
+        pipeline_player_halt(self);
+    }
+    return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_stop_obj, audio_pipeline_player_stop);
+
+STATIC mp_obj_t audio_pipeline_player_pause(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    if (self->pipeline == NULL || self->state.status != AUDIO_STATUS_RUNNING) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    return mp_obj_new_int(audio_pipeline_pause(self->pipeline) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_FAIL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_pause_obj, audio_pipeline_player_pause);
+
+STATIC mp_obj_t audio_pipeline_player_resume(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    if (self->pipeline == NULL || self->state.status != AUDIO_STATUS_PAUSED) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    return mp_obj_new_int(audio_pipeline_resume(self->pipeline) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_FAIL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_resume_obj, audio_pipeline_player_resume);
+
+STATIC mp_obj_t audio_pipeline_player_vol(size_t n_args, const mp_obj_t *args)
+{
+    audio_board_handle_t board_handle = audio_board_get_handle();
+    if (n_args == 1) {
+        int vol = 0;
+        audio_hal_get_volume(board_handle->audio_hal, &vol);
+        return mp_obj_new_int(vol);
+    }
+    int vol = mp_obj_get_int(args[1]);
+    if (vol < 0 || vol > 100) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_INVALID_PARAMETER);
+    }
+    return mp_obj_new_int(audio_hal_set_volume(board_handle->audio_hal, vol));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_pipeline_player_vol_obj, 1, 2, audio_pipeline_player_vol);
+
+STATIC mp_obj_t audio_pipeline_player_state(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    mp_obj_dict_t *dict = mp_obj_new_dict(3);
+
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_status), MP_OBJ_TO_PTR(mp_obj_new_int(self->state.status)));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_err_msg), MP_OBJ_TO_PTR(mp_obj_new_int(self->state.err_msg)));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_media_src), MP_OBJ_TO_PTR(mp_obj_new_int(self->state.media_src)));
+
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_state_obj, audio_pipeline_player_state);
+
+STATIC mp_obj_t audio_pipeline_player_pos(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    if (self->pipeline == NULL) {
+        return mp_const_none;
+    }
+    audio_element_info_t info;
+    audio_element_getinfo(self->reader, &info);
+    return mp_obj_new_int_from_ll(info.byte_pos);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_pos_obj, audio_pipeline_player_pos);
+
+STATIC mp_obj_t audio_pipeline_player_stats(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    mp_obj_dict_t *dict = mp_obj_new_dict(3);
+
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_create_us), mp_obj_new_int(self->create_us));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_create_bytes), mp_obj_new_int(self->create_bytes));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_start_us), mp_obj_new_int(self->start_us));
+
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_stats_obj, audio_pipeline_player_stats);
+
+STATIC mp_obj_t pipeline_player_check_state(mp_obj_t self_in, mp_obj_t status_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    int status = self->state.status;
+    bool match;
+    if (status_in == MP_OBJ_NULL || status_in == mp_const_none) {
+        match = status == AUDIO_STATUS_STOPPED || status == AUDIO_STATUS_FINISHED || status == AUDIO_STATUS_ERROR;
+    } else if (mp_obj_is_int(status_in)) {
+        match = status == mp_obj_get_int(status_in);
+    } else {
+        match = mp_obj_is_true(mp_binary_op(MP_BINARY_OP_CONTAINS, status_in, MP_OBJ_NEW_SMALL_INT(status)));
+    }
+    return match ? audio_pipeline_player_state(self) : MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t audio_pipeline_player_play_async(mp_uint_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
+{
+    audio_pipeline_player_obj_t *self = args[0];
+    int err = mp_obj_get_int(audio_pipeline_player_play_helper(self, n_args - 1, args + 1, kw_args));
+    if (err != ESP_ERR_AUDIO_NO_ERROR) {
+        self->state.status = AUDIO_STATUS_ERROR;
+        self->state.err_msg = err;
+    }
+    return audio_async_wait_new(self, &self->event, pipeline_player_check_state, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_pipeline_player_play_async_obj, 1, audio_pipeline_player_play_async);
+
+STATIC mp_obj_t audio_pipeline_player_wait_state(size_t n_args, const mp_obj_t *args)
+{
+    audio_pipeline_player_obj_t *self = args[0];
+    return audio_async_wait_new(self, &self->event, pipeline_player_check_state, n_args > 1 ? args[1] : MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_pipeline_player_wait_state_obj, 1, 2, audio_pipeline_player_wait_state);
+
+STATIC mp_obj_t audio_pipeline_player_deinit(mp_obj_t self_in)
+{
+    audio_pipeline_player_obj_t *self = self_in;
+    if (self->pipeline == NULL) {
+        return mp_const_none;
+    }
+    MP_THREAD_GIL_EXIT();
+    audio_pipeline_stop(self->pipeline);
+    audio_pipeline_wait_for_stop(self->pipeline);
+    audio_pipeline_terminate(self->pipeline);
+
+    audio_event_iface_msg_t msg = {
+        .source = self,
+        .cmd = PIPELINE_PLAYER_CMD_QUIT,
+    };
+    audio_event_iface_cmd(self->evt, &msg);
+    xSemaphoreTake(self->task_done, portMAX_DELAY);
+    vSemaphoreDelete(self->task_done);
+    MP_THREAD_GIL_ENTER();
+
+    audio_stack_untrack(self->reader);
+    audio_stack_untrack(self->decoder);
+    audio_stack_untrack(self->writer);
+    // terminate the pipeline before removing the listener
+    audio_pipeline_remove_listener(self->pipeline);
+    audio_event_iface_destroy(self->evt);
+    // deinit releases the registered elements too
+    audio_pipeline_deinit(self->pipeline);
+
+    self->pipeline = NULL;
+    self->reader = NULL;
+    self->decoder = NULL;
+    self->writer = NULL;
+    self->evt = NULL;
+    self->task_done = NULL;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_pipeline_player_deinit_obj, audio_pipeline_player_deinit);
+
+STATIC const mp_rom_map_elem_t pipeline_player_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_play), MP_ROM_PTR(&audio_pipeline_player_play_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&audio_pipeline_player_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pause), MP_ROM_PTR(&audio_pipeline_player_pause_obj) },
+    { MP_ROM_QSTR(MP_QSTR_resume), MP_ROM_PTR(&audio_pipeline_player_resume_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vol), MP_ROM_PTR(&audio_pipeline_player_vol_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get_state), MP_ROM_PTR(&audio_pipeline_player_state_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pos), MP_ROM_PTR(&audio_pipeline_player_pos_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&audio_pipeline_player_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_play_async), MP_ROM_PTR(&audio_pipeline_player_play_async_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait_state), MP_ROM_PTR(&audio_pipeline_player_wait_state_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&audio_pipeline_player_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&audio_pipeline_player_deinit_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_HTTP), MP_ROM_INT(PIPELINE_SOURCE_HTTP) },
+    { MP_ROM_QSTR(MP_QSTR_FILE), MP_ROM_INT(PIPELINE_SOURCE_FILE) },
+    { MP_ROM_QSTR(MP_QSTR_MP3), MP_ROM_INT(PIPELINE_CODEC_MP3) },
+    { MP_ROM_QSTR(MP_QSTR_WAV), MP_ROM_INT(PIPELINE_CODEC_WAV) },
+    { MP_ROM_QSTR(MP_QSTR_AMR), MP_ROM_INT(PIPELINE_CODEC_AMR) },
+
+    // esp_audio_status_t
+    { MP_ROM_QSTR(MP_QSTR_STATUS_RUNNING), MP_ROM_INT(AUDIO_STATUS_RUNNING) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_PAUSED), MP_ROM_INT(AUDIO_STATUS_PAUSED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_STOPPED), MP_ROM_INT(AUDIO_STATUS_STOPPED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_FINISHED), MP_ROM_INT(AUDIO_STATUS_FINISHED) },
+    { MP_ROM_QSTR(MP_QSTR_STATUS_ERROR), MP_ROM_INT(AUDIO_STATUS_ERROR) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(pipeline_player_locals_dict, pipeline_player_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_pipeline_player_type,
+    MP_QSTR_pipeline_player,
+    MP_TYPE_FLAG_NONE,
+    make_new, audio_pipeline_player_make_new,
+    locals_dict, &pipeline_player_locals_dict
+    );
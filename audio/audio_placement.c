@@ -0,0 +1,226 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_heap_caps.h"
+
+#include "audio_arena.h"
+#include "audio_mem_stats.h"
+#include "audio_placement.h"
+
+typedef struct {
+    char tag[configMAX_TASK_NAME_LEN];
+    uint8_t place[AUDIO_PLACE_KIND_MAX];
+} audio_placement_policy_t;
+
+static audio_placement_policy_t policies[AUDIO_PLACEMENT_MAX_POLICIES];
+static int policy_num = 0;
+
+static const char *scope_tag = NULL;
+static audio_place_kind_t scope_kind = AUDIO_PLACE_KIND_BUF;
+static TaskHandle_t scope_task = NULL;
+
+static audio_placement_policy_t *audio_placement_find(const char *tag)
+{
+    for (int i = 0; i < policy_num; i++) {
+        if (strncmp(policies[i].tag, tag, sizeof(policies[i].tag) - 1) == 0) {
+            return &policies[i];
+        }
+    }
+    return NULL;
+}
+
+bool audio_placement_set(const char *tag, audio_place_kind_t kind, audio_place_t place)
+{
+    audio_placement_policy_t *policy = audio_placement_find(tag);
+    if (policy == NULL) {
+        if (policy_num >= AUDIO_PLACEMENT_MAX_POLICIES) {
+            return false;
+        }
+        policy = &policies[policy_num];
+        memset(policy, 0, sizeof(audio_placement_policy_t));
+        strncpy(policy->tag, tag, sizeof(policy->tag) - 1);
+        policy_num++;
+    }
+    policy->place[kind] = place;
+    return true;
+}
+
+audio_place_t audio_placement_get(const char *tag, audio_place_kind_t kind)
+{
+    audio_placement_policy_t *policy = audio_placement_find(tag);
+    return policy ? policy->place[kind] : AUDIO_PLACE_DEFAULT;
+}
+
+bool audio_placement_stack_in_ext(const char *tag, bool default_ext)
+{
+    switch (audio_placement_get(tag, AUDIO_PLACE_KIND_STACK)) {
+        case AUDIO_PLACE_INTERNAL:
+            return false;
+        case AUDIO_PLACE_PSRAM:
+            return true;
+        default:
+            return default_ext;
+    }
+}
+
+void audio_placement_enter(const char *tag, audio_place_kind_t kind)
+{
+    scope_tag = tag;
+    scope_kind = kind;
+    scope_task = xTaskGetCurrentTaskHandle();
+}
+
+void audio_placement_exit(void)
+{
+    scope_tag = NULL;
+    scope_task = NULL;
+}
+
+const char *audio_placement_owner(void)
+{
+    if (scope_tag != NULL && scope_task == xTaskGetCurrentTaskHandle()) {
+        return scope_tag;
+    }
+    // element tasks are named after the element tag
+    return pcTaskGetName(NULL);
+}
+
+uint32_t audio_placement_caps(void)
+{
+    if (policy_num == 0) {
+        return 0;
+    }
+    audio_place_t place;
+    if (scope_tag != NULL && scope_task == xTaskGetCurrentTaskHandle()) {
+        place = audio_placement_get(scope_tag, scope_kind);
+    } else {
+        place = audio_placement_get(pcTaskGetName(NULL), AUDIO_PLACE_KIND_BUF);
+    }
+    switch (place) {
+        case AUDIO_PLACE_INTERNAL:
+            return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        case AUDIO_PLACE_PSRAM:
+            return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Allocations made inside an `audio_placement_enter` scope are element structs, element
+ * buffers and ringbuffers, they are served by the audio arena unless pinned to internal RAM.
+ */
+static bool audio_placement_use_arena(void)
+{
+    if (!audio_arena_ready() || scope_tag == NULL || scope_task != xTaskGetCurrentTaskHandle()) {
+        return false;
+    }
+    return audio_placement_get(scope_tag, scope_kind) != AUDIO_PLACE_INTERNAL;
+}
+
+/*
+ * ADF allocates everything through audio_malloc/audio_calloc/audio_realloc, the linker
+ * redirects those calls here (see micropython.cmake) so the policy and the accounting of
+ * audio.mem_info() apply to ringbuffers and codec memory that are allocated inside ADF.
+ */
+void *__real_audio_malloc(size_t size);
+void *__real_audio_calloc(size_t nmemb, size_t size);
+void *__real_audio_realloc(void *ptr, size_t size);
+void __real_audio_free(void *ptr);
+
+static void *audio_placement_malloc(size_t size)
+{
+    if (audio_placement_use_arena()) {
+        void *data = audio_arena_malloc(size);
+        if (data) {
+            return data;
+        }
+    }
+    uint32_t caps = audio_placement_caps();
+    void *data = caps ? heap_caps_malloc(size, caps) : NULL;
+    return data ? data : __real_audio_malloc(size);
+}
+
+static void *audio_placement_calloc(size_t nmemb, size_t size)
+{
+    if (audio_placement_use_arena()) {
+        void *data = audio_arena_calloc(nmemb, size);
+        if (data) {
+            return data;
+        }
+    }
+    uint32_t caps = audio_placement_caps();
+    void *data = caps ? heap_caps_calloc(nmemb, size, caps) : NULL;
+    return data ? data : __real_audio_calloc(nmemb, size);
+}
+
+static void *audio_placement_realloc(void *ptr, size_t size)
+{
+    if (audio_arena_contains(ptr)) {
+        return audio_arena_realloc(ptr, size);
+    }
+    uint32_t caps = audio_placement_caps();
+    void *data = caps ? heap_caps_realloc(ptr, size, caps) : NULL;
+    return data ? data : __real_audio_realloc(ptr, size);
+}
+
+void *__wrap_audio_malloc(size_t size)
+{
+    void *data = audio_placement_malloc(size);
+    audio_mem_stats_alloc(data, size, audio_placement_owner());
+    return data;
+}
+
+void *__wrap_audio_calloc(size_t nmemb, size_t size)
+{
+    void *data = audio_placement_calloc(nmemb, size);
+    audio_mem_stats_alloc(data, nmemb * size, audio_placement_owner());
+    return data;
+}
+
+void *__wrap_audio_realloc(void *ptr, size_t size)
+{
+    void *data = audio_placement_realloc(ptr, size);
+    if (data) {
+        audio_mem_stats_free(ptr);
+        audio_mem_stats_alloc(data, size, audio_placement_owner());
+    }
+    return data;
+}
+
+void __wrap_audio_free(void *ptr)
+{
+    audio_mem_stats_free(ptr);
+    if (audio_arena_contains(ptr)) {
+        audio_arena_free(ptr);
+    } else {
+        __real_audio_free(ptr);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_PLACEMENT_H_
+#define _AUDIO_PLACEMENT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_PLACEMENT_MAX_POLICIES (16)
+
+typedef enum {
+    AUDIO_PLACE_DEFAULT,  /*!< Keep the ADF default (PSRAM first when available) */
+    AUDIO_PLACE_INTERNAL, /*!< Internal RAM */
+    AUDIO_PLACE_PSRAM,    /*!< External PSRAM */
+} audio_place_t;
+
+typedef enum {
+    AUDIO_PLACE_KIND_STACK, /*!< Element task stack */
+    AUDIO_PLACE_KIND_RB,    /*!< Ringbuffers created while linking a pipeline */
+    AUDIO_PLACE_KIND_BUF,   /*!< Element structs, buffers and codec scratch memory */
+    AUDIO_PLACE_KIND_MAX,
+} audio_place_kind_t;
+
+/**
+ * @brief      Set the placement policy of a tag. Element tags control the task stack and
+ *             the buffers allocated by the element, pipeline tags control the ringbuffers
+ *             created by `audio_pipeline_link`.
+ *
+ * @param      tag    The element or pipeline tag
+ * @param      kind   What to place
+ * @param      place  Where to place it
+ *
+ * @return     false if the policy table is full
+ */
+bool audio_placement_set(const char *tag, audio_place_kind_t kind, audio_place_t place);
+
+/**
+ * @brief      Get the placement policy of a tag
+ */
+audio_place_t audio_placement_get(const char *tag, audio_place_kind_t kind);
+
+/**
+ * @brief      Resolve the `stack_in_ext` configuration of an element
+ *
+ * @param      tag          The element tag
+ * @param      default_ext  The default value of the element configuration
+ */
+bool audio_placement_stack_in_ext(const char *tag, bool default_ext);
+
+/**
+ * @brief      Attribute the allocations made by the calling task to a tag until
+ *             `audio_placement_exit` is called. Used around element init and pipeline link.
+ *
+ * @param      tag   The element or pipeline tag
+ * @param      kind  AUDIO_PLACE_KIND_BUF or AUDIO_PLACE_KIND_RB
+ */
+void audio_placement_enter(const char *tag, audio_place_kind_t kind);
+
+/**
+ * @brief      Leave the scope opened by `audio_placement_enter`
+ */
+void audio_placement_exit(void);
+
+/**
+ * @brief      Get the tag an allocation made now is attributed to: the scope tag, or the
+ *             name of the calling task, which is the element tag for element tasks
+ */
+const char *audio_placement_owner(void);
+
+/**
+ * @brief      Get the heap capabilities for an allocation made now, 0 to keep the default
+ */
+uint32_t audio_placement_caps(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,13 +22,21 @@
  *
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "extmod/vfs.h"
+#include "py/mphal.h"
+#include "py/mpthread.h"
 #include "py/objstr.h"
+#include "py/objtuple.h"
 #include "py/runtime.h"
+#include "py/stream.h"
 
 #include "esp_audio.h"
+#include "esp_bit_defs.h"
+#include "esp_system.h"
 
 #include "audio_hal.h"
 #include "board.h"
@@ -37,20 +45,102 @@
 #include "mp3_decoder.h"
 #include "wav_decoder.h"
 
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_pipeline.h"
 #include "http_stream.h"
 #include "i2s_stream.h"
+#include "raw_stream.h"
+#include "ringbuf.h"
 #include "vfs_stream.h"
 
+#include "audio_async.h"
+#include "audio_mem_stats.h"
+#include "audio_meter.h"
+#include "audio_pcm_out.h"
+#include "audio_placement.h"
+#include "audio_probe.h"
+#include "audio_stack.h"
+#include "audio_tee.h"
+#include "audio_upload.h"
+#include "modaudio.h"
+
+#define PLAYER_IDLE_TIMEOUT_MS (30000)
+#define PLAYER_OUTPUT_RATE (48000)
+#define PLAYER_SINK_SIZE (16 * 1024)
+#define PLAYER_MIRROR_DEPTH (64)
+#define PLAYER_MIRROR_DRAIN_MS (5000)
+
+static const char *TAG = "AUDIO_PLAYER";
+
 const mp_obj_type_t audio_player_type;
 
 typedef struct _audio_player_obj_t {
     mp_obj_base_t base;
     mp_obj_t callback;
+    mp_obj_t pcm_file;
 
-    esp_audio_handle_t player;
     esp_audio_state_t state;
+    audio_async_event_t event;
 } audio_player_obj_t;
 
+// keeps the player and its file alive while the PCM output task reads from it
+MP_REGISTER_ROOT_POINTER(mp_obj_t audio_player_pcm_owner);
+// keeps the Meter fed by the output alive
+MP_REGISTER_ROOT_POINTER(mp_obj_t audio_player_meter_ref);
+
+enum {
+    PLAYER_STREAM_FILE = BIT(0),
+    PLAYER_STREAM_HTTP = BIT(1),
+};
+
+enum {
+    PLAYER_CODEC_MP3 = BIT(0),
+    PLAYER_CODEC_AMR = BIT(1),
+    PLAYER_CODEC_WAV = BIT(2),
+    PLAYER_CODEC_ALL = PLAYER_CODEC_MP3 | PLAYER_CODEC_AMR | PLAYER_CODEC_WAV,
+};
+
+// The esp_audio instance shared by all player objects, input streams and decoders are
+// added on first use and everything is released after being idle for idle_ms
+typedef struct {
+    esp_audio_handle_t handle;
+    audio_element_handle_t elements[6];
+    int element_num;
+    uint32_t streams;
+    uint32_t codecs;
+    esp_timer_handle_t idle_timer;
+    int idle_ms;
+    bool release_pending;
+    int pcm_start;
+    int pcm_remain;
+    int pcm_rate;
+    // PCM written by Python with player.write(), drained by the PCM output task
+    ringbuf_handle_t sink;
+    bool sink_block;
+    // the output of both esp_audio and the PCM output task, see player.meter()
+    audio_meter_slot_t meter;
+    stream_func i2s_write;
+    // what was written to I2S, handed to the sink of player.mirror()
+    audio_tee_slot_t mirror;
+    audio_element_handle_t mirror_tee;
+    audio_pipeline_handle_t mirror_pipeline;
+    audio_element_handle_t mirror_stream;
+    audio_upload_t mirror_upload;
+    bool mirror_upload_on;
+    bool mirror_raw;
+    volatile bool mirror_reading;
+    // counters of the last mirror once it was stopped
+    audio_tee_stats_t mirror_stats;
+    bool mirror_used;
+} audio_player_core_t;
+
+static audio_player_core_t core = {
+    .idle_ms = PLAYER_IDLE_TIMEOUT_MS,
+    .mirror = { .rate = PLAYER_OUTPUT_RATE },
+};
+
 STATIC const qstr player_info_fields[] = {
     MP_QSTR_input, MP_QSTR_codec
 };
@@ -71,10 +161,20 @@ STATIC mp_obj_t player_info(void)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(audio_player_info_obj, player_info);
 
+STATIC void audio_player_idle_start(void);
+STATIC void audio_player_sink_free(void);
+
 STATIC void audio_state_cb(esp_audio_state_t *state, void *ctx)
 {
     audio_player_obj_t *self = (audio_player_obj_t *)ctx;
     memcpy(&self->state, state, sizeof(esp_audio_state_t));
+    audio_async_event_set(&self->event);
+    if (state->status != AUDIO_STATUS_RUNNING) {
+        audio_stack_sample();
+    }
+    if (state->status != AUDIO_STATUS_RUNNING && state->status != AUDIO_STATUS_PAUSED) {
+        audio_player_idle_start();
+    }
     if (self->callback != mp_const_none) {
         mp_obj_dict_t *dict = mp_obj_new_dict(3);
 
@@ -101,8 +201,32 @@ STATIC int _http_stream_event_handle(http_stream_event_msg_t *msg)
     return ESP_OK;
 }
 
-STATIC esp_audio_handle_t audio_player_create(void)
+// the write callback of the I2S writer, the meter sees the output before it is written
+// and the mirror after, the mirror only copies into free blocks so a slow sink never
+// holds up I2S
+STATIC int audio_player_output_write(audio_element_handle_t el, char *buffer, int len, TickType_t ticks_to_wait, void *context)
 {
+    // esp_audio resamples everything to the writer format
+    audio_meter_slot_feed(&core.meter, (const int16_t *)buffer, len / (2 * sizeof(int16_t)), 2, PLAYER_OUTPUT_RATE);
+    int ret = core.i2s_write(el, buffer, len, ticks_to_wait, NULL);
+    if (ret > 0) {
+        audio_tee_slot_feed(&core.mirror, buffer, ret, PLAYER_OUTPUT_RATE);
+    }
+    return ret;
+}
+
+STATIC void audio_player_core_add(audio_element_handle_t el)
+{
+    audio_stack_track(el);
+    core.elements[core.element_num++] = el;
+}
+
+STATIC void audio_player_core_create(void)
+{
+    int64_t start = esp_timer_get_time();
+    size_t heap = esp_get_free_heap_size();
+    audio_mem_stats_subsystem("player");
+
     // init audio board
     audio_board_handle_t board_handle = audio_board_init();
     audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START);
@@ -112,66 +236,405 @@ STATIC esp_audio_handle_t audio_player_create(void)
     cfg.vol_handle = board_handle->audio_hal;
     cfg.vol_set = (audio_volume_set)audio_hal_set_volume;
     cfg.vol_get = (audio_volume_get)audio_hal_get_volume;
-    cfg.resample_rate = 48000;
+    cfg.resample_rate = PLAYER_OUTPUT_RATE;
     cfg.prefer_type = ESP_AUDIO_PREFER_MEM;
-    esp_audio_handle_t player = esp_audio_create(&cfg);
-
-    // add input stream
-    // fatfs stream
-    vfs_stream_cfg_t fs_reader = VFS_STREAM_CFG_DEFAULT();
-    fs_reader.type = AUDIO_STREAM_READER;
-    fs_reader.task_core = 1;
-    esp_audio_input_stream_add(player, vfs_stream_init(&fs_reader));
-    // http stream
-    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
-    http_cfg.event_handle = _http_stream_event_handle;
-    http_cfg.type = AUDIO_STREAM_READER;
-    http_cfg.enable_playlist_parser = true;
-    http_cfg.task_core = 1;
-    audio_element_handle_t http_stream_reader = http_stream_init(&http_cfg);
-    esp_audio_input_stream_add(player, http_stream_reader);
-
-    // add decoder
-    // mp3
-    mp3_decoder_cfg_t mp3_dec_cfg = DEFAULT_MP3_DECODER_CONFIG();
-    mp3_dec_cfg.task_core = 1;
-    esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, mp3_decoder_init(&mp3_dec_cfg));
-    // amr
-    amr_decoder_cfg_t amr_dec_cfg = DEFAULT_AMR_DECODER_CONFIG();
-    amr_dec_cfg.task_core = 1;
-    esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, amr_decoder_init(&amr_dec_cfg));
-    // wav
-    wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
-    wav_dec_cfg.task_core = 1;
-    esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, wav_decoder_init(&wav_dec_cfg));
+    audio_placement_enter("player", AUDIO_PLACE_KIND_BUF);
+    core.handle = esp_audio_create(&cfg);
+    audio_placement_exit();
 
     // Create writers and add to esp_audio
     i2s_stream_cfg_t i2s_writer = I2S_STREAM_CFG_DEFAULT();
     i2s_writer.type = AUDIO_STREAM_WRITER;
-    i2s_writer.i2s_config.sample_rate = 48000;
+    i2s_writer.i2s_config.sample_rate = PLAYER_OUTPUT_RATE;
     i2s_writer.task_core = 1;
-    esp_audio_output_stream_add(player, i2s_stream_init(&i2s_writer));
+    // the recorder may still be using the driver when the player is released
+    i2s_writer.uninstall_drv = false;
+    i2s_writer.task_stack = audio_stack_size("iis", NULL, i2s_writer.task_stack);
+    i2s_writer.stack_in_ext = audio_placement_stack_in_ext("iis", i2s_writer.stack_in_ext);
+    audio_placement_enter("iis", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t i2s_stream_writer = i2s_stream_init(&i2s_writer);
+    audio_placement_exit();
+    audio_player_core_add(i2s_stream_writer);
+    esp_audio_output_stream_add(core.handle, i2s_stream_writer);
+    core.i2s_write = audio_element_get_write_cb(i2s_stream_writer);
+    audio_element_set_write_cb(i2s_stream_writer, audio_player_output_write, NULL);
+
+    audio_mem_stats_subsystem(NULL);
+    ESP_LOGI(TAG, "player created in %d us, %d bytes", (int)(esp_timer_get_time() - start), (int)(heap - esp_get_free_heap_size()));
+    audio_player_idle_start();
+}
+
+STATIC void audio_player_core_add_stream(uint32_t stream)
+{
+    audio_mem_stats_subsystem("player");
+    if (stream == PLAYER_STREAM_FILE) {
+        // fatfs stream
+        vfs_stream_cfg_t fs_reader = VFS_STREAM_CFG_DEFAULT();
+        fs_reader.type = AUDIO_STREAM_READER;
+        fs_reader.task_core = 1;
+        fs_reader.task_stack = audio_stack_size("file", NULL, fs_reader.task_stack);
+        fs_reader.stack_in_ext = audio_placement_stack_in_ext("file", fs_reader.stack_in_ext);
+        audio_placement_enter("file", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t fs_stream_reader = vfs_stream_init(&fs_reader);
+        audio_placement_exit();
+        audio_player_core_add(fs_stream_reader);
+        esp_audio_input_stream_add(core.handle, fs_stream_reader);
+    } else if (stream == PLAYER_STREAM_HTTP) {
+        // http stream
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.event_handle = _http_stream_event_handle;
+        http_cfg.type = AUDIO_STREAM_READER;
+        http_cfg.enable_playlist_parser = true;
+        http_cfg.task_core = 1;
+        http_cfg.task_stack = audio_stack_size("http", NULL, http_cfg.task_stack);
+        http_cfg.stack_in_ext = audio_placement_stack_in_ext("http", http_cfg.stack_in_ext);
+        audio_placement_enter("http", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t http_stream_reader = http_stream_init(&http_cfg);
+        audio_placement_exit();
+        audio_player_core_add(http_stream_reader);
+        esp_audio_input_stream_add(core.handle, http_stream_reader);
+    }
+    core.streams |= stream;
+    audio_mem_stats_subsystem(NULL);
+}
+
+STATIC void audio_player_core_add_codec(uint32_t codec)
+{
+    audio_mem_stats_subsystem("player");
+    if (codec == PLAYER_CODEC_MP3) {
+        mp3_decoder_cfg_t mp3_dec_cfg = DEFAULT_MP3_DECODER_CONFIG();
+        mp3_dec_cfg.task_core = 1;
+        mp3_dec_cfg.task_stack = audio_stack_size("mp3", NULL, mp3_dec_cfg.task_stack);
+        mp3_dec_cfg.stack_in_ext = audio_placement_stack_in_ext("mp3", mp3_dec_cfg.stack_in_ext);
+        audio_placement_enter("mp3", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t mp3_decoder = mp3_decoder_init(&mp3_dec_cfg);
+        audio_placement_exit();
+        audio_player_core_add(mp3_decoder);
+        esp_audio_codec_lib_add(core.handle, AUDIO_CODEC_TYPE_DECODER, mp3_decoder);
+    } else if (codec == PLAYER_CODEC_AMR) {
+        amr_decoder_cfg_t amr_dec_cfg = DEFAULT_AMR_DECODER_CONFIG();
+        amr_dec_cfg.task_core = 1;
+        amr_dec_cfg.task_stack = audio_stack_size("amr", NULL, amr_dec_cfg.task_stack);
+        amr_dec_cfg.stack_in_ext = audio_placement_stack_in_ext("amr", amr_dec_cfg.stack_in_ext);
+        audio_placement_enter("amr", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t amr_decoder = amr_decoder_init(&amr_dec_cfg);
+        audio_placement_exit();
+        audio_player_core_add(amr_decoder);
+        esp_audio_codec_lib_add(core.handle, AUDIO_CODEC_TYPE_DECODER, amr_decoder);
+    } else if (codec == PLAYER_CODEC_WAV) {
+        wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
+        wav_dec_cfg.task_core = 1;
+        wav_dec_cfg.task_stack = audio_stack_size("wav", NULL, wav_dec_cfg.task_stack);
+        wav_dec_cfg.stack_in_ext = audio_placement_stack_in_ext("wav", wav_dec_cfg.stack_in_ext);
+        audio_placement_enter("wav", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t wav_decoder = wav_decoder_init(&wav_dec_cfg);
+        audio_placement_exit();
+        audio_player_core_add(wav_decoder);
+        esp_audio_codec_lib_add(core.handle, AUDIO_CODEC_TYPE_DECODER, wav_decoder);
+    }
+    core.codecs |= codec;
+    audio_mem_stats_subsystem(NULL);
+}
+
+STATIC uint32_t audio_player_type_codecs(audio_probe_type_t type)
+{
+    switch (type) {
+        case AUDIO_PROBE_MP3:
+            return PLAYER_CODEC_MP3;
+        case AUDIO_PROBE_AMR:
+            return PLAYER_CODEC_AMR;
+        case AUDIO_PROBE_WAV:
+            return PLAYER_CODEC_WAV;
+        default:
+            // playlists and unknown formats may hold anything
+            return PLAYER_CODEC_ALL;
+    }
+}
+
+STATIC esp_audio_handle_t audio_player_core_get(void)
+{
+    core.release_pending = false;
+    if (core.idle_timer) {
+        esp_timer_stop(core.idle_timer);
+    }
+    if (core.handle == NULL) {
+        audio_player_core_create();
+    }
+    return core.handle;
+}
+
+bool audio_player_output_busy(void)
+{
+    if (audio_pcm_out_running()) {
+        return true;
+    }
+    if (core.handle == NULL) {
+        return false;
+    }
+    esp_audio_state_t state = { 0 };
+    esp_audio_state_get(core.handle, &state);
+    return state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED;
+}
+
+STATIC esp_audio_handle_t audio_player_core_prepare(const char *uri, audio_probe_type_t type)
+{
+    audio_player_core_get();
+    uint32_t stream = strncasecmp(uri, "http", 4) == 0 ? PLAYER_STREAM_HTTP : PLAYER_STREAM_FILE;
+    if (!(core.streams & stream)) {
+        audio_player_core_add_stream(stream);
+    }
+    uint32_t codecs = audio_player_type_codecs(type);
+    for (uint32_t codec = PLAYER_CODEC_MP3; codec & PLAYER_CODEC_ALL; codec <<= 1) {
+        if ((codecs & codec) && !(core.codecs & codec)) {
+            audio_player_core_add_codec(codec);
+        }
+    }
+    return core.handle;
+}
+
+STATIC mp_obj_t audio_player_core_release(mp_obj_t arg)
+{
+    if (!core.release_pending || core.handle == NULL) {
+        return mp_const_none;
+    }
+    esp_audio_state_t state = { 0 };
+    esp_audio_state_get(core.handle, &state);
+    if (state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED || audio_pcm_out_running()) {
+        return mp_const_none;
+    }
+    audio_player_sink_free();
+    for (int i = 0; i < core.element_num; i++) {
+        audio_stack_untrack(core.elements[i]);
+    }
+    esp_audio_destroy(core.handle);
+    core.handle = NULL;
+    core.element_num = 0;
+    core.streams = 0;
+    core.codecs = 0;
+    core.release_pending = false;
+    ESP_LOGI(TAG, "player released after %d ms idle", core.idle_ms);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_core_release_obj, audio_player_core_release);
+
+STATIC void audio_player_idle_cb(void *arg)
+{
+    // esp_audio_destroy blocks, release from the interpreter instead of the timer task
+    core.release_pending = true;
+    mp_sched_schedule(MP_OBJ_FROM_PTR(&audio_player_core_release_obj), mp_const_none);
+}
+
+STATIC void audio_player_idle_start(void)
+{
+    if (core.idle_ms <= 0) {
+        return;
+    }
+    if (core.idle_timer == NULL) {
+        esp_timer_create_args_t timer_conf = {
+            .callback = &audio_player_idle_cb,
+            .name = "player_idle",
+        };
+        esp_timer_create(&timer_conf, &core.idle_timer);
+    }
+    esp_timer_stop(core.idle_timer);
+    esp_timer_start_once(core.idle_timer, (uint64_t)core.idle_ms * 1000);
+}
 
-    return player;
+STATIC int audio_player_pcm_read(uint8_t *buf, int len, void *ctx)
+{
+    audio_player_obj_t *self = (audio_player_obj_t *)ctx;
+    if (len > core.pcm_remain) {
+        len = core.pcm_remain;
+    }
+    if (len <= 0) {
+        return 0;
+    }
+    int rlen = mp_stream_posix_read(self->pcm_file, buf, len);
+    if (rlen > 0) {
+        core.pcm_remain -= rlen;
+    }
+    return rlen;
 }
 
-STATIC mp_obj_t audio_player_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args)
+STATIC void audio_player_pcm_state(audio_pcm_out_status_t status, audio_player_obj_t *self)
 {
-    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    if (core.pcm_rate != PLAYER_OUTPUT_RATE) {
+        // esp_audio expects the driver at the output rate
+        i2s_set_clk(I2S_NUM_0, PLAYER_OUTPUT_RATE, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
+    }
+    esp_audio_state_t state = { 0 };
+    if (status == AUDIO_PCM_OUT_FINISHED) {
+        state.status = AUDIO_STATUS_FINISHED;
+        state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+    } else if (status == AUDIO_PCM_OUT_STOPPED) {
+        state.status = AUDIO_STATUS_STOPPED;
+        state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+    } else {
+        state.status = AUDIO_STATUS_ERROR;
+        state.err_msg = ESP_ERR_AUDIO_INPUT;
+    }
+    audio_state_cb(&state, self);
+    MP_STATE_VM(audio_player_pcm_owner) = mp_const_none;
+}
 
-    static esp_audio_handle_t basic_player = NULL;
+STATIC void audio_player_pcm_done(audio_pcm_out_status_t status, void *ctx)
+{
+    audio_player_obj_t *self = (audio_player_obj_t *)ctx;
+    mp_stream_close(self->pcm_file);
+    self->pcm_file = mp_const_none;
+    audio_player_pcm_state(status, self);
+}
+
+STATIC int audio_player_sink_read(uint8_t *buf, int len, void *ctx)
+{
+    int ret = rb_read(core.sink, (char *)buf, len, portMAX_DELAY);
+    // done after stop(TERMINATION_DONE) has drained the data, aborted by stop()
+    return ret > 0 ? ret : 0;
+}
+
+STATIC void audio_player_sink_done(audio_pcm_out_status_t status, void *ctx)
+{
+    // wake a write() blocked on a full ringbuffer, the ringbuffer is freed by the interpreter
+    rb_abort(core.sink);
+    audio_player_pcm_state(status, (audio_player_obj_t *)ctx);
+}
+
+STATIC void audio_player_sink_free(void)
+{
+    if (core.sink != NULL && !audio_pcm_out_running()) {
+        rb_destroy(core.sink);
+        core.sink = NULL;
+    }
+}
+
+STATIC void audio_player_pcm_stop(void)
+{
+    if (core.sink != NULL) {
+        rb_abort(core.sink);
+    }
+    MP_THREAD_GIL_EXIT();
+    audio_pcm_out_stop();
+    MP_THREAD_GIL_ENTER();
+}
+
+// Plain PCM WAV at the output rate goes from the file straight to the I2S driver,
+// the input stream, the decoder and their ringbuffers are left out
+STATIC bool audio_player_pcm_match(const char *uri, audio_probe_type_t type, audio_probe_wav_t *wav)
+{
+    if (type != AUDIO_PROBE_WAV || strncasecmp(uri, "http", 4) == 0) {
+        return false;
+    }
+    if (!audio_probe_wav_uri(uri, wav)) {
+        return false;
+    }
+    return wav->format == 1 && wav->sample_rate == PLAYER_OUTPUT_RATE && audio_pcm_out_supported(wav->channels, wav->bits);
+}
+
+STATIC int audio_player_pcm_play(audio_player_obj_t *self, const char *uri, const audio_probe_wav_t *wav, int pos, bool sync)
+{
+    const char *path = strstr(uri, "/sdcard");
+    mp_obj_t args[2] = {
+        mp_obj_new_str(path, strcspn(path, "#")),
+        MP_OBJ_NEW_QSTR(MP_QSTR_rb),
+    };
+    mp_obj_t file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
+
+    // pos is a byte position in the file like for esp_audio, keep it on a frame boundary
+    int frame_size = wav->channels * wav->bits / 8;
+    int size = wav->data_size > 0 ? wav->data_size : INT_MAX - wav->data_offset;
+    int skip = pos > wav->data_offset ? pos - wav->data_offset : 0;
+    skip = skip / frame_size * frame_size;
+    if (skip > size) {
+        skip = size;
+    }
+    core.pcm_start = wav->data_offset + skip;
+    core.pcm_remain = size - skip;
+    core.pcm_rate = wav->sample_rate;
+    mp_stream_posix_lseek(file, core.pcm_start, SEEK_SET);
+
+    self->pcm_file = file;
+    MP_STATE_VM(audio_player_pcm_owner) = MP_OBJ_FROM_PTR(self);
+    self->state.status = AUDIO_STATUS_RUNNING;
+    self->state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+
+    audio_pcm_out_cfg_t cfg = AUDIO_PCM_OUT_CFG_DEFAULT();
+    cfg.sample_rate = wav->sample_rate;
+    cfg.channels = wav->channels;
+    cfg.bits = wav->bits;
+    cfg.read = audio_player_pcm_read;
+    cfg.done = audio_player_pcm_done;
+    cfg.ctx = self;
+    cfg.meter = &core.meter;
+    cfg.mirror = &core.mirror;
+    if (audio_pcm_out_start(&cfg) != ESP_OK) {
+        mp_stream_close(file);
+        self->pcm_file = mp_const_none;
+        MP_STATE_VM(audio_player_pcm_owner) = mp_const_none;
+        self->state.status = AUDIO_STATUS_ERROR;
+        self->state.err_msg = ESP_ERR_AUDIO_FAIL;
+        return ESP_ERR_AUDIO_FAIL;
+    }
+    ESP_LOGI(TAG, "pcm passthrough %d Hz %d ch %d bit", wav->sample_rate, wav->channels, wav->bits);
+    if (!sync) {
+        return ESP_ERR_AUDIO_NO_ERROR;
+    }
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        while (audio_pcm_out_running()) {
+            mp_hal_delay_ms(20);
+        }
+        nlr_pop();
+    } else {
+        audio_player_pcm_stop();
+        nlr_jump(nlr.ret_val);
+    }
+    return self->state.err_msg;
+}
+
+STATIC mp_obj_t audio_player_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_callback,
+        ARG_idle,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_callback, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_idle, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = -1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
     audio_player_obj_t *self = m_new_obj_with_finaliser(audio_player_obj_t);
     self->base.type = type;
-    self->callback = args[0];
-    if (basic_player == NULL) {
-        basic_player = audio_player_create();
+    self->callback = args[ARG_callback].u_obj;
+    self->pcm_file = mp_const_none;
+    if (args[ARG_idle].u_int >= 0) {
+        core.idle_ms = args[ARG_idle].u_int;
     }
-    self->player = basic_player;
 
     return MP_OBJ_FROM_PTR(self);
 }
 
+STATIC void audio_player_halt(esp_audio_handle_t player)
+{
+    if (audio_pcm_out_running()) {
+        audio_player_pcm_stop();
+    }
+    audio_player_sink_free();
+    esp_audio_state_t state = { 0 };
+    esp_audio_state_get(player, &state);
+    if (state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED) {
+        esp_audio_stop(player, TERMINATION_TYPE_NOW);
+        int wait = 20;
+        esp_audio_state_get(player, &state);
+        while (wait-- && (state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED)) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            esp_audio_state_get(player, &state);
+        }
+    }
+}
+
 STATIC mp_obj_t audio_player_play_helper(audio_player_obj_t *self, mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
     enum {
@@ -191,24 +654,37 @@ STATIC mp_obj_t audio_player_play_helper(audio_player_obj_t *self, mp_uint_t n_a
         const char *uri = mp_obj_str_get_str(args[ARG_uri].u_obj);
         int pos = args[ARG_pos].u_int;
 
-        esp_audio_state_t state = { 0 };
-        esp_audio_state_get(self->player, &state);
-        if (state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED) {
-            esp_audio_stop(self->player, TERMINATION_TYPE_NOW);
-            int wait = 20;
-            esp_audio_state_get(self->player, &state);
-            while (wait-- && (state.status == AUDIO_STATUS_RUNNING || state.status == AUDIO_STATUS_PAUSED)) {
-                vTaskDelay(pdMS_TO_TICKS(100));
-                esp_audio_state_get(self->player, &state);
-            }
+        // esp_audio picks the decoder from the suffix, append the probed one as a fragment
+        // for extension-less and mislabelled sources
+        audio_probe_type_t type = audio_probe_uri(uri);
+        vstr_t hinted;
+        if (type != AUDIO_PROBE_UNKNOWN && type != audio_probe_suffix(uri)) {
+            const char *suffix = audio_probe_suffix_name(type);
+            vstr_init(&hinted, strlen(uri) + strlen(suffix) + 3);
+            vstr_add_str(&hinted, uri);
+            vstr_add_str(&hinted, strchr(uri, '#') ? "." : "#.");
+            vstr_add_str(&hinted, suffix);
+            uri = vstr_null_terminated_str(&hinted);
+        }
+
+        if (audio_recorder_port_held()) {
+            // the output would retime the port under the recording
+            return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
         }
-        esp_audio_callback_set(self->player, audio_state_cb, self);
+        esp_audio_handle_t player = audio_player_core_get();
+        audio_player_halt(player);
+        audio_probe_wav_t wav;
+        if (audio_player_pcm_match(uri, type, &wav)) {
+            return mp_obj_new_int(audio_player_pcm_play(self, uri, &wav, pos, args[ARG_sync].u_obj != mp_const_false));
+        }
+        audio_player_core_prepare(uri, type);
+        esp_audio_callback_set(player, audio_state_cb, self);
         if (args[ARG_sync].u_obj == mp_const_false) {
             self->state.status = AUDIO_STATUS_RUNNING;
             self->state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
-            return mp_obj_new_int(esp_audio_play(self->player, AUDIO_CODEC_TYPE_DECODER, uri, pos));
+            return mp_obj_new_int(esp_audio_play(player, AUDIO_CODEC_TYPE_DECODER, uri, pos));
         } else {
-            return mp_obj_new_int(esp_audio_sync_play(self->player, uri, pos));
+            return mp_obj_new_int(esp_audio_sync_play(player, uri, pos));
         }
     } else {
         return mp_obj_new_int(ESP_ERR_AUDIO_INVALID_PARAMETER);
@@ -232,7 +708,19 @@ STATIC mp_obj_t audio_player_stop_helper(audio_player_obj_t *self, mp_uint_t n_a
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
-    return mp_obj_new_int(esp_audio_stop(self->player, args[ARG_termination].u_int));
+    if (audio_pcm_out_running()) {
+        // TERMINATION_DONE lets the file play to its end, or the written data drain
+        if (args[ARG_termination].u_int == TERMINATION_TYPE_NOW) {
+            audio_player_pcm_stop();
+        } else if (core.sink != NULL) {
+            rb_done_write(core.sink);
+        }
+        return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+    }
+    if (core.handle == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    return mp_obj_new_int(esp_audio_stop(core.handle, args[ARG_termination].u_int));
 }
 
 STATIC mp_obj_t audio_player_stop(mp_uint_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
@@ -241,17 +729,39 @@ STATIC mp_obj_t audio_player_stop(mp_uint_t n_args, const mp_obj_t *args, mp_map
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_player_stop_obj, 1, audio_player_stop);
 
+STATIC void audio_player_pcm_pause(audio_player_obj_t *self, bool pause)
+{
+    audio_pcm_out_pause(pause);
+    esp_audio_state_t state = {
+        .status = pause ? AUDIO_STATUS_PAUSED : AUDIO_STATUS_RUNNING,
+        .err_msg = ESP_ERR_AUDIO_NO_ERROR,
+    };
+    audio_state_cb(&state, self);
+}
+
 STATIC mp_obj_t audio_player_pause(mp_obj_t self_in)
 {
-    audio_player_obj_t *self = self_in;
-    return mp_obj_new_int(esp_audio_pause(self->player));
+    if (audio_pcm_out_running()) {
+        audio_player_pcm_pause(self_in, true);
+        return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+    }
+    if (core.handle == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    return mp_obj_new_int(esp_audio_pause(core.handle));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_pause_obj, audio_player_pause);
 
 STATIC mp_obj_t audio_player_resume(mp_obj_t self_in)
 {
-    audio_player_obj_t *self = self_in;
-    return mp_obj_new_int(esp_audio_resume(self->player));
+    if (audio_pcm_out_running()) {
+        audio_player_pcm_pause(self_in, false);
+        return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+    }
+    if (core.handle == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    return mp_obj_new_int(esp_audio_resume(core.handle));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_resume_obj, audio_player_resume);
 
@@ -268,11 +778,11 @@ STATIC mp_obj_t audio_player_vol_helper(audio_player_obj_t *self, mp_uint_t n_ar
 
     if (args[ARG_vol].u_int == 0xffff) {
         int vol = 0;
-        esp_audio_vol_get(self->player, &vol);
+        esp_audio_vol_get(audio_player_core_get(), &vol);
         return mp_obj_new_int(vol);
     } else {
         if (args[ARG_vol].u_int >= 0 && args[ARG_vol].u_int <= 100) {
-            return mp_obj_new_int(esp_audio_vol_set(self->player, args[ARG_vol].u_int));
+            return mp_obj_new_int(esp_audio_vol_set(audio_player_core_get(), args[ARG_vol].u_int));
         } else {
             return mp_obj_new_int(ESP_ERR_AUDIO_INVALID_PARAMETER);
         }
@@ -287,18 +797,16 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_player_vol_obj, 1, audio_player_vol);
 
 STATIC mp_obj_t audio_player_get_vol(mp_obj_t self_in)
 {
-    audio_player_obj_t *self = self_in;
     int vol = 0;
-    esp_audio_vol_get(self->player, &vol);
+    esp_audio_vol_get(audio_player_core_get(), &vol);
     return mp_obj_new_int(vol);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_get_vol_obj, audio_player_get_vol);
 
 STATIC mp_obj_t audio_player_set_vol(mp_obj_t self_in, mp_obj_t vol)
 {
-    audio_player_obj_t *self = self_in;
     int volume = mp_obj_get_int(vol);
-    return mp_obj_new_int(esp_audio_vol_set(self->player, volume));
+    return mp_obj_new_int(esp_audio_vol_set(audio_player_core_get(), volume));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(audio_player_set_vol_obj, audio_player_set_vol);
 
@@ -315,11 +823,384 @@ STATIC mp_obj_t audio_player_state(mp_obj_t self_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_state_obj, audio_player_state);
 
-STATIC mp_obj_t audio_player_pos(mp_obj_t self_in)
+STATIC mp_obj_t audio_player_pcm(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_rate,
+        ARG_channels,
+        ARG_bits,
+        ARG_size,
+        ARG_block,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_rate, MP_ARG_INT, { .u_int = PLAYER_OUTPUT_RATE } },
+        { MP_QSTR_channels, MP_ARG_INT, { .u_int = 2 } },
+        { MP_QSTR_bits, MP_ARG_INT, { .u_int = 16 } },
+        { MP_QSTR_size, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = PLAYER_SINK_SIZE } },
+        { MP_QSTR_block, MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = true } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_player_obj_t *self = pos_args[0];
+
+    if (!audio_pcm_out_supported(args[ARG_channels].u_int, args[ARG_bits].u_int) || args[ARG_rate].u_int <= 0) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_SUPPORT);
+    }
+    if (audio_recorder_port_held()) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NOT_READY);
+    }
+    // the I2S writer of the core installs the driver
+    audio_player_halt(audio_player_core_get());
+
+    audio_mem_stats_subsystem("player");
+    audio_placement_enter("pcm", AUDIO_PLACE_KIND_RB);
+    core.sink = rb_create(args[ARG_size].u_int, 1);
+    audio_placement_exit();
+    audio_mem_stats_subsystem(NULL);
+    if (core.sink == NULL) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_MEMORY_LACK);
+    }
+    core.sink_block = args[ARG_block].u_bool;
+    core.pcm_start = 0;
+    core.pcm_rate = args[ARG_rate].u_int;
+
+    MP_STATE_VM(audio_player_pcm_owner) = MP_OBJ_FROM_PTR(self);
+    self->state.status = AUDIO_STATUS_RUNNING;
+    self->state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+
+    audio_pcm_out_cfg_t cfg = AUDIO_PCM_OUT_CFG_DEFAULT();
+    cfg.sample_rate = args[ARG_rate].u_int;
+    cfg.channels = args[ARG_channels].u_int;
+    cfg.bits = args[ARG_bits].u_int;
+    cfg.read = audio_player_sink_read;
+    cfg.done = audio_player_sink_done;
+    cfg.ctx = self;
+    cfg.meter = &core.meter;
+    cfg.mirror = &core.mirror;
+    if (audio_pcm_out_start(&cfg) != ESP_OK) {
+        rb_destroy(core.sink);
+        core.sink = NULL;
+        MP_STATE_VM(audio_player_pcm_owner) = mp_const_none;
+        self->state.status = AUDIO_STATUS_ERROR;
+        self->state.err_msg = ESP_ERR_AUDIO_FAIL;
+        return mp_obj_new_int(ESP_ERR_AUDIO_FAIL);
+    }
+    return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_player_pcm_obj, 1, audio_player_pcm);
+
+STATIC mp_obj_t audio_player_free(mp_obj_t self_in)
+{
+    if (core.sink == NULL || !audio_pcm_out_running()) {
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    return MP_OBJ_NEW_SMALL_INT(rb_bytes_available(core.sink));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_free_obj, audio_player_free);
+
+STATIC mp_obj_t audio_player_meter(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_t meter = n_args > 1 ? args[1] : mp_const_none;
+    audio_meter_t *m = audio_meter_from_obj(meter);
+    // returns once the output task let go of the previous one
+    audio_meter_slot_set(&core.meter, m);
+    MP_STATE_VM(audio_player_meter_ref) = meter;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_player_meter_obj, 1, 2, audio_player_meter);
+
+STATIC audio_element_handle_t audio_player_mirror_create_stream(const char *uri)
+{
+    audio_element_handle_t el;
+    if (strncmp(uri, "http://", 7) == 0 || strncmp(uri, "https://", 8) == 0) {
+        audio_upload_cfg_t up_cfg = AUDIO_UPLOAD_CFG_DEFAULT();
+        up_cfg.upload = &core.mirror_upload;
+        up_cfg.content_type = "audio/wav";
+        up_cfg.head = AUDIO_UPLOAD_HEAD_WAV;
+        up_cfg.sample_rate = PLAYER_OUTPUT_RATE;
+        up_cfg.channels = 2;
+        up_cfg.bits = 16;
+        up_cfg.task_stack = audio_stack_size("mirror", "upload", up_cfg.task_stack);
+        up_cfg.stack_in_ext = audio_placement_stack_in_ext("mirror", up_cfg.stack_in_ext);
+        audio_placement_enter("mirror", AUDIO_PLACE_KIND_BUF);
+        el = audio_upload_init(&up_cfg);
+        audio_placement_exit();
+        core.mirror_upload_on = el != NULL;
+    } else if (strstr(uri, "/sdcard/") != NULL) {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_WRITER;
+        vfs_cfg.task_core = 1;
+        vfs_cfg.task_stack = audio_stack_size("mirror", "vfs", vfs_cfg.task_stack);
+        vfs_cfg.stack_in_ext = audio_placement_stack_in_ext("mirror", vfs_cfg.stack_in_ext);
+        audio_placement_enter("mirror", AUDIO_PLACE_KIND_BUF);
+        el = vfs_stream_init(&vfs_cfg);
+        audio_placement_exit();
+    } else {
+        // read by Python with mirror_readinto(), the tee queue is its only buffer
+        raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+        raw_cfg.type = AUDIO_STREAM_WRITER;
+        el = raw_stream_init(&raw_cfg);
+        core.mirror_raw = el != NULL;
+    }
+    if (el == NULL) {
+        return NULL;
+    }
+    audio_element_set_uri(el, uri);
+    // the header of a .wav file
+    audio_element_info_t info;
+    audio_element_getinfo(el, &info);
+    info.sample_rates = PLAYER_OUTPUT_RATE;
+    info.channels = 2;
+    info.bits = 16;
+    audio_element_setinfo(el, &info);
+    return el;
+}
+
+STATIC void audio_player_mirror_get_stats(audio_tee_stats_t *stats)
+{
+    if (core.mirror_tee != NULL) {
+        audio_tee_get_stats(core.mirror_tee, 0, stats);
+    } else {
+        memcpy(stats, &core.mirror_stats, sizeof(audio_tee_stats_t));
+    }
+}
+
+// the sink writes out what the tee still holds and finishes its file or request
+STATIC void audio_player_mirror_release(void)
+{
+    if (core.mirror_tee == NULL) {
+        return;
+    }
+    audio_tee_slot_set(&core.mirror, NULL);
+    audio_tee_write_done(core.mirror_tee);
+    if (core.mirror_pipeline != NULL) {
+        audio_element_wait_for_stop_ms(core.mirror_stream, pdMS_TO_TICKS(PLAYER_MIRROR_DRAIN_MS));
+        audio_pipeline_stop(core.mirror_pipeline);
+        audio_pipeline_wait_for_stop(core.mirror_pipeline);
+        audio_stack_untrack(core.mirror_stream);
+        audio_pipeline_deinit(core.mirror_pipeline);
+    } else {
+        // a read in another thread sees the end within a poll
+        while (core.mirror_reading) {
+            MP_THREAD_GIL_EXIT();
+            vTaskDelay(1);
+            MP_THREAD_GIL_ENTER();
+        }
+        audio_element_deinit(core.mirror_stream);
+    }
+    audio_tee_get_stats(core.mirror_tee, 0, &core.mirror_stats);
+    audio_element_deinit(core.mirror_tee);
+    core.mirror_tee = NULL;
+    core.mirror_pipeline = NULL;
+    core.mirror_stream = NULL;
+}
+
+STATIC int audio_player_mirror_create(const char *uri, int depth)
+{
+    audio_mem_stats_subsystem("player");
+    audio_tee_cfg_t tee_cfg = AUDIO_TEE_CFG_DEFAULT();
+    tee_cfg.branches = 1;
+    tee_cfg.depth = depth;
+    audio_placement_enter("mirror", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t tee = audio_tee_init(&tee_cfg);
+    audio_placement_exit();
+    core.mirror_upload_on = false;
+    core.mirror_raw = false;
+    audio_element_handle_t el = tee != NULL ? audio_player_mirror_create_stream(uri) : NULL;
+    audio_mem_stats_subsystem(NULL);
+    if (el == NULL) {
+        if (tee != NULL) {
+            audio_element_deinit(tee);
+        }
+        core.mirror_upload_on = false;
+        return ESP_ERR_AUDIO_MEMORY_LACK;
+    }
+    audio_tee_connect(tee, 0, el);
+    core.mirror_tee = tee;
+    core.mirror_stream = el;
+    core.mirror_used = true;
+    core.mirror.skipped = 0;
+    if (!core.mirror_raw) {
+        audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+        core.mirror_pipeline = audio_pipeline_init(&pipeline_cfg);
+        audio_pipeline_register(core.mirror_pipeline, el, "mirror");
+        audio_stack_track(el);
+        const char *link_tag[1] = {"mirror"};
+        audio_pipeline_link(core.mirror_pipeline, &link_tag[0], 1);
+        audio_pipeline_run(core.mirror_pipeline);
+    }
+    // the tee is never run, the output writes to it and the sink reads from it
+    audio_tee_slot_set(&core.mirror, tee);
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+STATIC mp_obj_t audio_player_mirror(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_uri,
+        ARG_depth,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_uri, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_depth, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = PLAYER_MIRROR_DEPTH } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    audio_player_mirror_release();
+    if (args[ARG_uri].u_obj == mp_const_none) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_NO_ERROR);
+    }
+    if (args[ARG_depth].u_int < 1) {
+        return mp_obj_new_int(ESP_ERR_AUDIO_INVALID_PARAMETER);
+    }
+    return mp_obj_new_int(audio_player_mirror_create(mp_obj_str_get_str(args[ARG_uri].u_obj), args[ARG_depth].u_int));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_player_mirror_obj, 1, audio_player_mirror);
+
+STATIC const qstr mirror_info_fields[] = {
+    MP_QSTR_blocks, MP_QSTR_dropped, MP_QSTR_peak, MP_QSTR_skipped, MP_QSTR_sent, MP_QSTR_status, MP_QSTR_failed
+};
+
+STATIC mp_obj_t audio_player_mirror_info(mp_obj_t self_in)
+{
+    if (!core.mirror_used) {
+        return mp_const_none;
+    }
+    audio_tee_stats_t stats;
+    audio_player_mirror_get_stats(&stats);
+    audio_upload_t *up = &core.mirror_upload;
+    mp_obj_t items[7] = {
+        mp_obj_new_int_from_uint(stats.blocks),
+        mp_obj_new_int_from_uint(stats.dropped),
+        mp_obj_new_int_from_uint(stats.peak),
+        mp_obj_new_int_from_uint(core.mirror.skipped),
+        mp_obj_new_int_from_uint(core.mirror_upload_on ? up->sent : 0),
+        MP_OBJ_NEW_SMALL_INT(core.mirror_upload_on ? up->status : 0),
+        mp_obj_new_bool(core.mirror_upload_on && up->failed),
+    };
+    return mp_obj_new_attrtuple(mirror_info_fields, 7, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_mirror_info_obj, audio_player_mirror_info);
+
+STATIC mp_obj_t audio_player_mirror_readinto(size_t n_args, const mp_obj_t *args)
+{
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    int timeout_ms = n_args > 2 && args[2] != mp_const_none ? mp_obj_get_int(args[2]) : -1;
+    if (core.mirror_tee == NULL) {
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    if (!core.mirror_raw) {
+        mp_raise_OSError(MP_EINVAL);
+    }
+    audio_element_set_input_timeout(core.mirror_stream, timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms));
+    core.mirror_reading = true;
+    MP_THREAD_GIL_EXIT();
+    // straight from the shared blocks into the caller's buffer
+    int ret = raw_stream_read(core.mirror_stream, bufinfo.buf, bufinfo.len);
+    core.mirror_reading = false;
+    MP_THREAD_GIL_ENTER();
+    if (ret == AEL_IO_TIMEOUT) {
+        return mp_const_none;
+    }
+    return MP_OBJ_NEW_SMALL_INT(ret > 0 ? ret : 0);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_player_mirror_readinto_obj, 2, 3, audio_player_mirror_readinto);
+
+STATIC mp_uint_t audio_player_stream_write(mp_obj_t self_in, const void *buf, mp_uint_t size, int *errcode)
+{
+    if (core.sink == NULL || !audio_pcm_out_running()) {
+        *errcode = MP_EPIPE;
+        return MP_STREAM_ERROR;
+    }
+    int ret;
+    if (core.sink_block) {
+        MP_THREAD_GIL_EXIT();
+        ret = rb_write(core.sink, (char *)buf, size, portMAX_DELAY);
+        MP_THREAD_GIL_ENTER();
+    } else {
+        int space = rb_bytes_available(core.sink);
+        if (space <= 0) {
+            *errcode = MP_EAGAIN;
+            return MP_STREAM_ERROR;
+        }
+        ret = rb_write(core.sink, (char *)buf, size < (mp_uint_t)space ? (int)size : space, 0);
+    }
+    if (ret < 0) {
+        // aborted by stop() or closed by stop(TERMINATION_DONE)
+        *errcode = MP_EPIPE;
+        return MP_STREAM_ERROR;
+    }
+    return ret;
+}
+
+STATIC mp_uint_t audio_player_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode)
+{
+    if (request == MP_STREAM_POLL) {
+        mp_uint_t ret = 0;
+        if (core.sink != NULL && audio_pcm_out_running()) {
+            if (rb_bytes_available(core.sink) > 0) {
+                ret |= arg & MP_STREAM_POLL_WR;
+            }
+        } else {
+            ret |= arg & MP_STREAM_POLL_ERR;
+        }
+        return ret;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+STATIC const mp_stream_p_t audio_player_stream_p = {
+    .write = audio_player_stream_write,
+    .ioctl = audio_player_ioctl,
+};
+
+STATIC mp_obj_t audio_player_check_state(mp_obj_t self_in, mp_obj_t status_in)
 {
     audio_player_obj_t *self = self_in;
+    int status = self->state.status;
+    bool match;
+    if (status_in == MP_OBJ_NULL || status_in == mp_const_none) {
+        match = status == AUDIO_STATUS_STOPPED || status == AUDIO_STATUS_FINISHED || status == AUDIO_STATUS_ERROR;
+    } else if (mp_obj_is_int(status_in)) {
+        match = status == mp_obj_get_int(status_in);
+    } else {
+        match = mp_obj_is_true(mp_binary_op(MP_BINARY_OP_CONTAINS, status_in, MP_OBJ_NEW_SMALL_INT(status)));
+    }
+    return match ? audio_player_state(self) : MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t audio_player_play_async(mp_uint_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
+{
+    audio_player_obj_t *self = args[0];
+    int err = mp_obj_get_int(audio_player_play_helper(self, n_args - 1, args + 1, kw_args));
+    if (err != ESP_ERR_AUDIO_NO_ERROR) {
+        self->state.status = AUDIO_STATUS_ERROR;
+        self->state.err_msg = err;
+    }
+    return audio_async_wait_new(self, &self->event, audio_player_check_state, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_player_play_async_obj, 1, audio_player_play_async);
+
+STATIC mp_obj_t audio_player_wait_state(size_t n_args, const mp_obj_t *args)
+{
+    audio_player_obj_t *self = args[0];
+    return audio_async_wait_new(self, &self->event, audio_player_check_state, n_args > 1 ? args[1] : MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_player_wait_state_obj, 1, 2, audio_player_wait_state);
+
+STATIC mp_obj_t audio_player_pos(mp_obj_t self_in)
+{
     int pos = -1;
-    int err = esp_audio_pos_get(self->player, &pos);
+    if (audio_pcm_out_running()) {
+        return mp_obj_new_int(core.pcm_start + audio_pcm_out_bytes());
+    }
+    if (core.handle == NULL) {
+        return mp_const_none;
+    }
+    int err = esp_audio_pos_get(core.handle, &pos);
     if (err == ESP_ERR_AUDIO_NO_ERROR) {
         return mp_obj_new_int(pos);
     } else {
@@ -330,9 +1211,14 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_player_pos_obj, audio_player_pos);
 
 STATIC mp_obj_t audio_player_time(mp_obj_t self_in)
 {
-    audio_player_obj_t *self = self_in;
     int time = 0;
-    int err = esp_audio_time_get(self->player, &time);
+    if (audio_pcm_out_running()) {
+        return mp_obj_new_int(audio_pcm_out_time());
+    }
+    if (core.handle == NULL) {
+        return mp_const_none;
+    }
+    int err = esp_audio_time_get(core.handle, &time);
     if (err == ESP_ERR_AUDIO_NO_ERROR) {
         return mp_obj_new_int(time);
     } else {
@@ -353,6 +1239,15 @@ STATIC const mp_rom_map_elem_t player_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_get_state), MP_ROM_PTR(&audio_player_state_obj) },
     { MP_ROM_QSTR(MP_QSTR_pos), MP_ROM_PTR(&audio_player_pos_obj) },
     { MP_ROM_QSTR(MP_QSTR_time), MP_ROM_PTR(&audio_player_time_obj) },
+    { MP_ROM_QSTR(MP_QSTR_play_async), MP_ROM_PTR(&audio_player_play_async_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pcm), MP_ROM_PTR(&audio_player_pcm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free), MP_ROM_PTR(&audio_player_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR_meter), MP_ROM_PTR(&audio_player_meter_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mirror), MP_ROM_PTR(&audio_player_mirror_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mirror_info), MP_ROM_PTR(&audio_player_mirror_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mirror_readinto), MP_ROM_PTR(&audio_player_mirror_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait_state), MP_ROM_PTR(&audio_player_wait_state_obj) },
 
     // esp_audio_status_t
     { MP_ROM_QSTR(MP_QSTR_STATUS_UNKNOWN), MP_ROM_INT(AUDIO_STATUS_UNKNOWN) },
@@ -374,5 +1269,6 @@ MP_DEFINE_CONST_OBJ_TYPE(
     MP_QSTR_player,
     MP_TYPE_FLAG_NONE,
     make_new, audio_player_make_new,
+    protocol, &audio_player_stream_p,
     locals_dict, &player_locals_dict
     );
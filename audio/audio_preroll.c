@@ -0,0 +1,206 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_preroll.h"
+
+static const char *TAG = "PREROLL";
+
+typedef struct audio_preroll {
+    uint8_t *ring;
+    int size;
+    int head;          // next write position
+    int filled;
+    SemaphoreHandle_t lock;
+    // the recording being fed, guarded by lock
+    ringbuf_handle_t fwd;
+    bool flushed;
+    bool closed;       // limit reached or aborted by the reader
+    bool paused;       // the ring keeps filling, nothing is forwarded
+    uint32_t sent;
+    uint32_t limit;
+} audio_preroll_t;
+
+static void _preroll_store(audio_preroll_t *pre, const char *buf, int len)
+{
+    if (len >= pre->size) {
+        buf += len - pre->size;
+        len = pre->size;
+    }
+    int first = pre->size - pre->head;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(pre->ring + pre->head, buf, first);
+    memcpy(pre->ring, buf + first, len - first);
+    pre->head = (pre->head + len) % pre->size;
+    pre->filled = pre->filled + len > pre->size ? pre->size : pre->filled + len;
+}
+
+static void _preroll_forward(audio_preroll_t *pre, const char *buf, int len)
+{
+    if (pre->closed || len <= 0) {
+        return;
+    }
+    if (pre->limit && pre->sent + len > pre->limit) {
+        len = pre->limit - pre->sent;
+    }
+    if (len > 0 && rb_write(pre->fwd, (char *)buf, len, portMAX_DELAY) < 0) {
+        pre->closed = true;
+        return;
+    }
+    pre->sent += len;
+    if (pre->limit && pre->sent >= pre->limit) {
+        // the recording ends here, its elements drain and finish
+        rb_done_write(pre->fwd);
+        pre->closed = true;
+    }
+}
+
+static int _preroll_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_preroll_t *pre = (audio_preroll_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    xSemaphoreTake(pre->lock, portMAX_DELAY);
+    if (pre->fwd != NULL && !pre->paused) {
+        if (!pre->flushed) {
+            // oldest part first, the ring is full once it wrapped
+            int tail = (pre->head - pre->filled + pre->size) % pre->size;
+            int first = pre->size - tail < pre->filled ? pre->size - tail : pre->filled;
+            _preroll_forward(pre, (char *)pre->ring + tail, first);
+            _preroll_forward(pre, (char *)pre->ring, pre->filled - first);
+            pre->flushed = true;
+        }
+        _preroll_forward(pre, in_buffer, r_size);
+    }
+    xSemaphoreGive(pre->lock);
+    _preroll_store(pre, in_buffer, r_size);
+    return r_size;
+}
+
+esp_err_t audio_preroll_attach(audio_element_handle_t self, ringbuf_handle_t rb, uint32_t max_bytes)
+{
+    audio_preroll_t *pre = (audio_preroll_t *)audio_element_getdata(self);
+    esp_err_t ret = ESP_FAIL;
+    xSemaphoreTake(pre->lock, portMAX_DELAY);
+    if (pre->fwd == NULL) {
+        pre->fwd = rb;
+        pre->flushed = false;
+        pre->closed = false;
+        pre->paused = false;
+        pre->sent = 0;
+        pre->limit = max_bytes;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(pre->lock);
+    return ret;
+}
+
+void audio_preroll_detach(audio_element_handle_t self)
+{
+    audio_preroll_t *pre = (audio_preroll_t *)audio_element_getdata(self);
+    ringbuf_handle_t rb = pre->fwd;
+    if (rb == NULL) {
+        return;
+    }
+    // wake a write blocked on a full ringbuffer before waiting for the lock
+    rb_abort(rb);
+    xSemaphoreTake(pre->lock, portMAX_DELAY);
+    pre->fwd = NULL;
+    xSemaphoreGive(pre->lock);
+}
+
+void audio_preroll_pause(audio_element_handle_t self, bool pause)
+{
+    audio_preroll_t *pre = (audio_preroll_t *)audio_element_getdata(self);
+    xSemaphoreTake(pre->lock, portMAX_DELAY);
+    pre->paused = pause;
+    xSemaphoreGive(pre->lock);
+}
+
+static esp_err_t _preroll_destroy(audio_element_handle_t self)
+{
+    audio_preroll_t *pre = (audio_preroll_t *)audio_element_getdata(self);
+    vSemaphoreDelete(pre->lock);
+    audio_free(pre->ring);
+    audio_free(pre);
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_preroll_init(audio_preroll_cfg_t *config)
+{
+    audio_element_handle_t el;
+    audio_preroll_t *pre = audio_calloc(1, sizeof(audio_preroll_t));
+
+    AUDIO_MEM_CHECK(TAG, pre, return NULL);
+
+    int frame = config->frame_size > 0 ? config->frame_size : 1;
+    pre->size = config->ring_size - config->ring_size % frame;
+    if (pre->size <= 0) {
+        ESP_LOGE(TAG, "Ring of %d bytes is too small", config->ring_size);
+        goto _preroll_init_exit;
+    }
+    pre->ring = audio_calloc(1, pre->size);
+    AUDIO_MEM_CHECK(TAG, pre->ring, goto _preroll_init_exit);
+    pre->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, pre->lock, goto _preroll_init_exit);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.process = _preroll_process;
+    cfg.destroy = _preroll_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.buffer_len = config->buf_sz - config->buf_sz % frame;
+    if (cfg.buffer_len <= 0) {
+        cfg.buffer_len = AUDIO_PREROLL_BUF_SIZE;
+    }
+    cfg.tag = "preroll";
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _preroll_init_exit);
+    audio_element_setdata(el, pre);
+    return el;
+_preroll_init_exit:
+    if (pre->lock) {
+        vSemaphoreDelete(pre->lock);
+    }
+    audio_free(pre->ring);
+    audio_free(pre);
+    return NULL;
+}
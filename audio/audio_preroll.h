@@ -0,0 +1,104 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_PREROLL_H_
+#define _AUDIO_PREROLL_H_
+
+#include "audio_element.h"
+#include "ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_PREROLL_BUF_SIZE (1024)
+#define AUDIO_PREROLL_TASK_STACK (2560)
+#define AUDIO_PREROLL_TASK_CORE (1)
+#define AUDIO_PREROLL_TASK_PRIO (5)
+
+/**
+ * @brief   Pre-roll ring configuration
+ */
+typedef struct {
+    int ring_size;     /*!< Bytes of PCM kept, allocated with the element */
+    int frame_size;    /*!< Bytes per frame, the ring holds whole frames */
+    int buf_sz;        /*!< Audio Element Buffer size */
+    int task_stack;    /*!< Task stack size */
+    int task_core;     /*!< Task running in core (0 or 1) */
+    int task_prio;     /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext; /*!< Try to allocate stack in external memory */
+} audio_preroll_cfg_t;
+
+#define AUDIO_PREROLL_CFG_DEFAULT()             \
+{                                               \
+    .ring_size = 16 * 1024,                     \
+    .frame_size = 2,                            \
+    .buf_sz = AUDIO_PREROLL_BUF_SIZE,           \
+    .task_stack = AUDIO_PREROLL_TASK_STACK,     \
+    .task_core = AUDIO_PREROLL_TASK_CORE,       \
+    .task_prio = AUDIO_PREROLL_TASK_PRIO,       \
+    .stack_in_ext = false,                      \
+}
+
+/**
+ * @brief      Create the Audio Element ending an always-on capture pipeline. It keeps the
+ *             last ring_size bytes of its input and has no output ringbuffer until
+ *             `audio_preroll_attach` gives it one.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_preroll_init(audio_preroll_cfg_t *config);
+
+/**
+ * @brief      Start feeding a recording. The ring content goes out first, oldest frame first,
+ *             followed by the live input. After max_bytes, the pre-roll included, the
+ *             ringbuffer is marked done and nothing more is written.
+ *
+ * @param      rb         Ringbuffer read by the recording, at least ring_size bytes so the
+ *                        flush does not hold up the capture
+ * @param      max_bytes  Length limit, 0 for none
+ *
+ * @return     ESP_OK, ESP_FAIL when already attached
+ */
+esp_err_t audio_preroll_attach(audio_element_handle_t self, ringbuf_handle_t rb, uint32_t max_bytes);
+
+/**
+ * @brief      Stop feeding the recording, the ringbuffer is aborted and no longer used by the
+ *             element once this returns
+ */
+void audio_preroll_detach(audio_element_handle_t self);
+
+/**
+ * @brief      Hold back or resume the live input of the attached recording, the recording
+ *             waits for input meanwhile and the held back frames are dropped
+ */
+void audio_preroll_pause(audio_element_handle_t self, bool pause);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,908 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "extmod/vfs.h"
+#include "py/mpthread.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#include "audio_probe.h"
+
+static const char *TAG = "AUDIO_PROBE";
+
+typedef struct {
+    char uri[AUDIO_PROBE_URI_LEN]; // empty marks a free entry
+    // size and mtime of a file when probed, -1 for HTTP
+    int64_t size;
+    int64_t mtime;
+    audio_probe_type_t type;
+} audio_probe_cache_t;
+
+static audio_probe_cache_t cache[AUDIO_PROBE_CACHE_SIZE];
+static int cache_next = 0;
+
+static const char *suffix_names[] = {
+    [AUDIO_PROBE_UNKNOWN] = NULL,
+    [AUDIO_PROBE_MP3] = "mp3",
+    [AUDIO_PROBE_WAV] = "wav",
+    [AUDIO_PROBE_AMR] = "amr",
+    [AUDIO_PROBE_AMRWB] = "Wamr",
+    [AUDIO_PROBE_OGG] = "ogg",
+    [AUDIO_PROBE_OPUS] = "opus",
+    [AUDIO_PROBE_AAC] = "aac",
+};
+
+static int audio_probe_syncsafe(const uint8_t *buf)
+{
+    return ((buf[0] & 0x7f) << 21) | ((buf[1] & 0x7f) << 14) | ((buf[2] & 0x7f) << 7) | (buf[3] & 0x7f);
+}
+
+static int audio_probe_id3_size(const uint8_t *buf, int len)
+{
+    if (len < 10 || memcmp(buf, "ID3", 3) != 0) {
+        return 0;
+    }
+    return audio_probe_syncsafe(buf + 6) + ((buf[5] & 0x10) ? 20 : 10);
+}
+
+static bool audio_probe_mpeg_sync(const uint8_t *buf)
+{
+    // 11 bit sync, valid version, layer III, bitrate and sample rate indexes
+    return buf[0] == 0xff && (buf[1] & 0xe0) == 0xe0
+           && ((buf[1] >> 3) & 0x03) != 0x01
+           && ((buf[1] >> 1) & 0x03) == 0x01
+           && (buf[2] >> 4) != 0x0f && (buf[2] >> 4) != 0x00
+           && ((buf[2] >> 2) & 0x03) != 0x03;
+}
+
+audio_probe_type_t audio_probe_buffer(const uint8_t *buf, int len)
+{
+    if (len >= 12 && memcmp(buf, "RIFF", 4) == 0 && memcmp(buf + 8, "WAVE", 4) == 0) {
+        return AUDIO_PROBE_WAV;
+    }
+    if (len >= 9 && memcmp(buf, "#!AMR-WB\n", 9) == 0) {
+        return AUDIO_PROBE_AMRWB;
+    }
+    if (len >= 6 && memcmp(buf, "#!AMR\n", 6) == 0) {
+        return AUDIO_PROBE_AMR;
+    }
+    if (len >= 4 && memcmp(buf, "OggS", 4) == 0) {
+        if (len >= 36 && memcmp(buf + 28, "OpusHead", 8) == 0) {
+            return AUDIO_PROBE_OPUS;
+        }
+        return AUDIO_PROBE_OGG;
+    }
+    int offset = audio_probe_id3_size(buf, len);
+    if (offset > 0 && offset >= len - 4) {
+        // the tag is larger than the probe, ID3 is only used with MP3 here
+        return AUDIO_PROBE_MP3;
+    }
+    for (int i = offset; i + 4 <= len; i++) {
+        if (buf[i] != 0xff) {
+            continue;
+        }
+        if (audio_probe_mpeg_sync(buf + i)) {
+            return AUDIO_PROBE_MP3;
+        }
+        if ((buf[i + 1] & 0xf6) == 0xf0) {
+            return AUDIO_PROBE_AAC;
+        }
+    }
+    return AUDIO_PROBE_UNKNOWN;
+}
+
+static uint32_t audio_probe_le32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+bool audio_probe_wav(const uint8_t *buf, int len, audio_probe_wav_t *wav)
+{
+    if (len < 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    memset(wav, 0, sizeof(audio_probe_wav_t));
+    int offset = 12;
+    while (offset + 8 <= len) {
+        const uint8_t *chunk = buf + offset;
+        uint32_t size = audio_probe_le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && offset + 24 <= len) {
+            wav->format = chunk[8] | (chunk[9] << 8);
+            wav->channels = chunk[10] | (chunk[11] << 8);
+            wav->sample_rate = audio_probe_le32(chunk + 12);
+            wav->byte_rate = audio_probe_le32(chunk + 16);
+            wav->bits = chunk[22] | (chunk[23] << 8);
+            if (wav->format == 0xfffe && size >= 40 && offset + 34 <= len) {
+                // WAVE_FORMAT_EXTENSIBLE, the sub format starts with the format tag
+                wav->format = chunk[32] | (chunk[33] << 8);
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            wav->data_offset = offset + 8;
+            wav->data_size = size;
+            return wav->channels > 0;
+        }
+        if (size > len - offset - 8) {
+            break;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+static uint32_t audio_probe_be32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+}
+
+static int audio_probe_put_utf8(char *dst, int pos, int size, uint32_t c)
+{
+    uint8_t out[3];
+    int n = 1;
+    if (c < 0x80) {
+        out[0] = c;
+    } else if (c < 0x800) {
+        out[0] = 0xc0 | (c >> 6);
+        out[1] = 0x80 | (c & 0x3f);
+        n = 2;
+    } else {
+        out[0] = 0xe0 | (c >> 12);
+        out[1] = 0x80 | ((c >> 6) & 0x3f);
+        out[2] = 0x80 | (c & 0x3f);
+        n = 3;
+    }
+    if (pos + n >= size) {
+        return -1;
+    }
+    memcpy(dst + pos, out, n);
+    return pos + n;
+}
+
+// length of a valid multibyte UTF-8 sequence, 0 if it is not one
+static int audio_probe_utf8_len(const uint8_t *src, int len)
+{
+    int n = src[0] >= 0xf5 ? 0 : src[0] >= 0xf0 ? 4 : src[0] >= 0xe0 ? 3 : src[0] >= 0xc2 ? 2 : 0;
+    if (n == 0 || n > len) {
+        return 0;
+    }
+    for (int i = 1; i < n; i++) {
+        if ((src[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+// copy a tag as UTF-8, encoding is the ID3v2 one: 0 Latin-1, 1 UTF-16 with BOM, 2 UTF-16BE, 3 UTF-8
+static void audio_probe_text(char *dst, int size, const uint8_t *src, int len, int encoding)
+{
+    bool utf16 = encoding == 1 || encoding == 2;
+    bool big_endian = encoding == 2;
+    if (encoding == 1 && len >= 2 && ((src[0] == 0xfe && src[1] == 0xff) || (src[0] == 0xff && src[1] == 0xfe))) {
+        big_endian = src[0] == 0xfe;
+        src += 2;
+        len -= 2;
+    }
+    int pos = 0;
+    int i = 0;
+    while (i < len) {
+        uint32_t c = src[i];
+        int next = pos;
+        if (utf16) {
+            if (i + 2 > len) {
+                break;
+            }
+            c = big_endian ? (src[i] << 8) | src[i + 1] : src[i] | (src[i + 1] << 8);
+            i += 2;
+            if (c >= 0xd800 && c < 0xe000) {
+                // outside the BMP, drop the low surrogate too
+                i += c < 0xdc00 ? 2 : 0;
+                c = '?';
+            }
+        } else if (encoding == 3 && c >= 0x80 && audio_probe_utf8_len(src + i, len - i) > 0) {
+            int n = audio_probe_utf8_len(src + i, len - i);
+            if (pos + n >= size) {
+                break;
+            }
+            memcpy(dst + pos, src + i, n);
+            pos += n;
+            i += n;
+            continue;
+        } else {
+            // Latin-1, or bytes that are not valid UTF-8
+            i++;
+        }
+        if (c == 0 || (next = audio_probe_put_utf8(dst, pos, size, c)) < 0) {
+            break;
+        }
+        pos = next;
+    }
+    while (pos > 0 && dst[pos - 1] == ' ') {
+        pos--;
+    }
+    dst[pos] = '\0';
+}
+
+static void audio_probe_id3_tags(const uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    int version = buf[3];
+    if (version < 2 || version > 4 || (buf[5] & 0x80)) {
+        // unsynchronised tags are rare, the ID3v1 tag may still be there
+        return;
+    }
+    int end = audio_probe_id3_size(buf, len);
+    end = end < len ? end : len;
+    int offset = 10;
+    if ((buf[5] & 0x40) && version > 2 && len >= 14) {
+        // the v2.3 extended header size does not count itself
+        offset += version == 3 ? (int)audio_probe_be32(buf + 10) + 4 : audio_probe_syncsafe(buf + 10);
+    }
+    int head = version == 2 ? 6 : 10;
+    while (offset > 0 && offset + head <= end && buf[offset] != 0) {
+        const uint8_t *frame = buf + offset;
+        uint32_t size;
+        char *dst = NULL;
+        if (version == 2) {
+            size = (frame[3] << 16) | (frame[4] << 8) | frame[5];
+            dst = memcmp(frame, "TT2", 3) == 0 ? info->title
+                  : memcmp(frame, "TP1", 3) == 0 ? info->artist
+                  : memcmp(frame, "TAL", 3) == 0 ? info->album : NULL;
+        } else {
+            size = version == 4 ? audio_probe_syncsafe(frame + 4) : audio_probe_be32(frame + 4);
+            dst = memcmp(frame, "TIT2", 4) == 0 ? info->title
+                  : memcmp(frame, "TPE1", 4) == 0 ? info->artist
+                  : memcmp(frame, "TALB", 4) == 0 ? info->album : NULL;
+        }
+        if (size > end - offset - head) {
+            // the rest is past the probe, text frames usually come before the pictures
+            break;
+        }
+        if (dst != NULL && size > 1 && dst[0] == '\0') {
+            audio_probe_text(dst, AUDIO_PROBE_TAG_LEN, frame + head + 1, size - 1, frame[head]);
+        }
+        offset += head + size;
+    }
+}
+
+static void audio_probe_id3v1_tags(const uint8_t *tag, audio_probe_info_t *info)
+{
+    char *fields[3] = { info->title, info->artist, info->album };
+    for (int i = 0; i < 3; i++) {
+        if (fields[i][0] == '\0') {
+            audio_probe_text(fields[i], AUDIO_PROBE_TAG_LEN, tag + 3 + i * 30, 30, 0);
+        }
+    }
+}
+
+static const uint16_t mpeg_bitrates[2][15] = {
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+};
+
+static const uint16_t mpeg_rates[3] = { 44100, 48000, 32000 };
+
+// fill in the format of a layer III header and return the frame length
+static int audio_probe_mpeg_frame(const uint8_t *buf, audio_probe_info_t *info)
+{
+    // version 3 is MPEG-1, 2 MPEG-2 and 0 MPEG-2.5
+    int version = (buf[1] >> 3) & 0x03;
+    int lsf = version != 3;
+    info->bitrate = mpeg_bitrates[lsf][buf[2] >> 4] * 1000;
+    info->sample_rate = mpeg_rates[(buf[2] >> 2) & 0x03] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    info->channels = (buf[3] >> 6) == 3 ? 1 : 2;
+    return (lsf ? 72 : 144) * info->bitrate / info->sample_rate + ((buf[2] >> 1) & 0x01);
+}
+
+static void audio_probe_mp3_info(audio_probe_src_t *src, uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    int64_t start = audio_probe_id3_size(buf, len);
+    if (start > 0) {
+        audio_probe_id3_tags(buf, len, info);
+        len = src->read(src, start, buf, AUDIO_PROBE_INFO_SIZE);
+    }
+    // the first header followed by another one, a lone 0xff in the data is not a frame
+    int i = 0;
+    int frame_len = 0;
+    for (; i + 4 <= len; i++) {
+        if (audio_probe_mpeg_sync(buf + i) && (frame_len = audio_probe_mpeg_frame(buf + i, info)) > 0
+            && (i + frame_len + 4 > len || audio_probe_mpeg_sync(buf + i + frame_len))) {
+            break;
+        }
+    }
+    if (i + 4 > len) {
+        info->bitrate = 0;
+        info->sample_rate = 0;
+        info->channels = 0;
+        return;
+    }
+    start += i;
+    const uint8_t *frame = buf + i;
+    bool lsf = ((frame[1] >> 3) & 0x03) != 3;
+    int samples = lsf ? 576 : 1152;
+    int side = lsf ? (info->channels == 1 ? 9 : 17) : (info->channels == 1 ? 17 : 32);
+    int64_t frames = 0;
+    int64_t bytes = 0;
+    const uint8_t *xing = frame + 4 + side;
+    const uint8_t *vbri = frame + 36;
+    if (i + 4 + side + 16 <= len && (memcmp(xing, "Xing", 4) == 0 || memcmp(xing, "Info", 4) == 0)) {
+        uint32_t flags = audio_probe_be32(xing + 4);
+        int at = 8;
+        if (flags & 0x01) {
+            frames = audio_probe_be32(xing + at);
+            at += 4;
+        }
+        if (flags & 0x02) {
+            bytes = audio_probe_be32(xing + at);
+        }
+    } else if (i + 36 + 18 <= len && memcmp(vbri, "VBRI", 4) == 0) {
+        bytes = audio_probe_be32(vbri + 10);
+        frames = audio_probe_be32(vbri + 14);
+    }
+
+    int64_t end = src->size;
+    if (end >= 128 && src->read(src, end - 128, buf, 128) == 128 && memcmp(buf, "TAG", 3) == 0) {
+        audio_probe_id3v1_tags(buf, info);
+        end -= 128;
+    }
+    int64_t audio_len = end > start ? end - start : 0;
+    if (frames > 0) {
+        info->duration_ms = frames * samples * 1000 / info->sample_rate;
+        bytes = bytes > 0 ? bytes : audio_len;
+        if (bytes > 0 && info->duration_ms > 0) {
+            info->bitrate = bytes * 8000 / info->duration_ms;
+        }
+    } else if (audio_len > 0) {
+        // no frame count, exact for CBR only
+        info->duration_ms = audio_len * 8000 / info->bitrate;
+        info->estimated = true;
+    }
+}
+
+static void audio_probe_wav_tags(const uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    int offset = 12;
+    while (offset + 12 <= len && memcmp(buf + offset, "data", 4) != 0) {
+        uint32_t size = audio_probe_le32(buf + offset + 4);
+        if (memcmp(buf + offset, "LIST", 4) == 0 && memcmp(buf + offset + 8, "INFO", 4) == 0) {
+            int end = size < len - offset - 8 ? offset + 8 + size : len;
+            int sub = offset + 12;
+            while (sub + 8 <= end) {
+                const uint8_t *chunk = buf + sub;
+                uint32_t sub_size = audio_probe_le32(chunk + 4);
+                if (sub_size > end - sub - 8) {
+                    break;
+                }
+                char *dst = memcmp(chunk, "INAM", 4) == 0 ? info->title
+                            : memcmp(chunk, "IART", 4) == 0 ? info->artist
+                            : memcmp(chunk, "IPRD", 4) == 0 ? info->album : NULL;
+                if (dst != NULL) {
+                    audio_probe_text(dst, AUDIO_PROBE_TAG_LEN, chunk + 8, sub_size, 3);
+                }
+                sub += 8 + sub_size + (sub_size & 1);
+            }
+        }
+        if (size > len) {
+            break;
+        }
+        offset += 8 + size + (size & 1);
+    }
+}
+
+static void audio_probe_wav_info(audio_probe_src_t *src, const uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    audio_probe_wav_t wav;
+    if (!audio_probe_wav(buf, len, &wav)) {
+        return;
+    }
+    info->sample_rate = wav.sample_rate;
+    info->channels = wav.channels;
+    info->bits = wav.format == 1 || wav.format == 3 ? wav.bits : 0;
+    info->bitrate = wav.byte_rate * 8;
+    int64_t data_size = wav.data_size;
+    if (src->size > 0 && (data_size <= 0 || wav.data_offset + data_size > src->size)) {
+        // still recording, or the header was never finalised
+        data_size = src->size - wav.data_offset;
+    }
+    if (wav.byte_rate > 0 && data_size >= 0) {
+        info->duration_ms = data_size * 1000 / wav.byte_rate;
+    }
+    audio_probe_wav_tags(buf, len, info);
+}
+
+// bytes per frame including the header byte, speech modes only
+static const uint8_t amr_frame_sizes[] = { 13, 14, 16, 18, 20, 21, 27, 32 };
+static const uint8_t amrwb_frame_sizes[] = { 18, 24, 33, 37, 41, 47, 51, 59, 61 };
+
+static void audio_probe_amr_info(audio_probe_src_t *src, const uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    bool wb = info->type == AUDIO_PROBE_AMRWB;
+    int head = wb ? 9 : 6;
+    info->sample_rate = wb ? 16000 : 8000;
+    info->channels = 1;
+    if (len <= head) {
+        return;
+    }
+    int mode = (buf[head] >> 3) & 0x0f;
+    if (mode >= (wb ? sizeof(amrwb_frame_sizes) : sizeof(amr_frame_sizes))) {
+        return;
+    }
+    // 20 ms frames, the mode of the first one is taken for the whole file
+    int frame = wb ? amrwb_frame_sizes[mode] : amr_frame_sizes[mode];
+    info->bitrate = frame * 8 * 50;
+    if (src->size > head) {
+        info->duration_ms = (src->size - head) / frame * 20;
+        info->estimated = true;
+    }
+}
+
+static void audio_probe_vorbis_comments(const uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    // the vendor string then "KEY=value" comments, all after 32 bit lengths
+    if (len < 8 || audio_probe_le32(buf) > len - 8) {
+        return;
+    }
+    int offset = 4 + audio_probe_le32(buf);
+    uint32_t count = audio_probe_le32(buf + offset);
+    offset += 4;
+    while (count-- > 0 && offset + 4 <= len) {
+        uint32_t size = audio_probe_le32(buf + offset);
+        offset += 4;
+        if (size > len - offset) {
+            break;
+        }
+        const char *comment = (const char *)buf + offset;
+        char *dst = NULL;
+        int key = 0;
+        if (size > 6 && strncasecmp(comment, "TITLE=", 6) == 0) {
+            dst = info->title;
+            key = 6;
+        } else if (size > 7 && strncasecmp(comment, "ARTIST=", 7) == 0) {
+            dst = info->artist;
+            key = 7;
+        } else if (size > 6 && strncasecmp(comment, "ALBUM=", 6) == 0) {
+            dst = info->album;
+            key = 6;
+        }
+        if (dst != NULL && dst[0] == '\0') {
+            audio_probe_text(dst, AUDIO_PROBE_TAG_LEN, buf + offset + key, size - key, 3);
+        }
+        offset += size;
+    }
+}
+
+static void audio_probe_ogg_info(audio_probe_src_t *src, uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    int64_t pre_skip = 0;
+    int rate = 0;
+    if (len >= 47 && memcmp(buf + 28, "OpusHead", 8) == 0) {
+        // Opus always decodes at 48 kHz and counts granules in 48 kHz samples
+        info->channels = buf[37];
+        pre_skip = buf[38] | (buf[39] << 8);
+        rate = 48000;
+    } else if (len >= 58 && memcmp(buf + 28, "\x01vorbis", 7) == 0) {
+        info->channels = buf[39];
+        rate = audio_probe_le32(buf + 40);
+        info->bitrate = (int32_t)audio_probe_le32(buf + 48) > 0 ? audio_probe_le32(buf + 48) : 0;
+    }
+    info->sample_rate = rate;
+    // the comment header starts the second page
+    for (int i = 28; i + 8 <= len; i++) {
+        if (memcmp(buf + i, "OpusTags", 8) == 0 || memcmp(buf + i, "\x03vorbis", 7) == 0) {
+            int skip = buf[i] == 'O' ? 8 : 7;
+            audio_probe_vorbis_comments(buf + i + skip, len - i - skip, info);
+            break;
+        }
+    }
+    if (rate <= 0 || src->size <= 0) {
+        return;
+    }
+    // the granule position of the last page is the length in samples
+    int64_t at = src->size > AUDIO_PROBE_INFO_SIZE ? src->size - AUDIO_PROBE_INFO_SIZE : 0;
+    len = src->read(src, at, buf, AUDIO_PROBE_INFO_SIZE);
+    for (int i = len - 27; i >= 0; i--) {
+        if (buf[i] == 'O' && memcmp(buf + i, "OggS", 4) == 0 && buf[i + 4] == 0) {
+            int64_t granule = (int64_t)(audio_probe_le32(buf + i + 6) | ((uint64_t)audio_probe_le32(buf + i + 10) << 32));
+            if (granule > pre_skip && granule - pre_skip < (int64_t)rate * (INT32_MAX / 1000)) {
+                info->duration_ms = (granule - pre_skip) * 1000 / rate;
+                if (info->duration_ms > 0) {
+                    info->bitrate = src->size * 8000 / info->duration_ms;
+                }
+                break;
+            }
+        }
+    }
+}
+
+static const int aac_rates[] = { 96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350 };
+
+static void audio_probe_aac_info(audio_probe_src_t *src, uint8_t *buf, int len, audio_probe_info_t *info)
+{
+    int64_t start = audio_probe_id3_size(buf, len);
+    if (start > 0) {
+        audio_probe_id3_tags(buf, len, info);
+        len = src->read(src, start, buf, AUDIO_PROBE_INFO_SIZE);
+    }
+    int i = 0;
+    while (i + 7 <= len && !(buf[i] == 0xff && (buf[i + 1] & 0xf6) == 0xf0)) {
+        i++;
+    }
+    // average the ADTS frames of the probe
+    int frames = 0;
+    int bytes = 0;
+    for (int pos = i; pos + 7 <= len && buf[pos] == 0xff && (buf[pos + 1] & 0xf6) == 0xf0;) {
+        int index = (buf[pos + 2] >> 2) & 0x0f;
+        int frame_len = ((buf[pos + 3] & 0x03) << 11) | (buf[pos + 4] << 3) | (buf[pos + 5] >> 5);
+        if (index >= sizeof(aac_rates) / sizeof(aac_rates[0]) || frame_len < 7 || pos + frame_len > len) {
+            break;
+        }
+        if (frames == 0) {
+            info->sample_rate = aac_rates[index];
+            info->channels = ((buf[pos + 2] & 0x01) << 2) | (buf[pos + 3] >> 6);
+        }
+        frames++;
+        bytes += frame_len;
+        pos += frame_len;
+    }
+    if (frames == 0) {
+        return;
+    }
+    info->bitrate = (int64_t)bytes * 8 * info->sample_rate / (frames * 1024);
+    if (src->size > start + i && info->bitrate > 0) {
+        info->duration_ms = (src->size - start - i) * 8000 / info->bitrate;
+        info->estimated = true;
+    }
+}
+
+bool audio_probe_info(audio_probe_src_t *src, uint8_t *buf, audio_probe_info_t *info)
+{
+    memset(info, 0, sizeof(audio_probe_info_t));
+    info->duration_ms = -1;
+    int len = src->read(src, 0, buf, AUDIO_PROBE_INFO_SIZE);
+    info->type = audio_probe_buffer(buf, len);
+    switch (info->type) {
+        case AUDIO_PROBE_MP3:
+            audio_probe_mp3_info(src, buf, len, info);
+            break;
+        case AUDIO_PROBE_WAV:
+            audio_probe_wav_info(src, buf, len, info);
+            break;
+        case AUDIO_PROBE_AMR:
+        case AUDIO_PROBE_AMRWB:
+            audio_probe_amr_info(src, buf, len, info);
+            break;
+        case AUDIO_PROBE_OGG:
+        case AUDIO_PROBE_OPUS:
+            audio_probe_ogg_info(src, buf, len, info);
+            break;
+        case AUDIO_PROBE_AAC:
+            audio_probe_aac_info(src, buf, len, info);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+audio_probe_type_t audio_probe_content_type(const char *content_type)
+{
+    if (content_type == NULL) {
+        return AUDIO_PROBE_UNKNOWN;
+    }
+    static const struct {
+        const char *mime;
+        audio_probe_type_t type;
+    } mimes[] = {
+        { "audio/mpeg", AUDIO_PROBE_MP3 },
+        { "audio/mp3", AUDIO_PROBE_MP3 },
+        { "audio/wav", AUDIO_PROBE_WAV },
+        { "audio/x-wav", AUDIO_PROBE_WAV },
+        { "audio/wave", AUDIO_PROBE_WAV },
+        { "audio/amr-wb", AUDIO_PROBE_AMRWB },
+        { "audio/amr", AUDIO_PROBE_AMR },
+        { "audio/opus", AUDIO_PROBE_OPUS },
+        { "audio/ogg", AUDIO_PROBE_OGG },
+        { "audio/aac", AUDIO_PROBE_AAC },
+        { "audio/aacp", AUDIO_PROBE_AAC },
+    };
+    for (int i = 0; i < sizeof(mimes) / sizeof(mimes[0]); i++) {
+        if (strncasecmp(content_type, mimes[i].mime, strlen(mimes[i].mime)) == 0) {
+            return mimes[i].type;
+        }
+    }
+    return AUDIO_PROBE_UNKNOWN;
+}
+
+audio_probe_type_t audio_probe_suffix(const char *uri)
+{
+    const char *end = uri + strcspn(uri, "?#");
+    const char *ext = end;
+    while (ext > uri && *(ext - 1) != '.' && *(ext - 1) != '/') {
+        ext--;
+    }
+    if (ext == uri || *(ext - 1) != '.') {
+        return AUDIO_PROBE_UNKNOWN;
+    }
+    for (int type = AUDIO_PROBE_MP3; type <= AUDIO_PROBE_AAC; type++) {
+        const char *name = suffix_names[type];
+        if (end - ext == strlen(name) && strncasecmp(ext, name, end - ext) == 0) {
+            return type;
+        }
+    }
+    return AUDIO_PROBE_UNKNOWN;
+}
+
+const char *audio_probe_suffix_name(audio_probe_type_t type)
+{
+    return type <= AUDIO_PROBE_AAC ? suffix_names[type] : NULL;
+}
+
+static mp_obj_t audio_probe_open_file(const char *uri)
+{
+    const char *path = strstr(uri, "/sdcard");
+    if (path == NULL) {
+        return MP_OBJ_NULL;
+    }
+    mp_obj_t file = MP_OBJ_NULL;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t args[2] = {
+            mp_obj_new_str(path, strcspn(path, "#")),
+            MP_OBJ_NEW_QSTR(MP_QSTR_rb),
+        };
+        file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
+        nlr_pop();
+    } else {
+        // let the player report the missing file
+        file = MP_OBJ_NULL;
+    }
+    return file;
+}
+
+// false when the file is missing, it is probed again once it shows up
+static bool audio_probe_stat_file(const char *uri, int64_t *size, int64_t *mtime)
+{
+    const char *path = strstr(uri, "/sdcard");
+    if (path == NULL) {
+        return false;
+    }
+    bool ok = false;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        size_t len;
+        mp_obj_t *items;
+        mp_obj_tuple_get(mp_vfs_stat(mp_obj_new_str(path, strcspn(path, "#"))), &len, &items);
+        *size = mp_obj_get_int(items[6]);
+        *mtime = mp_obj_get_int(items[8]);
+        ok = true;
+        nlr_pop();
+    }
+    return ok;
+}
+
+static int audio_probe_read_file(const char *uri, uint8_t *buf, int len)
+{
+    mp_obj_t file = audio_probe_open_file(uri);
+    if (file == MP_OBJ_NULL) {
+        return 0;
+    }
+    int rlen = mp_stream_posix_read(file, buf, len);
+    mp_stream_close(file);
+    return rlen > 0 ? rlen : 0;
+}
+
+bool audio_probe_wav_uri(const char *uri, audio_probe_wav_t *wav)
+{
+    uint8_t buf[AUDIO_PROBE_SIZE];
+    int len = audio_probe_read_file(uri, buf, sizeof(buf));
+    return audio_probe_wav(buf, len, wav);
+}
+
+static esp_err_t audio_probe_http_event(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "Content-Type") == 0) {
+        *(audio_probe_type_t *)evt->user_data = audio_probe_content_type(evt->header_value);
+    }
+    return ESP_OK;
+}
+
+// the content decides, then the Content-Type: servers label files by their suffix too
+static audio_probe_type_t audio_probe_read_http(const char *uri, uint8_t *buf, int len)
+{
+    audio_probe_type_t type = AUDIO_PROBE_UNKNOWN;
+    audio_probe_type_t content_type = AUDIO_PROBE_UNKNOWN;
+    esp_http_client_config_t cfg = {
+        .url = uri,
+        .event_handler = audio_probe_http_event,
+        .user_data = &content_type,
+        .timeout_ms = AUDIO_PROBE_HTTP_TIMEOUT_MS,
+    };
+    MP_THREAD_GIL_EXIT();
+    esp_http_client_handle_t client = esp_http_client_init(&cfg);
+    if (client) {
+        char range[24];
+        snprintf(range, sizeof(range), "bytes=0-%d", len - 1);
+        esp_http_client_set_header(client, "Range", range);
+        if (esp_http_client_open(client, 0) == ESP_OK) {
+            esp_http_client_fetch_headers(client);
+            int rlen = esp_http_client_read(client, (char *)buf, len);
+            type = rlen > 0 ? audio_probe_buffer(buf, rlen) : AUDIO_PROBE_UNKNOWN;
+            esp_http_client_close(client);
+        }
+        esp_http_client_cleanup(client);
+    }
+    MP_THREAD_GIL_ENTER();
+    return type != AUDIO_PROBE_UNKNOWN ? type : content_type;
+}
+
+audio_probe_type_t audio_probe_uri(const char *uri)
+{
+    bool http = strncasecmp(uri, "http", 4) == 0;
+    int64_t size = -1;
+    int64_t mtime = -1;
+    if (!http && !audio_probe_stat_file(uri, &size, &mtime)) {
+        // let the player report the missing file
+        return AUDIO_PROBE_UNKNOWN;
+    }
+    int slot = -1;
+    for (int i = 0; i < AUDIO_PROBE_CACHE_SIZE; i++) {
+        if (strcmp(cache[i].uri, uri) == 0) {
+            if (cache[i].size == size && cache[i].mtime == mtime) {
+                return cache[i].type;
+            }
+            // the file changed since, probe it again into the same entry
+            slot = i;
+            break;
+        }
+    }
+
+    int64_t start = esp_timer_get_time();
+    audio_probe_type_t type = AUDIO_PROBE_UNKNOWN;
+    uint8_t buf[AUDIO_PROBE_SIZE];
+    if (http) {
+        type = audio_probe_read_http(uri, buf, sizeof(buf));
+        if (type == AUDIO_PROBE_UNKNOWN) {
+            type = audio_probe_suffix(uri);
+        }
+    } else {
+        int len = audio_probe_read_file(uri, buf, sizeof(buf));
+        type = audio_probe_buffer(buf, len);
+    }
+    ESP_LOGD(TAG, "%s is %d, probed in %d us", uri, type, (int)(esp_timer_get_time() - start));
+
+    if (slot >= 0) {
+        cache[slot].uri[0] = '\0';
+    }
+    if (type != AUDIO_PROBE_UNKNOWN && strlen(uri) < AUDIO_PROBE_URI_LEN) {
+        if (slot < 0) {
+            slot = cache_next;
+            cache_next = (cache_next + 1) % AUDIO_PROBE_CACHE_SIZE;
+        }
+        strcpy(cache[slot].uri, uri);
+        cache[slot].size = size;
+        cache[slot].mtime = mtime;
+        cache[slot].type = type;
+    }
+    return type;
+}
+
+static int audio_probe_file_src_read(audio_probe_src_t *src, int64_t offset, uint8_t *buf, int len)
+{
+    if (mp_stream_posix_lseek(src->ctx, offset, SEEK_SET) != offset) {
+        return 0;
+    }
+    int rlen = mp_stream_posix_read(src->ctx, buf, len);
+    return rlen > 0 ? rlen : 0;
+}
+
+static esp_err_t audio_probe_range_event(esp_http_client_event_t *evt)
+{
+    // "bytes 0-4095/123456", the total size follows the slash
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "Content-Range") == 0) {
+        const char *total = strchr(evt->header_value, '/');
+        if (total != NULL && total[1] != '*') {
+            *(int64_t *)evt->user_data = strtoll(total + 1, NULL, 10);
+        }
+    }
+    return ESP_OK;
+}
+
+static int audio_probe_http_src_read(audio_probe_src_t *src, int64_t offset, uint8_t *buf, int len)
+{
+    esp_http_client_handle_t client = src->ctx;
+    char range[48];
+    snprintf(range, sizeof(range), "bytes=%lld-%lld", (long long)offset, (long long)offset + len - 1);
+    int rlen = 0;
+    MP_THREAD_GIL_EXIT();
+    esp_http_client_set_header(client, "Range", range);
+    if (esp_http_client_open(client, 0) == ESP_OK) {
+        int64_t length = esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+        if (status == 200 && length > 0) {
+            src->size = length;
+        }
+        // a server without Range support can only serve the head
+        if (status == 206 || (status == 200 && offset == 0)) {
+            while (rlen < len) {
+                int n = esp_http_client_read(client, (char *)buf + rlen, len - rlen);
+                if (n <= 0) {
+                    break;
+                }
+                rlen += n;
+            }
+        }
+        esp_http_client_close(client);
+    }
+    MP_THREAD_GIL_ENTER();
+    return rlen;
+}
+
+bool audio_probe_info_uri(const char *uri, audio_probe_info_t *info)
+{
+    int64_t start = esp_timer_get_time();
+    bool ok = false;
+    audio_probe_src_t src = { .size = -1 };
+    uint8_t *buf = m_new(uint8_t, AUDIO_PROBE_INFO_SIZE);
+    memset(info, 0, sizeof(audio_probe_info_t));
+    info->duration_ms = -1;
+    if (strncasecmp(uri, "http", 4) == 0) {
+        esp_http_client_config_t cfg = {
+            .url = uri,
+            .event_handler = audio_probe_range_event,
+            .user_data = &src.size,
+            .timeout_ms = AUDIO_PROBE_HTTP_TIMEOUT_MS,
+        };
+        src.ctx = esp_http_client_init(&cfg);
+        if (src.ctx != NULL) {
+            src.read = audio_probe_http_src_read;
+            ok = audio_probe_info(&src, buf, info);
+            esp_http_client_cleanup(src.ctx);
+        }
+    } else {
+        mp_obj_t file = audio_probe_open_file(uri);
+        if (file != MP_OBJ_NULL) {
+            src.ctx = file;
+            src.read = audio_probe_file_src_read;
+            src.size = mp_stream_posix_lseek(file, 0, SEEK_END);
+            ok = audio_probe_info(&src, buf, info);
+            mp_stream_close(file);
+        }
+    }
+    m_del(uint8_t, buf, AUDIO_PROBE_INFO_SIZE);
+    ESP_LOGD(TAG, "%s is %d, %d ms, read in %d us", uri, info->type, info->duration_ms, (int)(esp_timer_get_time() - start));
+    return ok;
+}
+
+void audio_probe_cache_clear(void)
+{
+    memset(cache, 0, sizeof(cache));
+    cache_next = 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_PROBE_H_
+#define _AUDIO_PROBE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_PROBE_SIZE (512)
+#define AUDIO_PROBE_CACHE_SIZE (16)
+#define AUDIO_PROBE_URI_LEN (128)
+#define AUDIO_PROBE_HTTP_TIMEOUT_MS (3000)
+#define AUDIO_PROBE_INFO_SIZE (4096)
+#define AUDIO_PROBE_TAG_LEN (64)
+
+typedef enum {
+    AUDIO_PROBE_UNKNOWN,
+    AUDIO_PROBE_MP3,
+    AUDIO_PROBE_WAV,
+    AUDIO_PROBE_AMR,
+    AUDIO_PROBE_AMRWB,
+    AUDIO_PROBE_OGG,
+    AUDIO_PROBE_OPUS,
+    AUDIO_PROBE_AAC,
+} audio_probe_type_t;
+
+/**
+ * @brief   WAV header fields
+ */
+typedef struct {
+    int format;      /*!< fmt chunk format tag, 1 for PCM */
+    int sample_rate; /*!< Sample rate in Hz */
+    int channels;    /*!< Channel count */
+    int bits;        /*!< Bits per sample */
+    int data_offset; /*!< Offset of the first sample */
+    int data_size;   /*!< Size of the data chunk */
+    int byte_rate;   /*!< Average bytes per second */
+} audio_probe_wav_t;
+
+/**
+ * @brief   Media information read from the headers, without decoding
+ */
+typedef struct {
+    audio_probe_type_t type;
+    int duration_ms;                  /*!< Duration, -1 when it can not be known without decoding */
+    int bitrate;                      /*!< Average bitrate in bits per second, 0 when unknown */
+    int sample_rate;                  /*!< Sample rate in Hz */
+    int channels;                     /*!< Channel count */
+    int bits;                         /*!< Bits per sample of PCM WAV, 0 for compressed formats */
+    bool estimated;                   /*!< The duration comes from the bitrate, not a frame count */
+    char title[AUDIO_PROBE_TAG_LEN];  /*!< UTF-8 tags, empty when missing */
+    char artist[AUDIO_PROBE_TAG_LEN];
+    char album[AUDIO_PROBE_TAG_LEN];
+} audio_probe_info_t;
+
+/**
+ * @brief   Random access to the probed source
+ */
+typedef struct audio_probe_src audio_probe_src_t;
+struct audio_probe_src {
+    int (*read)(audio_probe_src_t *src, int64_t offset, uint8_t *buf, int len); /*!< Returns the bytes read, may set size */
+    int64_t size;                                                              /*!< Total size, -1 when unknown */
+    void *ctx;
+};
+
+/**
+ * @brief      Detect the format from the first bytes of a stream
+ *
+ * @param      buf   The data, AUDIO_PROBE_SIZE bytes are enough
+ * @param      len   Length of the data
+ */
+audio_probe_type_t audio_probe_buffer(const uint8_t *buf, int len);
+
+/**
+ * @brief      Parse the fmt and data chunks of a WAV header
+ *
+ * @param      buf   The data, the data chunk header must be inside
+ * @param      len   Length of the data
+ * @param      wav   Returns the header fields
+ *
+ * @return     false if the header is not a complete WAV header
+ */
+bool audio_probe_wav(const uint8_t *buf, int len, audio_probe_wav_t *wav);
+
+/**
+ * @brief      Read the WAV header of a file URI, must be called from the MicroPython thread
+ */
+bool audio_probe_wav_uri(const char *uri, audio_probe_wav_t *wav);
+
+/**
+ * @brief      Detect the format from a HTTP Content-Type header value
+ */
+audio_probe_type_t audio_probe_content_type(const char *content_type);
+
+/**
+ * @brief      Detect the format from the URI suffix
+ */
+audio_probe_type_t audio_probe_suffix(const char *uri);
+
+/**
+ * @brief      Detect the format of a file or HTTP URI by reading its first bytes. HTTP
+ *             sources fall back to the Content-Type of the response, then to the suffix.
+ *             Results are cached per URI shorter than AUDIO_PROBE_URI_LEN, a file entry
+ *             until the size or mtime of the file changes. Must be called from the
+ *             MicroPython thread.
+ */
+audio_probe_type_t audio_probe_uri(const char *uri);
+
+/**
+ * @brief      Read the duration, bitrate, format and tags from the ID3, Xing/VBRI, WAV,
+ *             AMR, Ogg and ADTS headers. Reads the head, the first frame and for some
+ *             formats the tail of the source, never the whole media.
+ *
+ * @param      src   The source
+ * @param      buf   AUDIO_PROBE_INFO_SIZE bytes of scratch
+ * @param      info  Returns the information
+ *
+ * @return     false if the format is unknown
+ */
+bool audio_probe_info(audio_probe_src_t *src, uint8_t *buf, audio_probe_info_t *info);
+
+/**
+ * @brief      Read the media information of a file or HTTP URI, must be called from the
+ *             MicroPython thread. HTTP sources need Range support past the first read.
+ */
+bool audio_probe_info_uri(const char *uri, audio_probe_info_t *info);
+
+/**
+ * @brief      Get the file suffix that selects the decoder of a format
+ */
+const char *audio_probe_suffix_name(audio_probe_type_t type);
+
+/**
+ * @brief      Drop the cached results
+ */
+void audio_probe_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
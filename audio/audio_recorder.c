@@ -25,44 +25,166 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "py/mpthread.h"
 #include "py/objstr.h"
 #include "py/runtime.h"
+#include "py/stream.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "audio_hal.h"
 #include "audio_pipeline.h"
 #include "board.h"
-#include "filter_resample.h"
 
 #include "i2s_stream.h"
 #include "raw_stream.h"
+#include "ringbuf.h"
 #include "vfs_stream.h"
 
 #include "amrnb_encoder.h"
+#include "opus_encoder.h"
 #include "wav_encoder.h"
 
+#include "audio_adpcm_encoder.h"
+#include "audio_async.h"
+#include "audio_decimator.h"
+#include "audio_mem_stats.h"
+#include "audio_meter.h"
+#include "audio_placement.h"
+#include "audio_preroll.h"
+#include "audio_stack.h"
+#include "audio_tee.h"
+#include "audio_upload.h"
+#include "audio_vad.h"
+#include "modaudio.h"
+
+// the rate the player keeps the shared I2S port at
+#define RECORDER_PORT_RATE (48000)
+// the codec of the board is the I2S slave and follows any port clock, boards whose codec
+// runs at a fixed rate define it 0 and always capture through the decimator
+#ifndef RECORDER_NATIVE_RATE_CAPTURE
+#define RECORDER_NATIVE_RATE_CAPTURE (1)
+#endif
+#define RECORDER_PREROLL_MARGIN (8 * 1024)
+// what an upload can fall behind before the recording stalls
+#define RECORDER_UPLOAD_BACKLOG (128 * 1024)
+#define RECORDER_UPLOAD_MIN_BACKLOG (8 * 1024)
+#define RECORDER_COPY_RB_SIZE (32 * 1024)
+#define RECORDER_COPY_DRAIN_MS (5000)
+
 enum {
     PCM,
     AMR,
     WAV,
-    MP3
+    MP3,
+    OPUS,
+    ADPCM
 };
 
 const mp_obj_type_t audio_recorder_type;
 
+// where one output of a recording goes
+typedef struct {
+    const char *uri;
+    int format;
+    int rate;
+    int channels;
+} audio_recorder_output_t;
+
+// the pipeline of an output behind the tee, with a filter when it takes another format
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t filter;
+    audio_element_handle_t encoder;
+    audio_element_handle_t out_stream;
+} audio_recorder_branch_t;
+
 typedef struct _audio_recorder_obj_t {
     mp_obj_base_t base;
 
     audio_pipeline_handle_t pipeline;
     audio_element_handle_t i2s_stream;
     audio_element_handle_t filter;
+    audio_element_handle_t meter;
+    audio_element_handle_t vad;
     audio_element_handle_t encoder;
     audio_element_handle_t out_stream;
 
-    esp_timer_handle_t timer;
+    // always-on capture ending in the pre-roll ring, i2s_stream and filter belong to it
+    audio_pipeline_handle_t capture;
+    audio_element_handle_t preroll;
+    ringbuf_handle_t preroll_rb;
+    int preroll_size;
+    int preroll_rate;
+    int preroll_channels;
+
+    // maxtime in frames, counted by the filter
+    uint32_t max_frames;
+    // set from the element task when the last element finished, cleared by start()
+    volatile bool ended;
     mp_obj_t end_cb;
+    // last counters of the voice activity detector, kept after stop()
+    audio_vad_stats_t vad_stats;
+    // the audio.Meter fed by the meter element, referenced here while it runs
+    mp_obj_t meter_obj;
+    audio_async_event_t event;
+
+    // I2S captures at the requested rate, the port goes back to the player rate on stop
+    bool native;
+    // the out stream is a raw_stream read by Python, see readinto()
+    bool raw;
+    // the file writer rotates through numbered segments
+    bool segmented;
+    // an output POSTs to an http(s) uri, the counters are kept after stop()
+    bool upload;
+    audio_upload_t upload_state;
+    audio_element_handle_t upload_stream;
+    // local copy of an upload, a writer in its own pipeline fed by the upload
+    audio_pipeline_handle_t copy;
+    audio_element_handle_t copy_stream;
+    ringbuf_handle_t copy_rb;
+    // several outputs: the tee ends the recording pipeline and feeds a pipeline per
+    // output, encoder and out_stream are those of the first
+    audio_element_handle_t tee;
+    audio_recorder_branch_t branches[AUDIO_TEE_MAX_BRANCHES];
+    int branch_num;
+    int branches_done;
+    // the input is held back, everything after it waits for data
+    bool paused;
+    volatile bool reading;
 } audio_recorder_obj_t;
 
 STATIC mp_obj_t audio_recorder_stop(mp_obj_t self_in);
+STATIC const mp_obj_fun_builtin_fixed_t audio_recorder_end_obj;
+
+STATIC portMUX_TYPE recorder_lock = portMUX_INITIALIZER_UNLOCKED;
+
+STATIC esp_err_t audio_recorder_element_event(audio_element_handle_t el, audio_event_iface_msg_t *msg, void *ctx)
+{
+    audio_recorder_obj_t *self = ctx;
+    int status = (int)(intptr_t)msg->data;
+    // a refused or broken upload ends the recording
+    bool failed = self->upload && status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN;
+    if (msg->cmd != AEL_MSG_CMD_REPORT_STATUS || !(status == AEL_STATUS_STATE_FINISHED || failed)) {
+        return ESP_OK;
+    }
+    if (self->branch_num > 0) {
+        // behind a tee it ends once every output did, a failed one leaves the others running
+        portENTER_CRITICAL(&recorder_lock);
+        int done = ++self->branches_done;
+        portEXIT_CRITICAL(&recorder_lock);
+        if (done < self->branch_num) {
+            return ESP_OK;
+        }
+    }
+    if (!self->ended) {
+        // the teardown waits for every element task, run it on the MicroPython thread
+        self->ended = true;
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&audio_recorder_end_obj), MP_OBJ_FROM_PTR(self));
+    }
+    return ESP_OK;
+}
 
 STATIC mp_obj_t audio_recorder_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args)
 {
@@ -72,65 +194,86 @@ STATIC mp_obj_t audio_recorder_make_new(const mp_obj_type_t *type, size_t n_args
     return MP_OBJ_FROM_PTR(self);
 }
 
-STATIC audio_element_handle_t audio_recorder_create_filter(int encoder_type)
+STATIC audio_element_handle_t audio_recorder_create_filter(int src_rate, int src_ch, int rate, int channels, uint32_t max_frames, const char *tag)
 {
-    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
-    rsp_cfg.src_rate = 48000;
-    rsp_cfg.src_ch = 2;
-    rsp_cfg.dest_ch = 1;
-    rsp_cfg.task_core = 1;
-
-    switch (encoder_type) {
-        case PCM: {
-            rsp_cfg.dest_rate = 16000;
-            break;
-        }
-        case AMR: {
-            rsp_cfg.dest_rate = 8000;
-            break;
-        }
-        case WAV: {
-            rsp_cfg.dest_rate = 16000;
-            break;
-        }
-        default:
-            break;
-    }
-    return rsp_filter_init(&rsp_cfg);
+    audio_decimator_cfg_t dec_cfg = AUDIO_DECIMATOR_CFG_DEFAULT();
+    dec_cfg.src_rate = src_rate;
+    dec_cfg.src_ch = src_ch;
+    dec_cfg.dest_rate = rate;
+    dec_cfg.dest_ch = channels;
+    dec_cfg.max_frames = max_frames;
+    dec_cfg.task_stack = audio_stack_size(tag, NULL, dec_cfg.task_stack);
+    dec_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, dec_cfg.stack_in_ext);
+    audio_placement_enter(tag, AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t filter = audio_decimator_init(&dec_cfg);
+    audio_placement_exit();
+    return filter;
 }
 
-STATIC audio_element_handle_t audio_recorder_create_encoder(int encoder_type)
+STATIC audio_element_handle_t audio_recorder_create_encoder(int encoder_type, int rate, int channels, int bitrate, const char *tag)
 {
     audio_element_handle_t encoder = NULL;
 
+    audio_placement_enter(tag, AUDIO_PLACE_KIND_BUF);
     switch (encoder_type) {
         case AMR: {
             amrnb_encoder_cfg_t amr_enc_cfg = DEFAULT_AMRNB_ENCODER_CONFIG();
             amr_enc_cfg.task_core = 1;
+            amr_enc_cfg.task_stack = audio_stack_size(tag, "amrnb_enc", amr_enc_cfg.task_stack);
+            amr_enc_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, amr_enc_cfg.stack_in_ext);
             encoder = amrnb_encoder_init(&amr_enc_cfg);
             break;
         }
         case WAV: {
             wav_encoder_cfg_t wav_cfg = DEFAULT_WAV_ENCODER_CONFIG();
             wav_cfg.task_core = 1;
+            wav_cfg.task_stack = audio_stack_size(tag, "wav_enc", wav_cfg.task_stack);
+            wav_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, wav_cfg.stack_in_ext);
             encoder = wav_encoder_init(&wav_cfg);
             break;
         }
+        case OPUS: {
+            opus_encoder_cfg_t opus_cfg = DEFAULT_OPUS_ENCODER_CONFIG();
+            opus_cfg.sample_rate = rate;
+            opus_cfg.channel = channels;
+            if (bitrate > 0) {
+                opus_cfg.bitrate = bitrate;
+            }
+            opus_cfg.task_core = 1;
+            opus_cfg.task_stack = audio_stack_size(tag, "opus_enc", opus_cfg.task_stack);
+            opus_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, opus_cfg.stack_in_ext);
+            encoder = encoder_opus_init(&opus_cfg);
+            break;
+        }
+        case ADPCM: {
+            audio_adpcm_encoder_cfg_t adpcm_cfg = AUDIO_ADPCM_ENCODER_CFG_DEFAULT();
+            adpcm_cfg.sample_rate = rate;
+            adpcm_cfg.channels = channels;
+            adpcm_cfg.task_stack = audio_stack_size(tag, "adpcm_enc", adpcm_cfg.task_stack);
+            adpcm_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, adpcm_cfg.stack_in_ext);
+            encoder = audio_adpcm_encoder_init(&adpcm_cfg);
+            break;
+        }
         default:
             break;
     }
+    audio_placement_exit();
 
     return encoder;
 }
 
-STATIC audio_element_handle_t audio_recorder_create_outstream(const char *uri)
+STATIC audio_element_handle_t audio_recorder_create_outstream(const char *uri, const char *tag)
 {
     audio_element_handle_t out_stream = NULL;
     if (strstr(uri, "/sdcard/") != NULL) {
         vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
         vfs_cfg.type = AUDIO_STREAM_WRITER;
         vfs_cfg.task_core = 1;
+        vfs_cfg.task_stack = audio_stack_size(tag, "vfs", vfs_cfg.task_stack);
+        vfs_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, vfs_cfg.stack_in_ext);
+        audio_placement_enter(tag, AUDIO_PLACE_KIND_BUF);
         out_stream = vfs_stream_init(&vfs_cfg);
+        audio_placement_exit();
     } else if (strstr(uri, "/spiffs/") != NULL) {
         // TODO: spiffs
     } else {
@@ -143,67 +286,436 @@ STATIC audio_element_handle_t audio_recorder_create_outstream(const char *uri)
     return out_stream;
 }
 
-STATIC void audio_recorder_create(audio_recorder_obj_t *self, const char *uri, int format)
+// WAV headers and segment boundaries follow the format
+STATIC void audio_recorder_set_out_info(audio_element_handle_t el, int format, int rate, int channels)
+{
+    audio_element_info_t info;
+    audio_element_getinfo(el, &info);
+    info.sample_rates = rate;
+    info.channels = channels;
+    // ADPCM picks the IMA-ADPCM header of the .wav writer
+    info.bits = format == ADPCM ? AUDIO_ADPCM_WAV_BITS : 16;
+    audio_element_setinfo(el, &info);
+}
+
+STATIC audio_element_handle_t audio_recorder_create_upload(audio_recorder_obj_t *self, const char *uri, int format, int rate, int channels, const char *tag)
+{
+    audio_upload_cfg_t up_cfg = AUDIO_UPLOAD_CFG_DEFAULT();
+    up_cfg.upload = &self->upload_state;
+    up_cfg.sample_rate = rate;
+    up_cfg.channels = channels;
+    up_cfg.bits = format == ADPCM ? AUDIO_ADPCM_WAV_BITS : 16;
+    up_cfg.copy_rb = self->copy_rb;
+    switch (format) {
+        case WAV:
+        case ADPCM:
+            up_cfg.content_type = "audio/wav";
+            up_cfg.head = AUDIO_UPLOAD_HEAD_WAV;
+            break;
+        case AMR:
+            up_cfg.content_type = "audio/amr";
+            up_cfg.head = AUDIO_UPLOAD_HEAD_AMR;
+            break;
+        case OPUS:
+            up_cfg.content_type = "audio/opus";
+            break;
+        case MP3:
+            up_cfg.content_type = "audio/mpeg";
+            break;
+        default:
+            up_cfg.content_type = "audio/L16";
+            break;
+    }
+    up_cfg.task_stack = audio_stack_size(tag, "upload", up_cfg.task_stack);
+    up_cfg.stack_in_ext = audio_placement_stack_in_ext(tag, up_cfg.stack_in_ext);
+    audio_placement_enter(tag, AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t out_stream = audio_upload_init(&up_cfg);
+    audio_placement_exit();
+    audio_element_set_uri(out_stream, uri);
+    return out_stream;
+}
+
+// the file writer of the local copy, behind its own ringbuffer so a slow card
+// never holds up the upload
+STATIC void audio_recorder_create_copy(audio_recorder_obj_t *self, const char *uri, int format, int rate, int channels)
+{
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->copy = audio_pipeline_init(&pipeline_cfg);
+    self->copy_stream = audio_recorder_create_outstream(uri, "copy");
+    audio_recorder_set_out_info(self->copy_stream, format, rate, channels);
+    audio_pipeline_register(self->copy, self->copy_stream, "copy");
+    audio_stack_track(self->copy_stream);
+    const char *link_tag[1] = {"copy"};
+    audio_pipeline_link(self->copy, &link_tag[0], 1);
+    audio_placement_enter("recorder", AUDIO_PLACE_KIND_RB);
+    self->copy_rb = rb_create(RECORDER_COPY_RB_SIZE, 1);
+    audio_placement_exit();
+    audio_element_set_input_ringbuf(self->copy_stream, self->copy_rb);
+}
+
+// after the upload ended, the copy writes out what it holds and finishes its file
+STATIC void audio_recorder_release_copy(audio_recorder_obj_t *self)
+{
+    if (self->copy == NULL) {
+        return;
+    }
+    rb_done_write(self->copy_rb);
+    audio_element_wait_for_stop_ms(self->copy_stream, pdMS_TO_TICKS(RECORDER_COPY_DRAIN_MS));
+    audio_pipeline_stop(self->copy);
+    audio_pipeline_wait_for_stop(self->copy);
+    audio_stack_untrack(self->copy_stream);
+    audio_pipeline_deinit(self->copy);
+    rb_destroy(self->copy_rb);
+    self->copy = NULL;
+    self->copy_stream = NULL;
+    self->copy_rb = NULL;
+}
+
+STATIC bool audio_recorder_is_upload(const char *uri)
+{
+    return strncmp(uri, "http://", 7) == 0 || strncmp(uri, "https://", 8) == 0;
+}
+
+// the writer of one output: a file, an upload with its optional local copy, or the raw stream
+STATIC audio_element_handle_t audio_recorder_create_output(audio_recorder_obj_t *self, const audio_recorder_output_t *out, const char *copy_uri, const char *tag)
+{
+    if (!audio_recorder_is_upload(out->uri)) {
+        return audio_recorder_create_outstream(out->uri, tag);
+    }
+    if (copy_uri != NULL) {
+        audio_recorder_create_copy(self, copy_uri, out->format, out->rate, out->channels);
+    }
+    self->upload_stream = audio_recorder_create_upload(self, out->uri, out->format, out->rate, out->channels, tag);
+    return self->upload_stream;
+}
+
+STATIC audio_element_handle_t audio_recorder_create_tee(int branches)
+{
+    audio_tee_cfg_t tee_cfg = AUDIO_TEE_CFG_DEFAULT();
+    tee_cfg.branches = branches;
+    tee_cfg.task_stack = audio_stack_size("tee", NULL, tee_cfg.task_stack);
+    tee_cfg.stack_in_ext = audio_placement_stack_in_ext("tee", tee_cfg.stack_in_ext);
+    audio_placement_enter("tee", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t tee = audio_tee_init(&tee_cfg);
+    audio_placement_exit();
+    return tee;
+}
+
+// the pipeline of output `index` behind the tee, the first output keeps the element
+// names of a recording with one output
+STATIC void audio_recorder_create_branch(audio_recorder_obj_t *self, int index, const audio_recorder_output_t *out, int rate, int channels, int bitrate,
+    const char *copy_uri, int backlog)
+{
+    audio_recorder_branch_t *branch = &self->branches[index];
+    char filter_tag[12], encoder_tag[12], out_tag[12];
+    snprintf(filter_tag, sizeof(filter_tag), index ? "filter%d" : "filter", index);
+    snprintf(encoder_tag, sizeof(encoder_tag), index ? "encoder%d" : "encoder", index);
+    snprintf(out_tag, sizeof(out_tag), index ? "out%d" : "out", index);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    branch->pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (out->rate != rate || out->channels != channels) {
+        branch->filter = audio_recorder_create_filter(rate, channels, out->rate, out->channels, 0, filter_tag);
+    }
+    branch->encoder = audio_recorder_create_encoder(out->format, out->rate, out->channels, bitrate, encoder_tag);
+    branch->out_stream = audio_recorder_create_output(self, out, copy_uri, out_tag);
+    audio_recorder_set_out_info(branch->out_stream, out->format, out->rate, out->channels);
+
+    const char *link_tag[3];
+    int link_num = 0;
+    if (branch->filter) {
+        audio_pipeline_register(branch->pipeline, branch->filter, filter_tag);
+        link_tag[link_num++] = filter_tag;
+    }
+    if (branch->encoder) {
+        audio_pipeline_register(branch->pipeline, branch->encoder, encoder_tag);
+        link_tag[link_num++] = encoder_tag;
+    }
+    audio_pipeline_register(branch->pipeline, branch->out_stream, out_tag);
+    link_tag[link_num++] = out_tag;
+    audio_stack_track(branch->filter);
+    audio_stack_track(branch->encoder);
+    audio_stack_track(branch->out_stream);
+    // an upload keeps its backlog behind its encoder, bare PCM only has the tee queue
+    audio_element_handle_t feeder = branch->encoder ? branch->encoder : branch->filter;
+    if (branch->out_stream == self->upload_stream && feeder != NULL) {
+        audio_element_set_output_ringbuf_size(feeder, backlog);
+    }
+    audio_placement_enter("recorder", AUDIO_PLACE_KIND_RB);
+    audio_pipeline_link(branch->pipeline, &link_tag[0], link_num);
+    audio_placement_exit();
+    audio_tee_connect(self->tee, index, branch->filter ? branch->filter : (branch->encoder ? branch->encoder : branch->out_stream));
+    audio_element_set_event_callback(branch->out_stream, audio_recorder_element_event, self);
+}
+
+STATIC void audio_recorder_release_branches(audio_recorder_obj_t *self)
+{
+    for (int i = 0; i < self->branch_num; i++) {
+        audio_recorder_branch_t *branch = &self->branches[i];
+        audio_stack_untrack(branch->filter);
+        audio_stack_untrack(branch->encoder);
+        audio_stack_untrack(branch->out_stream);
+        audio_pipeline_deinit(branch->pipeline);
+        memset(branch, 0, sizeof(audio_recorder_branch_t));
+    }
+    self->branch_num = 0;
+    self->branches_done = 0;
+}
+
+STATIC audio_element_handle_t audio_recorder_create_vad(audio_vad_cfg_t *vad_cfg, int rate, int channels)
+{
+    vad_cfg->sample_rate = rate;
+    vad_cfg->channels = channels;
+    vad_cfg->task_stack = audio_stack_size("vad", NULL, vad_cfg->task_stack);
+    vad_cfg->stack_in_ext = audio_placement_stack_in_ext("vad", vad_cfg->stack_in_ext);
+    audio_placement_enter("vad", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t vad = audio_vad_init(vad_cfg);
+    audio_placement_exit();
+    return vad;
+}
+
+STATIC audio_element_handle_t audio_recorder_create_meter(audio_meter_t *meter, int rate, int channels)
+{
+    audio_meter_cfg_t meter_cfg = AUDIO_METER_CFG_DEFAULT();
+    meter_cfg.meter = meter;
+    meter_cfg.sample_rate = rate;
+    meter_cfg.channels = channels;
+    meter_cfg.task_stack = audio_stack_size("meter", NULL, meter_cfg.task_stack);
+    meter_cfg.stack_in_ext = audio_placement_stack_in_ext("meter", meter_cfg.stack_in_ext);
+    audio_placement_enter("meter", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t el = audio_meter_init(&meter_cfg);
+    audio_placement_exit();
+    return el;
+}
+
+// inputs capturing at their own rate, I2S_NUM_0 is not retimed by anyone else meanwhile
+STATIC volatile int recorder_port_holders;
+
+bool audio_recorder_port_held(void)
+{
+    return recorder_port_holders > 0;
+}
+
+// I2S and the filter in front of everything else, their output is `rate` and `channels`
+STATIC void audio_recorder_create_input(audio_recorder_obj_t *self, int rate, int channels, uint32_t max_frames)
 {
     // init audio board
     audio_board_handle_t board_handle = audio_board_init();
     audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START);
 
-    // pipeline
-    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
-    self->pipeline = audio_pipeline_init(&pipeline_cfg);
     // I2S
     i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
     i2s_cfg.type = AUDIO_STREAM_READER;
     i2s_cfg.uninstall_drv = false;
-    i2s_cfg.i2s_config.sample_rate = 48000;
+    if (self->native) {
+        // the codec is the I2S slave and follows the port clock, no resampling needed
+        i2s_cfg.i2s_config.sample_rate = rate;
+        i2s_cfg.i2s_config.channel_format = channels == 1 ? I2S_CHANNEL_FMT_ONLY_LEFT : I2S_CHANNEL_FMT_RIGHT_LEFT;
+    } else {
+        i2s_cfg.i2s_config.sample_rate = RECORDER_PORT_RATE;
+    }
     i2s_cfg.task_core = 1;
+    i2s_cfg.task_stack = audio_stack_size("i2s", NULL, i2s_cfg.task_stack);
+    i2s_cfg.stack_in_ext = audio_placement_stack_in_ext("i2s", i2s_cfg.stack_in_ext);
+    audio_placement_enter("i2s", AUDIO_PLACE_KIND_BUF);
     self->i2s_stream = i2s_stream_init(&i2s_cfg);
+    audio_placement_exit();
+    if (self->native && self->i2s_stream != NULL) {
+        // the driver may already be installed by the player at its own rate
+        i2s_stream_set_clk(self->i2s_stream, rate, 16, channels);
+        recorder_port_holders++;
+    }
     // filter
-    self->filter = audio_recorder_create_filter(format);
-    // encoder
-    self->encoder = audio_recorder_create_encoder(format);
-    // out stream
-    self->out_stream = audio_recorder_create_outstream(uri);
+    if (!self->native) {
+        self->filter = audio_recorder_create_filter(RECORDER_PORT_RATE, 2, rate, channels, max_frames, "filter");
+    } else if (max_frames) {
+        // a pass-through filter only counts the frames
+        self->filter = audio_recorder_create_filter(rate, channels, rate, channels, max_frames, "filter");
+    }
+}
+
+// after the pipeline holding them is deinitialized
+STATIC void audio_recorder_release_input(audio_recorder_obj_t *self)
+{
+    if (self->native) {
+        if (self->i2s_stream != NULL) {
+            recorder_port_holders--;
+        }
+        i2s_set_clk(I2S_NUM_0, RECORDER_PORT_RATE, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
+        self->native = false;
+    }
+    self->i2s_stream = NULL;
+    self->filter = NULL;
+}
+
+STATIC void audio_recorder_create(audio_recorder_obj_t *self, const audio_recorder_output_t *outputs, int output_num, int rate, int channels, int bitrate,
+    audio_vad_cfg_t *vad_cfg, audio_meter_t *meter, const char *copy_uri, int backlog)
+{
+    audio_mem_stats_subsystem("recorder");
+
+    // pipeline
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->pipeline = audio_pipeline_init(&pipeline_cfg);
+    // I2S and filter, or the pre-roll capture that is already running
+    if (self->capture == NULL) {
+        audio_recorder_create_input(self, rate, channels, self->max_frames);
+    }
+    // level meter, sees the input before anything is trimmed
+    if (meter != NULL) {
+        self->meter = audio_recorder_create_meter(meter, rate, channels);
+    }
+    // voice activity detector
+    if (vad_cfg != NULL) {
+        self->vad = audio_recorder_create_vad(vad_cfg, rate, channels);
+    }
+    if (output_num > 1) {
+        // the outputs get their encoders in pipelines of their own
+        self->tee = audio_recorder_create_tee(output_num);
+    } else {
+        // encoder
+        self->encoder = audio_recorder_create_encoder(outputs[0].format, rate, channels, bitrate, "encoder");
+        // out stream
+        self->out_stream = audio_recorder_create_output(self, &outputs[0], copy_uri, "out");
+    }
     // register to pipeline
-    audio_pipeline_register(self->pipeline, self->i2s_stream, "i2s");
-    if (self->filter) {
-        audio_pipeline_register(self->pipeline, self->filter, "filter");
-    }
-    if (self->encoder) {
-        audio_pipeline_register(self->pipeline, self->encoder, "encoder");
-    }
-    audio_pipeline_register(self->pipeline, self->out_stream, "out");
-    if (format == WAV) {
-        audio_element_info_t out_stream_info;
-        audio_element_getinfo(self->out_stream, &out_stream_info);
-        out_stream_info.sample_rates = 16000;
-        out_stream_info.channels = 1;
-        audio_element_setinfo(self->out_stream, &out_stream_info);
-    }
-    // link
-    if (self->filter && self->encoder) {
-        const char *link_tag[4] = {"i2s", "filter", "encoder", "out"};
-        audio_pipeline_link(self->pipeline, &link_tag[0], 4);
-    } else if (self->filter) {
-        const char *link_tag[3] = {"i2s", "filter", "out"};
-        audio_pipeline_link(self->pipeline, &link_tag[0], 3);
-    } else if (self->encoder) {
-        const char *link_tag[3] = {"i2s", "encoder", "out"};
-        audio_pipeline_link(self->pipeline, &link_tag[0], 3);
+    if (self->capture == NULL) {
+        audio_pipeline_register(self->pipeline, self->i2s_stream, "i2s");
+        if (self->filter) {
+            audio_pipeline_register(self->pipeline, self->filter, "filter");
+        }
+        audio_stack_track(self->i2s_stream);
+        audio_stack_track(self->filter);
+    }
+    if (self->meter) {
+        audio_pipeline_register(self->pipeline, self->meter, "meter");
+    }
+    if (self->vad) {
+        audio_pipeline_register(self->pipeline, self->vad, "vad");
+    }
+    if (self->tee) {
+        audio_pipeline_register(self->pipeline, self->tee, "tee");
+    } else {
+        if (self->encoder) {
+            audio_pipeline_register(self->pipeline, self->encoder, "encoder");
+        }
+        audio_pipeline_register(self->pipeline, self->out_stream, "out");
+    }
+    audio_stack_track(self->meter);
+    audio_stack_track(self->vad);
+    audio_stack_track(self->tee);
+    audio_stack_track(self->encoder);
+    audio_stack_track(self->out_stream);
+    if (!self->raw && self->out_stream) {
+        audio_recorder_set_out_info(self->out_stream, outputs[0].format, rate, channels);
+    }
+    // the element feeding the out stream, NULL when the pre-roll ring does
+    audio_element_handle_t feeder = self->encoder ? self->encoder : (self->vad ? self->vad : self->meter);
+    if (feeder == NULL && self->capture == NULL) {
+        feeder = self->filter ? self->filter : self->i2s_stream;
+    }
+    int preroll_rb_size = self->preroll_size + RECORDER_PREROLL_MARGIN;
+    if (self->upload_stream != NULL && self->upload_stream == self->out_stream) {
+        // the ringbuffer in front of the upload holds what the network falls behind
+        if (feeder != NULL) {
+            audio_element_set_output_ringbuf_size(feeder, backlog);
+        } else {
+            preroll_rb_size += backlog;
+        }
+    }
+    // link, the ringbuffers follow the placement of the "recorder" tag
+    audio_placement_enter("recorder", AUDIO_PLACE_KIND_RB);
+    const char *link_tag[6];
+    int link_num = 0;
+    if (self->capture == NULL) {
+        link_tag[link_num++] = "i2s";
+        if (self->filter) {
+            link_tag[link_num++] = "filter";
+        }
+    }
+    if (self->meter) {
+        link_tag[link_num++] = "meter";
+    }
+    if (self->vad) {
+        link_tag[link_num++] = "vad";
+    }
+    if (self->tee) {
+        link_tag[link_num++] = "tee";
     } else {
-        const char *link_tag[2] = {"i2s", "out"};
-        audio_pipeline_link(self->pipeline, &link_tag[0], 2);
+        if (self->encoder) {
+            link_tag[link_num++] = "encoder";
+        }
+        link_tag[link_num++] = "out";
+    }
+    audio_pipeline_link(self->pipeline, &link_tag[0], link_num);
+    if (self->capture != NULL) {
+        // room for the whole pre-roll so flushing it never stalls the capture
+        self->preroll_rb = rb_create(preroll_rb_size, 1);
+        audio_element_handle_t first = self->out_stream;
+        if (self->meter) {
+            first = self->meter;
+        } else if (self->vad) {
+            first = self->vad;
+        } else if (self->tee) {
+            first = self->tee;
+        } else if (self->encoder) {
+            first = self->encoder;
+        }
+        audio_element_set_input_ringbuf(first, self->preroll_rb);
     }
+    audio_placement_exit();
+    if (self->tee) {
+        for (int i = 0; i < output_num; i++) {
+            audio_recorder_create_branch(self, i, &outputs[i], rate, channels, bitrate, copy_uri, backlog);
+        }
+        self->branch_num = output_num;
+        self->encoder = self->branches[0].encoder;
+        self->out_stream = self->branches[0].out_stream;
+        audio_mem_stats_subsystem(NULL);
+        return;
+    }
+    // a file is complete once its writer closed it, raw output once the element
+    // feeding the raw stream is done
+    audio_element_handle_t last = self->raw ? feeder : self->out_stream;
+    // a bare raw stream behind the pre-roll ends in readinto() at the end of the data
+    if (last != NULL) {
+        audio_element_set_event_callback(last, audio_recorder_element_event, self);
+    }
+
+    audio_mem_stats_subsystem(NULL);
 }
 
-static void audio_recorder_maxtime_cb(void *arg)
+STATIC bool audio_recorder_format_ok(int format, int rate, int channels)
 {
-    audio_recorder_stop(arg);
-    audio_recorder_obj_t *self = (audio_recorder_obj_t *)arg;
-    if (self->end_cb != mp_const_none) {
-        mp_sched_schedule(self->end_cb, self);
+    if ((format == AMR && (rate != 8000 || channels != 1)) || channels < 1 || channels > 2) {
+        return false;
     }
+    if (format == OPUS && rate != 8000 && rate != 12000 && rate != 16000 && rate != 24000 && rate != 48000) {
+        return false;
+    }
+    return true;
+}
+
+// (uri, format[, rate]) of another output, a file or an upload. It takes the rate and
+// channels of the recording unless it sets a rate, AMR is 8 kHz mono.
+STATIC bool audio_recorder_parse_output(mp_obj_t obj, audio_recorder_output_t *out, int rate, int channels)
+{
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(obj, &len, &items);
+    if (len < 2 || len > 3) {
+        return false;
+    }
+    out->uri = mp_obj_str_get_str(items[0]);
+    out->format = mp_obj_get_int(items[1]);
+    out->rate = len > 2 && items[2] != mp_const_none ? mp_obj_get_int(items[2]) : (out->format == AMR ? 8000 : rate);
+    out->channels = out->format == AMR ? 1 : channels;
+    if (!audio_recorder_is_upload(out->uri) && strstr(out->uri, "/sdcard/") == NULL) {
+        return false;
+    }
+    if (!audio_recorder_format_ok(out->format, out->rate, out->channels)) {
+        return false;
+    }
+    return (out->rate == rate && out->channels == channels) || audio_decimator_supported(rate, channels, out->rate, out->channels);
 }
 
 STATIC mp_obj_t audio_recorder_start(mp_uint_t n_args, const mp_obj_t *args_in, mp_map_t *kw_args)
@@ -212,13 +724,39 @@ STATIC mp_obj_t audio_recorder_start(mp_uint_t n_args, const mp_obj_t *args_in,
         ARG_uri,
         ARG_format,
         ARG_maxtime,
-        ARG_endcb
+        ARG_endcb,
+        ARG_rate,
+        ARG_channels,
+        ARG_native,
+        ARG_bitrate,
+        ARG_vad,
+        ARG_vad_keep,
+        ARG_vad_stop,
+        ARG_meter,
+        ARG_segment,
+        ARG_segment_size,
+        ARG_backlog,
+        ARG_copy,
+        ARG_outputs,
     };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_uri, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
         { MP_QSTR_format, MP_ARG_INT, { .u_int = PCM } },
         { MP_QSTR_maxtime, MP_ARG_INT, { .u_int = 0 } },
         { MP_QSTR_endcb, MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_rate, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_channels, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_native, MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = false } },
+        { MP_QSTR_bitrate, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_vad, MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = false } },
+        { MP_QSTR_vad_keep, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 200 } },
+        { MP_QSTR_vad_stop, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_meter, MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_segment, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_segment_size, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_backlog, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = RECORDER_UPLOAD_BACKLOG } },
+        { MP_QSTR_copy, MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_outputs, MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     audio_recorder_obj_t *self = args_in[0];
@@ -228,17 +766,106 @@ STATIC mp_obj_t audio_recorder_start(mp_uint_t n_args, const mp_obj_t *args_in,
         return mp_obj_new_bool(false);
     }
 
-    audio_recorder_create(self, mp_obj_str_get_str(args[ARG_uri].u_obj), args[ARG_format].u_int);
+    audio_meter_t *meter = audio_meter_from_obj(args[ARG_meter].u_obj);
+    int format = args[ARG_format].u_int;
+    int rate = args[ARG_rate].u_int;
+    int channels = args[ARG_channels].u_int;
+    if (self->capture != NULL) {
+        // the recording takes the format of the running pre-roll capture
+        if ((rate && rate != self->preroll_rate) || (channels && channels != self->preroll_channels)) {
+            return mp_obj_new_bool(false);
+        }
+        rate = self->preroll_rate;
+        channels = self->preroll_channels;
+    }
+    if (rate == 0) {
+        rate = format == AMR ? 8000 : 16000;
+    }
+    if (channels == 0) {
+        channels = 1;
+    }
+    if (!audio_recorder_format_ok(format, rate, channels)) {
+        return mp_obj_new_bool(false);
+    }
+    if (self->capture == NULL) {
+        // retiming the port under a playing stream would change its pitch, take the
+        // player rate and decimate instead; a native capture keeps the player out until
+        // stop(), so it is only taken when asked for
+        self->native = args[ARG_native].u_bool && RECORDER_NATIVE_RATE_CAPTURE
+            && !audio_player_output_busy() && !audio_recorder_port_held();
+        if (!self->native && !audio_decimator_supported(RECORDER_PORT_RATE, 2, rate, channels)) {
+            return mp_obj_new_bool(false);
+        }
+    }
+
+    const char *uri = mp_obj_str_get_str(args[ARG_uri].u_obj);
+    self->raw = !audio_recorder_is_upload(uri) && strstr(uri, "/sdcard/") == NULL && strstr(uri, "/spiffs/") == NULL;
+    audio_recorder_output_t outputs[AUDIO_TEE_MAX_BRANCHES] = {
+        { .uri = uri, .format = format, .rate = rate, .channels = channels },
+    };
+    int output_num = 1;
+    if (args[ARG_outputs].u_obj != mp_const_none) {
+        // more outputs from the same capture, the raw stream can't be one of them
+        size_t len;
+        mp_obj_t *items;
+        mp_obj_get_array(args[ARG_outputs].u_obj, &len, &items);
+        if (self->raw || len >= AUDIO_TEE_MAX_BRANCHES) {
+            return mp_obj_new_bool(false);
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (!audio_recorder_parse_output(items[i], &outputs[output_num++], rate, channels)) {
+                return mp_obj_new_bool(false);
+            }
+        }
+    }
+    // one upload per recording, it owns the upload counters and the local copy
+    int uploads = 0;
+    for (int i = 0; i < output_num; i++) {
+        uploads += audio_recorder_is_upload(outputs[i].uri);
+    }
+    if (uploads > 1) {
+        return mp_obj_new_bool(false);
+    }
+    self->upload = uploads > 0;
+    const char *copy_uri = args[ARG_copy].u_obj != mp_const_none ? mp_obj_str_get_str(args[ARG_copy].u_obj) : NULL;
+    if (copy_uri != NULL && (!self->upload || strstr(copy_uri, "/sdcard/") == NULL)) {
+        return mp_obj_new_bool(false);
+    }
+    int backlog = args[ARG_backlog].u_int;
+    if (backlog < RECORDER_UPLOAD_MIN_BACKLOG) {
+        backlog = RECORDER_UPLOAD_MIN_BACKLOG;
+    }
+    uint32_t segment_ms = args[ARG_segment].u_int > 0 ? args[ARG_segment].u_int : 0;
+    uint32_t segment_size = args[ARG_segment_size].u_int > 0 ? args[ARG_segment_size].u_int : 0;
+    self->segmented = segment_ms || segment_size;
+    // segments split on PCM frames, ADPCM blocks and AMR frames only
+    if (self->segmented && (self->raw || audio_recorder_is_upload(uri) || format == OPUS || format == MP3 || !vfs_stream_segment_uri_ok(uri))) {
+        return mp_obj_new_bool(false);
+    }
+    self->max_frames = args[ARG_maxtime].u_int > 0 ? (uint32_t)args[ARG_maxtime].u_int * rate : 0;
+    self->ended = false;
+    self->end_cb = args[ARG_endcb].u_obj;
+    memset(&self->vad_stats, 0, sizeof(self->vad_stats));
+    audio_vad_cfg_t vad_cfg = AUDIO_VAD_CFG_DEFAULT();
+    vad_cfg.keep_ms = args[ARG_vad_keep].u_int;
+    vad_cfg.stop_ms = args[ARG_vad_stop].u_int;
+    self->meter_obj = args[ARG_meter].u_obj;
+    audio_recorder_create(self, outputs, output_num, rate, channels, args[ARG_bitrate].u_int, args[ARG_vad].u_bool ? &vad_cfg : NULL, meter,
+        copy_uri, backlog);
+    if (self->segmented) {
+        vfs_stream_set_segment(self->out_stream, segment_size, (uint32_t)((uint64_t)segment_ms * rate / 1000));
+    }
+    self->paused = false;
+    if (self->copy != NULL) {
+        audio_pipeline_run(self->copy);
+    }
+    // the outputs first, they wait for the tee
+    for (int i = 0; i < self->branch_num; i++) {
+        audio_pipeline_run(self->branches[i].pipeline);
+    }
     if (audio_pipeline_run(self->pipeline) == ESP_OK) {
-        if (args[ARG_maxtime].u_int > 0) {
-            esp_timer_create_args_t timer_conf = {
-                .callback = &audio_recorder_maxtime_cb,
-                .name = "maxtime",
-                .arg = self,
-            };
-            esp_timer_create(&timer_conf, &self->timer);
-            esp_timer_start_once(self->timer, args[ARG_maxtime].u_int * 1000000);
-            self->end_cb = args[ARG_endcb].u_obj;
+        if (self->capture != NULL) {
+            audio_preroll_attach(self->preroll, self->preroll_rb, self->max_frames * channels * sizeof(int16_t));
         }
         return mp_obj_new_bool(true);
     } else {
@@ -251,29 +878,237 @@ STATIC mp_obj_t audio_recorder_stop(mp_obj_t self_in)
 {
     audio_recorder_obj_t *self = self_in;
 
-    if (self->timer) {
-        esp_timer_stop(self->timer);
-        esp_timer_delete(self->timer);
-        self->timer = NULL;
-    }
     if (self->pipeline != NULL) {
+        if (self->capture != NULL) {
+            // the capture keeps running, it only stops feeding this recording
+            audio_preroll_detach(self->preroll);
+        }
         audio_pipeline_stop(self->pipeline);
         audio_pipeline_wait_for_stop(self->pipeline);
+        for (int i = 0; i < self->branch_num; i++) {
+            audio_pipeline_stop(self->branches[i].pipeline);
+            audio_pipeline_wait_for_stop(self->branches[i].pipeline);
+        }
+        // the stopped encoder aborts the ringbuffer, let a blocked readinto() in another thread return first
+        while (self->reading) {
+            MP_THREAD_GIL_EXIT();
+            vTaskDelay(1);
+            MP_THREAD_GIL_ENTER();
+        }
+        audio_stack_untrack(self->meter);
+        audio_stack_untrack(self->vad);
+        audio_stack_untrack(self->tee);
+        audio_stack_untrack(self->encoder);
+        if (self->vad) {
+            audio_vad_get_stats(self->vad, &self->vad_stats);
+        }
+        audio_stack_untrack(self->out_stream);
+        if (self->capture == NULL) {
+            audio_stack_untrack(self->i2s_stream);
+            audio_stack_untrack(self->filter);
+        }
+        // the outputs read from the blocks of the tee, release them first
+        audio_recorder_release_branches(self);
         audio_pipeline_deinit(self->pipeline);
+        if (self->capture == NULL) {
+            audio_recorder_release_input(self);
+        }
+        if (self->preroll_rb != NULL) {
+            rb_destroy(self->preroll_rb);
+            self->preroll_rb = NULL;
+        }
+        audio_recorder_release_copy(self);
     } else {
         return mp_obj_new_bool(false);
     }
 
-    self->i2s_stream = NULL;
-    self->filter = NULL;
+    self->meter = NULL;
+    self->meter_obj = mp_const_none;
+    self->paused = false;
+    self->vad = NULL;
+    self->tee = NULL;
     self->encoder = NULL;
     self->out_stream = NULL;
+    self->upload_stream = NULL;
     self->pipeline = NULL;
+    audio_async_event_set(&self->event);
 
     return mp_obj_new_bool(true);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_stop_obj, audio_recorder_stop);
 
+STATIC mp_obj_t audio_recorder_end(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    // restarted before the scheduler got here
+    if (!self->ended) {
+        return mp_const_none;
+    }
+    // raw output stays readable, readinto() tears down once it is drained
+    if (!self->raw && self->pipeline != NULL) {
+        audio_recorder_stop(self);
+    }
+    if (self->end_cb != mp_const_none) {
+        mp_call_function_1(self->end_cb, self);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_end_obj, audio_recorder_end);
+
+STATIC void audio_recorder_release_capture(audio_recorder_obj_t *self)
+{
+    if (self->capture == NULL) {
+        return;
+    }
+    audio_pipeline_stop(self->capture);
+    audio_pipeline_wait_for_stop(self->capture);
+    audio_stack_untrack(self->i2s_stream);
+    audio_stack_untrack(self->filter);
+    audio_stack_untrack(self->preroll);
+    audio_pipeline_deinit(self->capture);
+    audio_recorder_release_input(self);
+    self->capture = NULL;
+    self->preroll = NULL;
+}
+
+STATIC mp_obj_t audio_recorder_preroll(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_ms,
+        ARG_rate,
+        ARG_channels,
+        ARG_budget,
+        ARG_native,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_ms, MP_ARG_INT, { .u_int = 500 } },
+        { MP_QSTR_rate, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 16000 } },
+        { MP_QSTR_channels, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 1 } },
+        { MP_QSTR_budget, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_native, MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = false } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    audio_recorder_obj_t *self = pos_args[0];
+
+    // the recording reads from the capture, change it between recordings only
+    if (self->pipeline != NULL) {
+        return mp_obj_new_bool(false);
+    }
+    audio_recorder_release_capture(self);
+    int rate = args[ARG_rate].u_int;
+    int channels = args[ARG_channels].u_int;
+    if (args[ARG_ms].u_int <= 0) {
+        return mp_obj_new_bool(true);
+    }
+    if (rate <= 0 || channels < 1 || channels > 2) {
+        return mp_obj_new_bool(false);
+    }
+    // the capture runs until the next preroll(0), holding the port at its own rate would
+    // keep the player out all that time: it shares the 48 kHz port unless asked otherwise
+    self->native = args[ARG_native].u_bool && RECORDER_NATIVE_RATE_CAPTURE
+        && !audio_player_output_busy() && !audio_recorder_port_held();
+    if (!self->native && !audio_decimator_supported(RECORDER_PORT_RATE, 2, rate, channels)) {
+        return mp_obj_new_bool(false);
+    }
+    int frame = channels * sizeof(int16_t);
+    int size = (int)((int64_t)args[ARG_ms].u_int * rate / 1000) * frame;
+    if (args[ARG_budget].u_int > 0 && size > args[ARG_budget].u_int) {
+        size = args[ARG_budget].u_int - args[ARG_budget].u_int % frame;
+    }
+
+    audio_mem_stats_subsystem("recorder");
+    // the ring follows the placement of the "preroll" tag, PSRAM on most boards
+    audio_preroll_cfg_t pre_cfg = AUDIO_PREROLL_CFG_DEFAULT();
+    pre_cfg.ring_size = size;
+    pre_cfg.frame_size = frame;
+    pre_cfg.task_stack = audio_stack_size("preroll", NULL, pre_cfg.task_stack);
+    pre_cfg.stack_in_ext = audio_placement_stack_in_ext("preroll", pre_cfg.stack_in_ext);
+    audio_placement_enter("preroll", AUDIO_PLACE_KIND_BUF);
+    self->preroll = audio_preroll_init(&pre_cfg);
+    audio_placement_exit();
+    if (self->preroll == NULL) {
+        self->native = false;
+        audio_mem_stats_subsystem(NULL);
+        return mp_obj_new_bool(false);
+    }
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->capture = audio_pipeline_init(&pipeline_cfg);
+    audio_recorder_create_input(self, rate, channels, 0);
+
+    audio_pipeline_register(self->capture, self->i2s_stream, "i2s");
+    if (self->filter) {
+        audio_pipeline_register(self->capture, self->filter, "filter");
+    }
+    audio_pipeline_register(self->capture, self->preroll, "preroll");
+    audio_stack_track(self->i2s_stream);
+    audio_stack_track(self->filter);
+    audio_stack_track(self->preroll);
+    audio_placement_enter("recorder", AUDIO_PLACE_KIND_RB);
+    if (self->filter) {
+        const char *link_tag[3] = {"i2s", "filter", "preroll"};
+        audio_pipeline_link(self->capture, &link_tag[0], 3);
+    } else {
+        const char *link_tag[2] = {"i2s", "preroll"};
+        audio_pipeline_link(self->capture, &link_tag[0], 2);
+    }
+    audio_placement_exit();
+    audio_mem_stats_subsystem(NULL);
+
+    self->preroll_size = size;
+    self->preroll_rate = rate;
+    self->preroll_channels = channels;
+    if (audio_pipeline_run(self->capture) != ESP_OK) {
+        audio_recorder_release_capture(self);
+        return mp_obj_new_bool(false);
+    }
+    return mp_obj_new_bool(true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_recorder_preroll_obj, 1, audio_recorder_preroll);
+
+STATIC mp_obj_t audio_recorder_pause(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (self->pipeline == NULL || self->paused) {
+        return mp_obj_new_bool(false);
+    }
+    if (self->capture != NULL) {
+        // the capture keeps filling the pre-roll ring
+        audio_preroll_pause(self->preroll, true);
+    } else if (audio_element_pause(self->i2s_stream) != ESP_OK) {
+        return mp_obj_new_bool(false);
+    }
+    self->paused = true;
+    return mp_obj_new_bool(true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_pause_obj, audio_recorder_pause);
+
+STATIC mp_obj_t audio_recorder_resume(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (self->pipeline == NULL || !self->paused) {
+        return mp_obj_new_bool(false);
+    }
+    if (self->capture != NULL) {
+        audio_preroll_pause(self->preroll, false);
+    } else if (audio_element_resume(self->i2s_stream, 0, pdMS_TO_TICKS(2000)) != ESP_OK) {
+        return mp_obj_new_bool(false);
+    }
+    self->paused = false;
+    return mp_obj_new_bool(true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_resume_obj, audio_recorder_resume);
+
+STATIC mp_obj_t audio_recorder_segment(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (self->pipeline == NULL || !self->segmented) {
+        return mp_const_none;
+    }
+    return mp_obj_new_int(vfs_stream_get_segment(self->out_stream));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_segment_obj, audio_recorder_segment);
+
 STATIC mp_obj_t audio_recorder_is_running(mp_obj_t self_in)
 {
     audio_recorder_obj_t *self = self_in;
@@ -281,14 +1116,171 @@ STATIC mp_obj_t audio_recorder_is_running(mp_obj_t self_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_is_running_obj, audio_recorder_is_running);
 
+STATIC const qstr vad_info_fields[] = {
+    MP_QSTR_frames_in, MP_QSTR_frames_out, MP_QSTR_speech, MP_QSTR_trimmed
+};
+
+STATIC mp_obj_t audio_recorder_vad_info(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (self->vad) {
+        audio_vad_get_stats(self->vad, &self->vad_stats);
+    }
+    audio_vad_stats_t *st = &self->vad_stats;
+    mp_obj_t items[4] = {
+        mp_obj_new_int_from_uint(st->frames_in),
+        mp_obj_new_int_from_uint(st->frames_out),
+        mp_obj_new_int_from_uint(st->speech),
+        mp_obj_new_float(st->frames_in ? 1.0f - (float)st->frames_out / st->frames_in : 0.0f),
+    };
+    return mp_obj_new_attrtuple(vad_info_fields, 4, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_vad_info_obj, audio_recorder_vad_info);
+
+STATIC const qstr upload_info_fields[] = {
+    MP_QSTR_sent, MP_QSTR_status, MP_QSTR_backlog, MP_QSTR_backlog_peak, MP_QSTR_failed, MP_QSTR_copy_dropped
+};
+
+STATIC mp_obj_t audio_recorder_upload_info(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (!self->upload) {
+        return mp_const_none;
+    }
+    audio_upload_t *up = &self->upload_state;
+    uint32_t backlog = 0;
+    if (self->pipeline != NULL) {
+        ringbuf_handle_t rb = audio_element_get_input_ringbuf(self->upload_stream);
+        backlog = rb != NULL ? rb_bytes_filled(rb) : 0;
+    }
+    mp_obj_t items[6] = {
+        mp_obj_new_int_from_uint(up->sent),
+        MP_OBJ_NEW_SMALL_INT(up->status),
+        mp_obj_new_int_from_uint(backlog),
+        mp_obj_new_int_from_uint(up->backlog_peak),
+        mp_obj_new_bool(up->failed),
+        mp_obj_new_int_from_uint(up->copy_dropped),
+    };
+    return mp_obj_new_attrtuple(upload_info_fields, 6, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_upload_info_obj, audio_recorder_upload_info);
+
+STATIC mp_obj_t audio_recorder_check_end(mp_obj_t self_in, mp_obj_t arg)
+{
+    audio_recorder_obj_t *self = self_in;
+    return self->pipeline == NULL ? mp_const_true : MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t audio_recorder_wait_end(mp_obj_t self_in)
+{
+    audio_recorder_obj_t *self = self_in;
+    return audio_async_wait_new(self, &self->event, audio_recorder_check_end, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_recorder_wait_end_obj, audio_recorder_wait_end);
+
+STATIC mp_uint_t audio_recorder_read_raw(audio_recorder_obj_t *self, void *buf, mp_uint_t size, int timeout_ms, int *errcode)
+{
+    if (self->pipeline == NULL) {
+        // end of the recording
+        return 0;
+    }
+    if (!self->raw) {
+        *errcode = MP_EINVAL;
+        return MP_STREAM_ERROR;
+    }
+    audio_element_set_input_timeout(self->out_stream, timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms));
+    self->reading = true;
+    MP_THREAD_GIL_EXIT();
+    // straight from the ringbuffer into the caller's buffer
+    int ret = raw_stream_read(self->out_stream, buf, size);
+    self->reading = false;
+    MP_THREAD_GIL_ENTER();
+    if (ret > 0) {
+        return ret;
+    }
+    if (ret == AEL_IO_TIMEOUT) {
+        *errcode = MP_EAGAIN;
+        return MP_STREAM_ERROR;
+    }
+    if (ret == AEL_IO_DONE) {
+        // maxtime or the detector ended the recording and everything is read
+        if (!self->ended) {
+            self->ended = true;
+            mp_sched_schedule(MP_OBJ_FROM_PTR(&audio_recorder_end_obj), MP_OBJ_FROM_PTR(self));
+        }
+        audio_recorder_stop(self);
+    }
+    return 0;
+}
+
+STATIC mp_obj_t audio_recorder_readinto(size_t n_args, const mp_obj_t *args)
+{
+    audio_recorder_obj_t *self = args[0];
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    int timeout_ms = n_args > 2 && args[2] != mp_const_none ? mp_obj_get_int(args[2]) : -1;
+
+    int errcode;
+    mp_uint_t ret = audio_recorder_read_raw(self, bufinfo.buf, bufinfo.len, timeout_ms, &errcode);
+    if (ret == MP_STREAM_ERROR) {
+        if (mp_is_nonblocking_error(errcode)) {
+            return mp_const_none;
+        }
+        mp_raise_OSError(errcode);
+    }
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_recorder_readinto_obj, 2, 3, audio_recorder_readinto);
+
+STATIC mp_uint_t audio_recorder_stream_read(mp_obj_t self_in, void *buf, mp_uint_t size, int *errcode)
+{
+    return audio_recorder_read_raw(self_in, buf, size, -1, errcode);
+}
+
+STATIC mp_uint_t audio_recorder_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode)
+{
+    audio_recorder_obj_t *self = self_in;
+    if (request == MP_STREAM_POLL) {
+        // readable when data is waiting in the raw stream or at the end of the recording
+        if (self->pipeline == NULL) {
+            return arg & MP_STREAM_POLL_RD;
+        }
+        if (self->raw) {
+            ringbuf_handle_t rb = audio_element_get_input_ringbuf(self->out_stream);
+            if (rb != NULL && rb_bytes_filled(rb) > 0) {
+                return arg & MP_STREAM_POLL_RD;
+            }
+        }
+        return 0;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+STATIC const mp_stream_p_t audio_recorder_stream_p = {
+    .read = audio_recorder_stream_read,
+    .ioctl = audio_recorder_ioctl,
+};
+
 STATIC const mp_rom_map_elem_t recorder_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_start), MP_ROM_PTR(&audio_recorder_start_obj) },
     { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&audio_recorder_stop_obj) },
     { MP_ROM_QSTR(MP_QSTR_is_running), MP_ROM_PTR(&audio_recorder_is_running_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pause), MP_ROM_PTR(&audio_recorder_pause_obj) },
+    { MP_ROM_QSTR(MP_QSTR_resume), MP_ROM_PTR(&audio_recorder_resume_obj) },
+    { MP_ROM_QSTR(MP_QSTR_segment), MP_ROM_PTR(&audio_recorder_segment_obj) },
+    { MP_ROM_QSTR(MP_QSTR_preroll), MP_ROM_PTR(&audio_recorder_preroll_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait_end), MP_ROM_PTR(&audio_recorder_wait_end_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vad_info), MP_ROM_PTR(&audio_recorder_vad_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_upload_info), MP_ROM_PTR(&audio_recorder_upload_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&audio_recorder_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_PCM), MP_ROM_INT(PCM) },
     { MP_ROM_QSTR(MP_QSTR_AMR), MP_ROM_INT(AMR) },
     { MP_ROM_QSTR(MP_QSTR_WAV), MP_ROM_INT(WAV) },
     { MP_ROM_QSTR(MP_QSTR_MP3), MP_ROM_INT(MP3) },
+    { MP_ROM_QSTR(MP_QSTR_OPUS), MP_ROM_INT(OPUS) },
+    { MP_ROM_QSTR(MP_QSTR_ADPCM), MP_ROM_INT(ADPCM) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(recorder_locals_dict, recorder_locals_dict_table);
@@ -299,5 +1291,6 @@ MP_DEFINE_CONST_OBJ_TYPE(
     MP_QSTR_recorder,
     MP_TYPE_FLAG_NONE,
     make_new, audio_recorder_make_new,
+    protocol, &audio_recorder_stream_p,
     locals_dict, &recorder_locals_dict
     );
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_element.h"
+#include "esp_log.h"
+
+#include "audio_stack.h"
+
+static const char *TAG = "AUDIO_STACK";
+
+typedef struct {
+    char tag[configMAX_TASK_NAME_LEN];
+    char kind[AUDIO_STACK_KIND_LEN];
+    int size;
+    int max_used;
+    uint32_t run_time;
+    // order of the last audio_stack_size call, the newest record of a tag is the live one
+    uint32_t sized;
+    audio_element_handle_t el;
+} audio_stack_record_t;
+
+static audio_stack_record_t records[AUDIO_STACK_MAX_ELEMENTS];
+static int record_num = 0;
+static uint32_t sized_count = 0;
+static int stack_margin = 0;
+static portMUX_TYPE stack_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// a tag names a slot in a pipeline, the kind the element type created in it: an
+// "encoder" slot holding WAV and AMR gets one record, and one stack size, for each
+static audio_stack_record_t *audio_stack_find(const char *tag, const char *kind, bool create)
+{
+    if (kind == NULL) {
+        kind = "";
+    }
+    for (int i = 0; i < record_num; i++) {
+        if (strncmp(records[i].tag, tag, sizeof(records[i].tag) - 1) == 0
+            && strncmp(records[i].kind, kind, sizeof(records[i].kind) - 1) == 0) {
+            return &records[i];
+        }
+    }
+    if (!create || record_num >= AUDIO_STACK_MAX_ELEMENTS) {
+        return NULL;
+    }
+    audio_stack_record_t *rec = &records[record_num++];
+    memset(rec, 0, sizeof(audio_stack_record_t));
+    strncpy(rec->tag, tag, sizeof(rec->tag) - 1);
+    strncpy(rec->kind, kind, sizeof(rec->kind) - 1);
+    return rec;
+}
+
+// the record of the task running under a tag now, whatever its kind
+static audio_stack_record_t *audio_stack_find_live(const char *tag)
+{
+    audio_stack_record_t *live = NULL;
+    for (int i = 0; i < record_num; i++) {
+        if (strncmp(records[i].tag, tag, sizeof(records[i].tag) - 1) == 0
+            && (live == NULL || records[i].sized > live->sized)) {
+            live = &records[i];
+        }
+    }
+    return live;
+}
+
+static void audio_stack_sample_record(audio_stack_record_t *rec)
+{
+    // element tasks are named after the element tag
+    TaskHandle_t task = xTaskGetHandle(rec->tag);
+    if (task == NULL) {
+        return;
+    }
+    int used = rec->size - (int)(uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t));
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    TaskStatus_t status;
+    vTaskGetInfo(task, &status, pdFALSE, eRunning);
+    rec->run_time = status.ulRunTimeCounter;
+#endif
+    portENTER_CRITICAL(&stack_lock);
+    if (used > rec->max_used) {
+        rec->max_used = used;
+    }
+    portEXIT_CRITICAL(&stack_lock);
+}
+
+int audio_stack_size(const char *tag, const char *kind, int default_size)
+{
+    audio_stack_record_t *rec = audio_stack_find(tag, kind, true);
+    if (rec == NULL) {
+        return default_size;
+    }
+    rec->sized = ++sized_count;
+    if (stack_margin <= 0 || rec->max_used <= 0) {
+        rec->size = default_size;
+        return default_size;
+    }
+    int size = rec->max_used + stack_margin;
+    size = (size + AUDIO_STACK_ALIGN - 1) / AUDIO_STACK_ALIGN * AUDIO_STACK_ALIGN;
+    if (size < AUDIO_STACK_MIN_SIZE) {
+        size = AUDIO_STACK_MIN_SIZE;
+    }
+    ESP_LOGD(TAG, "%s/%s stack %d -> %d (used %d)", tag, rec->kind, default_size, size, rec->max_used);
+    rec->size = size;
+    return size;
+}
+
+void audio_stack_track(audio_element_handle_t el)
+{
+    if (el == NULL) {
+        return;
+    }
+    const char *tag = audio_element_get_tag(el);
+    audio_stack_record_t *rec = audio_stack_find_live(tag);
+    if (rec == NULL) {
+        ESP_LOGW(TAG, "%s not tracked", tag);
+        return;
+    }
+    // the task under this tag is of the live kind now, the others must not sample it
+    for (int i = 0; i < record_num; i++) {
+        if (&records[i] != rec && strncmp(records[i].tag, tag, sizeof(records[i].tag) - 1) == 0) {
+            records[i].el = NULL;
+        }
+    }
+    rec->el = el;
+}
+
+void audio_stack_untrack(audio_element_handle_t el)
+{
+    for (int i = 0; i < record_num; i++) {
+        if (records[i].el == el) {
+            audio_stack_sample_record(&records[i]);
+            records[i].el = NULL;
+        }
+    }
+}
+
+void audio_stack_sample(void)
+{
+    for (int i = 0; i < record_num; i++) {
+        if (records[i].el != NULL) {
+            audio_stack_sample_record(&records[i]);
+        }
+    }
+}
+
+void audio_stack_sample_tag(const char *tag)
+{
+    audio_stack_record_t *rec = audio_stack_find_live(tag);
+    if (rec != NULL) {
+        audio_stack_sample_record(rec);
+    }
+}
+
+void audio_stack_set_margin(int margin)
+{
+    stack_margin = margin > 0 ? margin : 0;
+}
+
+int audio_stack_get_margin(void)
+{
+    return stack_margin;
+}
+
+bool audio_stack_get(int index, const char **tag, const char **kind, int *size, int *max_used, uint32_t *run_time)
+{
+    if (index < 0 || index >= record_num) {
+        return false;
+    }
+    *tag = records[index].tag;
+    *kind = records[index].kind;
+    *size = records[index].size;
+    *max_used = records[index].max_used;
+    *run_time = records[index].run_time;
+    return true;
+}
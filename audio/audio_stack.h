@@ -0,0 +1,115 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_STACK_H_
+#define _AUDIO_STACK_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_STACK_MAX_ELEMENTS (32)
+#define AUDIO_STACK_KIND_LEN (12)
+#define AUDIO_STACK_MIN_SIZE (2048)
+#define AUDIO_STACK_ALIGN (256)
+
+/**
+ * @brief      Get the task stack size to use for an element, taking the measured
+ *             high-water mark of earlier runs into account when auto sizing is enabled.
+ *             The returned size is remembered to compute the usage of the next run.
+ *             Measurements are kept per tag and kind, a slot whose tag holds different
+ *             element types never gets the size measured on another type.
+ *
+ * @param      tag           The element tag (also the name of its task)
+ * @param      kind          The element type, e.g. "wav_enc" or "http", NULL when the
+ *                           tag only ever holds one type
+ * @param      default_size  Stack size used when no measurement is available
+ *
+ * @return     The stack size in bytes
+ */
+int audio_stack_size(const char *tag, const char *kind, int default_size);
+
+/**
+ * @brief      Start recording the stack usage of an element task, the element must have
+ *             been created with the size returned by the last `audio_stack_size` call
+ *             for its tag
+ *
+ * @param      el    The element handle, its tag must be final
+ */
+void audio_stack_track(audio_element_handle_t el);
+
+/**
+ * @brief      Take a last sample and stop recording the stack usage of an element,
+ *             must be called before the element is deinitialized
+ *
+ * @param      el    The element handle
+ */
+void audio_stack_untrack(audio_element_handle_t el);
+
+/**
+ * @brief      Sample the stack high-water mark of all tracked element tasks
+ */
+void audio_stack_sample(void);
+
+/**
+ * @brief      Sample a task that is not an element, by its name
+ *
+ * @param      tag   The task name, also used for `audio_stack_size`
+ */
+void audio_stack_sample_tag(const char *tag);
+
+/**
+ * @brief      Set the safety margin added to the measured usage, 0 disables auto sizing
+ *
+ * @param      margin  Margin in bytes
+ */
+void audio_stack_set_margin(int margin);
+
+/**
+ * @brief      Get the safety margin, 0 when auto sizing is disabled
+ */
+int audio_stack_get_margin(void);
+
+/**
+ * @brief      Iterate over the measurements
+ *
+ * @param      index     Index of the record, from 0
+ * @param      tag       Returns the element tag
+ * @param      kind      Returns the element type, "" when not given
+ * @param      size      Returns the stack size of the last created instance
+ * @param      max_used  Returns the largest stack usage seen, 0 if never measured
+ * @param      run_time  Returns the CPU time of the last task instance in run time stats
+ *                       units, 0 without CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+ *
+ * @return     false when index is out of range
+ */
+bool audio_stack_get(int index, const char **tag, const char **kind, int *size, int *max_used, uint32_t *run_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
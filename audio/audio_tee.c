@@ -0,0 +1,322 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_tee.h"
+
+static const char *TAG = "TEE";
+
+typedef struct tee_block {
+    int refs;
+    int len;
+    char *data;
+} tee_block_t;
+
+typedef struct tee_branch {
+    struct audio_tee *tee;
+    QueueHandle_t queue;   // blocks waiting for the branch
+    tee_block_t *cur;      // the block being read and its read position
+    int pos;
+    volatile audio_tee_stats_t stats;
+} tee_branch_t;
+
+typedef struct audio_tee {
+    int branch_num;
+    int block_size;
+    int depth;
+    int block_num;
+    tee_block_t *blocks;
+    char *mem;
+    QueueHandle_t pool;    // free blocks
+    volatile bool done;
+    tee_branch_t branch[AUDIO_TEE_MAX_BRANCHES];
+} audio_tee_t;
+
+static portMUX_TYPE tee_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void _tee_unref(audio_tee_t *tee, tee_block_t *blk)
+{
+    portENTER_CRITICAL(&tee_lock);
+    int refs = --blk->refs;
+    portEXIT_CRITICAL(&tee_lock);
+    if (refs == 0) {
+        xQueueSend(tee->pool, &blk, 0);
+    }
+}
+
+// the read callback of a branch's first element
+static int _tee_read(audio_element_handle_t el, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    tee_branch_t *branch = (tee_branch_t *)context;
+    audio_tee_t *tee = branch->tee;
+    TickType_t start = xTaskGetTickCount();
+    int filled = 0;
+
+    // fill the whole buffer like a ringbuffer read, codecs expect full frames
+    while (filled < len) {
+        if (branch->cur == NULL) {
+            // done is set after the last block was queued, check it before looking
+            bool done = tee->done;
+            if (xQueueReceive(branch->queue, &branch->cur, done ? 0 : pdMS_TO_TICKS(AUDIO_TEE_POLL_MS)) == pdTRUE) {
+                branch->pos = 0;
+            } else if (done) {
+                return filled > 0 ? filled : AEL_IO_DONE;
+            } else if (audio_element_is_stopping(el)) {
+                return AEL_IO_ABORT;
+            } else if (ticks_to_wait != portMAX_DELAY && xTaskGetTickCount() - start >= ticks_to_wait) {
+                // only a raw stream read by the application sets a timeout
+                return filled > 0 ? filled : AEL_IO_TIMEOUT;
+            }
+            continue;
+        }
+        int n = branch->cur->len - branch->pos;
+        if (n > len - filled) {
+            n = len - filled;
+        }
+        memcpy(buffer + filled, branch->cur->data + branch->pos, n);
+        filled += n;
+        branch->pos += n;
+        if (branch->pos == branch->cur->len) {
+            _tee_unref(tee, branch->cur);
+            branch->cur = NULL;
+        }
+    }
+    return filled;
+}
+
+// hand a filled block to every branch, the caller's reference is dropped last
+static void _tee_queue(audio_tee_t *tee, tee_block_t *blk)
+{
+    blk->refs = tee->branch_num + 1;
+    for (int i = 0; i < tee->branch_num; i++) {
+        tee_branch_t *branch = &tee->branch[i];
+        if (xQueueSend(branch->queue, &blk, 0) == pdTRUE) {
+            branch->stats.blocks++;
+            uint32_t waiting = uxQueueMessagesWaiting(branch->queue);
+            if (waiting > branch->stats.peak) {
+                branch->stats.peak = waiting;
+            }
+        } else {
+            branch->stats.dropped += blk->len;
+            _tee_unref(tee, blk);
+        }
+    }
+    _tee_unref(tee, blk);
+}
+
+static esp_err_t _tee_open(audio_element_handle_t self)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    tee->done = false;
+    for (int i = 0; i < tee->branch_num; i++) {
+        memset((void *)&tee->branch[i].stats, 0, sizeof(audio_tee_stats_t));
+    }
+    return ESP_OK;
+}
+
+static int _tee_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    tee_block_t *blk = NULL;
+
+    // a branch holds at most depth queued blocks and the one it reads, the pool
+    // has one more for the input so it never runs dry
+    if (xQueueReceive(tee->pool, &blk, 0) != pdTRUE) {
+        ESP_LOGE(TAG, "No free block");
+        return AEL_IO_FAIL;
+    }
+    // the input lands in the shared block, branches read it from there
+    int r_size = audio_element_input(self, blk->data, tee->block_size);
+    if (r_size <= 0) {
+        xQueueSend(tee->pool, &blk, 0);
+        if (r_size == AEL_IO_DONE || r_size == AEL_IO_OK) {
+            tee->done = true;
+        }
+        return r_size;
+    }
+    blk->len = r_size;
+    _tee_queue(tee, blk);
+    return r_size;
+}
+
+static esp_err_t _tee_close(audio_element_handle_t self)
+{
+    return ESP_OK;
+}
+
+static void _tee_free(audio_tee_t *tee)
+{
+    for (int i = 0; i < tee->branch_num; i++) {
+        if (tee->branch[i].queue) {
+            vQueueDelete(tee->branch[i].queue);
+        }
+    }
+    if (tee->pool) {
+        vQueueDelete(tee->pool);
+    }
+    audio_free(tee->mem);
+    audio_free(tee->blocks);
+    audio_free(tee);
+}
+
+static esp_err_t _tee_destroy(audio_element_handle_t self)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    _tee_free(tee);
+    return ESP_OK;
+}
+
+esp_err_t audio_tee_connect(audio_element_handle_t self, int branch, audio_element_handle_t el)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    if (branch < 0 || branch >= tee->branch_num) {
+        return ESP_FAIL;
+    }
+    return audio_element_set_read_cb(el, _tee_read, &tee->branch[branch]);
+}
+
+void audio_tee_get_stats(audio_element_handle_t self, int branch, audio_tee_stats_t *stats)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    memset(stats, 0, sizeof(audio_tee_stats_t));
+    if (branch >= 0 && branch < tee->branch_num) {
+        stats->blocks = tee->branch[branch].stats.blocks;
+        stats->dropped = tee->branch[branch].stats.dropped;
+        stats->peak = tee->branch[branch].stats.peak;
+    }
+}
+
+int audio_tee_write(audio_element_handle_t self, const char *data, int len)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    int pos = 0;
+    while (pos < len) {
+        tee_block_t *blk = NULL;
+        if (xQueueReceive(tee->pool, &blk, 0) != pdTRUE) {
+            // the writer never waits, whatever does not fit is lost to every branch
+            for (int i = 0; i < tee->branch_num; i++) {
+                tee->branch[i].stats.dropped += len - pos;
+            }
+            break;
+        }
+        blk->len = len - pos < tee->block_size ? len - pos : tee->block_size;
+        memcpy(blk->data, data + pos, blk->len);
+        pos += blk->len;
+        _tee_queue(tee, blk);
+    }
+    return len;
+}
+
+void audio_tee_write_done(audio_element_handle_t self)
+{
+    audio_tee_t *tee = (audio_tee_t *)audio_element_getdata(self);
+    tee->done = true;
+}
+
+void audio_tee_slot_set(audio_tee_slot_t *slot, audio_element_handle_t tee)
+{
+    slot->tee = tee;
+    // a feed that started before the swap may still hold the old tee
+    while (slot->busy) {
+        vTaskDelay(1);
+    }
+}
+
+void audio_tee_slot_feed(audio_tee_slot_t *slot, const char *data, int len, int rate)
+{
+    slot->busy = true;
+    audio_element_handle_t tee = slot->tee;
+    if (tee != NULL) {
+        if (rate == slot->rate) {
+            audio_tee_write(tee, data, len);
+        } else {
+            slot->skipped += len;
+        }
+    }
+    slot->busy = false;
+}
+
+audio_element_handle_t audio_tee_init(audio_tee_cfg_t *config)
+{
+    if (config->branches < 1 || config->branches > AUDIO_TEE_MAX_BRANCHES || config->depth < 1 || config->block_size < 4) {
+        ESP_LOGE(TAG, "Unsupported configuration %d/%d/%d", config->branches, config->depth, config->block_size);
+        return NULL;
+    }
+    audio_element_handle_t el;
+    audio_tee_t *tee = audio_calloc(1, sizeof(audio_tee_t));
+
+    AUDIO_MEM_CHECK(TAG, tee, return NULL);
+
+    tee->branch_num = config->branches;
+    tee->block_size = config->block_size & ~3;
+    tee->depth = config->depth;
+    tee->block_num = tee->branch_num * (tee->depth + 1) + 1;
+    tee->blocks = audio_calloc(tee->block_num, sizeof(tee_block_t));
+    tee->mem = audio_calloc(tee->block_num, tee->block_size);
+    tee->pool = xQueueCreate(tee->block_num, sizeof(tee_block_t *));
+    AUDIO_MEM_CHECK(TAG, tee->blocks && tee->mem && tee->pool, goto _tee_init_exit);
+    for (int i = 0; i < tee->block_num; i++) {
+        tee_block_t *blk = &tee->blocks[i];
+        blk->data = tee->mem + i * tee->block_size;
+        xQueueSend(tee->pool, &blk, 0);
+    }
+    for (int i = 0; i < tee->branch_num; i++) {
+        tee->branch[i].tee = tee;
+        tee->branch[i].queue = xQueueCreate(tee->depth, sizeof(tee_block_t *));
+        AUDIO_MEM_CHECK(TAG, tee->branch[i].queue, goto _tee_init_exit);
+    }
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _tee_open;
+    cfg.close = _tee_close;
+    cfg.process = _tee_process;
+    cfg.destroy = _tee_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    // reads straight into the shared blocks, no element buffer and no output
+    cfg.buffer_len = 0;
+    cfg.out_rb_size = 0;
+    cfg.tag = "tee";
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _tee_init_exit);
+    audio_element_setdata(el, tee);
+    return el;
+_tee_init_exit:
+    _tee_free(tee);
+    return NULL;
+}
@@ -0,0 +1,143 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_TEE_H_
+#define _AUDIO_TEE_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_TEE_MAX_BRANCHES (4)
+#define AUDIO_TEE_BLOCK_SIZE (2048)
+#define AUDIO_TEE_DEPTH (32)
+#define AUDIO_TEE_POLL_MS (20)
+#define AUDIO_TEE_TASK_STACK (2048)
+#define AUDIO_TEE_TASK_CORE (1)
+#define AUDIO_TEE_TASK_PRIO (5)
+
+/**
+ * @brief   Counters of one branch
+ */
+typedef struct {
+    uint32_t blocks;   /*!< Blocks queued to the branch */
+    uint32_t dropped;  /*!< Bytes dropped while the branch was `depth` blocks behind */
+    uint32_t peak;     /*!< Most blocks waiting for the branch */
+} audio_tee_stats_t;
+
+/**
+ * @brief   A tee fed by an output task instead of its own task, see audio_tee_slot_set()
+ */
+typedef struct {
+    audio_element_handle_t volatile tee;
+    volatile bool busy;
+    int rate;                   /*!< Rate the tee's branches expect, other feeds are skipped */
+    volatile uint32_t skipped;  /*!< Bytes fed at another rate */
+} audio_tee_slot_t;
+
+/**
+ * @brief   Tee configuration
+ */
+typedef struct {
+    int branches;         /*!< Number of branches, up to AUDIO_TEE_MAX_BRANCHES */
+    int block_size;       /*!< Bytes read from the input at a time, rounded down to whole stereo frames */
+    int depth;            /*!< Blocks a branch may fall behind before its input is dropped */
+    int task_stack;       /*!< Task stack size */
+    int task_core;        /*!< Task running in core (0 or 1) */
+    int task_prio;        /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;    /*!< Try to allocate stack in external memory */
+} audio_tee_cfg_t;
+
+#define AUDIO_TEE_CFG_DEFAULT()                     \
+{                                                   \
+    .branches = 2,                                  \
+    .block_size = AUDIO_TEE_BLOCK_SIZE,             \
+    .depth = AUDIO_TEE_DEPTH,                       \
+    .task_stack = AUDIO_TEE_TASK_STACK,             \
+    .task_core = AUDIO_TEE_TASK_CORE,               \
+    .task_prio = AUDIO_TEE_TASK_PRIO,               \
+    .stack_in_ext = false,                          \
+}
+
+/**
+ * @brief      Create an Audio Element that hands its input to several branches. Each block
+ *             is read once into a shared, reference counted buffer and queued to every
+ *             branch, a branch `depth` blocks behind loses the block instead of holding up
+ *             the input and the other branches. The tee has no output ringbuffer, it is the
+ *             last element of its pipeline and each branch starts a pipeline of its own.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_tee_init(audio_tee_cfg_t *config);
+
+/**
+ * @brief      Feed a branch to the first element of a branch pipeline by setting its read
+ *             callback. The element reads AEL_IO_DONE once the tee input is done and the
+ *             branch drained, and AEL_IO_ABORT when it is stopped while waiting.
+ *
+ * @param      branch  Index of the branch
+ * @param      el      The element, must not outlive the tee
+ */
+esp_err_t audio_tee_connect(audio_element_handle_t self, int branch, audio_element_handle_t el);
+
+/**
+ * @brief      Get the counters of a branch, they are reset when the tee opens
+ */
+void audio_tee_get_stats(audio_element_handle_t self, int branch, audio_tee_stats_t *stats);
+
+/**
+ * @brief      Hand data to the branches of a tee that is not run as an element, from a
+ *             writer's callback for example. It is copied once into the shared blocks and
+ *             never waits: a branch `depth` blocks behind loses it and when no block is free
+ *             every branch does.
+ *
+ * @return     len
+ */
+int audio_tee_write(audio_element_handle_t self, const char *data, int len);
+
+/**
+ * @brief      End the input of a tee fed with audio_tee_write(), its branches read
+ *             AEL_IO_DONE once drained
+ */
+void audio_tee_write_done(audio_element_handle_t self);
+
+/**
+ * @brief      Swap the tee of a slot, returns once the previous tee is no longer in use
+ */
+void audio_tee_slot_set(audio_tee_slot_t *slot, audio_element_handle_t tee);
+
+/**
+ * @brief      Write to the tee of a slot if there is one and `rate` is the slot rate
+ */
+void audio_tee_slot_feed(audio_tee_slot_t *slot, const char *data, int len, int rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,588 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "py/mpthread.h"
+#include "py/runtime.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_element.h"
+#include "audio_pipeline.h"
+#include "esp_audio.h"
+#include "filter_resample.h"
+#include "ringbuf.h"
+
+#include "http_stream.h"
+#include "vfs_stream.h"
+
+#include "amr_decoder.h"
+#include "mp3_decoder.h"
+#include "wav_decoder.h"
+
+#include "amrnb_encoder.h"
+#include "opus_encoder.h"
+#include "wav_encoder.h"
+
+#include "audio_adpcm_encoder.h"
+#include "audio_async.h"
+#include "audio_mem_stats.h"
+#include "audio_placement.h"
+#include "audio_probe.h"
+#include "audio_stack.h"
+#include "modaudio.h"
+
+// below the elements of the players, a transcode only takes the time they leave
+#define TRANSCODE_TASK_PRIO (3)
+#define TRANSCODE_TASK_CORE (0)
+
+static const char *TAG = "AUDIO_TRANSCODE";
+
+// the formats of audio.recorder
+enum {
+    PCM,
+    AMR,
+    WAV,
+    MP3,
+    OPUS,
+    ADPCM
+};
+
+const mp_obj_type_t audio_transcode_type;
+
+// reader->decoder->[resample]->[encoder]->file with nothing pacing it, every element
+// runs as fast as its input arrives
+typedef struct _audio_transcode_obj_t {
+    mp_obj_base_t base;
+
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t reader;
+    audio_element_handle_t decoder;
+    audio_element_handle_t filter;
+    audio_element_handle_t encoder;
+    audio_element_handle_t writer;
+
+    // format of the PCM after the decoder or the filter, the source's until it is known
+    volatile int pcm_rate;
+    volatile int pcm_channels;
+    // PCM read by the first element after the decoder or filter, see transcode_count_read()
+    volatile uint64_t pcm_bytes;
+    int64_t start_time;
+    volatile int elapsed_ms;
+    volatile int status;
+    volatile int err;
+    audio_async_event_t event;
+} audio_transcode_obj_t;
+
+STATIC mp_obj_t audio_transcode_deinit(mp_obj_t self_in);
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_transcode_deinit_obj, audio_transcode_deinit);
+
+STATIC int transcode_error(int ael_status)
+{
+    switch (ael_status) {
+        case AEL_STATUS_ERROR_OPEN:
+            return ESP_ERR_AUDIO_OPEN;
+        case AEL_STATUS_ERROR_INPUT:
+            return ESP_ERR_AUDIO_INPUT;
+        case AEL_STATUS_ERROR_PROCESS:
+            return ESP_ERR_AUDIO_PROCESS;
+        case AEL_STATUS_ERROR_OUTPUT:
+            return ESP_ERR_AUDIO_OUTPUT;
+        case AEL_STATUS_ERROR_CLOSE:
+            return ESP_ERR_AUDIO_CLOSE;
+        case AEL_STATUS_ERROR_TIMEOUT:
+            return ESP_ERR_AUDIO_TIMEOUT;
+        default:
+            return ESP_ERR_AUDIO_UNKNOWN;
+    }
+}
+
+STATIC void transcode_end(audio_transcode_obj_t *self, int status, int err)
+{
+    if (self->status != AUDIO_STATUS_RUNNING) {
+        return;
+    }
+    self->elapsed_ms = (int)((esp_timer_get_time() - self->start_time) / 1000);
+    self->err = err;
+    self->status = status;
+    audio_async_event_set(&self->event);
+    // the teardown waits for every element task, run it on the MicroPython thread
+    mp_sched_schedule(MP_OBJ_FROM_PTR(&audio_transcode_deinit_obj), MP_OBJ_FROM_PTR(self));
+}
+
+STATIC esp_err_t transcode_event(audio_element_handle_t el, audio_event_iface_msg_t *msg, void *ctx)
+{
+    audio_transcode_obj_t *self = ctx;
+    if (el == self->decoder && msg->cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
+        audio_element_info_t info;
+        audio_element_getinfo(self->decoder, &info);
+        ESP_LOGI(TAG, "source %d Hz %d ch %d bit", info.sample_rates, info.channels, info.bits);
+        // reported before the first PCM leaves the decoder
+        if (self->filter != NULL) {
+            rsp_filter_set_src_info(self->filter, info.sample_rates, info.channels);
+        } else {
+            self->pcm_rate = info.sample_rates;
+            self->pcm_channels = info.channels;
+            audio_element_info_t out;
+            audio_element_getinfo(self->writer, &out);
+            out.sample_rates = info.sample_rates;
+            out.channels = info.channels;
+            audio_element_setinfo(self->writer, &out);
+        }
+        return ESP_OK;
+    }
+    if (msg->cmd != AEL_MSG_CMD_REPORT_STATUS) {
+        return ESP_OK;
+    }
+    int status = (int)(intptr_t)msg->data;
+    if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+        ESP_LOGW(TAG, "%s error %d", audio_element_get_tag(el), status);
+        transcode_end(self, AUDIO_STATUS_ERROR, transcode_error(status));
+    } else if (el == self->writer && status == AEL_STATUS_STATE_FINISHED) {
+        transcode_end(self, AUDIO_STATUS_FINISHED, ESP_ERR_AUDIO_NO_ERROR);
+    }
+    return ESP_OK;
+}
+
+// the read callback of the element after the decoder or filter, the same ringbuffer read
+// the element would do, counting the PCM on the way
+STATIC int transcode_count_read(audio_element_handle_t el, char *buf, int len, TickType_t ticks_to_wait, void *ctx)
+{
+    audio_transcode_obj_t *self = ctx;
+    int ret = rb_read(audio_element_get_input_ringbuf(el), buf, len, ticks_to_wait);
+    if (ret > 0) {
+        self->pcm_bytes += ret;
+    }
+    return ret;
+}
+
+STATIC audio_element_handle_t transcode_create_reader(const char *uri, int prio)
+{
+    audio_element_handle_t reader;
+    audio_placement_enter("tc_in", AUDIO_PLACE_KIND_BUF);
+    if (strncasecmp(uri, "http", 4) == 0) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = AUDIO_STREAM_READER;
+        http_cfg.task_core = TRANSCODE_TASK_CORE;
+        http_cfg.task_prio = prio;
+        http_cfg.task_stack = audio_stack_size("tc_in", "http", http_cfg.task_stack);
+        http_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_in", http_cfg.stack_in_ext);
+        reader = http_stream_init(&http_cfg);
+    } else {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_READER;
+        vfs_cfg.task_core = TRANSCODE_TASK_CORE;
+        vfs_cfg.task_prio = prio;
+        vfs_cfg.task_stack = audio_stack_size("tc_in", "vfs", vfs_cfg.task_stack);
+        vfs_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_in", vfs_cfg.stack_in_ext);
+        reader = vfs_stream_init(&vfs_cfg);
+    }
+    audio_placement_exit();
+    audio_element_set_uri(reader, uri);
+    return reader;
+}
+
+STATIC audio_element_handle_t transcode_create_decoder(audio_probe_type_t type, int prio)
+{
+    audio_element_handle_t decoder = NULL;
+    audio_placement_enter("tc_dec", AUDIO_PLACE_KIND_BUF);
+    switch (type) {
+        case AUDIO_PROBE_MP3: {
+            mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+            mp3_cfg.task_core = TRANSCODE_TASK_CORE;
+            mp3_cfg.task_prio = prio;
+            mp3_cfg.task_stack = audio_stack_size("tc_dec", "mp3_dec", mp3_cfg.task_stack);
+            mp3_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_dec", mp3_cfg.stack_in_ext);
+            decoder = mp3_decoder_init(&mp3_cfg);
+            break;
+        }
+        case AUDIO_PROBE_WAV: {
+            wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+            wav_cfg.task_core = TRANSCODE_TASK_CORE;
+            wav_cfg.task_prio = prio;
+            wav_cfg.task_stack = audio_stack_size("tc_dec", "wav_dec", wav_cfg.task_stack);
+            wav_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_dec", wav_cfg.stack_in_ext);
+            decoder = wav_decoder_init(&wav_cfg);
+            break;
+        }
+        case AUDIO_PROBE_AMR: {
+            amr_decoder_cfg_t amr_cfg = DEFAULT_AMR_DECODER_CONFIG();
+            amr_cfg.task_core = TRANSCODE_TASK_CORE;
+            amr_cfg.task_prio = prio;
+            amr_cfg.task_stack = audio_stack_size("tc_dec", "amr_dec", amr_cfg.task_stack);
+            amr_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_dec", amr_cfg.stack_in_ext);
+            decoder = amr_decoder_init(&amr_cfg);
+            break;
+        }
+        default:
+            break;
+    }
+    audio_placement_exit();
+    return decoder;
+}
+
+STATIC audio_element_handle_t transcode_create_filter(int rate, int channels, int prio)
+{
+    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+    // the source format is set once the decoder reports it
+    rsp_cfg.dest_rate = rate;
+    rsp_cfg.dest_ch = channels;
+    rsp_cfg.task_core = TRANSCODE_TASK_CORE;
+    rsp_cfg.task_prio = prio;
+    rsp_cfg.task_stack = audio_stack_size("tc_rsp", NULL, rsp_cfg.task_stack);
+    rsp_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_rsp", rsp_cfg.stack_in_ext);
+    audio_placement_enter("tc_rsp", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t filter = rsp_filter_init(&rsp_cfg);
+    audio_placement_exit();
+    return filter;
+}
+
+STATIC audio_element_handle_t transcode_create_encoder(int format, int rate, int channels, int bitrate, int prio)
+{
+    audio_element_handle_t encoder = NULL;
+    audio_placement_enter("tc_enc", AUDIO_PLACE_KIND_BUF);
+    switch (format) {
+        case AMR: {
+            amrnb_encoder_cfg_t amr_cfg = DEFAULT_AMRNB_ENCODER_CONFIG();
+            amr_cfg.task_core = TRANSCODE_TASK_CORE;
+            amr_cfg.task_prio = prio;
+            amr_cfg.task_stack = audio_stack_size("tc_enc", "amrnb_enc", amr_cfg.task_stack);
+            amr_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_enc", amr_cfg.stack_in_ext);
+            encoder = amrnb_encoder_init(&amr_cfg);
+            break;
+        }
+        case WAV: {
+            wav_encoder_cfg_t wav_cfg = DEFAULT_WAV_ENCODER_CONFIG();
+            wav_cfg.task_core = TRANSCODE_TASK_CORE;
+            wav_cfg.task_prio = prio;
+            wav_cfg.task_stack = audio_stack_size("tc_enc", "wav_enc", wav_cfg.task_stack);
+            wav_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_enc", wav_cfg.stack_in_ext);
+            encoder = wav_encoder_init(&wav_cfg);
+            break;
+        }
+        case OPUS: {
+            opus_encoder_cfg_t opus_cfg = DEFAULT_OPUS_ENCODER_CONFIG();
+            opus_cfg.sample_rate = rate;
+            opus_cfg.channel = channels;
+            if (bitrate > 0) {
+                opus_cfg.bitrate = bitrate;
+            }
+            opus_cfg.task_core = TRANSCODE_TASK_CORE;
+            opus_cfg.task_prio = prio;
+            opus_cfg.task_stack = audio_stack_size("tc_enc", "opus_enc", opus_cfg.task_stack);
+            opus_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_enc", opus_cfg.stack_in_ext);
+            encoder = encoder_opus_init(&opus_cfg);
+            break;
+        }
+        case ADPCM: {
+            audio_adpcm_encoder_cfg_t adpcm_cfg = AUDIO_ADPCM_ENCODER_CFG_DEFAULT();
+            adpcm_cfg.sample_rate = rate;
+            adpcm_cfg.channels = channels;
+            adpcm_cfg.task_core = TRANSCODE_TASK_CORE;
+            adpcm_cfg.task_prio = prio;
+            adpcm_cfg.task_stack = audio_stack_size("tc_enc", "adpcm_enc", adpcm_cfg.task_stack);
+            adpcm_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_enc", adpcm_cfg.stack_in_ext);
+            encoder = audio_adpcm_encoder_init(&adpcm_cfg);
+            break;
+        }
+        default:
+            break;
+    }
+    audio_placement_exit();
+    return encoder;
+}
+
+STATIC audio_element_handle_t transcode_create_writer(const char *uri, int format, int rate, int channels, int prio)
+{
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_WRITER;
+    vfs_cfg.task_core = TRANSCODE_TASK_CORE;
+    vfs_cfg.task_prio = prio;
+    vfs_cfg.task_stack = audio_stack_size("tc_out", NULL, vfs_cfg.task_stack);
+    vfs_cfg.stack_in_ext = audio_placement_stack_in_ext("tc_out", vfs_cfg.stack_in_ext);
+    audio_placement_enter("tc_out", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t writer = vfs_stream_init(&vfs_cfg);
+    audio_placement_exit();
+    audio_element_set_uri(writer, uri);
+    // the header of a .wav file, the source format is filled in later when it is kept
+    audio_element_info_t info;
+    audio_element_getinfo(writer, &info);
+    info.sample_rates = rate;
+    info.channels = channels;
+    info.bits = format == ADPCM ? AUDIO_ADPCM_WAV_BITS : 16;
+    audio_element_setinfo(writer, &info);
+    return writer;
+}
+
+STATIC void transcode_register(audio_transcode_obj_t *self, audio_element_handle_t el, const char *tag, const char **link_tag, int *link_num)
+{
+    if (el == NULL) {
+        return;
+    }
+    audio_pipeline_register(self->pipeline, el, tag);
+    audio_element_set_event_callback(el, transcode_event, self);
+    audio_stack_track(el);
+    link_tag[(*link_num)++] = tag;
+}
+
+STATIC int transcode_create(audio_transcode_obj_t *self, const char *src, const char *dst, audio_probe_type_t type,
+    int format, int rate, int channels, int bitrate, int prio)
+{
+    audio_mem_stats_subsystem("transcode");
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    self->pipeline = audio_pipeline_init(&pipeline_cfg);
+    self->reader = transcode_create_reader(src, prio);
+    self->decoder = transcode_create_decoder(type, prio);
+    if (rate > 0) {
+        self->filter = transcode_create_filter(rate, channels, prio);
+        self->pcm_rate = rate;
+        self->pcm_channels = channels;
+    }
+    if (format != PCM) {
+        self->encoder = transcode_create_encoder(format, rate, channels, bitrate, prio);
+    }
+    self->writer = transcode_create_writer(dst, format, rate, channels, prio);
+    audio_mem_stats_subsystem(NULL);
+    if (self->pipeline == NULL || self->reader == NULL || self->decoder == NULL || (rate > 0 && self->filter == NULL)
+        || (format != PCM && self->encoder == NULL) || self->writer == NULL) {
+        audio_element_handle_t els[5] = { self->reader, self->decoder, self->filter, self->encoder, self->writer };
+        for (int i = 0; i < 5; i++) {
+            if (els[i] != NULL) {
+                audio_element_deinit(els[i]);
+            }
+        }
+        if (self->pipeline != NULL) {
+            audio_pipeline_deinit(self->pipeline);
+        }
+        self->pipeline = NULL;
+        self->reader = NULL;
+        self->decoder = NULL;
+        self->filter = NULL;
+        self->encoder = NULL;
+        self->writer = NULL;
+        return ESP_ERR_AUDIO_MEMORY_LACK;
+    }
+
+    const char *link_tag[5];
+    int link_num = 0;
+    transcode_register(self, self->reader, "tc_in", link_tag, &link_num);
+    transcode_register(self, self->decoder, "tc_dec", link_tag, &link_num);
+    transcode_register(self, self->filter, "tc_rsp", link_tag, &link_num);
+    transcode_register(self, self->encoder, "tc_enc", link_tag, &link_num);
+    transcode_register(self, self->writer, "tc_out", link_tag, &link_num);
+    audio_placement_enter("transcode", AUDIO_PLACE_KIND_RB);
+    audio_pipeline_link(self->pipeline, &link_tag[0], link_num);
+    audio_placement_exit();
+    // after linking, which sets the ringbuffer reads
+    audio_element_set_read_cb(self->encoder ? self->encoder : self->writer, transcode_count_read, self);
+
+    self->status = AUDIO_STATUS_RUNNING;
+    self->err = ESP_ERR_AUDIO_NO_ERROR;
+    self->start_time = esp_timer_get_time();
+    if (audio_pipeline_run(self->pipeline) != ESP_OK) {
+        self->status = AUDIO_STATUS_ERROR;
+        return ESP_ERR_AUDIO_FAIL;
+    }
+    ESP_LOGI(TAG, "%s -> %s, format %d, %d Hz %d ch, prio %d", src, dst, format, rate, channels, prio);
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+STATIC void transcode_release(audio_transcode_obj_t *self)
+{
+    if (self->pipeline == NULL) {
+        return;
+    }
+    MP_THREAD_GIL_EXIT();
+    audio_pipeline_stop(self->pipeline);
+    audio_pipeline_wait_for_stop(self->pipeline);
+    // the last run time and stack use are read from the tasks, before terminate ends them
+    audio_stack_untrack(self->reader);
+    audio_stack_untrack(self->decoder);
+    audio_stack_untrack(self->filter);
+    audio_stack_untrack(self->encoder);
+    audio_stack_untrack(self->writer);
+    audio_pipeline_terminate(self->pipeline);
+    MP_THREAD_GIL_ENTER();
+    // deinit releases the registered elements too
+    audio_pipeline_deinit(self->pipeline);
+    self->pipeline = NULL;
+    self->reader = NULL;
+    self->decoder = NULL;
+    self->filter = NULL;
+    self->encoder = NULL;
+    self->writer = NULL;
+}
+
+STATIC mp_obj_t audio_transcode(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_src,
+        ARG_dst,
+        ARG_format,
+        ARG_rate,
+        ARG_channels,
+        ARG_bitrate,
+        ARG_prio,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_src, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_dst, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_format, MP_ARG_INT, { .u_int = WAV } },
+        { MP_QSTR_rate, MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_channels, MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_bitrate, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_prio, MP_ARG_KW_ONLY | MP_ARG_INT, { .u_int = TRANSCODE_TASK_PRIO } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    const char *src = mp_obj_str_get_str(args[ARG_src].u_obj);
+    const char *dst = mp_obj_str_get_str(args[ARG_dst].u_obj);
+    int format = args[ARG_format].u_int;
+    int rate = args[ARG_rate].u_int;
+    int channels = args[ARG_channels].u_int;
+    int prio = args[ARG_prio].u_int;
+    if (format == AMR) {
+        rate = 8000;
+        channels = 1;
+    } else if (rate > 0 && channels == 0) {
+        channels = 2;
+    }
+    if (strstr(dst, "/sdcard/") == NULL || rate < 0 || (channels != 0 && channels != 1 && channels != 2)
+        || (channels > 0 && rate == 0) || prio < 1 || prio >= configMAX_PRIORITIES) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid argument"));
+    }
+    // the encoders are set up for one format before the source reports its own
+    if ((format == OPUS || format == ADPCM) && rate == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("rate required"));
+    }
+    if (format == MP3 || format < PCM || format > ADPCM) {
+        mp_raise_ValueError(MP_ERROR_TEXT("unsupported format"));
+    }
+    audio_probe_type_t type = audio_probe_uri(src);
+    if (type != AUDIO_PROBE_MP3 && type != AUDIO_PROBE_WAV && type != AUDIO_PROBE_AMR) {
+        mp_raise_ValueError(MP_ERROR_TEXT("unsupported source"));
+    }
+
+    audio_transcode_obj_t *self = m_new_obj_with_finaliser(audio_transcode_obj_t);
+    self->base.type = &audio_transcode_type;
+    int err = transcode_create(self, src, dst, type, format, rate, channels, args[ARG_bitrate].u_int, prio);
+    if (err != ESP_ERR_AUDIO_NO_ERROR) {
+        transcode_release(self);
+        mp_raise_OSError(err == ESP_ERR_AUDIO_MEMORY_LACK ? MP_ENOMEM : MP_EIO);
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(audio_transcode_obj, 2, audio_transcode);
+
+STATIC const qstr transcode_progress_fields[] = {
+    MP_QSTR_status, MP_QSTR_err, MP_QSTR_pos, MP_QSTR_total, MP_QSTR_written, MP_QSTR_media_ms, MP_QSTR_elapsed_ms, MP_QSTR_speed
+};
+
+STATIC mp_obj_t audio_transcode_progress(mp_obj_t self_in)
+{
+    audio_transcode_obj_t *self = self_in;
+    // the input position and the output size stay with the elements, 0 once released
+    audio_element_info_t in = { 0 };
+    audio_element_info_t out = { 0 };
+    if (self->pipeline != NULL) {
+        audio_element_getinfo(self->reader, &in);
+        audio_element_getinfo(self->writer, &out);
+    }
+    int elapsed_ms = self->status == AUDIO_STATUS_RUNNING ? (int)((esp_timer_get_time() - self->start_time) / 1000) : self->elapsed_ms;
+    int frame_size = self->pcm_channels * sizeof(int16_t);
+    int media_ms = self->pcm_rate > 0 && frame_size > 0 ? (int)(self->pcm_bytes / frame_size * 1000 / self->pcm_rate) : 0;
+    mp_obj_t items[8] = {
+        MP_OBJ_NEW_SMALL_INT(self->status),
+        MP_OBJ_NEW_SMALL_INT(self->err),
+        mp_obj_new_int_from_ll(in.byte_pos),
+        mp_obj_new_int_from_ll(in.total_bytes),
+        mp_obj_new_int_from_ll(out.byte_pos),
+        mp_obj_new_int(media_ms),
+        mp_obj_new_int(elapsed_ms),
+        // times real time
+        mp_obj_new_float(elapsed_ms > 0 ? (float)media_ms / elapsed_ms : 0.0f),
+    };
+    return mp_obj_new_attrtuple(transcode_progress_fields, 8, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_transcode_progress_obj, audio_transcode_progress);
+
+STATIC mp_obj_t transcode_check_end(mp_obj_t self_in, mp_obj_t arg)
+{
+    audio_transcode_obj_t *self = self_in;
+    return self->status != AUDIO_STATUS_RUNNING ? MP_OBJ_NEW_SMALL_INT(self->err) : MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t audio_transcode_wait(mp_obj_t self_in)
+{
+    audio_transcode_obj_t *self = self_in;
+    return audio_async_wait_new(self, &self->event, transcode_check_end, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_transcode_wait_obj, audio_transcode_wait);
+
+STATIC mp_obj_t audio_transcode_done(mp_obj_t self_in)
+{
+    audio_transcode_obj_t *self = self_in;
+    return mp_obj_new_bool(self->status != AUDIO_STATUS_RUNNING);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_transcode_done_obj, audio_transcode_done);
+
+STATIC mp_obj_t audio_transcode_stop(mp_obj_t self_in)
+{
+    audio_transcode_obj_t *self = self_in;
+    transcode_end(self, AUDIO_STATUS_STOPPED, ESP_ERR_AUDIO_NO_ERROR);
+    transcode_release(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(audio_transcode_stop_obj, audio_transcode_stop);
+
+STATIC mp_obj_t audio_transcode_deinit(mp_obj_t self_in)
+{
+    transcode_release(self_in);
+    return mp_const_none;
+}
+
+STATIC const mp_rom_map_elem_t transcode_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_progress), MP_ROM_PTR(&audio_transcode_progress_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&audio_transcode_wait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&audio_transcode_done_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&audio_transcode_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&audio_transcode_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&audio_transcode_deinit_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(transcode_locals_dict, transcode_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_transcode_type,
+    MP_QSTR_Transcode,
+    MP_TYPE_FLAG_NONE,
+    locals_dict, &transcode_locals_dict
+    );
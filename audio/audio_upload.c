@@ -0,0 +1,178 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_element.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "http_stream.h"
+#include "wav_head.h"
+
+#include "audio_adpcm_encoder.h"
+#include "audio_upload.h"
+
+static const char *TAG = "AUDIO_UPLOAD";
+
+// one chunk of the chunked transfer encoding, the empty chunk ends the body
+static esp_err_t _upload_chunk(esp_http_client_handle_t http, const char *data, int len)
+{
+    char size[12];
+    int n = snprintf(size, sizeof(size), "%x\r\n", len);
+    if (esp_http_client_write(http, size, n) != n) {
+        return ESP_FAIL;
+    }
+    if (len > 0 && esp_http_client_write(http, data, len) != len) {
+        return ESP_FAIL;
+    }
+    if (esp_http_client_write(http, "\r\n", 2) != 2) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _upload_head(audio_upload_t *up, esp_http_client_handle_t http)
+{
+    if (up->head == AUDIO_UPLOAD_HEAD_WAV && up->bits == AUDIO_ADPCM_WAV_BITS) {
+        uint8_t head[AUDIO_ADPCM_WAV_HEADER_SIZE];
+        audio_adpcm_wav_header(head, up->sample_rate, up->channels, AUDIO_UPLOAD_STREAM_SIZE);
+        return _upload_chunk(http, (const char *)head, sizeof(head));
+    } else if (up->head == AUDIO_UPLOAD_HEAD_WAV) {
+        wav_header_t head;
+        wav_head_init(&head, up->sample_rate, up->bits, up->channels);
+        wav_head_size(&head, AUDIO_UPLOAD_STREAM_SIZE);
+        return _upload_chunk(http, (const char *)&head, sizeof(head));
+    } else if (up->head == AUDIO_UPLOAD_HEAD_AMR) {
+        return _upload_chunk(http, "#!AMR\n", 6);
+    }
+    return ESP_OK;
+}
+
+static int _upload_write(audio_upload_t *up, http_stream_event_msg_t *msg)
+{
+    esp_http_client_handle_t http = msg->http_client;
+    int len = msg->buffer_len;
+
+    // the copy gets everything, a slow card only loses what it can't take in time
+    if (up->copy_rb != NULL
+        && rb_write(up->copy_rb, msg->buffer, len, pdMS_TO_TICKS(AUDIO_UPLOAD_COPY_TIMEOUT_MS)) != len) {
+        up->copy_dropped += len;
+    }
+    if (!up->failed) {
+        if (!up->head_sent) {
+            up->head_sent = true;
+            if (_upload_head(up, http) != ESP_OK) {
+                up->failed = true;
+            }
+        }
+        if (!up->failed && _upload_chunk(http, msg->buffer, len) == ESP_OK) {
+            up->sent += len;
+        } else {
+            ESP_LOGE(TAG, "Upload failed after %u bytes", (unsigned)up->sent);
+            up->failed = true;
+        }
+    }
+    if (up->failed && up->copy_rb == NULL) {
+        return ESP_FAIL;
+    }
+    // what piled up behind this write while the network was slow
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf((audio_element_handle_t)msg->el);
+    if (rb != NULL) {
+        uint32_t waiting = rb_bytes_filled(rb);
+        if (waiting > up->backlog_peak) {
+            up->backlog_peak = waiting;
+        }
+    }
+    return len;
+}
+
+static int _upload_event(http_stream_event_msg_t *msg)
+{
+    audio_upload_t *up = (audio_upload_t *)msg->user_data;
+    esp_http_client_handle_t http = msg->http_client;
+    char value[12];
+
+    switch (msg->event_id) {
+        case HTTP_STREAM_PRE_REQUEST:
+            // a negative length opens the request with Transfer-Encoding: chunked
+            esp_http_client_set_method(http, HTTP_METHOD_POST);
+            esp_http_client_set_header(http, "Content-Type", up->content_type);
+            snprintf(value, sizeof(value), "%d", up->sample_rate);
+            esp_http_client_set_header(http, "x-audio-sample-rates", value);
+            snprintf(value, sizeof(value), "%d", up->bits);
+            esp_http_client_set_header(http, "x-audio-bits", value);
+            snprintf(value, sizeof(value), "%d", up->channels);
+            esp_http_client_set_header(http, "x-audio-channel", value);
+            up->head_sent = false;
+            return ESP_OK;
+        case HTTP_STREAM_ON_REQUEST:
+            return _upload_write(up, msg);
+        case HTTP_STREAM_POST_REQUEST:
+            if (up->copy_rb != NULL) {
+                rb_done_write(up->copy_rb);
+            }
+            if (up->failed) {
+                return ESP_FAIL;
+            }
+            if ((!up->head_sent && _upload_head(up, http) != ESP_OK) || _upload_chunk(http, NULL, 0) != ESP_OK) {
+                up->failed = true;
+                return ESP_FAIL;
+            }
+            up->head_sent = true;
+            return ESP_OK;
+        case HTTP_STREAM_FINISH_REQUEST:
+            up->status = esp_http_client_get_status_code(http);
+            ESP_LOGI(TAG, "Uploaded %u bytes, status %d", (unsigned)up->sent, up->status);
+            return ESP_OK;
+        default:
+            return ESP_OK;
+    }
+}
+
+audio_element_handle_t audio_upload_init(audio_upload_cfg_t *config)
+{
+    audio_upload_t *up = config->upload;
+    if (up == NULL) {
+        ESP_LOGE(TAG, "No upload state");
+        return NULL;
+    }
+    memset(up, 0, sizeof(audio_upload_t));
+    up->content_type = config->content_type;
+    up->head = config->head;
+    up->sample_rate = config->sample_rate;
+    up->channels = config->channels;
+    up->bits = config->bits;
+    up->copy_rb = config->copy_rb;
+
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.type = AUDIO_STREAM_WRITER;
+    http_cfg.event_handle = _upload_event;
+    http_cfg.user_data = up;
+    http_cfg.task_stack = config->task_stack;
+    http_cfg.task_core = config->task_core;
+    http_cfg.task_prio = config->task_prio;
+    http_cfg.stack_in_ext = config->stack_in_ext;
+    return http_stream_init(&http_cfg);
+}
@@ -0,0 +1,117 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_UPLOAD_H_
+#define _AUDIO_UPLOAD_H_
+
+#include "audio_element.h"
+#include "ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_UPLOAD_TASK_STACK (4 * 1024)
+#define AUDIO_UPLOAD_TASK_CORE (0)
+#define AUDIO_UPLOAD_TASK_PRIO (4)
+#define AUDIO_UPLOAD_COPY_TIMEOUT_MS (1000)
+// data size announced by the header of a stream of unknown length
+#define AUDIO_UPLOAD_STREAM_SIZE (0x7ffff000)
+
+/**
+ * @brief   Header sent in front of the payload, a file header for a stream of unknown length
+ */
+typedef enum {
+    AUDIO_UPLOAD_HEAD_NONE,
+    AUDIO_UPLOAD_HEAD_WAV,  /*!< RIFF header of PCM, or of IMA-ADPCM for AUDIO_ADPCM_WAV_BITS */
+    AUDIO_UPLOAD_HEAD_AMR,  /*!< AMR-NB magic */
+} audio_upload_head_t;
+
+/**
+ * @brief   Upload state and counters, owned by the caller and written by the element task
+ */
+typedef struct {
+    const char *content_type;
+    audio_upload_head_t head;
+    int sample_rate;
+    int channels;
+    int bits;
+    ringbuf_handle_t copy_rb;
+    bool head_sent;
+    volatile bool failed;            /*!< The connection broke, the rest only goes to the copy */
+    volatile int status;             /*!< HTTP status of the response, 0 until it arrived */
+    volatile uint32_t sent;          /*!< Payload bytes written to the connection */
+    volatile uint32_t backlog_peak;  /*!< Most bytes seen waiting in the input ringbuffer */
+    volatile uint32_t copy_dropped;  /*!< Bytes the local copy could not take in time */
+} audio_upload_t;
+
+/**
+ * @brief   Upload element configuration
+ */
+typedef struct {
+    audio_upload_t *upload;       /*!< State of the upload, must outlive the element */
+    const char *content_type;     /*!< Content-Type of the request, a string literal */
+    audio_upload_head_t head;     /*!< Header in front of the payload */
+    int sample_rate;              /*!< Format of the payload, also sent as x-audio-* headers */
+    int channels;
+    int bits;
+    ringbuf_handle_t copy_rb;     /*!< Every payload byte is written here too, NULL for none */
+    int task_stack;               /*!< Task stack size */
+    int task_core;                /*!< Task running in core (0 or 1) */
+    int task_prio;                /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;            /*!< Try to allocate stack in external memory */
+} audio_upload_cfg_t;
+
+#define AUDIO_UPLOAD_CFG_DEFAULT()                  \
+{                                                   \
+    .upload = NULL,                                 \
+    .content_type = "application/octet-stream",     \
+    .head = AUDIO_UPLOAD_HEAD_NONE,                 \
+    .sample_rate = 16000,                           \
+    .channels = 1,                                  \
+    .bits = 16,                                     \
+    .copy_rb = NULL,                                \
+    .task_stack = AUDIO_UPLOAD_TASK_STACK,          \
+    .task_core = AUDIO_UPLOAD_TASK_CORE,            \
+    .task_prio = AUDIO_UPLOAD_TASK_PRIO,            \
+    .stack_in_ext = false,                          \
+}
+
+/**
+ * @brief      Create an http_stream writer that POSTs its input to the element uri with
+ *             chunked transfer encoding, one chunk per write. A broken connection is an
+ *             output error, unless there is a copy: then the rest of the input still goes
+ *             to the copy. The copy ringbuffer is marked done when the request ends.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_upload_init(audio_upload_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+#include "esp_log.h"
+#include "audio_vad.h"
+
+static const char *TAG = "VAD";
+
+typedef struct audio_vad {
+    int channels;
+    int frame_samples; // per channel
+    int threshold;
+    uint32_t min_energy;
+    int zcr_max;
+    int hangover;      // all in frames
+    int keep;
+    int stop;
+    bool skip_leading;
+
+    uint32_t floor;    // noise energy, mean square
+    int hang;
+    int gap;           // silent frames since the last speech state
+    bool started;
+    volatile audio_vad_stats_t stats;
+} audio_vad_t;
+
+static int _vad_frames(int ms)
+{
+    return (ms + AUDIO_VAD_FRAME_MS - 1) / AUDIO_VAD_FRAME_MS;
+}
+
+static bool _vad_classify(audio_vad_t *vad, const int16_t *pcm, int samples)
+{
+    uint64_t sum = 0;
+    int zcr = 0;
+    int prev = 0;
+    for (int i = 0; i < samples; i++) {
+        int x = vad->channels == 2 ? (pcm[2 * i] + pcm[2 * i + 1]) >> 1 : pcm[i];
+        sum += (uint32_t)(x * x);
+        zcr += (x ^ prev) < 0;
+        prev = x;
+    }
+    uint32_t energy = sum / samples;
+    if (vad->stats.frames_in == 0) {
+        vad->floor = energy;
+    }
+
+    uint32_t level = vad->floor > vad->min_energy ? vad->floor : vad->min_energy;
+    uint64_t thr = (uint64_t)level * vad->threshold;
+    // quiet frames need the low zero-crossing rate of voiced sound, loud ones pass on energy
+    bool speech = energy > thr && (zcr <= vad->zcr_max || energy > 4 * thr);
+
+    // the floor falls fast and rises slowly, and only outside speech
+    if (energy < vad->floor) {
+        vad->floor -= (vad->floor - energy) >> 2;
+    } else if (!speech && vad->hang == 0) {
+        vad->floor += ((energy - vad->floor) >> 6) + 1;
+    }
+    return speech;
+}
+
+static esp_err_t _vad_open(audio_element_handle_t self)
+{
+    audio_vad_t *vad = (audio_vad_t *)audio_element_getdata(self);
+    vad->floor = 0;
+    vad->hang = 0;
+    vad->gap = 0;
+    vad->started = false;
+    memset((void *)&vad->stats, 0, sizeof(vad->stats));
+    return ESP_OK;
+}
+
+static int _vad_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    audio_vad_t *vad = (audio_vad_t *)audio_element_getdata(self);
+    // one frame per call, only the last read of the stream can be short
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    int samples = r_size / (vad->channels * sizeof(int16_t));
+    if (samples == 0) {
+        return r_size;
+    }
+    bool speech = _vad_classify(vad, (const int16_t *)in_buffer, samples);
+    vad->stats.frames_in++;
+    if (speech) {
+        vad->stats.speech++;
+        vad->hang = vad->hangover;
+        vad->gap = 0;
+        vad->started = true;
+    } else if (vad->hang > 0) {
+        vad->hang--;
+    } else {
+        vad->gap++;
+    }
+    vad->stats.active = speech || vad->hang > 0;
+
+    if (vad->stop && vad->started && vad->gap >= vad->stop) {
+        // finishing marks the output done, the encoder and writer then close cleanly
+        return AEL_IO_DONE;
+    }
+    bool pass = vad->stats.active || (vad->gap <= vad->keep && (vad->started || !vad->skip_leading));
+    if (!pass) {
+        return r_size;
+    }
+    vad->stats.frames_out++;
+    return audio_element_output(self, in_buffer, r_size);
+}
+
+static esp_err_t _vad_close(audio_element_handle_t self)
+{
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _vad_destroy(audio_element_handle_t self)
+{
+    audio_vad_t *vad = (audio_vad_t *)audio_element_getdata(self);
+    audio_free(vad);
+    return ESP_OK;
+}
+
+void audio_vad_get_stats(audio_element_handle_t self, audio_vad_stats_t *stats)
+{
+    audio_vad_t *vad = (audio_vad_t *)audio_element_getdata(self);
+    stats->frames_in = vad->stats.frames_in;
+    stats->frames_out = vad->stats.frames_out;
+    stats->speech = vad->stats.speech;
+    stats->active = vad->stats.active;
+}
+
+audio_element_handle_t audio_vad_init(audio_vad_cfg_t *config)
+{
+    if (config->channels < 1 || config->channels > 2 || config->sample_rate < 1000) {
+        ESP_LOGE(TAG, "Unsupported format %d/%d", config->sample_rate, config->channels);
+        return NULL;
+    }
+    audio_element_handle_t el;
+    audio_vad_t *vad = audio_calloc(1, sizeof(audio_vad_t));
+
+    AUDIO_MEM_CHECK(TAG, vad, return NULL);
+
+    vad->channels = config->channels;
+    vad->frame_samples = config->sample_rate * AUDIO_VAD_FRAME_MS / 1000;
+    vad->threshold = config->threshold > 1 ? config->threshold : 2;
+    vad->min_energy = (uint32_t)config->min_level * config->min_level;
+    vad->zcr_max = config->zcr_max;
+    vad->hangover = _vad_frames(config->hangover_ms);
+    vad->keep = _vad_frames(config->keep_ms);
+    vad->stop = _vad_frames(config->stop_ms);
+    vad->skip_leading = config->skip_leading;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _vad_open;
+    cfg.close = _vad_close;
+    cfg.process = _vad_process;
+    cfg.destroy = _vad_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = vad->frame_samples * vad->channels * sizeof(int16_t);
+    cfg.tag = "vad";
+
+    el = audio_element_init(&cfg);
+
+    AUDIO_MEM_CHECK(TAG, el, goto _vad_init_exit);
+    audio_element_setdata(el, vad);
+    return el;
+_vad_init_exit:
+    audio_free(vad);
+    return NULL;
+}
@@ -0,0 +1,109 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_VAD_H_
+#define _AUDIO_VAD_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_VAD_FRAME_MS (10)
+#define AUDIO_VAD_TASK_STACK (2560)
+#define AUDIO_VAD_TASK_CORE (1)
+#define AUDIO_VAD_TASK_PRIO (5)
+#define AUDIO_VAD_RINGBUFFER_SIZE (4 * 1024)
+
+/**
+ * @brief   Voice activity detector configuration, 16 bit PCM in and out
+ */
+typedef struct {
+    int sample_rate;      /*!< Input sample rate */
+    int channels;         /*!< Input channels, 1 or 2 */
+    int threshold;        /*!< Speech when the frame energy exceeds the noise floor by this factor */
+    int min_level;        /*!< RMS below which a frame is always silence */
+    int zcr_max;          /*!< Zero crossings per 10 ms above which a quiet frame counts as noise */
+    int hangover_ms;      /*!< Speech state held after the last speech frame */
+    int keep_ms;          /*!< Silence kept at the start of each gap, the rest is dropped */
+    int stop_ms;          /*!< Finish the stream after this much silence past the hangover, 0 never */
+    bool skip_leading;    /*!< Drop everything before the first speech frame */
+    int out_rb_size;      /*!< Size of output ringbuffer */
+    int task_stack;       /*!< Task stack size */
+    int task_core;        /*!< Task running in core (0 or 1) */
+    int task_prio;        /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;    /*!< Try to allocate stack in external memory */
+} audio_vad_cfg_t;
+
+#define AUDIO_VAD_CFG_DEFAULT()                     \
+{                                                   \
+    .sample_rate = 16000,                           \
+    .channels = 1,                                  \
+    .threshold = 8,                                 \
+    .min_level = 100,                               \
+    .zcr_max = 50,                                  \
+    .hangover_ms = 300,                             \
+    .keep_ms = 200,                                 \
+    .stop_ms = 0,                                   \
+    .skip_leading = true,                           \
+    .out_rb_size = AUDIO_VAD_RINGBUFFER_SIZE,       \
+    .task_stack = AUDIO_VAD_TASK_STACK,             \
+    .task_core = AUDIO_VAD_TASK_CORE,               \
+    .task_prio = AUDIO_VAD_TASK_PRIO,               \
+    .stack_in_ext = false,                          \
+}
+
+/**
+ * @brief   Frame counters of a running detector
+ */
+typedef struct {
+    uint32_t frames_in;  /*!< 10 ms frames read */
+    uint32_t frames_out; /*!< Frames passed on, speech plus the kept silence */
+    uint32_t speech;     /*!< Frames detected as speech */
+    bool active;         /*!< Speech state including the hangover */
+} audio_vad_stats_t;
+
+/**
+ * @brief      Create an Audio Element that passes speech and trims silence. Each 10 ms frame is
+ *             classified from its energy against an adaptive noise floor and its zero-crossing
+ *             rate, all in integer arithmetic. Speech holds for the hangover time, then only
+ *             the first keep_ms of the gap is passed on.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The Audio Element handle
+ */
+audio_element_handle_t audio_vad_init(audio_vad_cfg_t *config);
+
+/**
+ * @brief      Read the counters, safe to call while the element runs
+ */
+void audio_vad_get_stats(audio_element_handle_t self, audio_vad_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_HAL_H_
+#define _AUDIO_HAL_H_
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_HAL_VOL_DEFAULT (70)
+
+/**
+ * @brief   Select media hal codec mode
+ */
+typedef enum {
+    AUDIO_HAL_CODEC_MODE_ENCODE = 1, /*!< select adc */
+    AUDIO_HAL_CODEC_MODE_DECODE,     /*!< select dac */
+    AUDIO_HAL_CODEC_MODE_BOTH,       /*!< select both adc and dac */
+    AUDIO_HAL_CODEC_MODE_LINE_IN,    /*!< set adc channel */
+} audio_hal_codec_mode_t;
+
+/**
+ * @brief   Select media hal codec start or stop
+ */
+typedef enum {
+    AUDIO_HAL_CTRL_STOP = 0x00,  /*!< set stop mode */
+    AUDIO_HAL_CTRL_START = 0x01, /*!< set start mode */
+} audio_hal_ctrl_t;
+
+/**
+ * @brief   The codec of the host build has no hardware, it keeps the volume and the mute state
+ *          so the Python API reads back what was set
+ */
+typedef struct audio_hal *audio_hal_handle_t;
+
+esp_err_t audio_hal_ctrl_codec(audio_hal_handle_t audio_hal, audio_hal_codec_mode_t mode, audio_hal_ctrl_t audio_hal_ctrl);
+
+/**
+ * @brief      Set the volume, 0 to 100
+ */
+esp_err_t audio_hal_set_volume(audio_hal_handle_t audio_hal, int volume);
+
+esp_err_t audio_hal_get_volume(audio_hal_handle_t audio_hal, int *volume);
+
+esp_err_t audio_hal_set_mute(audio_hal_handle_t audio_hal, bool mute);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "board.h"
+#include "esp_log.h"
+
+static const char *TAG = "AUDIO_BOARD";
+
+struct audio_hal {
+    int volume;
+    bool mute;
+    int mode;
+    bool started;
+};
+
+static audio_board_handle_t board_handle;
+
+esp_err_t audio_hal_ctrl_codec(audio_hal_handle_t audio_hal, audio_hal_codec_mode_t mode, audio_hal_ctrl_t audio_hal_ctrl)
+{
+    if (audio_hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_hal->mode = mode;
+    audio_hal->started = audio_hal_ctrl == AUDIO_HAL_CTRL_START;
+    ESP_LOGD(TAG, "codec mode %d %s", mode, audio_hal->started ? "started" : "stopped");
+    return ESP_OK;
+}
+
+esp_err_t audio_hal_set_volume(audio_hal_handle_t audio_hal, int volume)
+{
+    if (audio_hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (volume < 0) {
+        volume = 0;
+    } else if (volume > 100) {
+        volume = 100;
+    }
+    audio_hal->volume = volume;
+    return ESP_OK;
+}
+
+esp_err_t audio_hal_get_volume(audio_hal_handle_t audio_hal, int *volume)
+{
+    if (audio_hal == NULL || volume == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *volume = audio_hal->volume;
+    return ESP_OK;
+}
+
+esp_err_t audio_hal_set_mute(audio_hal_handle_t audio_hal, bool mute)
+{
+    if (audio_hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_hal->mute = mute;
+    return ESP_OK;
+}
+
+audio_board_handle_t audio_board_init(void)
+{
+    if (board_handle) {
+        return board_handle;
+    }
+    board_handle = audio_calloc(1, sizeof(struct audio_board_handle));
+    AUDIO_MEM_CHECK(TAG, board_handle, return NULL);
+    board_handle->audio_hal = audio_calloc(1, sizeof(struct audio_hal));
+    AUDIO_MEM_CHECK(TAG, board_handle->audio_hal, {
+        audio_free(board_handle);
+        board_handle = NULL;
+        return NULL;
+    });
+    board_handle->audio_hal->volume = AUDIO_HAL_VOL_DEFAULT;
+    return board_handle;
+}
+
+audio_board_handle_t audio_board_get_handle(void)
+{
+    return board_handle;
+}
+
+esp_err_t audio_board_deinit(audio_board_handle_t audio_board)
+{
+    if (audio_board == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (audio_board == board_handle) {
+        board_handle = NULL;
+    }
+    audio_free(audio_board->audio_hal);
+    audio_free(audio_board);
+    return ESP_OK;
+}
@@ -0,0 +1,86 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "audio_element.h"
+#include "esp_log.h"
+
+#include "amr_decoder.h"
+#include "amrnb_encoder.h"
+#include "mp3_decoder.h"
+#include "opus_encoder.h"
+
+static const char *TAG = "CODEC_STUB";
+
+// the compressed codecs of esp-adf-libs are ESP32 binaries, on the host their elements
+// exist so that pipelines link, and fail at open the way a broken stream would
+
+static esp_err_t _codec_stub_open(audio_element_handle_t self)
+{
+    ESP_LOGE(TAG, "The %s codec is not supported on the host build", audio_element_get_tag(self));
+    return ESP_FAIL;
+}
+
+static int _codec_stub_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    return AEL_PROCESS_FAIL;
+}
+
+static audio_element_handle_t codec_stub_init(const char *tag, int out_rb_size, int task_stack, int task_core,
+                                              int task_prio, bool stack_in_ext)
+{
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _codec_stub_open;
+    cfg.process = _codec_stub_process;
+    cfg.task_stack = task_stack;
+    cfg.task_prio = task_prio;
+    cfg.task_core = task_core;
+    cfg.stack_in_ext = stack_in_ext;
+    cfg.out_rb_size = out_rb_size;
+    cfg.tag = tag;
+    return audio_element_init(&cfg);
+}
+
+audio_element_handle_t mp3_decoder_init(mp3_decoder_cfg_t *config)
+{
+    return codec_stub_init("mp3", config->out_rb_size, config->task_stack, config->task_core, config->task_prio,
+                           config->stack_in_ext);
+}
+
+audio_element_handle_t amr_decoder_init(amr_decoder_cfg_t *config)
+{
+    return codec_stub_init("amr", config->out_rb_size, config->task_stack, config->task_core, config->task_prio,
+                           config->stack_in_ext);
+}
+
+audio_element_handle_t amrnb_encoder_init(amrnb_encoder_cfg_t *config)
+{
+    return codec_stub_init("amrnb", config->out_rb_size, config->task_stack, config->task_core, config->task_prio,
+                           config->stack_in_ext);
+}
+
+audio_element_handle_t encoder_opus_init(opus_encoder_cfg_t *config)
+{
+    return codec_stub_init("opus", config->out_rb_size, config->task_stack, config->task_core, config->task_prio,
+                           config->stack_in_ext);
+}
@@ -0,0 +1,631 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "audio_pipeline.h"
+#include "esp_audio.h"
+#include "esp_log.h"
+#include "filter_resample.h"
+#include "i2s_stream.h"
+
+#define ESP_AUDIO_MAX_INPUTS (4)
+#define ESP_AUDIO_MAX_CODECS (8)
+#define ESP_AUDIO_TAG_LEN (16)
+#define ESP_AUDIO_CMD_QUIT (0x7f00)
+#define ESP_AUDIO_EVT_QUEUE_SIZE (16)
+
+static const char *TAG = "ESP_AUDIO";
+
+// The host stand-in of the esp_audio library: every added element is registered to one
+// pipeline, each play links reader -> decoder [-> resample] -> writer for the uri and a task
+// turns the element reports into the esp_audio status and callback
+struct esp_audio {
+    esp_audio_cfg_t cfg;
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t task_done;
+    SemaphoreHandle_t play_done;
+
+    audio_element_handle_t inputs[ESP_AUDIO_MAX_INPUTS];
+    int input_num;
+    audio_element_handle_t codecs[ESP_AUDIO_MAX_CODECS];
+    int codec_num;
+    audio_element_handle_t output;
+    audio_element_handle_t rsp;
+
+    // the linked chain
+    audio_element_handle_t reader;
+    audio_element_handle_t decoder;
+    bool linked;
+    bool ran;
+
+    esp_audio_state_t state;
+    // set by play until the writer reports running, the stop of the previous uri may still be queued
+    volatile bool starting;
+};
+
+static int esp_audio_error(int ael_status)
+{
+    switch (ael_status) {
+        case AEL_STATUS_ERROR_OPEN:
+            return ESP_ERR_AUDIO_OPEN;
+        case AEL_STATUS_ERROR_INPUT:
+            return ESP_ERR_AUDIO_INPUT;
+        case AEL_STATUS_ERROR_PROCESS:
+            return ESP_ERR_AUDIO_PROCESS;
+        case AEL_STATUS_ERROR_OUTPUT:
+            return ESP_ERR_AUDIO_OUTPUT;
+        case AEL_STATUS_ERROR_CLOSE:
+            return ESP_ERR_AUDIO_CLOSE;
+        case AEL_STATUS_ERROR_TIMEOUT:
+            return ESP_ERR_AUDIO_TIMEOUT;
+        default:
+            return ESP_ERR_AUDIO_UNKNOWN;
+    }
+}
+
+static void esp_audio_set_state(esp_audio_handle_t h, esp_audio_status_t status, int err_msg)
+{
+    h->state.status = status;
+    h->state.err_msg = err_msg;
+    if (status == AUDIO_STATUS_STOPPED || status == AUDIO_STATUS_FINISHED || status == AUDIO_STATUS_ERROR) {
+        xSemaphoreGive(h->play_done);
+    }
+    esp_audio_state_t state = h->state;
+    if (h->cfg.cb_func) {
+        h->cfg.cb_func(&state, h->cfg.cb_ctx);
+    }
+}
+
+// on the decoder task, the resampler or the clock has to change before the first samples get to it
+static esp_err_t esp_audio_decoder_event(audio_element_handle_t el, audio_event_iface_msg_t *msg, void *ctx)
+{
+    esp_audio_handle_t h = (esp_audio_handle_t)ctx;
+    if (el == h->decoder && msg->cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(el, &info);
+        ESP_LOGI(TAG, "music info, sample_rates=%d, bits=%d, ch=%d", info.sample_rates, info.bits, info.channels);
+        if (h->rsp) {
+            rsp_filter_set_src_info(h->rsp, info.sample_rates, info.channels);
+        } else {
+            i2s_stream_set_clk(h->output, info.sample_rates, info.bits, info.channels);
+        }
+        return ESP_OK;
+    }
+    return audio_event_iface_cmd(h->evt, msg);
+}
+
+static void esp_audio_task(void *arg)
+{
+    esp_audio_handle_t h = (esp_audio_handle_t)arg;
+
+    while (1) {
+        audio_event_iface_msg_t msg;
+        if (audio_event_iface_listen(h->evt, &msg, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        if (msg.source == (void *)h && msg.cmd == ESP_AUDIO_CMD_QUIT) {
+            break;
+        }
+        if (msg.source_type != AUDIO_ELEMENT_TYPE_ELEMENT) {
+            continue;
+        }
+
+        if (msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+            ESP_LOGW(TAG, "%s error %d", audio_element_get_tag(msg.source), status);
+            h->starting = false;
+            esp_audio_set_state(h, AUDIO_STATUS_ERROR, esp_audio_error(status));
+        } else if (msg.source == (void *)h->output) {
+            // the writer tells the state of the whole pipeline
+            if (status == AEL_STATUS_STATE_RUNNING) {
+                h->starting = false;
+                esp_audio_set_state(h, AUDIO_STATUS_RUNNING, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (status == AEL_STATUS_STATE_PAUSED) {
+                esp_audio_set_state(h, AUDIO_STATUS_PAUSED, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (h->starting || h->state.status == AUDIO_STATUS_ERROR) {
+                // keep the error until the next play
+                continue;
+            } else if (status == AEL_STATUS_STATE_STOPPED) {
+                esp_audio_set_state(h, AUDIO_STATUS_STOPPED, ESP_ERR_AUDIO_NO_ERROR);
+            } else if (status == AEL_STATUS_STATE_FINISHED) {
+                esp_audio_set_state(h, AUDIO_STATUS_FINISHED, ESP_ERR_AUDIO_NO_ERROR);
+            }
+        }
+    }
+
+    xSemaphoreGive(h->task_done);
+    vTaskDelete(NULL);
+}
+
+static audio_err_t esp_audio_register(esp_audio_handle_t h, audio_element_handle_t el)
+{
+    // the pipeline replaces the tag of the element, register it with a copy of its own
+    char tag[ESP_AUDIO_TAG_LEN];
+    const char *el_tag = audio_element_get_tag(el);
+    if (el_tag == NULL || strlen(el_tag) >= sizeof(tag)) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    strcpy(tag, el_tag);
+    return audio_pipeline_register(h->pipeline, el, tag) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_FAIL;
+}
+
+static bool esp_audio_has_tag(audio_element_handle_t *list, int num, const char *tag)
+{
+    if (tag == NULL) {
+        return false;
+    }
+    for (int i = 0; i < num; i++) {
+        if (strcmp(audio_element_get_tag(list[i]), tag) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static audio_element_handle_t esp_audio_find_input(esp_audio_handle_t h, const char *uri)
+{
+    const char *tag = strncasecmp(uri, "http", 4) == 0 ? "http" : "file";
+    for (int i = 0; i < h->input_num; i++) {
+        if (strcmp(audio_element_get_tag(h->inputs[i]), tag) == 0) {
+            return h->inputs[i];
+        }
+    }
+    return NULL;
+}
+
+// the decoder is the one tagged with the suffix of the uri, a fragment like "#.mp3" takes precedence
+static audio_element_handle_t esp_audio_find_codec(esp_audio_handle_t h, const char *uri)
+{
+    const char *hint = strchr(uri, '#');
+    const char *end = hint ? hint + strlen(hint) : uri + strcspn(uri, "?");
+    const char *start = hint ? hint : uri;
+    const char *dot = NULL;
+    for (const char *p = start; p < end; p++) {
+        if (*p == '.') {
+            dot = p + 1;
+        } else if (*p == '/') {
+            dot = NULL;
+        }
+    }
+    if (dot) {
+        for (int i = 0; i < h->codec_num; i++) {
+            const char *tag = audio_element_get_tag(h->codecs[i]);
+            if (strlen(tag) == (size_t)(end - dot) && strncasecmp(tag, dot, end - dot) == 0) {
+                return h->codecs[i];
+            }
+        }
+    }
+    // playlists and unknown suffixes
+    if (h->codec_num == 1) {
+        return h->codecs[0];
+    }
+    for (int i = 0; i < h->codec_num; i++) {
+        if (strcmp(audio_element_get_tag(h->codecs[i]), "mp3") == 0) {
+            return h->codecs[i];
+        }
+    }
+    return NULL;
+}
+
+static void esp_audio_halt(esp_audio_handle_t h)
+{
+    if (!h->ran) {
+        return;
+    }
+    audio_pipeline_stop(h->pipeline);
+    audio_pipeline_wait_for_stop(h->pipeline);
+}
+
+static audio_err_t esp_audio_link(esp_audio_handle_t h, audio_element_handle_t reader, audio_element_handle_t decoder)
+{
+    if (h->linked && h->reader == reader && h->decoder == decoder) {
+        return ESP_ERR_AUDIO_NO_ERROR;
+    }
+    const char *link_tag[4];
+    int link_num = 0;
+    link_tag[link_num++] = audio_element_get_tag(reader);
+    link_tag[link_num++] = audio_element_get_tag(decoder);
+    if (h->rsp) {
+        link_tag[link_num++] = audio_element_get_tag(h->rsp);
+    }
+    link_tag[link_num++] = audio_element_get_tag(h->output);
+
+    esp_err_t ret;
+    if (h->linked) {
+        audio_pipeline_breakup_elements(h->pipeline, NULL);
+        ret = audio_pipeline_relink(h->pipeline, link_tag, link_num);
+    } else {
+        ret = audio_pipeline_link(h->pipeline, link_tag, link_num);
+    }
+    if (ret != ESP_OK) {
+        h->linked = false;
+        ESP_LOGE(TAG, "failed to link %s -> %s", link_tag[0], link_tag[1]);
+        return ESP_ERR_AUDIO_LINK_FAIL;
+    }
+    audio_pipeline_set_listener(h->pipeline, h->evt);
+    h->reader = reader;
+    h->decoder = decoder;
+    h->linked = true;
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+static audio_err_t esp_audio_start(esp_audio_handle_t h, const char *uri, int pos)
+{
+    if (h->output == NULL) {
+        return ESP_ERR_AUDIO_NO_OUTPUT_STREAM;
+    }
+    audio_element_handle_t reader = esp_audio_find_input(h, uri);
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "no input stream for %s", uri);
+        return ESP_ERR_AUDIO_NO_INPUT_STREAM;
+    }
+    if (h->codec_num == 0) {
+        return ESP_ERR_AUDIO_NO_CODEC;
+    }
+    audio_element_handle_t decoder = esp_audio_find_codec(h, uri);
+    if (decoder == NULL) {
+        ESP_LOGE(TAG, "no decoder for %s", uri);
+        return ESP_ERR_AUDIO_NOT_SUPPORT;
+    }
+
+    esp_audio_halt(h);
+    audio_err_t ret = esp_audio_link(h, reader, decoder);
+    if (ret != ESP_ERR_AUDIO_NO_ERROR) {
+        return ret;
+    }
+    if (h->ran) {
+        audio_pipeline_reset_ringbuffer(h->pipeline);
+        audio_pipeline_reset_elements(h->pipeline);
+        audio_pipeline_change_state(h->pipeline, AEL_STATE_INIT);
+    }
+    audio_element_set_uri(reader, uri);
+    audio_element_info_t info;
+    audio_element_getinfo(reader, &info);
+    info.byte_pos = pos;
+    audio_element_setinfo(reader, &info);
+
+    h->starting = true;
+    xSemaphoreTake(h->play_done, 0);
+    h->state.status = AUDIO_STATUS_RUNNING;
+    h->state.err_msg = ESP_ERR_AUDIO_NO_ERROR;
+    h->state.media_src = strncasecmp(uri, "http", 4) == 0 ? MEDIA_SRC_TYPE_MUSIC_HTTP : MEDIA_SRC_TYPE_MUSIC_SD;
+    h->ran = true;
+    if (audio_pipeline_run(h->pipeline) != ESP_OK) {
+        h->starting = false;
+        h->state.status = AUDIO_STATUS_ERROR;
+        h->state.err_msg = ESP_ERR_AUDIO_FAIL;
+        return ESP_ERR_AUDIO_FAIL;
+    }
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+static bool esp_audio_active(esp_audio_handle_t h)
+{
+    return h->state.status == AUDIO_STATUS_RUNNING || h->state.status == AUDIO_STATUS_PAUSED;
+}
+
+static void esp_audio_free(esp_audio_handle_t h)
+{
+    if (h->lock) {
+        vSemaphoreDelete(h->lock);
+    }
+    if (h->task_done) {
+        vSemaphoreDelete(h->task_done);
+    }
+    if (h->play_done) {
+        vSemaphoreDelete(h->play_done);
+    }
+    if (h->pipeline) {
+        audio_pipeline_deinit(h->pipeline);
+    }
+    if (h->evt) {
+        audio_event_iface_destroy(h->evt);
+    }
+    audio_free(h);
+}
+
+esp_audio_handle_t esp_audio_create(const esp_audio_cfg_t *cfg)
+{
+    esp_audio_handle_t h = audio_calloc(1, sizeof(struct esp_audio));
+    AUDIO_MEM_CHECK(TAG, h, return NULL);
+    h->cfg = *cfg;
+    h->state.status = AUDIO_STATUS_UNKNOWN;
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    if (cfg->out_stream_buf_size > 0) {
+        pipeline_cfg.rb_size = cfg->out_stream_buf_size;
+    }
+    h->pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    evt_cfg.external_queue_size = ESP_AUDIO_EVT_QUEUE_SIZE;
+    evt_cfg.queue_set_size = ESP_AUDIO_EVT_QUEUE_SIZE;
+    h->evt = audio_event_iface_init(&evt_cfg);
+    h->lock = xSemaphoreCreateMutex();
+    h->task_done = xSemaphoreCreateBinary();
+    h->play_done = xSemaphoreCreateBinary();
+    AUDIO_MEM_CHECK(TAG, h->pipeline && h->evt && h->lock && h->task_done && h->play_done, {
+        esp_audio_free(h);
+        return NULL;
+    });
+
+    if (cfg->resample_rate > 0) {
+        rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+        rsp_cfg.dest_rate = cfg->resample_rate;
+        rsp_cfg.dest_ch = 2;
+        h->rsp = rsp_filter_init(&rsp_cfg);
+        AUDIO_MEM_CHECK(TAG, h->rsp, {
+            esp_audio_free(h);
+            return NULL;
+        });
+        esp_audio_register(h, h->rsp);
+    }
+
+    int stack = cfg->task_stack > 0 ? cfg->task_stack : 3 * 1024;
+    if (xTaskCreatePinnedToCore(esp_audio_task, "esp_audio", stack, h, cfg->task_prio, NULL, 1) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create the esp_audio task");
+        esp_audio_free(h);
+        return NULL;
+    }
+    return h;
+}
+
+audio_err_t esp_audio_destroy(esp_audio_handle_t h)
+{
+    if (h == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    esp_audio_halt(h);
+    audio_pipeline_terminate(h->pipeline);
+
+    audio_event_iface_msg_t msg = {
+        .source = h,
+        .cmd = ESP_AUDIO_CMD_QUIT,
+    };
+    audio_event_iface_cmd(h->evt, &msg);
+    xSemaphoreTake(h->task_done, portMAX_DELAY);
+    xSemaphoreGive(h->lock);
+
+    // terminate the pipeline before removing the listener
+    if (h->linked) {
+        audio_pipeline_remove_listener(h->pipeline);
+    }
+    // the registered elements are released with the pipeline
+    esp_audio_free(h);
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_input_stream_add(esp_audio_handle_t h, audio_element_handle_t in_stream)
+{
+    if (h == NULL || in_stream == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->input_num >= ESP_AUDIO_MAX_INPUTS) {
+        return ESP_ERR_AUDIO_MEMORY_LACK;
+    }
+    if (esp_audio_has_tag(h->inputs, h->input_num, audio_element_get_tag(in_stream))) {
+        return ESP_ERR_AUDIO_ALREADY_EXISTS;
+    }
+    audio_err_t ret = esp_audio_register(h, in_stream);
+    if (ret == ESP_ERR_AUDIO_NO_ERROR) {
+        h->inputs[h->input_num++] = in_stream;
+    }
+    return ret;
+}
+
+audio_err_t esp_audio_output_stream_add(esp_audio_handle_t h, audio_element_handle_t out_stream)
+{
+    if (h == NULL || out_stream == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->output) {
+        ESP_LOGW(TAG, "the host build plays to one output stream");
+        return ESP_ERR_AUDIO_ALREADY_EXISTS;
+    }
+    audio_err_t ret = esp_audio_register(h, out_stream);
+    if (ret == ESP_ERR_AUDIO_NO_ERROR) {
+        h->output = out_stream;
+    }
+    return ret;
+}
+
+audio_err_t esp_audio_codec_lib_add(esp_audio_handle_t h, audio_codec_type_t type, audio_element_handle_t lib)
+{
+    if (h == NULL || lib == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (type != AUDIO_CODEC_TYPE_DECODER) {
+        return ESP_ERR_AUDIO_NOT_SUPPORT;
+    }
+    if (h->codec_num >= ESP_AUDIO_MAX_CODECS) {
+        return ESP_ERR_AUDIO_MEMORY_LACK;
+    }
+    if (esp_audio_has_tag(h->codecs, h->codec_num, audio_element_get_tag(lib))) {
+        return ESP_ERR_AUDIO_ALREADY_EXISTS;
+    }
+    audio_err_t ret = esp_audio_register(h, lib);
+    if (ret == ESP_ERR_AUDIO_NO_ERROR) {
+        audio_element_set_event_callback(lib, esp_audio_decoder_event, h);
+        h->codecs[h->codec_num++] = lib;
+    }
+    return ret;
+}
+
+audio_err_t esp_audio_callback_set(esp_audio_handle_t h, esp_audio_event_callback cb, void *cb_ctx)
+{
+    if (h == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    h->cfg.cb_func = cb;
+    h->cfg.cb_ctx = cb_ctx;
+    xSemaphoreGive(h->lock);
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_play(esp_audio_handle_t h, audio_codec_type_t type, const char *uri, int pos)
+{
+    if (h == NULL || uri == NULL || type != AUDIO_CODEC_TYPE_DECODER || pos < 0) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    audio_err_t ret = esp_audio_start(h, uri, pos);
+    xSemaphoreGive(h->lock);
+    return ret;
+}
+
+audio_err_t esp_audio_sync_play(esp_audio_handle_t h, const char *uri, int pos)
+{
+    audio_err_t ret = esp_audio_play(h, AUDIO_CODEC_TYPE_DECODER, uri, pos);
+    if (ret != ESP_ERR_AUDIO_NO_ERROR) {
+        return ret;
+    }
+    // a stop of the previous uri may still wake it up
+    do {
+        xSemaphoreTake(h->play_done, portMAX_DELAY);
+    } while (h->starting || esp_audio_active(h));
+    return h->state.status == AUDIO_STATUS_ERROR ? h->state.err_msg : ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_stop(esp_audio_handle_t h, audio_termination_type_t type)
+{
+    if (h == NULL || type >= TERMINATION_TYPE_MAX) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    // TERMINATION_TYPE_DONE leaves the music to play to its end
+    if (type == TERMINATION_TYPE_NOW) {
+        xSemaphoreTake(h->lock, portMAX_DELAY);
+        if (esp_audio_active(h)) {
+            esp_audio_halt(h);
+        }
+        xSemaphoreGive(h->lock);
+    }
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_pause(esp_audio_handle_t h)
+{
+    if (h == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    audio_err_t ret = ESP_ERR_AUDIO_NOT_READY;
+    if (h->state.status == AUDIO_STATUS_RUNNING) {
+        ret = audio_pipeline_pause(h->pipeline) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_FAIL;
+    }
+    xSemaphoreGive(h->lock);
+    return ret;
+}
+
+audio_err_t esp_audio_resume(esp_audio_handle_t h)
+{
+    if (h == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    audio_err_t ret = ESP_ERR_AUDIO_NOT_READY;
+    if (h->state.status == AUDIO_STATUS_PAUSED) {
+        ret = audio_pipeline_resume(h->pipeline) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_FAIL;
+    }
+    xSemaphoreGive(h->lock);
+    return ret;
+}
+
+audio_err_t esp_audio_vol_set(esp_audio_handle_t h, int vol)
+{
+    if (h == NULL || vol < 0 || vol > 100) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->cfg.vol_set == NULL) {
+        return ESP_ERR_AUDIO_NOT_SUPPORT;
+    }
+    return h->cfg.vol_set(h->cfg.vol_handle, vol) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_HAL_FAIL;
+}
+
+audio_err_t esp_audio_vol_get(esp_audio_handle_t h, int *vol)
+{
+    if (h == NULL || vol == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->cfg.vol_get == NULL) {
+        return ESP_ERR_AUDIO_NOT_SUPPORT;
+    }
+    return h->cfg.vol_get(h->cfg.vol_handle, vol) == ESP_OK ? ESP_ERR_AUDIO_NO_ERROR : ESP_ERR_AUDIO_HAL_FAIL;
+}
+
+audio_err_t esp_audio_state_get(esp_audio_handle_t h, esp_audio_state_t *state)
+{
+    if (h == NULL || state == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    *state = h->state;
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_pos_get(esp_audio_handle_t h, int *pos)
+{
+    if (h == NULL || pos == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->reader == NULL) {
+        return ESP_ERR_AUDIO_NOT_READY;
+    }
+    audio_element_info_t info = { 0 };
+    audio_element_getinfo(h->reader, &info);
+    *pos = (int)info.byte_pos;
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
+
+audio_err_t esp_audio_time_get(esp_audio_handle_t h, int *time)
+{
+    if (h == NULL || time == NULL) {
+        return ESP_ERR_AUDIO_INVALID_PARAMETER;
+    }
+    if (h->output == NULL) {
+        return ESP_ERR_AUDIO_NOT_READY;
+    }
+    audio_element_info_t info = { 0 };
+    audio_element_getinfo(h->output, &info);
+    int byte_rate = info.sample_rates * info.channels * info.bits / 8;
+    if (byte_rate <= 0) {
+        return ESP_ERR_AUDIO_NOT_READY;
+    }
+    *time = (int)(info.byte_pos * 1000 / byte_rate);
+    return ESP_ERR_AUDIO_NO_ERROR;
+}
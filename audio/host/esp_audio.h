@@ -0,0 +1,229 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _ESP_AUDIO_H_
+#define _ESP_AUDIO_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "audio_common.h"
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   The error codes of esp_audio, the values of the ADF audio_error.h
+ */
+#define ESP_ERR_AUDIO_BASE (0x80000)
+
+typedef enum {
+    ESP_ERR_AUDIO_NO_ERROR = ESP_OK,
+    ESP_ERR_AUDIO_FAIL = ESP_FAIL,
+
+    ESP_ERR_AUDIO_NO_INPUT_STREAM = ESP_ERR_AUDIO_BASE + 1,
+    ESP_ERR_AUDIO_NO_OUTPUT_STREAM = ESP_ERR_AUDIO_BASE + 2,
+    ESP_ERR_AUDIO_NO_CODEC = ESP_ERR_AUDIO_BASE + 3,
+    ESP_ERR_AUDIO_HAL_FAIL = ESP_ERR_AUDIO_BASE + 4,
+    ESP_ERR_AUDIO_MEMORY_LACK = ESP_ERR_AUDIO_BASE + 5,
+    ESP_ERR_AUDIO_INVALID_URI = ESP_ERR_AUDIO_BASE + 6,
+    ESP_ERR_AUDIO_INVALID_PATH = ESP_ERR_AUDIO_BASE + 7,
+    ESP_ERR_AUDIO_INVALID_PARAMETER = ESP_ERR_AUDIO_BASE + 8,
+    ESP_ERR_AUDIO_NOT_READY = ESP_ERR_AUDIO_BASE + 9,
+    ESP_ERR_AUDIO_NOT_SUPPORT = ESP_ERR_AUDIO_BASE + 10,
+    ESP_ERR_AUDIO_TIMEOUT = ESP_ERR_AUDIO_BASE + 11,
+    ESP_ERR_AUDIO_ALREADY_EXISTS = ESP_ERR_AUDIO_BASE + 12,
+    ESP_ERR_AUDIO_LINK_FAIL = ESP_ERR_AUDIO_BASE + 13,
+    ESP_ERR_AUDIO_UNKNOWN = ESP_ERR_AUDIO_BASE + 14,
+
+    ESP_ERR_AUDIO_OUTPUT = ESP_ERR_AUDIO_BASE + 15,
+    ESP_ERR_AUDIO_INPUT = ESP_ERR_AUDIO_BASE + 16,
+    ESP_ERR_AUDIO_CODEC = ESP_ERR_AUDIO_BASE + 17,
+    ESP_ERR_AUDIO_OPEN = ESP_ERR_AUDIO_BASE + 18,
+    ESP_ERR_AUDIO_PROCESS = ESP_ERR_AUDIO_BASE + 19,
+    ESP_ERR_AUDIO_CLOSE = ESP_ERR_AUDIO_BASE + 20,
+} audio_err_t;
+
+/**
+ * @brief   esp_audio status
+ */
+typedef enum {
+    AUDIO_STATUS_UNKNOWN = 0,
+    AUDIO_STATUS_RUNNING = 1,
+    AUDIO_STATUS_PAUSED = 2,
+    AUDIO_STATUS_STOPPED = 3,
+    AUDIO_STATUS_FINISHED = 4,
+    AUDIO_STATUS_ERROR = 5,
+} esp_audio_status_t;
+
+/**
+ * @brief   How esp_audio_stop terminates the playback
+ */
+typedef enum {
+    TERMINATION_TYPE_NOW = 0,  /*!< Stop immediately, the status is AUDIO_STATUS_STOPPED */
+    TERMINATION_TYPE_DONE = 1, /*!< Let the music play to its end, the status is AUDIO_STATUS_FINISHED */
+    TERMINATION_TYPE_MAX,
+} audio_termination_type_t;
+
+typedef enum {
+    MEDIA_SRC_TYPE_NULL,
+    MEDIA_SRC_TYPE_MUSIC_BASE = 0x100,
+    MEDIA_SRC_TYPE_MUSIC_SD = MEDIA_SRC_TYPE_MUSIC_BASE + 2,
+    MEDIA_SRC_TYPE_MUSIC_HTTP = MEDIA_SRC_TYPE_MUSIC_BASE + 3,
+    MEDIA_SRC_TYPE_MUSIC_MAX = 0x1FF,
+} media_source_type_t;
+
+typedef enum {
+    ESP_AUDIO_PREFER_MEM = 0,
+    ESP_AUDIO_PREFER_SPEED = 1,
+} esp_audio_prefer_t;
+
+/**
+ * @brief   esp_audio state, passed to the callback
+ */
+typedef struct {
+    esp_audio_status_t status;     /*!< Status of esp_audio */
+    audio_err_t err_msg;           /*!< Status is `AUDIO_STATUS_ERROR`, err_msg will be setup */
+    media_source_type_t media_src; /*!< Media source type */
+} esp_audio_state_t;
+
+typedef struct esp_audio *esp_audio_handle_t;
+
+typedef void (*esp_audio_event_callback)(esp_audio_state_t *audio, void *ctx);
+typedef esp_err_t (*audio_volume_set)(void *vol_handle, int vol);
+typedef esp_err_t (*audio_volume_get)(void *vol_handle, int *vol);
+
+/**
+ * @brief   esp_audio configuration. The host build runs one reader -> decoder [-> resample] -> writer
+ *          pipeline, the buffer sizes and prefer_type are kept for source compatibility.
+ */
+typedef struct {
+    int in_stream_buf_size;            /*!< Input buffer size */
+    int out_stream_buf_size;           /*!< Output buffer size */
+    audio_volume_set vol_set;          /*!< Set volume callback */
+    audio_volume_get vol_get;          /*!< Get volume callback */
+    void *vol_handle;                  /*!< Handle of the volume callbacks */
+    QueueHandle_t evt_que;             /*!< Not used on the host build */
+    esp_audio_event_callback cb_func;  /*!< esp_audio event callback */
+    void *cb_ctx;                      /*!< Callback context */
+    esp_audio_prefer_t prefer_type;    /*!< Not used on the host build */
+    int resample_rate;                 /*!< Resample the decoded data to this rate, 0 sets the writer clock instead */
+    int task_prio;                     /*!< esp_audio task priority */
+    int task_stack;                    /*!< esp_audio task stack size */
+} esp_audio_cfg_t;
+
+#define DEFAULT_ESP_AUDIO_CONFIG() {   \
+    .in_stream_buf_size = 10 * 1024,   \
+    .out_stream_buf_size = 4 * 1024,   \
+    .vol_set = NULL,                   \
+    .vol_get = NULL,                   \
+    .vol_handle = NULL,                \
+    .evt_que = NULL,                   \
+    .cb_func = NULL,                   \
+    .cb_ctx = NULL,                    \
+    .prefer_type = ESP_AUDIO_PREFER_MEM, \
+    .resample_rate = 0,                \
+    .task_prio = 6,                    \
+    .task_stack = 3 * 1024,            \
+}
+
+/**
+ * @brief      Create esp_audio instance, the elements are added afterwards
+ *
+ * @param      cfg   The configuration
+ *
+ * @return     The esp_audio handle, NULL on failure
+ */
+esp_audio_handle_t esp_audio_create(const esp_audio_cfg_t *cfg);
+
+/**
+ * @brief      Stop the playback and free the instance with all the elements added to it
+ */
+audio_err_t esp_audio_destroy(esp_audio_handle_t handle);
+
+/**
+ * @brief      Add a reader, chosen by its tag: "http" for http URIs, "file" for the others
+ */
+audio_err_t esp_audio_input_stream_add(esp_audio_handle_t handle, audio_element_handle_t in_stream);
+
+/**
+ * @brief      Add the writer, the host build plays to the first one
+ */
+audio_err_t esp_audio_output_stream_add(esp_audio_handle_t handle, audio_element_handle_t out_stream);
+
+/**
+ * @brief      Add a decoder, chosen by the URI suffix matching its tag
+ */
+audio_err_t esp_audio_codec_lib_add(esp_audio_handle_t handle, audio_codec_type_t type, audio_element_handle_t lib);
+
+/**
+ * @brief      Set the callback called from the esp_audio task on every status change
+ */
+audio_err_t esp_audio_callback_set(esp_audio_handle_t handle, esp_audio_event_callback cb, void *cb_ctx);
+
+/**
+ * @brief      Play the URI from byte position `pos`, returns once the pipeline runs.
+ *             A fragment such as "uri#.mp3" selects the decoder.
+ */
+audio_err_t esp_audio_play(esp_audio_handle_t handle, audio_codec_type_t type, const char *uri, int pos);
+
+/**
+ * @brief      Play the URI and block until it finishes, stops or fails
+ *
+ * @return     ESP_ERR_AUDIO_NO_ERROR when the music finished, the error of the playback otherwise
+ */
+audio_err_t esp_audio_sync_play(esp_audio_handle_t handle, const char *uri, int pos);
+
+/**
+ * @brief      Stop the playback, see audio_termination_type_t
+ */
+audio_err_t esp_audio_stop(esp_audio_handle_t handle, audio_termination_type_t type);
+
+audio_err_t esp_audio_pause(esp_audio_handle_t handle);
+
+audio_err_t esp_audio_resume(esp_audio_handle_t handle);
+
+audio_err_t esp_audio_vol_set(esp_audio_handle_t handle, int vol);
+
+audio_err_t esp_audio_vol_get(esp_audio_handle_t handle, int *vol);
+
+audio_err_t esp_audio_state_get(esp_audio_handle_t handle, esp_audio_state_t *state);
+
+/**
+ * @brief      Get the byte position of the reader
+ */
+audio_err_t esp_audio_pos_get(esp_audio_handle_t handle, int *pos);
+
+/**
+ * @brief      Get the played time in ms, counted from the bytes the writer took
+ */
+audio_err_t esp_audio_time_get(esp_audio_handle_t handle, int *time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
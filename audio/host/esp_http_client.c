@@ -0,0 +1,919 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "HTTP_CLIENT";
+
+#define HOST_HTTP_RX_SIZE (4096)
+#define HOST_HTTP_LOOPBACK "loopback"
+#define HOST_HTTP_HEAD_MAX (8192)
+
+typedef struct host_http_header {
+    char *key;
+    char *value;
+    struct host_http_header *next;
+} host_http_header_t;
+
+typedef enum {
+    HOST_HTTP_CHUNK_SIZE,
+    HOST_HTTP_CHUNK_EXT,
+    HOST_HTTP_CHUNK_SIZE_LF,
+    HOST_HTTP_CHUNK_DATA,
+    HOST_HTTP_CHUNK_DATA_CR,
+    HOST_HTTP_CHUNK_DATA_LF,
+    HOST_HTTP_CHUNK_DONE,
+} host_http_chunk_state_t;
+
+// the framing of a chunked body, decoded a byte at a time on the loopback upload and
+// a line at a time on a socket response
+typedef struct {
+    host_http_chunk_state_t state;
+    int64_t remain;
+} host_http_chunk_t;
+
+struct esp_http_client {
+    http_event_handle_cb event_handler;
+    void *user_data;
+    int timeout_ms;
+    char *url;
+    char *host;
+    int port;
+    char *path;
+    esp_http_client_method_t method;
+    host_http_header_t *headers;
+    host_http_header_t *response_headers;
+    char *post_data;
+    int post_len;
+
+    int fd;
+    bool loopback;
+    FILE *file;
+    int64_t file_remain;
+    int64_t rate_start;
+    int64_t rate_bytes;
+    host_http_chunk_t upload_chunk;
+    bool upload_chunked;
+    bool upload_ok;
+
+    char *rx;
+    int rx_len;
+    int rx_pos;
+    int status;
+    int64_t content_length;
+    int64_t body_read;
+    bool chunked;
+    host_http_chunk_t chunk;
+    bool body_done;
+    bool head_done;
+    char *location;
+    int err;
+};
+
+static const char *http_method_names[HTTP_METHOD_MAX] = {
+    "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD",
+};
+
+static char *http_strdup(const char *s, int len)
+{
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, s, len);
+        copy[len] = 0;
+    }
+    return copy;
+}
+
+static void http_event(esp_http_client_handle_t client, esp_http_client_event_id_t id, void *data, int len)
+{
+    if (client->event_handler == NULL) {
+        return;
+    }
+    esp_http_client_event_t evt = {
+        .event_id = id,
+        .client = client,
+        .data = data,
+        .data_len = len,
+        .user_data = client->user_data,
+    };
+    client->event_handler(&evt);
+}
+
+static void http_headers_free(host_http_header_t **list)
+{
+    while (*list) {
+        host_http_header_t *h = *list;
+        *list = h->next;
+        free(h->key);
+        free(h->value);
+        free(h);
+    }
+}
+
+static host_http_header_t *http_header_find(host_http_header_t *list, const char *key)
+{
+    for (; list; list = list->next) {
+        if (strcasecmp(list->key, key) == 0) {
+            return list;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t http_header_set(host_http_header_t **list, const char *key, int key_len, const char *value)
+{
+    char *k = http_strdup(key, key_len);
+    host_http_header_t *h = k ? http_header_find(*list, k) : NULL;
+    char *v = strdup(value);
+    if (k == NULL || v == NULL) {
+        free(k);
+        free(v);
+        return ESP_ERR_NO_MEM;
+    }
+    if (h) {
+        free(k);
+        free(h->value);
+        h->value = v;
+        return ESP_OK;
+    }
+    h = calloc(1, sizeof(host_http_header_t));
+    if (h == NULL) {
+        free(k);
+        free(v);
+        return ESP_ERR_NO_MEM;
+    }
+    h->key = k;
+    h->value = v;
+    // appended, the request goes out in the order the headers were set
+    host_http_header_t **tail = list;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = h;
+    return ESP_OK;
+}
+
+// http://host[:port]/path?query, a relative Location keeps host and port
+static esp_err_t http_parse_url(esp_http_client_handle_t client, const char *url)
+{
+    if (strncasecmp(url, "https://", 8) == 0) {
+        ESP_LOGE(TAG, "https is not supported on the host build: %s", url);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (url[0] == '/' && client->host) {
+        char *path = strdup(url);
+        if (path == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        free(client->path);
+        client->path = path;
+        return ESP_OK;
+    }
+    if (strncasecmp(url, "http://", 7) != 0) {
+        ESP_LOGE(TAG, "Invalid url %s", url);
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *host = url + 7;
+    const char *end = host + strcspn(host, ":/?#");
+    const char *path = end;
+    int port = 80;
+    if (*end == ':') {
+        port = strtol(end + 1, (char **)&path, 10);
+    }
+    if (end == host || port <= 0 || port > 65535) {
+        ESP_LOGE(TAG, "Invalid url %s", url);
+        return ESP_ERR_INVALID_ARG;
+    }
+    char *h = http_strdup(host, end - host);
+    char *p = *path == '/' ? http_strdup(path, strcspn(path, "#")) : strdup("/");
+    char *u = strdup(url);
+    if (h == NULL || p == NULL || u == NULL) {
+        free(h);
+        free(p);
+        free(u);
+        return ESP_ERR_NO_MEM;
+    }
+    free(client->host);
+    free(client->path);
+    free(client->url);
+    client->host = h;
+    client->path = p;
+    client->url = u;
+    client->port = port;
+    return ESP_OK;
+}
+
+// AUDIO_HOST_HTTP_RATE bytes per second on the loopback, the rate of a slow network
+static void http_loopback_pace(esp_http_client_handle_t client, int len)
+{
+    static int rate = -1;
+    if (rate < 0) {
+        const char *env = getenv("AUDIO_HOST_HTTP_RATE");
+        rate = env ? atoi(env) : 0;
+    }
+    if (rate <= 0) {
+        return;
+    }
+    client->rate_bytes += len;
+    int64_t due = client->rate_start + client->rate_bytes * 1000000LL / rate;
+    int64_t wait = due - esp_timer_get_time();
+    if (wait > 0) {
+        struct timespec ts = { .tv_sec = wait / 1000000, .tv_nsec = (wait % 1000000) * 1000 };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+}
+
+static char *http_loopback_path(esp_http_client_handle_t client)
+{
+    const char *root = getenv("AUDIO_HOST_HTTP_ROOT");
+    if (root == NULL) {
+        root = ".";
+    }
+    int len = strcspn(client->path, "?");
+    if (strstr(client->path, "..")) {
+        return NULL;
+    }
+    char *file = malloc(strlen(root) + len + 1);
+    if (file) {
+        sprintf(file, "%s%.*s", root, len, client->path);
+    }
+    return file;
+}
+
+static const char *http_loopback_type(const char *path)
+{
+    static const char *types[][2] = {
+        { ".mp3", "audio/mpeg" }, { ".wav", "audio/wav" }, { ".amr", "audio/amr" },
+        { ".aac", "audio/aac" }, { ".m4a", "audio/mp4" }, { ".ogg", "audio/ogg" },
+        { ".opus", "audio/ogg" }, { ".flac", "audio/flac" }, { ".m3u", "audio/x-mpegurl" },
+        { ".m3u8", "application/vnd.apple.mpegurl" }, { ".pls", "audio/x-scpls" },
+    };
+    const char *dot = strrchr(path, '.');
+    for (size_t i = 0; dot && i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcasecmp(dot, types[i][0]) == 0) {
+            return types[i][1];
+        }
+    }
+    return "application/octet-stream";
+}
+
+// the response head is put in rx as if the server had sent it, the body is read
+// from the file as the socket would be
+static void http_loopback_respond(esp_http_client_handle_t client)
+{
+    char *path = http_loopback_path(client);
+    int len = 0;
+    client->rx_pos = 0;
+    if (client->method == HTTP_METHOD_POST || client->method == HTTP_METHOD_PUT) {
+        len = snprintf(client->rx, HOST_HTTP_RX_SIZE, "HTTP/1.1 %s\r\nContent-Length: 0\r\n\r\n",
+                       client->upload_ok ? "200 OK" : "500 Internal Server Error");
+    } else {
+        struct stat st;
+        FILE *file = path && stat(path, &st) == 0 && S_ISREG(st.st_mode) ? fopen(path, "rb") : NULL;
+        if (file == NULL) {
+            len = snprintf(client->rx, HOST_HTTP_RX_SIZE, "HTTP/1.1 %s\r\nContent-Length: 0\r\n\r\n",
+                           path ? "404 Not Found" : "403 Forbidden");
+        } else {
+            long long size = st.st_size, first = 0, last = size - 1;
+            host_http_header_t *range = http_header_find(client->headers, "Range");
+            bool partial = range && sscanf(range->value, "bytes=%lld-%lld", &first, &last) >= 1;
+            if (last >= size) {
+                last = size - 1;
+            }
+            if (partial && first >= size) {
+                fclose(file);
+                file = NULL;
+                len = snprintf(client->rx, HOST_HTTP_RX_SIZE,
+                               "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%lld\r\n"
+                               "Content-Length: 0\r\n\r\n", size);
+            } else {
+                fseek(file, first, SEEK_SET);
+                client->file_remain = client->method == HTTP_METHOD_HEAD ? 0 : last - first + 1;
+                len = snprintf(client->rx, HOST_HTTP_RX_SIZE, "HTTP/1.1 %s\r\nContent-Type: %s\r\n"
+                               "Accept-Ranges: bytes\r\nContent-Length: %lld\r\n",
+                               partial ? "206 Partial Content" : "200 OK", http_loopback_type(path), last - first + 1);
+                if (partial) {
+                    len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len,
+                                    "Content-Range: bytes %lld-%lld/%lld\r\n", first, last, size);
+                }
+                len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "\r\n");
+            }
+            client->file = file;
+        }
+    }
+    client->rx_len = len;
+    free(path);
+}
+
+static esp_err_t http_loopback_open(esp_http_client_handle_t client, int write_len)
+{
+    client->loopback = true;
+    client->rate_start = esp_timer_get_time();
+    client->rate_bytes = 0;
+    client->file_remain = 0;
+    if (client->method == HTTP_METHOD_POST || client->method == HTTP_METHOD_PUT) {
+        char *path = http_loopback_path(client);
+        client->file = path ? fopen(path, "wb") : NULL;
+        if (client->file == NULL) {
+            ESP_LOGW(TAG, "Loopback upload to %s failed", path ? path : client->path);
+        }
+        free(path);
+        client->upload_ok = client->file != NULL;
+        client->upload_chunked = write_len < 0;
+        memset(&client->upload_chunk, 0, sizeof(client->upload_chunk));
+    } else {
+        http_loopback_respond(client);
+    }
+    return ESP_OK;
+}
+
+// the body of a chunked upload is stored without its framing
+static int http_loopback_store(esp_http_client_handle_t client, const char *data, int len)
+{
+    if (!client->upload_chunked) {
+        return fwrite(data, 1, len, client->file);
+    }
+    host_http_chunk_t *ch = &client->upload_chunk;
+    for (int i = 0; i < len;) {
+        char c = data[i];
+        switch (ch->state) {
+            case HOST_HTTP_CHUNK_SIZE:
+                if (isxdigit((unsigned char)c)) {
+                    ch->remain = ch->remain * 16 + (isdigit((unsigned char)c) ? c - '0' : (tolower(c) - 'a' + 10));
+                } else {
+                    ch->state = c == '\r' ? HOST_HTTP_CHUNK_SIZE_LF : HOST_HTTP_CHUNK_EXT;
+                }
+                i++;
+                break;
+            case HOST_HTTP_CHUNK_EXT:
+                if (c == '\r') {
+                    ch->state = HOST_HTTP_CHUNK_SIZE_LF;
+                }
+                i++;
+                break;
+            case HOST_HTTP_CHUNK_SIZE_LF:
+                ch->state = ch->remain ? HOST_HTTP_CHUNK_DATA : HOST_HTTP_CHUNK_DONE;
+                i++;
+                break;
+            case HOST_HTTP_CHUNK_DATA: {
+                int n = len - i < ch->remain ? len - i : ch->remain;
+                if (fwrite(data + i, 1, n, client->file) != (size_t)n) {
+                    return -1;
+                }
+                ch->remain -= n;
+                i += n;
+                if (ch->remain == 0) {
+                    ch->state = HOST_HTTP_CHUNK_DATA_CR;
+                }
+                break;
+            }
+            case HOST_HTTP_CHUNK_DATA_CR:
+                ch->state = HOST_HTTP_CHUNK_DATA_LF;
+                i++;
+                break;
+            case HOST_HTTP_CHUNK_DATA_LF:
+                ch->state = HOST_HTTP_CHUNK_SIZE;
+                i++;
+                break;
+            case HOST_HTTP_CHUNK_DONE:
+                i = len;
+                break;
+        }
+    }
+    return len;
+}
+
+static esp_err_t http_socket_open(esp_http_client_handle_t client)
+{
+    char port[8];
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    snprintf(port, sizeof(port), "%d", client->port);
+    int err = getaddrinfo(client->host, port, &hints, &res);
+    if (err != 0) {
+        ESP_LOGE(TAG, "Resolving %s failed: %s", client->host, gai_strerror(err));
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    struct timeval tv = { .tv_sec = client->timeout_ms / 1000, .tv_usec = (client->timeout_ms % 1000) * 1000 };
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        // SO_SNDTIMEO bounds connect() as well on Linux
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int ret;
+        do {
+            ret = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        } while (ret != 0 && errno == EINTR);
+        if (ret == 0) {
+            client->fd = fd;
+            break;
+        }
+        client->err = errno;
+        close(fd);
+    }
+    freeaddrinfo(res);
+    if (client->fd < 0) {
+        ESP_LOGE(TAG, "Connecting to %s:%d failed: %s", client->host, client->port, strerror(client->err));
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    return ESP_OK;
+}
+
+static int http_send(esp_http_client_handle_t client, const char *data, int len)
+{
+    if (client->loopback) {
+        if (client->file == NULL) {
+            return -1;
+        }
+        http_loopback_pace(client, len);
+        return http_loopback_store(client, data, len);
+    }
+    int sent = 0;
+    while (sent < len) {
+        ssize_t n = send(client->fd, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            client->err = errno;
+            ESP_LOGE(TAG, "Sending failed: %s", strerror(errno));
+            return sent > 0 ? sent : -1;
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+// more of the response into rx, the unread part moved to the front first
+static int http_fill(esp_http_client_handle_t client)
+{
+    if (client->rx_pos > 0) {
+        memmove(client->rx, client->rx + client->rx_pos, client->rx_len - client->rx_pos);
+        client->rx_len -= client->rx_pos;
+        client->rx_pos = 0;
+    }
+    int room = HOST_HTTP_RX_SIZE - client->rx_len;
+    if (room <= 0) {
+        return -1;
+    }
+    ssize_t n;
+    if (client->loopback) {
+        if (client->file == NULL || client->file_remain <= 0 || !client->head_done) {
+            return 0;
+        }
+        if (room > client->file_remain) {
+            room = client->file_remain;
+        }
+        http_loopback_pace(client, room);
+        n = fread(client->rx + client->rx_len, 1, room, client->file);
+        client->file_remain = n > 0 ? client->file_remain - n : 0;
+    } else {
+        do {
+            n = recv(client->fd, client->rx + client->rx_len, room, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            client->err = errno;
+            ESP_LOGE(TAG, "Receiving failed: %s", strerror(errno));
+            return -1;
+        }
+    }
+    client->rx_len += n;
+    return n;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+    if (client == NULL) {
+        return NULL;
+    }
+    client->rx = malloc(HOST_HTTP_RX_SIZE);
+    client->fd = -1;
+    client->event_handler = config->event_handler;
+    client->user_data = config->user_data;
+    client->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 5000;
+    client->method = config->method;
+    if (client->rx == NULL || config->url == NULL || http_parse_url(client, config->url) != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return NULL;
+    }
+    return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    return http_parse_url(client, url);
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    return http_header_set(&client->headers, key, strlen(key), value);
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    for (host_http_header_t **h = &client->headers; *h; h = &(*h)->next) {
+        if (strcasecmp((*h)->key, key) == 0) {
+            host_http_header_t *del = *h;
+            *h = del->next;
+            del->next = NULL;
+            http_headers_free(&del);
+            return ESP_OK;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    client->post_data = (char *)data;
+    client->post_len = len;
+    if (client->method == HTTP_METHOD_GET) {
+        client->method = HTTP_METHOD_POST;
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_get_post_field(esp_http_client_handle_t client, char **data)
+{
+    *data = client->post_data;
+    return client->post_len;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    esp_http_client_close(client);
+    http_headers_free(&client->response_headers);
+    client->rx_len = client->rx_pos = 0;
+    client->status = 0;
+    client->content_length = -1;
+    client->body_read = 0;
+    client->chunked = false;
+    client->body_done = false;
+    client->head_done = false;
+    client->err = 0;
+    memset(&client->chunk, 0, sizeof(client->chunk));
+
+    esp_err_t err = strcasecmp(client->host, HOST_HTTP_LOOPBACK) == 0 ? http_loopback_open(client, write_len)
+                                                                       : http_socket_open(client);
+    if (err != ESP_OK) {
+        http_event(client, HTTP_EVENT_ERROR, NULL, 0);
+        return err;
+    }
+    http_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    if (client->loopback) {
+        http_event(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+        return ESP_OK;
+    }
+
+    int len = snprintf(client->rx, HOST_HTTP_RX_SIZE, "%s %s HTTP/1.1\r\nHost: %s", http_method_names[client->method],
+                       client->path, client->host);
+    if (client->port != 80) {
+        len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, ":%d", client->port);
+    }
+    len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "\r\nUser-Agent: ESP32 HTTP Client/1.0\r\n");
+    for (host_http_header_t *h = client->headers; h && len < HOST_HTTP_RX_SIZE; h = h->next) {
+        len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "%s: %s\r\n", h->key, h->value);
+    }
+    if (write_len < 0 && len < HOST_HTTP_RX_SIZE) {
+        len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "Transfer-Encoding: chunked\r\n");
+    } else if (write_len > 0 && len < HOST_HTTP_RX_SIZE) {
+        len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "Content-Length: %d\r\n", write_len);
+    }
+    if (len < HOST_HTTP_RX_SIZE) {
+        len += snprintf(client->rx + len, HOST_HTTP_RX_SIZE - len, "\r\n");
+    }
+    if (len >= HOST_HTTP_RX_SIZE) {
+        ESP_LOGE(TAG, "Request head too long");
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (http_send(client, client->rx, len) != len) {
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    http_event(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+    return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, int len)
+{
+    if (client->fd < 0 && !client->loopback) {
+        return -1;
+    }
+    return http_send(client, buffer, len);
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (client->fd < 0 && !client->loopback) {
+        return ESP_FAIL;
+    }
+    if (client->loopback && (client->method == HTTP_METHOD_POST || client->method == HTTP_METHOD_PUT)) {
+        if (client->file) {
+            fclose(client->file);
+        }
+        client->file = NULL;
+        http_loopback_respond(client);
+    }
+    char *end;
+    while ((end = memmem(client->rx, client->rx_len, "\r\n\r\n", 4)) == NULL) {
+        if (client->rx_len >= HOST_HTTP_RX_SIZE || http_fill(client) <= 0) {
+            ESP_LOGE(TAG, "No response head");
+            return ESP_FAIL;
+        }
+    }
+    client->head_done = true;
+    *end = 0;
+    client->rx_pos = end + 4 - client->rx;
+
+    char *line = client->rx;
+    char *next = strstr(line, "\r\n");
+    if (next) {
+        *next = 0;
+    }
+    if (sscanf(line, "HTTP/%*d.%*d %d", &client->status) != 1) {
+        ESP_LOGE(TAG, "Bad status line %s", line);
+        return ESP_FAIL;
+    }
+    while (next) {
+        line = next + 2;
+        next = strstr(line, "\r\n");
+        if (next) {
+            *next = 0;
+        }
+        char *colon = strchr(line, ':');
+        if (colon == NULL) {
+            continue;
+        }
+        char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') {
+            value++;
+        }
+        http_header_set(&client->response_headers, line, colon - line, value);
+        *colon = 0;
+        if (strcasecmp(line, "Content-Length") == 0) {
+            client->content_length = strtoll(value, NULL, 10);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0 && strcasestr(value, "chunked")) {
+            client->chunked = true;
+        }
+        if (client->event_handler) {
+            esp_http_client_event_t evt = {
+                .event_id = HTTP_EVENT_ON_HEADER,
+                .client = client,
+                .user_data = client->user_data,
+                .header_key = line,
+                .header_value = value,
+            };
+            client->event_handler(&evt);
+        }
+    }
+    if (client->chunked) {
+        client->content_length = -1;
+    }
+    if (client->content_length == 0 || client->status == 204 || client->status == 304 ||
+        client->method == HTTP_METHOD_HEAD) {
+        client->body_done = true;
+    }
+    host_http_header_t *location = http_header_find(client->response_headers, "Location");
+    free(client->location);
+    client->location = location && client->status >= 300 && client->status < 400 ? strdup(location->value) : NULL;
+    ESP_LOGD(TAG, "%s %s: %d, length %lld", http_method_names[client->method], client->url, client->status,
+             (long long)client->content_length);
+    return client->content_length;
+}
+
+// a chunk size line from rx, false when the body ended or broke
+static bool http_chunk_next(esp_http_client_handle_t client)
+{
+    char *eol;
+    while ((eol = memmem(client->rx + client->rx_pos, client->rx_len - client->rx_pos, "\r\n", 2)) == NULL) {
+        if (http_fill(client) <= 0) {
+            return false;
+        }
+    }
+    char *line = client->rx + client->rx_pos;
+    client->rx_pos = eol + 2 - client->rx;
+    if (eol == line && client->chunk.state == HOST_HTTP_CHUNK_DATA_CR) {
+        // the CRLF closing the previous chunk
+        client->chunk.state = HOST_HTTP_CHUNK_SIZE;
+        return http_chunk_next(client);
+    }
+    client->chunk.remain = strtoll(line, NULL, 16);
+    client->chunk.state = client->chunk.remain > 0 ? HOST_HTTP_CHUNK_DATA : HOST_HTTP_CHUNK_DONE;
+    return client->chunk.remain > 0;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    if (client->fd < 0 && !client->loopback) {
+        return -1;
+    }
+    int rlen = 0;
+    while (rlen < len && !client->body_done) {
+        if (client->chunked && client->chunk.remain == 0 && !http_chunk_next(client)) {
+            client->body_done = true;
+            break;
+        }
+        if (client->rx_pos == client->rx_len) {
+            if (rlen > 0) {
+                // what is here now, a socket does not wait for the whole buffer
+                break;
+            }
+            int n = http_fill(client);
+            if (n < 0) {
+                return -1;
+            }
+            if (n == 0) {
+                client->body_done = true;
+                break;
+            }
+        }
+        int n = client->rx_len - client->rx_pos;
+        if (n > len - rlen) {
+            n = len - rlen;
+        }
+        if (client->chunked && n > client->chunk.remain) {
+            n = client->chunk.remain;
+        }
+        if (client->content_length >= 0 && n > client->content_length - client->body_read) {
+            n = client->content_length - client->body_read;
+        }
+        memcpy(buffer + rlen, client->rx + client->rx_pos, n);
+        client->rx_pos += n;
+        client->body_read += n;
+        rlen += n;
+        if (client->chunked) {
+            client->chunk.remain -= n;
+            if (client->chunk.remain == 0) {
+                client->chunk.state = HOST_HTTP_CHUNK_DATA_CR;
+            }
+        }
+        if (client->content_length >= 0 && client->body_read >= client->content_length) {
+            client->body_done = true;
+        }
+    }
+    if (rlen > 0) {
+        http_event(client, HTTP_EVENT_ON_DATA, buffer, rlen);
+    }
+    if (client->body_done && rlen == 0) {
+        http_event(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    }
+    return rlen;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client->content_length;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client->chunked;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    return client->body_done;
+}
+
+esp_err_t esp_http_client_get_header(esp_http_client_handle_t client, const char *key, char **value)
+{
+    host_http_header_t *h = http_header_find(client->response_headers, key);
+    *value = h ? h->value : NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_get_url(esp_http_client_handle_t client, char *url, const int len)
+{
+    if (snprintf(url, len, "http://%s:%d%s", client->host, client->port, client->path) >= len) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client)
+{
+    if (client->location == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = http_parse_url(client, client->location);
+    free(client->location);
+    client->location = NULL;
+    return err;
+}
+
+int esp_http_client_get_errno(esp_http_client_handle_t client)
+{
+    return client->err;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    esp_err_t err = esp_http_client_open(client, client->post_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (client->post_len > 0 && esp_http_client_write(client, client->post_data, client->post_len) != client->post_len) {
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (esp_http_client_fetch_headers(client) < 0 && !client->chunked) {
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+    char buf[512];
+    int n;
+    while ((n = esp_http_client_read(client, buf, sizeof(buf))) > 0) {
+    }
+    esp_http_client_close(client);
+    return n < 0 ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    bool open = client->fd >= 0 || client->loopback;
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    if (client->file) {
+        fclose(client->file);
+        client->file = NULL;
+    }
+    client->loopback = false;
+    if (open) {
+        http_event(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    esp_http_client_close(client);
+    http_headers_free(&client->headers);
+    http_headers_free(&client->response_headers);
+    free(client->url);
+    free(client->host);
+    free(client->path);
+    free(client->location);
+    free(client->rx);
+    free(client);
+    return ESP_OK;
+}
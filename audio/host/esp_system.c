@@ -0,0 +1,252 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+
+#include "audio_arena.h"
+
+// the heap of the board the figures are reported against, internal RAM and SPIRAM
+#define HOST_HEAP_SIZE (320 * 1024 + 4 * 1024 * 1024)
+#define HOST_LOG_TAGS (16)
+
+#ifndef MICROPY_AUDIO_ARENA_SIZE
+#define MICROPY_AUDIO_ARENA_SIZE (1 * 1024 * 1024)
+#endif
+
+typedef struct {
+    char tag[16];
+    esp_log_level_t level;
+} host_log_tag_t;
+
+static esp_log_level_t log_level = CONFIG_LOG_DEFAULT_LEVEL;
+static host_log_tag_t log_tags[HOST_LOG_TAGS];
+static int log_tag_num;
+static portMUX_TYPE log_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct timespec log_start;
+static size_t heap_base;
+static size_t heap_min_free = HOST_HEAP_SIZE;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:
+            return "ESP_ERR_INVALID_RESPONSE";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    portENTER_CRITICAL(&log_lock);
+    if (strcmp(tag, "*") == 0) {
+        log_level = level;
+        log_tag_num = 0;
+    } else {
+        int i = 0;
+        while (i < log_tag_num && strncmp(log_tags[i].tag, tag, sizeof(log_tags[i].tag) - 1) != 0) {
+            i++;
+        }
+        if (i < HOST_LOG_TAGS) {
+            strncpy(log_tags[i].tag, tag, sizeof(log_tags[i].tag) - 1);
+            log_tags[i].level = level;
+            log_tag_num = i == log_tag_num ? i + 1 : log_tag_num;
+        }
+    }
+    portEXIT_CRITICAL(&log_lock);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - log_start.tv_sec) * 1000 + (now.tv_nsec - log_start.tv_nsec) / 1000000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    esp_log_level_t limit = log_level;
+    portENTER_CRITICAL(&log_lock);
+    for (int i = 0; i < log_tag_num; i++) {
+        if (strncmp(log_tags[i].tag, tag, sizeof(log_tags[i].tag) - 1) == 0) {
+            limit = log_tags[i].level;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&log_lock);
+    if (level > limit) {
+        return;
+    }
+    // one write per line, the tasks log concurrently
+    char line[256];
+    int n = snprintf(line, sizeof(line), "%c (%u) %s: ", letters[level], esp_log_timestamp(), tag);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line + n, sizeof(line) - n - 1, format, args);
+    va_end(args);
+    strcat(line, "\n");
+    fputs(line, stderr);
+}
+
+// the host has one heap, every region reports the growth of the C heap since the first
+// query, which comes after the interpreter heap has been allocated
+static size_t host_heap_used(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+#else
+    struct mallinfo info = mallinfo();
+    size_t used = (unsigned)info.uordblks + (unsigned)info.hblkhd;
+#endif
+    if (heap_base == 0) {
+        heap_base = used;
+    }
+    return used > heap_base ? used - heap_base : 0;
+}
+
+static size_t host_heap_free(void)
+{
+    size_t used = host_heap_used();
+    size_t free = used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0;
+    if (free < heap_min_free) {
+        heap_min_free = free;
+    }
+    return free;
+}
+
+// blocks stay plain malloc blocks, ADF frees them with free()
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    return realloc(ptr, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return host_heap_free();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    host_heap_free();
+    return heap_min_free;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return host_heap_free();
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return HOST_HEAP_SIZE;
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    memset(info, 0, sizeof(multi_heap_info_t));
+    info->total_free_bytes = host_heap_free();
+    info->total_allocated_bytes = host_heap_used();
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = heap_min_free;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return host_heap_free();
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t)random();
+}
+
+__attribute__((constructor)) static void host_system_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &log_start);
+    const char *level = getenv("AUDIO_HOST_LOG");
+    if (level && *level >= '0' && *level <= '5') {
+        log_level = (esp_log_level_t)(*level - '0');
+    }
+    // the board reserves the arena at the end of SPIRAM, AUDIO_HOST_ARENA=0 runs without
+    const char *arena = getenv("AUDIO_HOST_ARENA");
+    size_t arena_size = arena ? strtoul(arena, NULL, 0) : MICROPY_AUDIO_ARENA_SIZE;
+    if (arena_size) {
+        void *base = malloc(arena_size);
+        if (base) {
+            audio_arena_init(base, arena_size);
+        }
+    }
+}
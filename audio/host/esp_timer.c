@@ -0,0 +1,179 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define ESP_TIMER_TASK_STACK (4096)
+#define ESP_TIMER_TASK_PRIO (22)
+
+static const char *TAG = "HOST_TIMER";
+
+struct esp_timer {
+    struct esp_timer *next;
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t alarm;
+    uint64_t period;
+    bool armed;
+};
+
+// armed timers by alarm time, served by one task like the IDF timer task
+static struct esp_timer *timer_list;
+static portMUX_TYPE timer_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t timer_wake;
+static TaskHandle_t timer_task;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// with timer_lock held
+static void timer_unlink(struct esp_timer *timer)
+{
+    for (struct esp_timer **p = &timer_list; *p; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    timer->armed = false;
+}
+
+// with timer_lock held
+static void timer_insert(struct esp_timer *timer)
+{
+    struct esp_timer **p = &timer_list;
+    while (*p && (*p)->alarm <= timer->alarm) {
+        p = &(*p)->next;
+    }
+    timer->next = *p;
+    *p = timer;
+    timer->armed = true;
+}
+
+static void timer_task_run(void *arg)
+{
+    for (;;) {
+        portENTER_CRITICAL(&timer_lock);
+        struct esp_timer *timer = timer_list;
+        int64_t now = esp_timer_get_time();
+        if (timer && timer->alarm <= now) {
+            timer_unlink(timer);
+            if (timer->period) {
+                timer->alarm += timer->period;
+                timer_insert(timer);
+            }
+            portEXIT_CRITICAL(&timer_lock);
+            timer->callback(timer->arg);
+            continue;
+        }
+        TickType_t ticks = portMAX_DELAY;
+        if (timer) {
+            ticks = (TickType_t)((timer->alarm - now + 999) / 1000);
+        }
+        portEXIT_CRITICAL(&timer_lock);
+        xSemaphoreTake(timer_wake, ticks);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer_task == NULL) {
+        timer_wake = xSemaphoreCreateBinary();
+        if (xTaskCreate(timer_task_run, "esp_timer", ESP_TIMER_TASK_STACK, NULL, ESP_TIMER_TASK_PRIO, &timer_task) != pdPASS) {
+            ESP_LOGE(TAG, "failed to create the timer task");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    struct esp_timer *timer = calloc(1, sizeof(struct esp_timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period)
+{
+    portENTER_CRITICAL(&timer_lock);
+    if (timer->armed) {
+        portEXIT_CRITICAL(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm = esp_timer_get_time() + timeout_us;
+    timer->period = period;
+    timer_insert(timer);
+    portEXIT_CRITICAL(&timer_lock);
+    xSemaphoreGive(timer_wake);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    portENTER_CRITICAL(&timer_lock);
+    bool armed = timer->armed;
+    if (armed) {
+        timer_unlink(timer);
+    }
+    portEXIT_CRITICAL(&timer_lock);
+    return armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    free(timer);
+    return ESP_OK;
+}
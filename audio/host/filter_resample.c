@@ -0,0 +1,252 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "esp_log.h"
+#include "filter_resample.h"
+
+static const char *TAG = "RSP_FILTER";
+
+#define RSP_FILTER_IN_SIZE (2048)
+#define RSP_FRAC_BITS (32)
+#define RSP_FRAC_ONE (1ULL << RSP_FRAC_BITS)
+
+typedef struct rsp_filter {
+    int src_rate;
+    int src_ch;
+    int dest_rate;
+    int dest_ch;
+    // the source the decoder reported, taken over by the filter task between two buffers
+    int next_rate;
+    int next_ch;
+    volatile bool changed;
+    int16_t *in;
+    int in_len;
+    int16_t *mix;
+    int16_t *out;
+    int out_size;
+    // the position of the next output frame from the last input frame, in 2^-32 frames
+    uint64_t pos;
+    uint64_t step;
+    int16_t last[2];
+} rsp_filter_t;
+
+static esp_err_t rsp_filter_alloc(rsp_filter_t *rsp)
+{
+    rsp->changed = false;
+    rsp->src_rate = rsp->next_rate;
+    rsp->src_ch = rsp->next_ch;
+    int frames = RSP_FILTER_IN_SIZE / sizeof(int16_t) / rsp->src_ch;
+    int out_frames = (int)((int64_t)frames * rsp->dest_rate / rsp->src_rate) + 2;
+    int out_size = out_frames * rsp->dest_ch * sizeof(int16_t);
+    if (out_size > rsp->out_size) {
+        int16_t *out = audio_realloc(rsp->out, out_size);
+        AUDIO_MEM_CHECK(TAG, out, return ESP_ERR_NO_MEM);
+        rsp->out = out;
+        rsp->out_size = out_size;
+    }
+    rsp->step = ((uint64_t)rsp->src_rate << RSP_FRAC_BITS) / rsp->dest_rate;
+    rsp->pos = RSP_FRAC_ONE;
+    memset(rsp->last, 0, sizeof(rsp->last));
+    return ESP_OK;
+}
+
+static esp_err_t _rsp_filter_open(audio_element_handle_t self)
+{
+    rsp_filter_t *rsp = (rsp_filter_t *)audio_element_getdata(self);
+    rsp->in_len = 0;
+    if (rsp_filter_alloc(rsp) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    audio_element_set_music_info(self, rsp->dest_rate, rsp->dest_ch, 16);
+    ESP_LOGD(TAG, "%d Hz %d ch to %d Hz %d ch", rsp->src_rate, rsp->src_ch, rsp->dest_rate, rsp->dest_ch);
+    return ESP_OK;
+}
+
+// the frames in the destination channel layout, stereo to mono averages
+static const int16_t *rsp_filter_mix(rsp_filter_t *rsp, const int16_t *in, int frames)
+{
+    if (rsp->src_ch == rsp->dest_ch) {
+        return in;
+    }
+    for (int i = 0; i < frames; i++) {
+        if (rsp->dest_ch == 1) {
+            rsp->mix[i] = (int16_t)(((int32_t)in[2 * i] + in[2 * i + 1]) >> 1);
+        } else {
+            rsp->mix[2 * i] = rsp->mix[2 * i + 1] = in[i];
+        }
+    }
+    return rsp->mix;
+}
+
+static int rsp_filter_resample(rsp_filter_t *rsp, const int16_t *in, int frames)
+{
+    int ch = rsp->dest_ch;
+    if (rsp->src_rate == rsp->dest_rate) {
+        memcpy(rsp->out, in, frames * ch * sizeof(int16_t));
+        return frames;
+    }
+    int n = 0;
+    uint64_t end = (uint64_t)frames << RSP_FRAC_BITS;
+    // frame 0 is the last one of the previous buffer, frame i + 1 is in[i]
+    while (rsp->pos < end) {
+        int i = rsp->pos >> RSP_FRAC_BITS;
+        int64_t frac = (rsp->pos & (RSP_FRAC_ONE - 1)) >> 16;
+        for (int c = 0; c < ch; c++) {
+            int32_t a = i == 0 ? rsp->last[c] : in[(i - 1) * ch + c];
+            int32_t b = in[i * ch + c];
+            rsp->out[n * ch + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+        }
+        n++;
+        rsp->pos += rsp->step;
+    }
+    rsp->pos -= end;
+    for (int c = 0; c < ch; c++) {
+        rsp->last[c] = in[(frames - 1) * ch + c];
+    }
+    return n;
+}
+
+static int _rsp_filter_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    rsp_filter_t *rsp = (rsp_filter_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, (char *)rsp->in + rsp->in_len, RSP_FILTER_IN_SIZE - rsp->in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    // the decoder tells the new format before it outputs any of it, so the read is the new one
+    if (rsp->changed) {
+        memmove(rsp->in, (char *)rsp->in + rsp->in_len, r_size);
+        rsp->in_len = 0;
+        if (rsp_filter_alloc(rsp) != ESP_OK) {
+            return AEL_PROCESS_FAIL;
+        }
+    }
+    int bytes = rsp->in_len + r_size;
+    int frame_size = rsp->src_ch * sizeof(int16_t);
+    int frames = bytes / frame_size;
+    if (frames == 0) {
+        rsp->in_len = bytes;
+        return r_size;
+    }
+    const int16_t *mixed = rsp_filter_mix(rsp, rsp->in, frames);
+    int out_frames = rsp_filter_resample(rsp, mixed, frames);
+    // a split frame waits for the rest of it
+    rsp->in_len = bytes - frames * frame_size;
+    memmove(rsp->in, (char *)rsp->in + frames * frame_size, rsp->in_len);
+    if (out_frames == 0) {
+        return r_size;
+    }
+    return audio_element_output(self, (char *)rsp->out, out_frames * rsp->dest_ch * sizeof(int16_t));
+}
+
+static esp_err_t _rsp_filter_close(audio_element_handle_t self)
+{
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_set_byte_pos(self, 0);
+    }
+    return ESP_OK;
+}
+
+static void _rsp_filter_free(rsp_filter_t *rsp)
+{
+    audio_free(rsp->in);
+    audio_free(rsp->mix);
+    audio_free(rsp->out);
+    audio_free(rsp);
+}
+
+static esp_err_t _rsp_filter_destroy(audio_element_handle_t self)
+{
+    _rsp_filter_free((rsp_filter_t *)audio_element_getdata(self));
+    return ESP_OK;
+}
+
+esp_err_t rsp_filter_change_src_info(audio_element_handle_t self, int src_rate, int src_ch, int src_bits)
+{
+    rsp_filter_t *rsp = (rsp_filter_t *)audio_element_getdata(self);
+    if (src_rate <= 0 || src_ch < 1 || src_ch > 2 || src_bits != 16) {
+        ESP_LOGE(TAG, "Unsupported source %d Hz %d ch %d bits", src_rate, src_ch, src_bits);
+        return ESP_FAIL;
+    }
+    if (rsp->next_rate == src_rate && rsp->next_ch == src_ch) {
+        return ESP_OK;
+    }
+    rsp->next_rate = src_rate;
+    rsp->next_ch = src_ch;
+    rsp->changed = true;
+    return ESP_OK;
+}
+
+esp_err_t rsp_filter_set_src_info(audio_element_handle_t self, int src_rate, int src_ch)
+{
+    return rsp_filter_change_src_info(self, src_rate, src_ch, 16);
+}
+
+audio_element_handle_t rsp_filter_init(rsp_filter_cfg_t *config)
+{
+    if (config->src_rate <= 0 || config->dest_rate <= 0 || config->src_ch < 1 || config->src_ch > 2
+        || config->dest_ch < 1 || config->dest_ch > 2) {
+        ESP_LOGE(TAG, "Unsupported conversion %d Hz %d ch to %d Hz %d ch", config->src_rate, config->src_ch,
+                 config->dest_rate, config->dest_ch);
+        return NULL;
+    }
+    rsp_filter_t *rsp = audio_calloc(1, sizeof(rsp_filter_t));
+    AUDIO_MEM_CHECK(TAG, rsp, return NULL);
+    rsp->src_rate = config->src_rate;
+    rsp->src_ch = config->src_ch;
+    rsp->next_rate = config->src_rate;
+    rsp->next_ch = config->src_ch;
+    rsp->dest_rate = config->dest_rate;
+    rsp->dest_ch = config->dest_ch;
+    // mono to stereo doubles the input
+    rsp->in = audio_malloc(RSP_FILTER_IN_SIZE);
+    rsp->mix = audio_malloc(RSP_FILTER_IN_SIZE * 2);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _rsp_filter_open;
+    cfg.close = _rsp_filter_close;
+    cfg.process = _rsp_filter_process;
+    cfg.destroy = _rsp_filter_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = RSP_FILTER_BUFFER_BYTE;
+    cfg.tag = "resample";
+
+    audio_element_handle_t el = rsp->in && rsp->mix ? audio_element_init(&cfg) : NULL;
+    AUDIO_MEM_CHECK(TAG, el, {
+        _rsp_filter_free(rsp);
+        return NULL;
+    });
+    audio_element_setdata(el, rsp);
+    audio_element_set_music_info(el, rsp->dest_rate, rsp->dest_ch, 16);
+    return el;
+}
@@ -0,0 +1,104 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _FILTER_RESAMPLE_H_
+#define _FILTER_RESAMPLE_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Resample filter configurations. The host build converts 16 bit PCM by linear
+ *             interpolation and mixes or duplicates channels between mono and stereo.
+ */
+typedef struct {
+    int src_rate;      /*!< The sampling rate of the source PCM file (in Hz) */
+    int src_ch;        /*!< The number of channels of the source PCM file (Mono=1, Dual=2) */
+    int dest_rate;     /*!< The sampling rate of the destination PCM file (in Hz) */
+    int dest_bits;     /*!< The bit width of the destination PCM file, 16 only */
+    int dest_ch;       /*!< The number of channels of the destination PCM file (Mono=1, Dual=2) */
+    int src_bits;      /*!< The bit width of the source PCM file, 16 only */
+    int complexity;    /*!< Not used on the host build */
+    int out_rb_size;   /*!< Output ringbuffer size */
+    int task_stack;    /*!< Task stack size */
+    int task_core;     /*!< Task running on core */
+    int task_prio;     /*!< Task priority */
+    bool stack_in_ext; /*!< Try to allocate stack in external memory */
+} rsp_filter_cfg_t;
+
+#define RSP_FILTER_BUFFER_BYTE (512)
+#define RSP_FILTER_TASK_STACK (4 * 1024)
+#define RSP_FILTER_TASK_CORE (0)
+#define RSP_FILTER_TASK_PRIO (5)
+#define RSP_FILTER_RINGBUFFER_SIZE (8 * 1024)
+
+#define DEFAULT_RESAMPLE_FILTER_CONFIG()         \
+{                                                \
+    .src_rate = 44100,                           \
+    .src_ch = 2,                                 \
+    .dest_rate = 48000,                          \
+    .dest_bits = 16,                             \
+    .dest_ch = 2,                                \
+    .src_bits = 16,                              \
+    .complexity = 2,                             \
+    .out_rb_size = RSP_FILTER_RINGBUFFER_SIZE,   \
+    .task_stack = RSP_FILTER_TASK_STACK,         \
+    .task_core = RSP_FILTER_TASK_CORE,           \
+    .task_prio = RSP_FILTER_TASK_PRIO,           \
+    .stack_in_ext = true,                        \
+}
+
+/**
+ * @brief      Set the source audio format, it applies from the next buffer
+ *
+ * @param      self      Audio element handle
+ * @param      src_rate  The sampling rate of the source PCM (in Hz)
+ * @param      src_ch    The number of channels of the source PCM (Mono=1, Dual=2)
+ *
+ * @return     ESP_OK, ESP_FAIL for a format the filter does not convert
+ */
+esp_err_t rsp_filter_set_src_info(audio_element_handle_t self, int src_rate, int src_ch);
+
+/**
+ * @brief      Set the source audio format with its bit width
+ */
+esp_err_t rsp_filter_change_src_info(audio_element_handle_t self, int src_rate, int src_ch, int src_bits);
+
+/**
+ * @brief      Create an Audio Element handle to resample incoming data
+ *
+ * @param      config  The configuration
+ *
+ * @return     The audio element handle
+ */
+audio_element_handle_t rsp_filter_init(rsp_filter_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
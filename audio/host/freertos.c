@@ -0,0 +1,779 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <alloca.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "py/mpconfig.h"
+#if MICROPY_PY_THREAD
+#include "py/mpthread.h"
+#include "py/runtime.h"
+#include "py/stackctrl.h"
+#endif
+
+// x86-64 frames are about twice the size of the Xtensa ones, and libc needs room of its own
+#define HOST_TASK_STACK_SCALE (2)
+#define HOST_TASK_STACK_EXTRA (32 * 1024)
+// left unpainted at the bottom of the stack, clear of the guard page
+#define HOST_TASK_STACK_GUARD (8192)
+#define HOST_TASK_STACK_PAINT (0xa5)
+
+static const char *TAG = "HOST_RTOS";
+
+struct host_task {
+    struct host_task *next;
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *arg;
+    UBaseType_t prio;
+    BaseType_t core;
+    uint32_t stack_depth;
+    size_t stack_size;
+    uint8_t *stack_top;
+    uint8_t *paint_low;
+    size_t paint_len;
+    pthread_t thread;
+    pthread_cond_t notify_cond;
+    uint32_t notify;
+#if MICROPY_PY_THREAD
+    bool mp_thread;
+    mp_obj_dict_t *locals;
+    mp_obj_dict_t *globals;
+#endif
+};
+
+struct host_queue {
+    pthread_cond_t cond;
+    uint8_t type;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t *items;
+    struct host_queue *set;
+    TaskHandle_t holder;
+    UBaseType_t recursion;
+};
+
+struct host_event_group {
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+TaskHandle_t mp_main_task_handle;
+
+// one lock for all objects, queue sets wait on changes of several queues at once
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task *host_tasks;
+static UBaseType_t host_task_num;
+static __thread struct host_task *host_current;
+static struct timespec host_start;
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void host_deadline(TickType_t ticks, struct timespec *ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ns = (uint64_t)ticks * (1000000000ULL / configTICK_RATE_HZ) + ts->tv_nsec;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+// wait with host_lock held, false once the deadline passed
+static bool host_wait(pthread_cond_t *cond, TickType_t ticks, const struct timespec *deadline)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, &host_lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, &host_lock, deadline) != ETIMEDOUT;
+}
+
+static void host_task_link(struct host_task *task)
+{
+    pthread_mutex_lock(&host_lock);
+    task->next = host_tasks;
+    host_tasks = task;
+    host_task_num++;
+    pthread_mutex_unlock(&host_lock);
+}
+
+static void host_task_unlink(struct host_task *task)
+{
+    pthread_mutex_lock(&host_lock);
+    for (struct host_task **p = &host_tasks; *p; p = &(*p)->next) {
+        if (*p == task) {
+            *p = task->next;
+            host_task_num--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+static struct host_task *host_task_new(const char *name)
+{
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (task == NULL) {
+        return NULL;
+    }
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    host_cond_init(&task->notify_cond);
+    return task;
+}
+
+static void host_task_free(struct host_task *task)
+{
+    pthread_cond_destroy(&task->notify_cond);
+    free(task);
+}
+
+// paint the free part of the stack to find the deepest use later
+static NOINLINE_ATTR void host_task_paint(struct host_task *task)
+{
+#if defined(__SANITIZE_ADDRESS__)
+    // the sanitizer owns the stack layout, no high-water mark in such builds
+    return;
+#endif
+    pthread_attr_t attr;
+    void *base;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return;
+    }
+    pthread_attr_getstack(&attr, &base, &size);
+    pthread_attr_destroy(&attr);
+    uint8_t *frame = (uint8_t *)__builtin_frame_address(0);
+    uint8_t *low = (uint8_t *)base + HOST_TASK_STACK_GUARD;
+    if (frame < low + 4096) {
+        return;
+    }
+    // the region below this frame, the memset frame stays under it
+    size_t len = frame - low - 2048;
+    low = alloca(len);
+    memset(low, HOST_TASK_STACK_PAINT, len);
+    // the memory is read back from another function, keep the stores
+    __asm__ volatile ("" : : "r" (low) : "memory");
+    task->paint_low = low;
+    task->paint_len = len;
+}
+
+static void host_task_exit(struct host_task *task)
+{
+    host_task_unlink(task);
+#if MICROPY_PY_THREAD
+    bool mp_thread = task->mp_thread;
+#endif
+    host_current = NULL;
+    host_task_free(task);
+#if MICROPY_PY_THREAD
+    if (mp_thread) {
+        mp_thread_finish();
+    }
+#endif
+    pthread_exit(NULL);
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task *task = (struct host_task *)arg;
+    host_current = task;
+    task->thread = pthread_self();
+    task->stack_top = (uint8_t *)__builtin_frame_address(0);
+#if MICROPY_PY_THREAD
+    mp_state_thread_t ts;
+    if (task->mp_thread) {
+        memset(&ts, 0, sizeof(ts));
+        mp_thread_set_state(&ts);
+        mp_stack_set_top(&ts + 1);
+        mp_stack_set_limit(task->stack_size - HOST_TASK_STACK_GUARD);
+        mp_locals_set(task->locals);
+        mp_globals_set(task->globals);
+        mp_thread_start();
+    }
+#endif
+    host_task_paint(task);
+    host_task_link(task);
+    task->fn(task->arg);
+    // FreeRTOS tasks never return, be lenient with the ones that do
+    ESP_LOGW(TAG, "task %s returned", task->name);
+    host_task_exit(task);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, const uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle, const BaseType_t core)
+{
+    struct host_task *task = host_task_new(name);
+    if (task == NULL) {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->prio = prio;
+    task->core = core;
+    task->stack_depth = stack_depth;
+    task->stack_size = (size_t)stack_depth * HOST_TASK_STACK_SCALE + HOST_TASK_STACK_EXTRA;
+    if (handle) {
+        *handle = task;
+    }
+#if MICROPY_PY_THREAD
+    // only an interpreter thread can register another one
+    if (mp_thread_get_state() != NULL) {
+        task->mp_thread = true;
+        task->locals = mp_locals_get();
+        task->globals = mp_globals_get();
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            mp_thread_create(host_task_entry, task, &task->stack_size);
+            nlr_pop();
+            return pdPASS;
+        }
+        ESP_LOGE(TAG, "failed to create task %s", name);
+        host_task_free(task);
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+#endif
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, task->stack_size);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int ret = pthread_create(&thread, &attr, host_task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "failed to create task %s, %s", name, strerror(ret));
+        host_task_free(task);
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == host_current) {
+        host_task_exit(host_current);
+    }
+    ESP_LOGE(TAG, "deleting another task is not supported on the host (%s)", task->name);
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    struct timespec ts;
+    ts.tv_sec = ticks / configTICK_RATE_HZ;
+    ts.tv_nsec = (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    // the GC signals of the unix port interrupt the sleep
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ms = (int64_t)(now.tv_sec - host_start.tv_sec) * 1000 + (now.tv_nsec - host_start.tv_nsec) / 1000000;
+    return (TickType_t)(ms * configTICK_RATE_HZ / 1000);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (host_current == NULL) {
+        // a thread the shim did not create, give it a record for the notifications
+        struct host_task *task = host_task_new("pthread");
+        if (task == NULL) {
+            return NULL;
+        }
+        task->thread = pthread_self();
+        host_current = task;
+        host_task_link(task);
+    }
+    return host_current;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+    pthread_mutex_lock(&host_lock);
+    struct host_task *task = host_tasks;
+    while (task && strncmp(task->name, name, sizeof(task->name) - 1) != 0) {
+        task = task->next;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return task;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->name;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->prio;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    task->prio = prio;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    if (task->paint_low == NULL) {
+        return task->stack_depth;
+    }
+    size_t free = 0;
+    while (free < task->paint_len && task->paint_low[free] == HOST_TASK_STACK_PAINT) {
+        free++;
+    }
+    size_t used = (task->stack_top - (task->paint_low + free)) / HOST_TASK_STACK_SCALE;
+    return used < task->stack_depth ? task->stack_depth - used : 0;
+}
+
+void vTaskGetInfo(TaskHandle_t task, TaskStatus_t *status, BaseType_t get_free_stack, eTaskState state)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    memset(status, 0, sizeof(TaskStatus_t));
+    status->xHandle = task;
+    status->pcTaskName = task->name;
+    status->eCurrentState = task == host_current ? eRunning : eBlocked;
+    status->uxCurrentPriority = task->prio;
+    status->uxBasePriority = task->prio;
+    status->xCoreID = task->core;
+    // the CPU time of the thread stands in for the run time counter
+    clockid_t clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(task->thread, &clock) == 0 && clock_gettime(clock, &ts) == 0) {
+        status->ulRunTimeCounter = (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+    }
+    if (get_free_stack) {
+        status->usStackHighWaterMark = uxTaskGetStackHighWaterMark(task);
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    return host_task_num;
+}
+
+void vTaskSuspendAll(void)
+{
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    return pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&host_lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->notify_cond);
+    pthread_mutex_unlock(&host_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    host_deadline(ticks_to_wait, &deadline);
+    pthread_mutex_lock(&host_lock);
+    while (task->notify == 0 && host_wait(&task->notify_cond, ticks_to_wait, &deadline)) {
+    }
+    uint32_t value = task->notify;
+    if (value) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return value;
+}
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t length, const UBaseType_t item_size, const uint8_t type)
+{
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    if (item_size) {
+        queue->items = malloc(length * item_size);
+        if (queue->items == NULL) {
+            free(queue);
+            return NULL;
+        }
+    }
+    host_cond_init(&queue->cond);
+    queue->type = type;
+    queue->length = length;
+    queue->item_size = item_size;
+    // a mutex is created given
+    if (type == queueQUEUE_TYPE_MUTEX || type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+        queue->count = 1;
+    }
+    return queue;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t max_count, const UBaseType_t initial_count)
+{
+    QueueHandle_t queue = xQueueGenericCreate(max_count, 0, queueQUEUE_TYPE_COUNTING_SEMAPHORE);
+    if (queue) {
+        queue->count = initial_count;
+    }
+    return queue;
+}
+
+// with host_lock held and room in the queue
+static void host_queue_put(struct host_queue *queue, const void *item, BaseType_t position)
+{
+    if (queue->item_size) {
+        UBaseType_t slot;
+        if (position == queueOVERWRITE && queue->count == queue->length) {
+            slot = (queue->head + queue->count - 1) % queue->length;
+            queue->count--;
+        } else if (position == queueSEND_TO_FRONT) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(queue->items + slot * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    if (queue->set && queue->set->count < queue->set->length) {
+        host_queue_put(queue->set, &queue, queueSEND_TO_BACK);
+    }
+}
+
+// with host_lock held and an item in the queue
+static void host_queue_get(struct host_queue *queue, void *buffer, bool peek)
+{
+    if (queue->item_size) {
+        memcpy(buffer, queue->items + queue->head * queue->item_size, queue->item_size);
+    }
+    if (!peek) {
+        queue->head = queue->item_size ? (queue->head + 1) % queue->length : 0;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *const item, TickType_t ticks_to_wait, const BaseType_t position)
+{
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&host_lock);
+    if (queue->type == queueQUEUE_TYPE_MUTEX || queue->type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+        if (queue->holder != host_current || queue->count) {
+            ret = pdFAIL;
+        } else {
+            queue->holder = NULL;
+            queue->recursion = 0;
+            host_queue_put(queue, item, position);
+        }
+        pthread_mutex_unlock(&host_lock);
+        return ret;
+    }
+    struct timespec deadline;
+    host_deadline(ticks_to_wait, &deadline);
+    while (queue->count >= queue->length && position != queueOVERWRITE) {
+        if (!host_wait(&queue->cond, ticks_to_wait, &deadline)) {
+            ret = errQUEUE_FULL;
+            break;
+        }
+    }
+    if (ret == pdPASS) {
+        host_queue_put(queue, item, position);
+    }
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+static BaseType_t host_queue_receive(QueueHandle_t queue, void *const buffer, TickType_t ticks_to_wait, bool peek)
+{
+    BaseType_t ret = pdPASS;
+    struct timespec deadline;
+    host_deadline(ticks_to_wait, &deadline);
+    pthread_mutex_lock(&host_lock);
+    while (queue->count == 0) {
+        if (!host_wait(&queue->cond, ticks_to_wait, &deadline)) {
+            ret = errQUEUE_EMPTY;
+            break;
+        }
+    }
+    if (ret == pdPASS) {
+        host_queue_get(queue, buffer, peek);
+        if (queue->type == queueQUEUE_TYPE_MUTEX || queue->type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+            queue->holder = host_current;
+            queue->recursion = 1;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *const buffer, TickType_t ticks_to_wait)
+{
+    return host_queue_receive(queue, buffer, ticks_to_wait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *const buffer, TickType_t ticks_to_wait)
+{
+    return host_queue_receive(queue, buffer, ticks_to_wait, true);
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t queue, TickType_t ticks_to_wait)
+{
+    if (host_current == NULL) {
+        // the holder of a mutex needs a handle
+        xTaskGetCurrentTaskHandle();
+    }
+    return host_queue_receive(queue, NULL, ticks_to_wait, false);
+}
+
+BaseType_t xQueueTakeMutexRecursive(QueueHandle_t mutex, TickType_t ticks_to_wait)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&host_lock);
+    if (mutex->holder == self) {
+        mutex->recursion++;
+        pthread_mutex_unlock(&host_lock);
+        return pdPASS;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return host_queue_receive(mutex, NULL, ticks_to_wait, false);
+}
+
+BaseType_t xQueueGiveMutexRecursive(QueueHandle_t mutex)
+{
+    pthread_mutex_lock(&host_lock);
+    if (mutex->holder != host_current) {
+        pthread_mutex_unlock(&host_lock);
+        return pdFAIL;
+    }
+    if (--mutex->recursion == 0) {
+        mutex->holder = NULL;
+        host_queue_put(mutex, NULL, queueSEND_TO_BACK);
+    }
+    pthread_mutex_unlock(&host_lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueGenericReset(QueueHandle_t queue, BaseType_t new_queue)
+{
+    pthread_mutex_lock(&host_lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&host_lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue)
+{
+    pthread_mutex_lock(&host_lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&host_lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t queue)
+{
+    pthread_mutex_lock(&host_lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&host_lock);
+    return spaces;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&queue->cond);
+    free(queue->items);
+    free(queue);
+}
+
+QueueSetHandle_t xQueueCreateSet(const UBaseType_t length)
+{
+    return xQueueGenericCreate(length, sizeof(QueueHandle_t), queueQUEUE_TYPE_SET);
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&host_lock);
+    // like FreeRTOS, only an empty queue can join
+    if (member->set != NULL || (member->count && member->type != queueQUEUE_TYPE_MUTEX)) {
+        ret = pdFAIL;
+    } else {
+        member->set = set;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+BaseType_t xQueueRemoveFromSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&host_lock);
+    if (member->set != set || member->count) {
+        ret = pdFAIL;
+    } else {
+        member->set = NULL;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, const TickType_t ticks_to_wait)
+{
+    QueueSetMemberHandle_t member = NULL;
+    xQueueReceive(set, &member, ticks_to_wait);
+    return member;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct host_event_group *group = calloc(1, sizeof(struct host_event_group));
+    if (group) {
+        host_cond_init(&group->cond);
+    }
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    if (group == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&group->cond);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&host_lock);
+    group->bits |= bits;
+    EventBits_t ret = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&host_lock);
+    EventBits_t ret = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    pthread_mutex_lock(&host_lock);
+    EventBits_t ret = group->bits;
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, const EventBits_t bits, const BaseType_t clear_on_exit,
+                                const BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    host_deadline(ticks_to_wait, &deadline);
+    pthread_mutex_lock(&host_lock);
+    for (;;) {
+        EventBits_t set = group->bits & bits;
+        if (wait_for_all ? set == bits : set != 0) {
+            break;
+        }
+        if (!host_wait(&group->cond, ticks_to_wait, &deadline)) {
+            EventBits_t ret = group->bits;
+            pthread_mutex_unlock(&host_lock);
+            return ret;
+        }
+    }
+    EventBits_t ret = group->bits;
+    if (clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return ret;
+}
+
+__attribute__((constructor)) static void host_freertos_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+    // the interpreter runs on the main thread, named like the esp32 port task
+    mp_main_task_handle = xTaskGetCurrentTaskHandle();
+    strncpy(mp_main_task_handle->name, "mp_task", sizeof(mp_main_task_handle->name) - 1);
+}
@@ -0,0 +1,62 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t max_count, const UBaseType_t initial_count);
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t queue, TickType_t ticks_to_wait);
+
+BaseType_t xQueueTakeMutexRecursive(QueueHandle_t mutex, TickType_t ticks_to_wait);
+
+BaseType_t xQueueGiveMutexRecursive(QueueHandle_t mutex);
+
+#define xSemaphoreCreateBinary() xQueueGenericCreate(1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE)
+#define xSemaphoreCreateMutex() xQueueGenericCreate(1, 0, queueQUEUE_TYPE_MUTEX)
+#define xSemaphoreCreateRecursiveMutex() xQueueGenericCreate(1, 0, queueQUEUE_TYPE_RECURSIVE_MUTEX)
+#define xSemaphoreCreateCounting(max_count, initial_count) xQueueCreateCountingSemaphore(max_count, initial_count)
+
+#define xSemaphoreTake(sem, ticks) xQueueSemaphoreTake(sem, ticks)
+#define xSemaphoreGive(sem) xQueueGenericSend(sem, NULL, 0, queueSEND_TO_BACK)
+#define xSemaphoreTakeRecursive(mutex, ticks) xQueueTakeMutexRecursive(mutex, ticks)
+#define xSemaphoreGiveRecursive(mutex) xQueueGiveMutexRecursive(mutex)
+#define xSemaphoreTakeFromISR(sem, woken) xQueueSemaphoreTake(sem, 0)
+#define xSemaphoreGiveFromISR(sem, woken) xQueueGenericSend(sem, NULL, 0, queueSEND_TO_BACK)
+
+#define uxSemaphoreGetCount(sem) uxQueueMessagesWaiting(sem)
+#define vSemaphoreDelete(sem) vQueueDelete(sem)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
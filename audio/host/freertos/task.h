@@ -0,0 +1,129 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define tskNO_AFFINITY (0x7fffffff)
+#define tskIDLE_PRIORITY (0)
+
+typedef struct host_task *TaskHandle_t;
+
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;   /*!< CPU time of the thread in microseconds */
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+/**
+ * @brief      The task running the interpreter, notified by audio_async_event_set
+ */
+extern TaskHandle_t mp_main_task_handle;
+
+/**
+ * @brief      Create a task as a MicroPython thread, so it may allocate from the GC heap and
+ *             call into the VFS like the element tasks do on the board. The priority and the
+ *             core are recorded only, the host scheduler decides. The stack is sized up for
+ *             the host ABI, see HOST_TASK_STACK_SCALE in host/freertos.c
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, const uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle, const BaseType_t core);
+
+#define xTaskCreate(fn, name, stack_depth, arg, prio, handle) \
+    xTaskCreatePinnedToCore(fn, name, stack_depth, arg, prio, handle, tskNO_AFFINITY)
+
+/**
+ * @brief      Delete a task, only the calling task (NULL) can be deleted on the host
+ */
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(const TickType_t ticks);
+
+TickType_t xTaskGetTickCount(void);
+
+TickType_t xTaskGetTickCountFromISR(void);
+
+/**
+ * @brief      Handle of the calling thread, threads not created by xTaskCreate get one on first use
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+TaskHandle_t xTaskGetHandle(const char *name);
+
+char *pcTaskGetName(TaskHandle_t task);
+
+#define pcTaskGetTaskName pcTaskGetName
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio);
+
+/**
+ * @brief      Least free stack seen, in target bytes: the host use is measured against a
+ *             painted stack and divided by HOST_TASK_STACK_SCALE
+ */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+void vTaskGetInfo(TaskHandle_t task, TaskStatus_t *status, BaseType_t get_free_stack, eTaskState state);
+
+UBaseType_t uxTaskGetNumberOfTasks(void);
+
+void vTaskSuspendAll(void);
+
+BaseType_t xTaskResumeAll(void);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,494 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "esp_log.h"
+#include "http_stream.h"
+
+static const char *TAG = "HTTP_STREAM";
+
+#define HTTP_STREAM_TIMEOUT_MS (30 * 1000)
+#define HTTP_STREAM_MAX_REDIRECT (3)
+#define HTTP_PLAYLIST_MAX_SIZE (32 * 1024)
+#define HTTP_PLAYLIST_MAX_TRACKS (256)
+
+typedef struct http_stream {
+    audio_stream_type_t type;
+    bool is_open;
+    esp_http_client_handle_t client;
+    http_stream_event_handle_t hook;
+    void *user_data;
+    bool enable_playlist_parser;
+    bool auto_connect_next_track;
+    // the playlist, its tracks are played one after the other by the same element
+    char *playlist_uri;
+    char **tracks;
+    int track_num;
+    int track_index;
+    bool is_playlist_resolved;
+    bool next_pending;
+} http_stream_t;
+
+static int dispatch_hook(audio_element_handle_t self, http_stream_event_id_t type, void *buffer, int buffer_len)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->hook == NULL) {
+        return ESP_OK;
+    }
+    http_stream_event_msg_t msg = {
+        .event_id = type,
+        .http_client = http->client,
+        .buffer = buffer,
+        .buffer_len = buffer_len,
+        .user_data = http->user_data,
+        .el = self,
+    };
+    return http->hook(&msg);
+}
+
+static void _playlist_free(http_stream_t *http)
+{
+    for (int i = 0; i < http->track_num; i++) {
+        audio_free(http->tracks[i]);
+    }
+    audio_free(http->tracks);
+    http->tracks = NULL;
+    http->track_num = 0;
+    http->track_index = 0;
+    http->is_playlist_resolved = false;
+}
+
+static bool _is_playlist(esp_http_client_handle_t client, const char *uri)
+{
+    char *type = NULL;
+    esp_http_client_get_header(client, "Content-Type", &type);
+    if (type && (strcasestr(type, "mpegurl") || strcasestr(type, "scpls"))) {
+        return true;
+    }
+    const char *end = uri + strcspn(uri, "?#");
+    const char *dot = end;
+    while (dot > uri && *dot != '.' && *dot != '/') {
+        dot--;
+    }
+    return (end - dot == 4 && (strncasecmp(dot, ".m3u", 4) == 0 || strncasecmp(dot, ".pls", 4) == 0))
+           || (end - dot == 5 && strncasecmp(dot, ".m3u8", 5) == 0);
+}
+
+// a track relative to the playlist, a leading slash keeps the host only
+static char *_playlist_track_uri(const char *base, const char *line)
+{
+    if (strncasecmp(line, "http://", 7) == 0 || strncasecmp(line, "https://", 8) == 0) {
+        return audio_strdup(line);
+    }
+    const char *host = strstr(base, "://");
+    host = host ? host + 3 : base;
+    int origin = host - base + strcspn(host, "/?#");
+    int keep = origin;
+    if (line[0] != '/') {
+        int end = strcspn(base, "?#");
+        for (int i = origin; i < end; i++) {
+            if (base[i] == '/') {
+                keep = i + 1;
+            }
+        }
+    }
+    char *uri = audio_malloc(keep + strlen(line) + 2);
+    if (uri) {
+        sprintf(uri, "%.*s%s%s", keep, base, keep == origin && line[0] != '/' ? "/" : "", line);
+    }
+    return uri;
+}
+
+// the lines of an m3u, the FileN= entries of a pls, comments and tags skipped
+static esp_err_t _playlist_parse(http_stream_t *http, char *body)
+{
+    _playlist_free(http);
+    http->tracks = audio_calloc(HTTP_PLAYLIST_MAX_TRACKS, sizeof(char *));
+    AUDIO_MEM_CHECK(TAG, http->tracks, return ESP_FAIL);
+    char *save = NULL;
+    for (char *line = strtok_r(body, "\r\n", &save); line && http->track_num < HTTP_PLAYLIST_MAX_TRACKS;
+         line = strtok_r(NULL, "\r\n", &save)) {
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (strncasecmp(line, "File", 4) == 0 && strchr(line, '=')) {
+            line = strchr(line, '=') + 1;
+        } else if (*line == 0 || *line == '#' || *line == '[' || strchr(line, '=')) {
+            continue;
+        }
+        char *track = _playlist_track_uri(http->playlist_uri, line);
+        AUDIO_MEM_CHECK(TAG, track, break);
+        http->tracks[http->track_num++] = track;
+    }
+    if (http->track_num == 0) {
+        ESP_LOGE(TAG, "No track in the playlist %s", http->playlist_uri);
+        _playlist_free(http);
+        return ESP_FAIL;
+    }
+    http->is_playlist_resolved = true;
+    ESP_LOGI(TAG, "Playlist %s has %d tracks", http->playlist_uri, http->track_num);
+    return ESP_OK;
+}
+
+static esp_err_t _playlist_read(audio_element_handle_t self, const char *uri)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    char *body = audio_malloc(HTTP_PLAYLIST_MAX_SIZE + 1);
+    AUDIO_MEM_CHECK(TAG, body, return ESP_FAIL);
+    int len = 0, rlen;
+    while (len < HTTP_PLAYLIST_MAX_SIZE
+           && (rlen = esp_http_client_read(http->client, body + len, HTTP_PLAYLIST_MAX_SIZE - len)) > 0) {
+        len += rlen;
+    }
+    body[len] = 0;
+    audio_free(http->playlist_uri);
+    http->playlist_uri = audio_strdup(uri);
+    esp_err_t err = http->playlist_uri ? _playlist_parse(http, body) : ESP_FAIL;
+    audio_free(body);
+    if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
+    dispatch_hook(self, HTTP_STREAM_RESOLVE_ALL_TRACKS, NULL, 0);
+    return ESP_OK;
+}
+
+static void _http_client_release(http_stream_t *http)
+{
+    if (http->client) {
+        esp_http_client_close(http->client);
+        esp_http_client_cleanup(http->client);
+        http->client = NULL;
+    }
+}
+
+static esp_err_t _http_connect(audio_element_handle_t self, const char *uri, int write_len)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    esp_http_client_config_t http_cfg = {
+        .url = uri,
+        .user_data = self,
+        .timeout_ms = HTTP_STREAM_TIMEOUT_MS,
+    };
+    http->client = esp_http_client_init(&http_cfg);
+    AUDIO_NULL_CHECK(TAG, http->client, return ESP_FAIL);
+
+    audio_element_info_t info;
+    audio_element_getinfo(self, &info);
+    if (http->type == AUDIO_STREAM_READER && info.byte_pos > 0) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%lld-", (long long)info.byte_pos);
+        esp_http_client_set_header(http->client, "Range", range);
+    }
+    if (dispatch_hook(self, HTTP_STREAM_PRE_REQUEST, NULL, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to process user callback");
+        return ESP_FAIL;
+    }
+    if (http->type == AUDIO_STREAM_WRITER) {
+        return esp_http_client_open(http->client, write_len);
+    }
+
+    char *post = NULL;
+    int post_len = esp_http_client_get_post_field(http->client, &post);
+    for (int redirect = 0;; redirect++) {
+        if (esp_http_client_open(http->client, post_len) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open http stream %s", uri);
+            return ESP_FAIL;
+        }
+        int wrlen = dispatch_hook(self, HTTP_STREAM_ON_REQUEST, post, post_len);
+        if (wrlen < 0) {
+            ESP_LOGE(TAG, "Failed to process user callback");
+            return ESP_FAIL;
+        }
+        if (post_len && wrlen == 0 && esp_http_client_write(http->client, post, post_len) <= 0) {
+            ESP_LOGE(TAG, "Failed to write data to http stream");
+            return ESP_FAIL;
+        }
+        if (dispatch_hook(self, HTTP_STREAM_POST_REQUEST, NULL, 0) < 0) {
+            return ESP_FAIL;
+        }
+        int64_t length = esp_http_client_fetch_headers(http->client);
+        int status = esp_http_client_get_status_code(http->client);
+        if (status >= 300 && status < 400 && redirect < HTTP_STREAM_MAX_REDIRECT
+            && esp_http_client_set_redirection(http->client) == ESP_OK) {
+            continue;
+        }
+        if (status != 200 && status != 206) {
+            ESP_LOGE(TAG, "Status %d for %s", status, uri);
+            return ESP_FAIL;
+        }
+        if (length > 0) {
+            info.total_bytes = (status == 206 ? info.byte_pos : 0) + length;
+        }
+        if (status == 200) {
+            // the server ignored the Range header
+            info.byte_pos = 0;
+        }
+        audio_element_setinfo(self, &info);
+        return dispatch_hook(self, HTTP_STREAM_FINISH_REQUEST, NULL, 0) < 0 ? ESP_FAIL : ESP_OK;
+    }
+}
+
+static esp_err_t _http_open(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->is_open) {
+        ESP_LOGE(TAG, "already opened");
+        return ESP_OK;
+    }
+    char *uri = audio_element_get_uri(self);
+    if (uri == NULL) {
+        ESP_LOGE(TAG, "Error open connection, uri = NULL");
+        return ESP_FAIL;
+    }
+    if (http->is_playlist_resolved && strcmp(uri, http->playlist_uri) != 0) {
+        // a new uri was set since the playlist was resolved
+        _playlist_free(http);
+    }
+    if (http->is_playlist_resolved) {
+        uri = http->tracks[http->track_index < http->track_num ? http->track_index : 0];
+    }
+    ESP_LOGD(TAG, "URI=%s", uri);
+
+    if (_http_connect(self, uri, -1) != ESP_OK) {
+        _http_client_release(http);
+        return ESP_FAIL;
+    }
+    if (http->type == AUDIO_STREAM_READER && http->enable_playlist_parser && !http->is_playlist_resolved
+        && _is_playlist(http->client, uri)) {
+        esp_err_t err = _playlist_read(self, uri);
+        _http_client_release(http);
+        if (err != ESP_OK) {
+            return ESP_FAIL;
+        }
+        audio_element_set_byte_pos(self, 0);
+        audio_element_set_total_bytes(self, 0);
+        return _http_open(self);
+    }
+    http->is_open = true;
+    return ESP_OK;
+}
+
+// the next track of the playlist on the same element, between two reads
+static esp_err_t _http_reconnect(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    http->next_pending = false;
+    http->is_open = false;
+    _http_client_release(http);
+    audio_element_set_byte_pos(self, 0);
+    audio_element_set_total_bytes(self, 0);
+    return _http_open(self);
+}
+
+static int _http_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    for (;;) {
+        int rlen = esp_http_client_read(http->client, buffer, len);
+        if (rlen > 0) {
+            audio_element_update_byte_pos(self, rlen);
+            dispatch_hook(self, HTTP_STREAM_ON_RESPONSE, buffer, rlen);
+            return rlen;
+        }
+        if (rlen < 0) {
+            ESP_LOGE(TAG, "Read failed, errno %d", esp_http_client_get_errno(http->client));
+            return ESP_FAIL;
+        }
+        if (http->auto_connect_next_track) {
+            http_stream_next_track(self);
+        } else if (dispatch_hook(self, HTTP_STREAM_FINISH_TRACK, NULL, 0) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to process user callback");
+            return ESP_FAIL;
+        }
+        if (http->is_playlist_resolved && !http->next_pending && http->track_index >= http->track_num) {
+            if (dispatch_hook(self, HTTP_STREAM_FINISH_PLAYLIST, NULL, 0) != ESP_OK) {
+                return ESP_FAIL;
+            }
+        }
+        if (!http->next_pending) {
+            ESP_LOGD(TAG, "No more data");
+            return 0;
+        }
+        if (_http_reconnect(self) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+}
+
+static int _http_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    int wrlen = dispatch_hook(self, HTTP_STREAM_ON_REQUEST, buffer, len);
+    if (wrlen < 0) {
+        ESP_LOGE(TAG, "Failed to write");
+        return ESP_FAIL;
+    }
+    if (wrlen > 0) {
+        return wrlen;
+    }
+    if ((wrlen = esp_http_client_write(http->client, buffer, len)) <= 0) {
+        ESP_LOGE(TAG, "Failed to write data to http stream, wrlen=%d", wrlen);
+        return ESP_FAIL;
+    }
+    audio_element_update_byte_pos(self, wrlen);
+    return wrlen;
+}
+
+static int _http_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        w_size = audio_element_output(self, in_buffer, r_size);
+        http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+        if (http->type == AUDIO_STREAM_READER && w_size > 0) {
+            audio_element_multi_output(self, in_buffer, w_size, 0);
+        }
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+static esp_err_t _http_close(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    if (http->is_open) {
+        http->is_open = false;
+        do {
+            if (http->type != AUDIO_STREAM_WRITER) {
+                break;
+            }
+            if (dispatch_hook(self, HTTP_STREAM_POST_REQUEST, NULL, 0) < 0) {
+                break;
+            }
+            esp_http_client_fetch_headers(http->client);
+            if (dispatch_hook(self, HTTP_STREAM_FINISH_REQUEST, NULL, 0) < 0) {
+                break;
+            }
+        } while (0);
+    }
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_report_pos(self);
+        audio_element_set_byte_pos(self, 0);
+        _http_client_release(http);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _http_destroy(audio_element_handle_t self)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(self);
+    _http_client_release(http);
+    _playlist_free(http);
+    audio_free(http->playlist_uri);
+    audio_free(http);
+    return ESP_OK;
+}
+
+esp_err_t http_stream_next_track(audio_element_handle_t el)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(el);
+    if (!(http->enable_playlist_parser && http->is_playlist_resolved)) {
+        // a direct URI, the stream just ends
+        return ESP_OK;
+    }
+    if (http->track_index + 1 < http->track_num) {
+        http->track_index++;
+        http->next_pending = true;
+    } else {
+        http->track_index = http->track_num;
+        http->next_pending = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t http_stream_restart(audio_element_handle_t el)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(el);
+    if (!http->is_playlist_resolved) {
+        return ESP_OK;
+    }
+    http->track_index = 0;
+    http->next_pending = true;
+    return ESP_OK;
+}
+
+esp_err_t http_stream_fetch_again(audio_element_handle_t el)
+{
+    http_stream_t *http = (http_stream_t *)audio_element_getdata(el);
+    if (!http->is_playlist_resolved) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // the playlist uri is still the element uri, it is resolved again on the reconnect
+    _playlist_free(http);
+    http->next_pending = true;
+    return ESP_OK;
+}
+
+audio_element_handle_t http_stream_init(http_stream_cfg_t *config)
+{
+    http_stream_t *http = audio_calloc(1, sizeof(http_stream_t));
+    AUDIO_MEM_CHECK(TAG, http, return NULL);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _http_open;
+    cfg.close = _http_close;
+    cfg.process = _http_process;
+    cfg.destroy = _http_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.multi_out_rb_num = config->multi_out_num;
+    cfg.tag = "http";
+
+    http->type = config->type;
+    http->hook = config->event_handle;
+    http->user_data = config->user_data;
+    http->enable_playlist_parser = config->enable_playlist_parser;
+    http->auto_connect_next_track = config->auto_connect_next_track;
+    if (config->type == AUDIO_STREAM_READER) {
+        cfg.read = _http_read;
+    } else if (config->type == AUDIO_STREAM_WRITER) {
+        cfg.write = _http_write;
+    }
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        audio_free(http);
+        return NULL;
+    });
+    audio_element_setdata(el, http);
+    return el;
+}
@@ -0,0 +1,410 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/i2s.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define I2S_WAV_HEAD_SIZE (44)
+// how far the writer may run ahead of the clock, the DMA buffers of the board
+#define I2S_AHEAD_DEFAULT_US (20000)
+
+static const char *TAG = "HOST_I2S";
+
+typedef struct {
+    int fd;
+    bool wav;
+    uint32_t data_bytes;
+    // pacing: frames moved since the clock started
+    int64_t start_us;
+    uint64_t frames;
+    int64_t ahead_us;
+} i2s_host_dir_t;
+
+typedef struct {
+    bool installed;
+    i2s_mode_t mode;
+    uint32_t rate;
+    int bits;
+    int channels;
+    i2s_host_dir_t tx;
+    i2s_host_dir_t rx;
+    int in_channels;
+    portMUX_TYPE lock;
+} i2s_host_port_t;
+
+static i2s_host_port_t ports[I2S_NUM_MAX] = {
+    { .tx = { .fd = -1 }, .rx = { .fd = -1 }, .lock = portMUX_INITIALIZER_UNLOCKED },
+    { .tx = { .fd = -1 }, .rx = { .fd = -1 }, .lock = portMUX_INITIALIZER_UNLOCKED },
+};
+static bool free_running;
+static bool exit_hooked;
+
+static void i2s_put_le(uint8_t *p, uint32_t v, int n)
+{
+    for (int i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t i2s_get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static int i2s_frame_bytes(i2s_host_port_t *p, int channels)
+{
+    return (p->bits / 8) * channels;
+}
+
+static void i2s_write_head(i2s_host_port_t *p)
+{
+    uint8_t head[I2S_WAV_HEAD_SIZE];
+    int block = i2s_frame_bytes(p, p->channels);
+    memcpy(head, "RIFF", 4);
+    i2s_put_le(head + 4, 36 + p->tx.data_bytes, 4);
+    memcpy(head + 8, "WAVEfmt ", 8);
+    i2s_put_le(head + 16, 16, 4);
+    i2s_put_le(head + 20, 1, 2);
+    i2s_put_le(head + 22, p->channels, 2);
+    i2s_put_le(head + 24, p->rate, 4);
+    i2s_put_le(head + 28, p->rate * block, 4);
+    i2s_put_le(head + 32, block, 2);
+    i2s_put_le(head + 34, p->bits, 2);
+    memcpy(head + 36, "data", 4);
+    i2s_put_le(head + 40, p->tx.data_bytes, 4);
+    if (pwrite(p->tx.fd, head, sizeof(head), 0) != sizeof(head)) {
+        ESP_LOGE(TAG, "failed to write the WAV header, %s", strerror(errno));
+    }
+}
+
+static void i2s_finish_all(void)
+{
+    for (int i = 0; i < I2S_NUM_MAX; i++) {
+        i2s_host_port_t *p = &ports[i];
+        if (p->tx.fd >= 0 && p->tx.wav) {
+            i2s_write_head(p);
+        }
+    }
+}
+
+static void i2s_open_out(i2s_host_port_t *p, i2s_port_t port)
+{
+    const char *path = getenv(port == I2S_NUM_0 ? "AUDIO_HOST_I2S_OUT" : "AUDIO_HOST_I2S1_OUT");
+    if (path == NULL || *path == 0) {
+        return;
+    }
+    p->tx.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (p->tx.fd < 0) {
+        ESP_LOGE(TAG, "failed to open %s, %s", path, strerror(errno));
+        return;
+    }
+    const char *dot = strrchr(path, '.');
+    p->tx.wav = dot && strcasecmp(dot, ".wav") == 0;
+    p->tx.data_bytes = 0;
+    if (p->tx.wav) {
+        i2s_write_head(p);
+        lseek(p->tx.fd, I2S_WAV_HEAD_SIZE, SEEK_SET);
+    }
+    if (!exit_hooked) {
+        // a script may end without deinit, the header still gets its sizes
+        atexit(i2s_finish_all);
+        exit_hooked = true;
+    }
+    ESP_LOGI(TAG, "port %d output to %s", port, path);
+}
+
+static void i2s_open_in(i2s_host_port_t *p, i2s_port_t port)
+{
+    const char *path = getenv(port == I2S_NUM_0 ? "AUDIO_HOST_I2S_IN" : "AUDIO_HOST_I2S1_IN");
+    p->in_channels = 0;
+    if (path == NULL || *path == 0) {
+        return;
+    }
+    p->rx.fd = open(path, O_RDONLY);
+    if (p->rx.fd < 0) {
+        ESP_LOGE(TAG, "failed to open %s, %s", path, strerror(errno));
+        return;
+    }
+    // a WAV file is read from its data chunk, a mono one feeds both channels
+    uint8_t head[I2S_WAV_HEAD_SIZE];
+    if (read(p->rx.fd, head, sizeof(head)) == sizeof(head) && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WAVE", 4) == 0) {
+        off_t pos = 12;
+        uint8_t chunk[8];
+        while (pread(p->rx.fd, chunk, sizeof(chunk), pos) == sizeof(chunk)) {
+            uint32_t size = i2s_get_le(chunk + 4, 4);
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && pread(p->rx.fd, head, 16, pos + 8) == 16) {
+                p->in_channels = i2s_get_le(head + 2, 2);
+                uint32_t rate = i2s_get_le(head + 4, 4);
+                int bits = i2s_get_le(head + 14, 2);
+                if (rate != p->rate || bits != 16) {
+                    ESP_LOGW(TAG, "%s is %d Hz %d bits, the port runs %d Hz 16 bits", path, (int)rate, bits, (int)p->rate);
+                }
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                lseek(p->rx.fd, pos + 8, SEEK_SET);
+                break;
+            }
+            pos += 8 + size + (size & 1);
+        }
+    } else {
+        lseek(p->rx.fd, 0, SEEK_SET);
+    }
+    ESP_LOGI(TAG, "port %d input from %s", port, path);
+}
+
+static void i2s_clock_restart(i2s_host_dir_t *dir)
+{
+    dir->start_us = esp_timer_get_time();
+    dir->frames = 0;
+}
+
+// sleep until the clock has caught up with the frames moved, less what the DMA holds
+static void i2s_pace(i2s_host_port_t *p, i2s_host_dir_t *dir, size_t frames)
+{
+    if (free_running || p->rate == 0) {
+        return;
+    }
+    dir->frames += frames;
+    int64_t due = dir->start_us + (int64_t)(dir->frames * 1000000 / p->rate);
+    int64_t now = esp_timer_get_time();
+    if (now > due + 100000) {
+        // an underrun, the clock kept running while nothing was written
+        dir->start_us = now - (int64_t)(dir->frames * 1000000 / p->rate);
+        return;
+    }
+    int64_t wait = due - dir->ahead_us - now;
+    if (wait > 0) {
+        struct timespec ts = { .tv_sec = wait / 1000000, .tv_nsec = (wait % 1000000) * 1000 };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *config, int queue_size, void *queue)
+{
+    if (port >= I2S_NUM_MAX || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    i2s_host_port_t *p = &ports[port];
+    const char *pacing = getenv("AUDIO_HOST_PACING");
+    free_running = pacing && strcmp(pacing, "free") == 0;
+    if (p->installed) {
+        // ADF installs again for the second direction of a full-duplex port
+        if ((p->mode & I2S_MODE_TX) == 0 && (config->mode & I2S_MODE_TX)) {
+            i2s_open_out(p, port);
+        }
+        if ((p->mode & I2S_MODE_RX) == 0 && (config->mode & I2S_MODE_RX)) {
+            i2s_open_in(p, port);
+        }
+        p->mode |= config->mode;
+        return ESP_OK;
+    }
+    p->installed = true;
+    p->mode = config->mode;
+    p->rate = config->sample_rate;
+    p->bits = config->bits_per_sample ? config->bits_per_sample : 16;
+    p->channels = config->channel_format >= I2S_CHANNEL_FMT_ONLY_RIGHT ? 1 : 2;
+    int64_t ahead = (int64_t)config->dma_buf_count * config->dma_buf_len * 1000000 / (p->rate ? p->rate : 1);
+    p->tx.ahead_us = ahead > 0 ? ahead : I2S_AHEAD_DEFAULT_US;
+    p->rx.ahead_us = 0;
+    if (config->mode & I2S_MODE_TX) {
+        i2s_open_out(p, port);
+    }
+    if (config->mode & I2S_MODE_RX) {
+        i2s_open_in(p, port);
+    }
+    i2s_clock_restart(&p->tx);
+    i2s_clock_restart(&p->rx);
+    return ESP_OK;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t port)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    i2s_host_port_t *p = &ports[port];
+    portENTER_CRITICAL(&p->lock);
+    if (p->tx.fd >= 0) {
+        if (p->tx.wav) {
+            i2s_write_head(p);
+        }
+        close(p->tx.fd);
+        p->tx.fd = -1;
+    }
+    if (p->rx.fd >= 0) {
+        close(p->rx.fd);
+        p->rx.fd = -1;
+    }
+    p->installed = false;
+    portEXIT_CRITICAL(&p->lock);
+    return ESP_OK;
+}
+
+esp_err_t i2s_write(i2s_port_t port, const void *src, size_t size, size_t *bytes_written, TickType_t ticks_to_wait)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    i2s_host_port_t *p = &ports[port];
+    portENTER_CRITICAL(&p->lock);
+    if (p->tx.fd >= 0) {
+        const uint8_t *data = (const uint8_t *)src;
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = write(p->tx.fd, data + done, size - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                ESP_LOGE(TAG, "output write failed, %s", strerror(errno));
+                break;
+            }
+            done += n;
+        }
+        p->tx.data_bytes += done;
+    }
+    portEXIT_CRITICAL(&p->lock);
+    // the bytes are taken whether or not there is a file, like the DMA does
+    *bytes_written = size;
+    i2s_pace(p, &p->tx, size / i2s_frame_bytes(p, p->channels));
+    return ESP_OK;
+}
+
+esp_err_t i2s_read(i2s_port_t port, void *dest, size_t size, size_t *bytes_read, TickType_t ticks_to_wait)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    i2s_host_port_t *p = &ports[port];
+    int frame = i2s_frame_bytes(p, p->channels);
+    size -= size % frame;
+    uint8_t *out = (uint8_t *)dest;
+    size_t got = 0;
+    portENTER_CRITICAL(&p->lock);
+    if (p->rx.fd >= 0) {
+        // a mono file is read into the second half and spread over both channels
+        bool spread = p->in_channels == 1 && p->channels == 2;
+        size_t want = spread ? size / 2 : size;
+        uint8_t *buf = spread ? out + size / 2 : out;
+        while (got < want) {
+            ssize_t n = read(p->rx.fd, buf + got, want - got);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+        }
+        int sample = p->bits / 8;
+        got -= got % sample;
+        if (spread) {
+            for (size_t i = 0; i < got; i += sample) {
+                memmove(out + 2 * i, buf + i, sample);
+                memcpy(out + 2 * i + sample, out + 2 * i, sample);
+            }
+            got *= 2;
+        }
+    }
+    portEXIT_CRITICAL(&p->lock);
+    // the microphone never stops, silence after the end of the file
+    memset(out + got, 0, size - got);
+    *bytes_read = size;
+    i2s_pace(p, &p->rx, size / frame);
+    return ESP_OK;
+}
+
+esp_err_t i2s_set_clk(i2s_port_t port, uint32_t rate, uint32_t bits_cfg, i2s_channel_t ch)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    i2s_host_port_t *p = &ports[port];
+    portENTER_CRITICAL(&p->lock);
+    bool changed = p->rate != rate || p->bits != (int)(bits_cfg & 0xffff) || p->channels != (int)ch;
+    if (changed && p->tx.wav && p->tx.data_bytes) {
+        // one WAV file holds one format, the header keeps the last one
+        ESP_LOGW(TAG, "output format changes to %d Hz %d ch after %d bytes", (int)rate, (int)ch, (int)p->tx.data_bytes);
+    }
+    p->rate = rate;
+    p->bits = bits_cfg & 0xffff;
+    p->channels = ch;
+    if (p->tx.fd >= 0 && p->tx.wav) {
+        i2s_write_head(p);
+    }
+    portEXIT_CRITICAL(&p->lock);
+    i2s_clock_restart(&p->tx);
+    i2s_clock_restart(&p->rx);
+    return ESP_OK;
+}
+
+esp_err_t i2s_set_sample_rates(i2s_port_t port, uint32_t rate)
+{
+    if (port >= I2S_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return i2s_set_clk(port, rate, ports[port].bits, (i2s_channel_t)ports[port].channels);
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // nothing is buffered, the clock starts over with the next write
+    i2s_clock_restart(&ports[port].tx);
+    return ESP_OK;
+}
+
+esp_err_t i2s_start(i2s_port_t port)
+{
+    if (port >= I2S_NUM_MAX || !ports[port].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    i2s_clock_restart(&ports[port].tx);
+    i2s_clock_restart(&ports[port].rx);
+    return ESP_OK;
+}
+
+esp_err_t i2s_stop(i2s_port_t port)
+{
+    return port < I2S_NUM_MAX && ports[port].installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
@@ -0,0 +1,207 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "esp_log.h"
+#include "i2s_stream.h"
+
+static const char *TAG = "I2S_STREAM";
+
+typedef struct i2s_stream {
+    audio_stream_type_t type;
+    i2s_port_t port;
+    bool uninstall_drv;
+    int volume;
+    bool is_open;
+} i2s_stream_t;
+
+static esp_err_t _i2s_open(audio_element_handle_t self)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    if (i2s->is_open) {
+        return ESP_OK;
+    }
+    i2s_start(i2s->port);
+    i2s->is_open = true;
+    return ESP_OK;
+}
+
+static int _i2s_read(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    size_t bytes_read = 0;
+    i2s_read(i2s->port, buffer, len, &bytes_read, ticks_to_wait);
+    if (bytes_read > 0) {
+        audio_element_info_t info;
+        audio_element_getinfo(self, &info);
+        info.byte_pos += bytes_read;
+        audio_element_setinfo(self, &info);
+    }
+    return bytes_read;
+}
+
+static int _i2s_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    size_t bytes_written = 0;
+    if (i2s_write(i2s->port, buffer, len, &bytes_written, ticks_to_wait) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (bytes_written > 0) {
+        audio_element_info_t info;
+        audio_element_getinfo(self, &info);
+        info.byte_pos += bytes_written;
+        audio_element_setinfo(self, &info);
+    }
+    return bytes_written;
+}
+
+static int _i2s_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        w_size = audio_element_output(self, in_buffer, r_size);
+        i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+        if (i2s->type == AUDIO_STREAM_READER && w_size > 0) {
+            audio_element_multi_output(self, in_buffer, w_size, 0);
+        }
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+static esp_err_t _i2s_close(audio_element_handle_t self)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    if (i2s->type == AUDIO_STREAM_WRITER) {
+        i2s_zero_dma_buffer(i2s->port);
+    }
+    i2s->is_open = false;
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_report_pos(self);
+        audio_element_info_t info = { 0 };
+        audio_element_getinfo(self, &info);
+        info.byte_pos = 0;
+        audio_element_setinfo(self, &info);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _i2s_destroy(audio_element_handle_t self)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    if (i2s->uninstall_drv) {
+        i2s_driver_uninstall(i2s->port);
+    }
+    audio_free(i2s);
+    return ESP_OK;
+}
+
+esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bits, int ch)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    audio_element_info_t info;
+    audio_element_getinfo(i2s_stream, &info);
+    if (info.sample_rates == rate && info.bits == bits && info.channels == ch) {
+        return ESP_OK;
+    }
+    if (i2s_set_clk(i2s->port, rate, bits, (i2s_channel_t)ch) != ESP_OK) {
+        ESP_LOGE(TAG, "i2s_set_clk failed, rate:%d, bits:%d, ch:%d", rate, bits, ch);
+        return ESP_FAIL;
+    }
+    audio_element_set_music_info(i2s_stream, rate, ch, bits);
+    return ESP_OK;
+}
+
+esp_err_t i2s_alc_volume_set(audio_element_handle_t i2s_stream, int volume)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    i2s->volume = volume;
+    return ESP_OK;
+}
+
+esp_err_t i2s_alc_volume_get(audio_element_handle_t i2s_stream, int *volume)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    *volume = i2s->volume;
+    return ESP_OK;
+}
+
+audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
+{
+    i2s_stream_t *i2s = audio_calloc(1, sizeof(i2s_stream_t));
+    AUDIO_MEM_CHECK(TAG, i2s, return NULL);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _i2s_open;
+    cfg.close = _i2s_close;
+    cfg.process = _i2s_process;
+    cfg.destroy = _i2s_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.multi_out_rb_num = config->multi_out_num;
+    cfg.tag = "iis";
+    cfg.buffer_len = config->buffer_len ? config->buffer_len : I2S_STREAM_BUF_SIZE;
+
+    i2s->type = config->type;
+    i2s->port = config->i2s_port;
+    i2s->uninstall_drv = config->uninstall_drv;
+    i2s->volume = config->volume;
+    if (config->type == AUDIO_STREAM_READER) {
+        cfg.read = _i2s_read;
+    } else if (config->type == AUDIO_STREAM_WRITER) {
+        cfg.write = _i2s_write;
+    }
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        audio_free(i2s);
+        return NULL;
+    });
+    audio_element_setdata(el, i2s);
+
+    i2s_config_t i2s_config = config->i2s_config;
+    i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER | (config->type == AUDIO_STREAM_READER ? I2S_MODE_RX : I2S_MODE_TX));
+    if (i2s_driver_install(i2s->port, &i2s_config, 0, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "i2s_driver_install failed");
+        audio_element_deinit(el);
+        return NULL;
+    }
+    int ch = i2s_config.channel_format >= I2S_CHANNEL_FMT_ONLY_RIGHT ? 1 : 2;
+    audio_element_set_music_info(el, i2s_config.sample_rate, ch, i2s_config.bits_per_sample);
+    ESP_LOGD(TAG, "i2s_stream_init %s, rate:%d, ch:%d", config->type == AUDIO_STREAM_READER ? "reader" : "writer",
+             (int)i2s_config.sample_rate, ch);
+    return el;
+}
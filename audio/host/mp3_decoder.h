@@ -0,0 +1,73 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _MP3_DECODER_H_
+#define _MP3_DECODER_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      MP3 decoder configurations
+ */
+typedef struct {
+    int out_rb_size;   /*!< Size of output ringbuffer */
+    int task_stack;    /*!< Task stack size */
+    int task_core;     /*!< Task running in core (0 or 1) */
+    int task_prio;     /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext; /*!< Try to allocate stack in external memory */
+} mp3_decoder_cfg_t;
+
+#define MP3_DECODER_TASK_STACK (5 * 1024)
+#define MP3_DECODER_TASK_CORE (0)
+#define MP3_DECODER_TASK_PRIO (5)
+#define MP3_DECODER_RINGBUFFER_SIZE (2 * 1024)
+
+#define DEFAULT_MP3_DECODER_CONFIG()            \
+{                                               \
+    .out_rb_size = MP3_DECODER_RINGBUFFER_SIZE, \
+    .task_stack = MP3_DECODER_TASK_STACK,       \
+    .task_core = MP3_DECODER_TASK_CORE,         \
+    .task_prio = MP3_DECODER_TASK_PRIO,         \
+    .stack_in_ext = true,                       \
+}
+
+/**
+ * @brief      Create an Audio Element handle of the MP3 decoder. The host build has no MP3 decoder
+ *             library, the element fails to open.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The audio element handle
+ */
+audio_element_handle_t mp3_decoder_init(mp3_decoder_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _OPUS_ENCODER_H_
+#define _OPUS_ENCODER_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Opus encoder configurations
+ */
+typedef struct {
+    int sample_rate;   /*!< Sample rate of the PCM input */
+    int channel;       /*!< Channels of the PCM input */
+    int bitrate;       /*!< Bitrate of the encoded stream */
+    int complexity;    /*!< Complexity, 0 to 10 */
+    int out_rb_size;   /*!< Size of output ringbuffer */
+    int task_stack;    /*!< Task stack size */
+    int task_core;     /*!< Task running in core (0 or 1) */
+    int task_prio;     /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext; /*!< Try to allocate stack in external memory */
+} opus_encoder_cfg_t;
+
+#define OPUS_ENCODER_TASK_STACK (40 * 1024)
+#define OPUS_ENCODER_TASK_CORE (0)
+#define OPUS_ENCODER_TASK_PRIO (5)
+#define OPUS_ENCODER_RINGBUFFER_SIZE (8 * 1024)
+
+#define DEFAULT_OPUS_ENCODER_CONFIG()            \
+{                                                \
+    .sample_rate = 16000,                        \
+    .channel = 1,                                \
+    .bitrate = 64000,                            \
+    .complexity = 10,                            \
+    .out_rb_size = OPUS_ENCODER_RINGBUFFER_SIZE, \
+    .task_stack = OPUS_ENCODER_TASK_STACK,       \
+    .task_core = OPUS_ENCODER_TASK_CORE,         \
+    .task_prio = OPUS_ENCODER_TASK_PRIO,         \
+    .stack_in_ext = true,                        \
+}
+
+/**
+ * @brief      Create an Audio Element handle of the Opus encoder. The host build has no Opus encoder
+ *             library, the element fails to open.
+ *
+ * @param      config  The configuration
+ *
+ * @return     The audio element handle
+ */
+audio_element_handle_t encoder_opus_init(opus_encoder_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
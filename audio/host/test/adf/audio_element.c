@@ -0,0 +1,979 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The ESP-ADF element for the native tests. The task, command and state handling follow
+// audio_element.c of ESP-ADF v2.x so the module and the host elements meet the same behaviour
+// they get on the device.
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+
+static const char *TAG = "AUDIO_ELEMENT";
+
+#define DEFAULT_MAX_WAIT_TIME (2000 / portTICK_RATE_MS)
+
+#define STOPPED_BIT (1 << 0)
+#define TASK_CREATED_BIT (1 << 3)
+#define TASK_DESTROYED_BIT (1 << 4)
+#define PAUSED_BIT (1 << 5)
+#define RESUMED_BIT (1 << 6)
+
+typedef enum {
+    IO_TYPE_RB = 1,
+    IO_TYPE_CB,
+} io_type_t;
+
+typedef struct {
+    stream_func cb;
+    void *ctx;
+} stream_cb_t;
+
+typedef struct {
+    int max_rb_num;
+    ringbuf_handle_t *rb;
+} audio_multi_rb_t;
+
+struct audio_element {
+    el_io_func open;
+    ctrl_func seek;
+    process_func process;
+    el_io_func close;
+    el_io_func destroy;
+    io_type_t read_type;
+    io_type_t write_type;
+    stream_cb_t read_cb;
+    stream_cb_t write_cb;
+    ringbuf_handle_t input_rb;
+    ringbuf_handle_t output_rb;
+    audio_multi_rb_t multi_in;
+    audio_multi_rb_t multi_out;
+    audio_event_iface_handle_t iface_event;
+    event_cb_func callback_func;
+    void *callback_ctx;
+    EventGroupHandle_t state_event;
+    SemaphoreHandle_t lock;
+    audio_element_info_t info;
+    audio_element_info_t report_info;
+    char *buf;
+    int buf_size;
+    char *tag;
+    int task_stack;
+    int task_prio;
+    int task_core;
+    int out_rb_size;
+    void *data;
+    TickType_t input_wait_time;
+    TickType_t output_wait_time;
+    volatile audio_element_state_t state;
+    volatile bool is_open;
+    volatile bool task_run;
+    volatile bool is_running;
+    volatile bool stopping;
+};
+
+static esp_err_t audio_element_msg_sendout(audio_element_handle_t el, audio_event_iface_msg_t *msg)
+{
+    msg->source = el;
+    msg->source_type = AUDIO_ELEMENT_TYPE_ELEMENT;
+    if (el->callback_func) {
+        return el->callback_func(el, msg, el->callback_ctx);
+    }
+    return audio_event_iface_sendout(el->iface_event, msg);
+}
+
+static void audio_element_force_set_state(audio_element_handle_t el, audio_element_state_t new_state)
+{
+    el->state = new_state;
+}
+
+static esp_err_t audio_element_cmd_send(audio_element_handle_t el, audio_element_msg_cmd_t cmd)
+{
+    audio_event_iface_msg_t msg = {
+        .source = el,
+        .source_type = AUDIO_ELEMENT_TYPE_ELEMENT,
+        .cmd = cmd,
+    };
+    return audio_event_iface_cmd(el->iface_event, &msg);
+}
+
+static void audio_element_abort_input_ringbuf(audio_element_handle_t el)
+{
+    if (el->read_type == IO_TYPE_RB && el->input_rb) {
+        rb_abort(el->input_rb);
+    }
+    for (int i = 0; i < el->multi_in.max_rb_num; i++) {
+        if (el->multi_in.rb[i]) {
+            rb_abort(el->multi_in.rb[i]);
+        }
+    }
+}
+
+static void audio_element_abort_output_ringbuf(audio_element_handle_t el)
+{
+    if (el->write_type == IO_TYPE_RB && el->output_rb) {
+        rb_abort(el->output_rb);
+    }
+    for (int i = 0; i < el->multi_out.max_rb_num; i++) {
+        if (el->multi_out.rb[i]) {
+            rb_abort(el->multi_out.rb[i]);
+        }
+    }
+}
+
+static void audio_element_close(audio_element_handle_t el)
+{
+    if (el->is_open && el->close) {
+        el->close(el);
+    }
+    el->is_open = false;
+}
+
+static esp_err_t audio_element_on_cmd_error(audio_element_handle_t el)
+{
+    audio_element_close(el);
+    audio_element_force_set_state(el, AEL_STATE_ERROR);
+    audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+    el->is_running = false;
+    el->stopping = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+    return ESP_OK;
+}
+
+static esp_err_t audio_element_on_cmd_stop(audio_element_handle_t el)
+{
+    if (el->state != AEL_STATE_FINISHED && el->state != AEL_STATE_STOPPED) {
+        audio_element_close(el);
+        audio_element_force_set_state(el, AEL_STATE_STOPPED);
+        audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+        audio_element_report_status(el, AEL_STATUS_STATE_STOPPED);
+    } else {
+        // a finished element only changes its state, it was closed already
+        audio_element_force_set_state(el, AEL_STATE_STOPPED);
+        audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+    }
+    el->is_running = false;
+    el->stopping = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+    return ESP_OK;
+}
+
+static esp_err_t audio_element_on_cmd_finish(audio_element_handle_t el)
+{
+    if (el->state == AEL_STATE_ERROR || el->state == AEL_STATE_STOPPED) {
+        return ESP_OK;
+    }
+    audio_element_close(el);
+    audio_element_force_set_state(el, AEL_STATE_FINISHED);
+    audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+    audio_element_report_status(el, AEL_STATUS_STATE_FINISHED);
+    el->is_running = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+    return ESP_OK;
+}
+
+static esp_err_t audio_element_on_cmd_resume(audio_element_handle_t el)
+{
+    if (el->state == AEL_STATE_RUNNING) {
+        xEventGroupSetBits(el->state_event, RESUMED_BIT);
+        return ESP_OK;
+    }
+    if (el->state != AEL_STATE_INIT && el->state != AEL_STATE_PAUSED) {
+        audio_element_reset_output_ringbuf(el);
+    }
+    el->is_running = true;
+    xEventGroupClearBits(el->state_event, STOPPED_BIT);
+    if (!el->is_open) {
+        if (el->open && el->open(el) != ESP_OK) {
+            ESP_LOGE(TAG, "[%s] AEL_STATUS_ERROR_OPEN", el->tag);
+            audio_element_report_status(el, AEL_STATUS_ERROR_OPEN);
+            audio_element_on_cmd_error(el);
+            xEventGroupSetBits(el->state_event, RESUMED_BIT);
+            return ESP_FAIL;
+        }
+        el->is_open = true;
+    }
+    audio_element_force_set_state(el, AEL_STATE_RUNNING);
+    audio_element_report_status(el, AEL_STATUS_STATE_RUNNING);
+    audio_event_iface_set_cmd_waiting_timeout(el->iface_event, 0);
+    xEventGroupSetBits(el->state_event, RESUMED_BIT);
+    return ESP_OK;
+}
+
+static esp_err_t audio_element_on_cmd(audio_event_iface_msg_t *msg, void *context)
+{
+    audio_element_handle_t el = (audio_element_handle_t)context;
+    switch (msg->cmd) {
+        case AEL_MSG_CMD_FINISH:
+            audio_element_on_cmd_finish(el);
+            break;
+        case AEL_MSG_CMD_STOP:
+            audio_element_on_cmd_stop(el);
+            break;
+        case AEL_MSG_CMD_PAUSE:
+            audio_element_force_set_state(el, AEL_STATE_PAUSED);
+            audio_element_report_status(el, AEL_STATUS_STATE_PAUSED);
+            audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+            xEventGroupSetBits(el->state_event, PAUSED_BIT);
+            break;
+        case AEL_MSG_CMD_RESUME:
+            audio_element_on_cmd_resume(el);
+            break;
+        case AEL_MSG_CMD_DESTROY:
+            el->is_running = false;
+            el->task_run = false;
+            return ESP_FAIL;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+static void audio_element_process_running(audio_element_handle_t el)
+{
+    if (!el->is_open || el->state != AEL_STATE_RUNNING) {
+        return;
+    }
+    int process_len = el->process(el, el->buf, el->buf_size);
+    if (process_len > 0) {
+        return;
+    }
+    switch (process_len) {
+        case AEL_IO_ABORT:
+            ESP_LOGD(TAG, "[%s] ERROR_PROCESS, AEL_IO_ABORT", el->tag);
+            audio_element_on_cmd_stop(el);
+            break;
+        case AEL_IO_DONE:
+        case AEL_IO_OK:
+            // reset_state was called from a callback, the element opens again
+            if (el->state == AEL_STATE_INIT) {
+                el->is_open = false;
+                audio_element_on_cmd_resume(el);
+                break;
+            }
+            audio_element_set_ringbuf_done(el);
+            audio_element_on_cmd_finish(el);
+            break;
+        case AEL_IO_FAIL:
+        case AEL_PROCESS_FAIL:
+            ESP_LOGE(TAG, "[%s] ERROR_PROCESS, AEL_IO_FAIL", el->tag);
+            audio_element_report_status(el, AEL_STATUS_ERROR_PROCESS);
+            audio_element_on_cmd_error(el);
+            break;
+        case AEL_IO_TIMEOUT:
+            break;
+        default:
+            ESP_LOGW(TAG, "[%s] Process return error,ret:%d", el->tag, process_len);
+            break;
+    }
+}
+
+static void audio_element_task(void *pv)
+{
+    audio_element_handle_t el = (audio_element_handle_t)pv;
+    el->task_run = true;
+    xEventGroupSetBits(el->state_event, TASK_CREATED_BIT);
+    audio_event_iface_set_cmd_waiting_timeout(el->iface_event, portMAX_DELAY);
+    if (el->buf_size > 0) {
+        el->buf = audio_calloc(1, el->buf_size);
+    }
+    while (el->task_run) {
+        if (audio_event_iface_waiting_cmd_msg(el->iface_event) != ESP_OK) {
+            xEventGroupSetBits(el->state_event, STOPPED_BIT);
+            continue;
+        }
+        audio_element_process_running(el);
+    }
+    if (el->is_open && el->close) {
+        el->close(el);
+        audio_element_force_set_state(el, AEL_STATE_STOPPED);
+    }
+    el->is_open = false;
+    audio_free(el->buf);
+    el->buf = NULL;
+    el->stopping = false;
+    xEventGroupClearBits(el->state_event, STOPPED_BIT);
+    xEventGroupSetBits(el->state_event, TASK_DESTROYED_BIT);
+    vTaskDelete(NULL);
+}
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config)
+{
+    audio_element_handle_t el = audio_calloc(1, sizeof(struct audio_element));
+    AUDIO_MEM_CHECK(TAG, el, return NULL);
+
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    evt_cfg.on_cmd = audio_element_on_cmd;
+    evt_cfg.context = el;
+    // an element has no queue set, others listen to it
+    evt_cfg.queue_set_size = 0;
+    el->iface_event = audio_event_iface_init(&evt_cfg);
+    el->state_event = xEventGroupCreate();
+    el->lock = xSemaphoreCreateMutex();
+    if (el->iface_event == NULL || el->state_event == NULL || el->lock == NULL) {
+        goto _element_init_failed;
+    }
+    if (config->multi_in_rb_num > 0) {
+        el->multi_in.rb = audio_calloc(config->multi_in_rb_num, sizeof(ringbuf_handle_t));
+        AUDIO_MEM_CHECK(TAG, el->multi_in.rb, goto _element_init_failed);
+        el->multi_in.max_rb_num = config->multi_in_rb_num;
+    }
+    if (config->multi_out_rb_num > 0) {
+        el->multi_out.rb = audio_calloc(config->multi_out_rb_num, sizeof(ringbuf_handle_t));
+        AUDIO_MEM_CHECK(TAG, el->multi_out.rb, goto _element_init_failed);
+        el->multi_out.max_rb_num = config->multi_out_rb_num;
+    }
+
+    el->open = config->open;
+    el->seek = config->seek;
+    el->process = config->process;
+    el->close = config->close;
+    el->destroy = config->destroy;
+    if (config->read) {
+        el->read_type = IO_TYPE_CB;
+        el->read_cb.cb = config->read;
+    } else {
+        el->read_type = IO_TYPE_RB;
+    }
+    if (config->write) {
+        el->write_type = IO_TYPE_CB;
+        el->write_cb.cb = config->write;
+    } else {
+        el->write_type = IO_TYPE_RB;
+    }
+    el->buf_size = config->buffer_len > 0 ? config->buffer_len : DEFAULT_ELEMENT_BUFFER_LENGTH;
+    el->out_rb_size = config->out_rb_size > 0 ? config->out_rb_size : DEFAULT_ELEMENT_RINGBUF_SIZE;
+    el->task_stack = config->task_stack;
+    el->task_prio = config->task_prio;
+    el->task_core = config->task_core;
+    el->data = config->data;
+    el->input_wait_time = portMAX_DELAY;
+    el->output_wait_time = portMAX_DELAY;
+    audio_element_set_tag(el, config->tag ? config->tag : "unknown");
+    audio_element_force_set_state(el, AEL_STATE_INIT);
+    return el;
+
+_element_init_failed:
+    if (el->iface_event) {
+        audio_event_iface_destroy(el->iface_event);
+    }
+    if (el->state_event) {
+        vEventGroupDelete(el->state_event);
+    }
+    if (el->lock) {
+        vSemaphoreDelete(el->lock);
+    }
+    audio_free(el->multi_in.rb);
+    audio_free(el->multi_out.rb);
+    audio_free(el);
+    return NULL;
+}
+
+esp_err_t audio_element_deinit(audio_element_handle_t el)
+{
+    audio_element_stop(el);
+    audio_element_wait_for_stop(el);
+    audio_element_terminate(el);
+    audio_event_iface_destroy(el->iface_event);
+    vEventGroupDelete(el->state_event);
+    vSemaphoreDelete(el->lock);
+    if (el->destroy) {
+        el->destroy(el);
+    }
+    audio_free(el->info.uri);
+    audio_free(el->tag);
+    audio_free(el->multi_in.rb);
+    audio_free(el->multi_out.rb);
+    audio_free(el);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data)
+{
+    el->data = data;
+    return ESP_OK;
+}
+
+void *audio_element_getdata(audio_element_handle_t el)
+{
+    return el->data;
+}
+
+esp_err_t audio_element_set_tag(audio_element_handle_t el, const char *tag)
+{
+    audio_free(el->tag);
+    el->tag = NULL;
+    if (tag) {
+        el->tag = audio_strdup(tag);
+        AUDIO_MEM_CHECK(TAG, el->tag, return ESP_ERR_NO_MEM);
+    }
+    return ESP_OK;
+}
+
+char *audio_element_get_tag(audio_element_handle_t el)
+{
+    return el->tag;
+}
+
+esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    if (info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    // the uri belongs to the element, audio_element_set_uri changes it
+    char *uri = el->info.uri;
+    memcpy(&el->info, info, sizeof(audio_element_info_t));
+    el->info.uri = uri;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    if (info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    memcpy(info, &el->info, sizeof(audio_element_info_t));
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    audio_free(el->info.uri);
+    el->info.uri = uri ? audio_strdup(uri) : NULL;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+char *audio_element_get_uri(audio_element_handle_t el)
+{
+    return el->info.uri;
+}
+
+esp_err_t audio_element_set_music_info(audio_element_handle_t el, int sample_rates, int channels, int bits)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    el->info.sample_rates = sample_rates;
+    el->info.channels = channels;
+    el->info.bits = bits;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_codec_fmt(audio_element_handle_t el, int format)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    el->info.codec_fmt = format;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_byte_pos(audio_element_handle_t el, int64_t pos)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    el->info.byte_pos = pos;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_update_byte_pos(audio_element_handle_t el, int pos)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    el->info.byte_pos += pos;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_total_bytes(audio_element_handle_t el, int64_t total_bytes)
+{
+    xSemaphoreTake(el->lock, portMAX_DELAY);
+    el->info.total_bytes = total_bytes;
+    xSemaphoreGive(el->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_run(audio_element_handle_t el)
+{
+    if (el->task_run) {
+        ESP_LOGD(TAG, "[%s] Element already created", el->tag);
+        return ESP_OK;
+    }
+    if (el->task_stack > 0) {
+        xEventGroupClearBits(el->state_event, TASK_CREATED_BIT | TASK_DESTROYED_BIT);
+        if (xTaskCreatePinnedToCore(audio_element_task, el->tag, el->task_stack, el, el->task_prio, NULL,
+                                    el->task_core) != pdPASS) {
+            ESP_LOGE(TAG, "[%s] Error create element task", el->tag);
+            return ESP_FAIL;
+        }
+        xEventGroupWaitBits(el->state_event, TASK_CREATED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    } else {
+        el->task_run = true;
+        el->is_running = true;
+        audio_element_force_set_state(el, AEL_STATE_RUNNING);
+        audio_element_report_status(el, AEL_STATUS_STATE_RUNNING);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_terminate(audio_element_handle_t el)
+{
+    if (!el->task_run) {
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        el->task_run = false;
+        el->is_running = false;
+        return ESP_OK;
+    }
+    if (el->is_running) {
+        // a task blocked on its ring buffers would not see the command
+        audio_element_abort_input_ringbuf(el);
+        audio_element_abort_output_ringbuf(el);
+    }
+    xEventGroupClearBits(el->state_event, TASK_DESTROYED_BIT);
+    if (audio_element_cmd_send(el, AEL_MSG_CMD_DESTROY) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    EventBits_t bits = xEventGroupWaitBits(el->state_event, TASK_DESTROYED_BIT, pdFALSE, pdTRUE, DEFAULT_MAX_WAIT_TIME);
+    if (!(bits & TASK_DESTROYED_BIT)) {
+        ESP_LOGE(TAG, "[%s] Element destroy timeout", el->tag);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_stop(audio_element_handle_t el)
+{
+    if (!el->task_run) {
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        el->is_running = false;
+        audio_element_force_set_state(el, AEL_STATE_STOPPED);
+        xEventGroupSetBits(el->state_event, STOPPED_BIT);
+        audio_element_report_status(el, AEL_STATUS_STATE_STOPPED);
+        return ESP_OK;
+    }
+    if (!el->is_running) {
+        xEventGroupSetBits(el->state_event, STOPPED_BIT);
+        audio_element_report_status(el, AEL_STATUS_STATE_STOPPED);
+        ESP_LOGD(TAG, "[%s] Element already stopped", el->tag);
+        return ESP_OK;
+    }
+    if (el->state == AEL_STATE_PAUSED) {
+        audio_event_iface_set_cmd_waiting_timeout(el->iface_event, 0);
+    }
+    if (el->stopping) {
+        return ESP_OK;
+    }
+    el->stopping = true;
+    if (audio_element_cmd_send(el, AEL_MSG_CMD_STOP) != ESP_OK) {
+        el->stopping = false;
+        return ESP_FAIL;
+    }
+    // wake a process blocked on a ringbuffer so the command gets read
+    audio_element_abort_output_ringbuf(el);
+    audio_element_abort_input_ringbuf(el);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_wait_for_stop(audio_element_handle_t el)
+{
+    return audio_element_wait_for_stop_ms(el, portMAX_DELAY);
+}
+
+esp_err_t audio_element_wait_for_stop_ms(audio_element_handle_t el, TickType_t ticks_to_wait)
+{
+    if (!el->is_running) {
+        return ESP_OK;
+    }
+    EventBits_t bits = xEventGroupWaitBits(el->state_event, STOPPED_BIT, pdFALSE, pdTRUE, ticks_to_wait);
+    return (bits & STOPPED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t audio_element_pause(audio_element_handle_t el)
+{
+    if (!el->task_run || el->state != AEL_STATE_RUNNING) {
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        audio_element_force_set_state(el, AEL_STATE_PAUSED);
+        return ESP_OK;
+    }
+    xEventGroupClearBits(el->state_event, PAUSED_BIT);
+    if (audio_element_cmd_send(el, AEL_MSG_CMD_PAUSE) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    EventBits_t bits = xEventGroupWaitBits(el->state_event, PAUSED_BIT, pdTRUE, pdTRUE, DEFAULT_MAX_WAIT_TIME);
+    return (bits & PAUSED_BIT) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_element_resume(audio_element_handle_t el, float wait_for_rb_threshold, TickType_t timeout)
+{
+    if (!el->task_run) {
+        return ESP_FAIL;
+    }
+    if (el->state == AEL_STATE_RUNNING) {
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        el->is_running = true;
+        audio_element_force_set_state(el, AEL_STATE_RUNNING);
+        return ESP_OK;
+    }
+    xEventGroupClearBits(el->state_event, RESUMED_BIT);
+    if (audio_element_cmd_send(el, AEL_MSG_CMD_RESUME) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    EventBits_t bits = xEventGroupWaitBits(el->state_event, RESUMED_BIT, pdTRUE, pdTRUE, timeout);
+    if (!(bits & RESUMED_BIT) || el->state == AEL_STATE_ERROR) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+audio_element_state_t audio_element_get_state(audio_element_handle_t el)
+{
+    return el ? el->state : AEL_STATE_NONE;
+}
+
+esp_err_t audio_element_reset_state(audio_element_handle_t el)
+{
+    audio_element_force_set_state(el, AEL_STATE_INIT);
+    return ESP_OK;
+}
+
+bool audio_element_is_stopping(audio_element_handle_t el)
+{
+    return el->stopping;
+}
+
+esp_err_t audio_element_msg_set_listener(audio_element_handle_t el, audio_event_iface_handle_t listener)
+{
+    return audio_event_iface_set_listener(el->iface_event, listener);
+}
+
+esp_err_t audio_element_msg_remove_listener(audio_element_handle_t el, audio_event_iface_handle_t listener)
+{
+    return audio_event_iface_remove_listener(listener, el->iface_event);
+}
+
+esp_err_t audio_element_set_event_callback(audio_element_handle_t el, event_cb_func cb_func, void *ctx)
+{
+    el->callback_func = cb_func;
+    el->callback_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_report_status(audio_element_handle_t el, audio_element_status_t status)
+{
+    audio_event_iface_msg_t msg = {
+        .cmd = AEL_MSG_CMD_REPORT_STATUS,
+        .data = (void *)status,
+        .data_len = sizeof(status),
+    };
+    return audio_element_msg_sendout(el, &msg);
+}
+
+esp_err_t audio_element_report_info(audio_element_handle_t el)
+{
+    audio_event_iface_msg_t msg = {
+        .cmd = AEL_MSG_CMD_REPORT_MUSIC_INFO,
+    };
+    return audio_element_msg_sendout(el, &msg);
+}
+
+esp_err_t audio_element_report_codec_fmt(audio_element_handle_t el)
+{
+    audio_event_iface_msg_t msg = {
+        .cmd = AEL_MSG_CMD_REPORT_CODEC_FMT,
+    };
+    return audio_element_msg_sendout(el, &msg);
+}
+
+esp_err_t audio_element_report_pos(audio_element_handle_t el)
+{
+    audio_element_getinfo(el, &el->report_info);
+    audio_event_iface_msg_t msg = {
+        .cmd = AEL_MSG_CMD_REPORT_POSITION,
+        .data = &el->report_info,
+        .data_len = sizeof(audio_element_info_t),
+    };
+    return audio_element_msg_sendout(el, &msg);
+}
+
+esp_err_t audio_element_set_input_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb)
+{
+    if (rb) {
+        el->input_rb = rb;
+        el->read_type = IO_TYPE_RB;
+    }
+    return ESP_OK;
+}
+
+ringbuf_handle_t audio_element_get_input_ringbuf(audio_element_handle_t el)
+{
+    return el->read_type == IO_TYPE_RB ? el->input_rb : NULL;
+}
+
+esp_err_t audio_element_set_output_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb)
+{
+    if (rb) {
+        el->output_rb = rb;
+        el->write_type = IO_TYPE_RB;
+    }
+    return ESP_OK;
+}
+
+ringbuf_handle_t audio_element_get_output_ringbuf(audio_element_handle_t el)
+{
+    return el->write_type == IO_TYPE_RB ? el->output_rb : NULL;
+}
+
+int audio_element_get_output_ringbuf_size(audio_element_handle_t el)
+{
+    return el->out_rb_size;
+}
+
+esp_err_t audio_element_set_output_ringbuf_size(audio_element_handle_t el, int rb_size)
+{
+    if (rb_size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    el->out_rb_size = rb_size;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_multi_input_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb, int index)
+{
+    if (index < 0 || index >= el->multi_in.max_rb_num || rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    el->multi_in.rb[index] = rb;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_multi_output_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb, int index)
+{
+    if (index < 0 || index >= el->multi_out.max_rb_num || rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    el->multi_out.rb[index] = rb;
+    return ESP_OK;
+}
+
+ringbuf_handle_t audio_element_get_multi_input_ringbuf(audio_element_handle_t el, int index)
+{
+    if (index < 0 || index >= el->multi_in.max_rb_num) {
+        return NULL;
+    }
+    return el->multi_in.rb[index];
+}
+
+ringbuf_handle_t audio_element_get_multi_output_ringbuf(audio_element_handle_t el, int index)
+{
+    if (index < 0 || index >= el->multi_out.max_rb_num) {
+        return NULL;
+    }
+    return el->multi_out.rb[index];
+}
+
+esp_err_t audio_element_reset_input_ringbuf(audio_element_handle_t el)
+{
+    if (el->read_type == IO_TYPE_RB && el->input_rb) {
+        rb_reset(el->input_rb);
+    }
+    for (int i = 0; i < el->multi_in.max_rb_num; i++) {
+        if (el->multi_in.rb[i]) {
+            rb_reset(el->multi_in.rb[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_reset_output_ringbuf(audio_element_handle_t el)
+{
+    if (el->write_type == IO_TYPE_RB && el->output_rb) {
+        rb_reset(el->output_rb);
+    }
+    for (int i = 0; i < el->multi_out.max_rb_num; i++) {
+        if (el->multi_out.rb[i]) {
+            rb_reset(el->multi_out.rb[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_ringbuf_done(audio_element_handle_t el)
+{
+    if (el->write_type == IO_TYPE_RB && el->output_rb) {
+        rb_done_write(el->output_rb);
+    }
+    for (int i = 0; i < el->multi_out.max_rb_num; i++) {
+        if (el->multi_out.rb[i]) {
+            rb_done_write(el->multi_out.rb[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_input_timeout(audio_element_handle_t el, TickType_t timeout)
+{
+    el->input_wait_time = timeout;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_output_timeout(audio_element_handle_t el, TickType_t timeout)
+{
+    el->output_wait_time = timeout;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_read_cb(audio_element_handle_t el, stream_func fn, void *context)
+{
+    el->read_cb.cb = fn;
+    el->read_cb.ctx = context;
+    el->read_type = IO_TYPE_CB;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_write_cb(audio_element_handle_t el, stream_func fn, void *context)
+{
+    el->write_cb.cb = fn;
+    el->write_cb.ctx = context;
+    el->write_type = IO_TYPE_CB;
+    return ESP_OK;
+}
+
+stream_func audio_element_get_read_cb(audio_element_handle_t el)
+{
+    return el->read_type == IO_TYPE_CB ? el->read_cb.cb : NULL;
+}
+
+stream_func audio_element_get_write_cb(audio_element_handle_t el)
+{
+    return el->write_type == IO_TYPE_CB ? el->write_cb.cb : NULL;
+}
+
+int audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    int in_len;
+    if (el->read_type == IO_TYPE_CB) {
+        if (el->read_cb.cb == NULL) {
+            ESP_LOGE(TAG, "[%s] Read IO Callback is NULL", el->tag);
+            return ESP_FAIL;
+        }
+        in_len = el->read_cb.cb(el, buffer, wanted_size, el->input_wait_time, el->read_cb.ctx);
+    } else {
+        if (el->input_rb == NULL) {
+            ESP_LOGE(TAG, "[%s] Input Ringbuffer is NULL", el->tag);
+            return ESP_FAIL;
+        }
+        in_len = rb_read(el->input_rb, buffer, wanted_size, el->input_wait_time);
+    }
+    if (in_len <= 0) {
+        switch (in_len) {
+            case AEL_IO_ABORT:
+                ESP_LOGD(TAG, "IN-[%s] AEL_IO_ABORT", el->tag);
+                break;
+            case AEL_IO_DONE:
+            case AEL_IO_OK:
+                ESP_LOGD(TAG, "IN-[%s] AEL_IO_DONE,%d", el->tag, in_len);
+                break;
+            case AEL_IO_TIMEOUT:
+                break;
+            default:
+                ESP_LOGE(TAG, "IN-[%s] AEL_STATUS_ERROR_INPUT,%d", el->tag, in_len);
+                audio_element_report_status(el, AEL_STATUS_ERROR_INPUT);
+                break;
+        }
+    }
+    return in_len;
+}
+
+int audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    int output_len;
+    if (el->write_type == IO_TYPE_CB) {
+        if (el->write_cb.cb == NULL) {
+            ESP_LOGE(TAG, "[%s] Write IO Callback is NULL", el->tag);
+            return ESP_FAIL;
+        }
+        output_len = el->write_cb.cb(el, buffer, write_size, el->output_wait_time, el->write_cb.ctx);
+    } else {
+        if (el->output_rb == NULL) {
+            ESP_LOGE(TAG, "[%s] Output Ringbuffer is NULL", el->tag);
+            return ESP_FAIL;
+        }
+        output_len = rb_write(el->output_rb, buffer, write_size, el->output_wait_time);
+    }
+    if (output_len <= 0) {
+        switch (output_len) {
+            case AEL_IO_ABORT:
+                ESP_LOGD(TAG, "OUT-[%s] AEL_IO_ABORT", el->tag);
+                break;
+            case AEL_IO_DONE:
+            case AEL_IO_OK:
+                ESP_LOGD(TAG, "OUT-[%s] AEL_IO_DONE,%d", el->tag, output_len);
+                break;
+            case AEL_IO_TIMEOUT:
+                break;
+            default:
+                ESP_LOGE(TAG, "OUT-[%s] AEL_STATUS_ERROR_OUTPUT,%d", el->tag, output_len);
+                audio_element_report_status(el, AEL_STATUS_ERROR_OUTPUT);
+                break;
+        }
+    }
+    return output_len;
+}
+
+esp_err_t audio_element_multi_input(audio_element_handle_t el, char *buffer, int wanted_size, int index, TickType_t ticks_to_wait)
+{
+    if (index < 0 || index >= el->multi_in.max_rb_num || el->multi_in.rb[index] == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return rb_read(el->multi_in.rb[index], buffer, wanted_size, ticks_to_wait);
+}
+
+esp_err_t audio_element_multi_output(audio_element_handle_t el, char *buffer, int wanted_size, TickType_t ticks_to_wait)
+{
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < el->multi_out.max_rb_num; i++) {
+        if (el->multi_out.rb[i]) {
+            ret |= rb_write(el->multi_out.rb[i], buffer, wanted_size, ticks_to_wait);
+        }
+    }
+    return ret;
+}
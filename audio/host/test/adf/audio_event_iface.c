@@ -0,0 +1,171 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The ESP-ADF event interface for the native tests. Like in ADF a listener waits on a queue set
+// holding its own command queue and the message queues of the interfaces it listens to.
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "audio_error.h"
+#include "audio_event_iface.h"
+#include "audio_mem.h"
+
+// ADF grows the set with every listened queue, a fixed size with room for all of them here
+#define EVENT_IFACE_SET_SIZE (64)
+
+struct audio_event_iface {
+    QueueHandle_t internal_queue;
+    QueueHandle_t external_queue;
+    QueueSetHandle_t queue_set;
+    on_event_iface_func on_cmd;
+    void *context;
+    TickType_t wait_time;
+    int type;
+};
+
+audio_event_iface_handle_t audio_event_iface_init(audio_event_iface_cfg_t *config)
+{
+    audio_event_iface_handle_t evt = audio_calloc(1, sizeof(struct audio_event_iface));
+    if (evt == NULL) {
+        return NULL;
+    }
+    evt->on_cmd = config->on_cmd;
+    evt->context = config->context;
+    evt->wait_time = config->wait_time;
+    evt->type = config->type;
+    if (config->internal_queue_size) {
+        evt->internal_queue = xQueueCreate(config->internal_queue_size, sizeof(audio_event_iface_msg_t));
+    }
+    if (config->external_queue_size) {
+        evt->external_queue = xQueueCreate(config->external_queue_size, sizeof(audio_event_iface_msg_t));
+    }
+    if (config->queue_set_size) {
+        evt->queue_set = xQueueCreateSet(EVENT_IFACE_SET_SIZE);
+        if (evt->queue_set && evt->internal_queue) {
+            xQueueAddToSet(evt->internal_queue, evt->queue_set);
+        }
+    }
+    return evt;
+}
+
+esp_err_t audio_event_iface_destroy(audio_event_iface_handle_t evt)
+{
+    if (evt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (evt->internal_queue) {
+        vQueueDelete(evt->internal_queue);
+    }
+    if (evt->external_queue) {
+        vQueueDelete(evt->external_queue);
+    }
+    if (evt->queue_set) {
+        vQueueDelete(evt->queue_set);
+    }
+    audio_free(evt);
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_set_listener(audio_event_iface_handle_t evt, audio_event_iface_handle_t listener)
+{
+    if (evt == NULL || listener == NULL || evt->external_queue == NULL || listener->queue_set == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xQueueReset(evt->external_queue);
+    return xQueueAddToSet(evt->external_queue, listener->queue_set) == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_event_iface_remove_listener(audio_event_iface_handle_t listen, audio_event_iface_handle_t evt)
+{
+    if (evt == NULL || listen == NULL || evt->external_queue == NULL || listen->queue_set == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // only an empty queue leaves a set, the messages nobody read are dropped
+    xQueueReset(evt->external_queue);
+    return xQueueRemoveFromSet(evt->external_queue, listen->queue_set) == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_event_iface_set_cmd_waiting_timeout(audio_event_iface_handle_t evt, TickType_t wait_time)
+{
+    if (evt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    evt->wait_time = wait_time;
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_waiting_cmd_msg(audio_event_iface_handle_t evt)
+{
+    audio_event_iface_msg_t msg;
+    if (evt->internal_queue && xQueueReceive(evt->internal_queue, &msg, evt->wait_time) == pdTRUE) {
+        if (evt->on_cmd && evt->on_cmd(&msg, evt->context) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_cmd(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg)
+{
+    if (evt == NULL || evt->internal_queue == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xQueueSend(evt->internal_queue, msg, portMAX_DELAY) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_event_iface_sendout(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg)
+{
+    if (evt == NULL || evt->external_queue == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return xQueueSend(evt->external_queue, msg, 0) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_event_iface_discard(audio_event_iface_handle_t evt)
+{
+    if (evt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    audio_event_iface_msg_t msg;
+    if (evt->external_queue) {
+        while (xQueueReceive(evt->external_queue, &msg, 0) == pdTRUE) {
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_listen(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg, TickType_t wait_time)
+{
+    if (evt == NULL || evt->queue_set == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    QueueSetMemberHandle_t active = xQueueSelectFromSet(evt->queue_set, wait_time);
+    if (active && xQueueReceive(active, msg, 0) == pdTRUE) {
+        return ESP_OK;
+    }
+    return ESP_FAIL;
+}
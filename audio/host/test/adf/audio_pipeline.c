@@ -0,0 +1,395 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The ESP-ADF pipeline for the native tests, after audio_pipeline.c of ESP-ADF v2.x
+
+#include <string.h>
+#include <strings.h>
+#include <sys/queue.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "audio_pipeline.h"
+
+static const char *TAG = "AUDIO_PIPELINE";
+
+#define DEFAULT_MAX_WAIT_TIME (2000 / portTICK_RATE_MS)
+
+typedef struct ringbuf_item {
+    STAILQ_ENTRY(ringbuf_item) next;
+    ringbuf_handle_t rb;
+    audio_element_handle_t host_el;
+    bool linked;
+} ringbuf_item_t;
+
+typedef STAILQ_HEAD(ringbuf_list, ringbuf_item) ringbuf_list_t;
+
+typedef struct audio_element_item {
+    STAILQ_ENTRY(audio_element_item) next;
+    audio_element_handle_t el;
+    bool linked;
+} audio_element_item_t;
+
+typedef STAILQ_HEAD(audio_element_list, audio_element_item) audio_element_list_t;
+
+struct audio_pipeline {
+    audio_element_list_t el_list;
+    ringbuf_list_t rb_list;
+    audio_element_state_t state;
+    SemaphoreHandle_t lock;
+    bool linked;
+    int rb_size;
+    audio_event_iface_handle_t listener;
+};
+
+static audio_element_item_t *audio_pipeline_get_el_item_by_tag(audio_pipeline_handle_t pipeline, const char *tag)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        char *el_tag = audio_element_get_tag(item->el);
+        if (el_tag && tag && strcasecmp(el_tag, tag) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+audio_pipeline_handle_t audio_pipeline_init(audio_pipeline_cfg_t *config)
+{
+    audio_pipeline_handle_t pipeline = audio_calloc(1, sizeof(struct audio_pipeline));
+    AUDIO_MEM_CHECK(TAG, pipeline, return NULL);
+    STAILQ_INIT(&pipeline->el_list);
+    STAILQ_INIT(&pipeline->rb_list);
+    pipeline->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, pipeline->lock, {
+        audio_free(pipeline);
+        return NULL;
+    });
+    pipeline->rb_size = config->rb_size > 0 ? config->rb_size : DEFAULT_PIPELINE_RINGBUF_SIZE;
+    pipeline->state = AEL_STATE_INIT;
+    return pipeline;
+}
+
+esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline)
+{
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_unlink(pipeline);
+    audio_element_item_t *item, *tmp;
+    STAILQ_FOREACH_SAFE(item, &pipeline->el_list, next, tmp) {
+        STAILQ_REMOVE(&pipeline->el_list, item, audio_element_item, next);
+        audio_element_deinit(item->el);
+        audio_free(item);
+    }
+    vSemaphoreDelete(pipeline->lock);
+    audio_free(pipeline);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_register(audio_pipeline_handle_t pipeline, audio_element_handle_t el, const char *name)
+{
+    if (name) {
+        audio_element_set_tag(el, name);
+    }
+    audio_element_item_t *item = audio_calloc(1, sizeof(audio_element_item_t));
+    AUDIO_MEM_CHECK(TAG, item, return ESP_ERR_NO_MEM);
+    item->el = el;
+    STAILQ_INSERT_TAIL(&pipeline->el_list, item, next);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_unregister(audio_pipeline_handle_t pipeline, audio_element_handle_t el)
+{
+    audio_element_item_t *item, *tmp;
+    STAILQ_FOREACH_SAFE(item, &pipeline->el_list, next, tmp) {
+        if (item->el == el) {
+            STAILQ_REMOVE(&pipeline->el_list, item, audio_element_item, next);
+            audio_free(item);
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+audio_element_handle_t audio_pipeline_get_el_by_tag(audio_pipeline_handle_t pipeline, const char *tag)
+{
+    audio_element_item_t *item = audio_pipeline_get_el_item_by_tag(pipeline, tag);
+    return item ? item->el : NULL;
+}
+
+// a ringbuffer left over from audio_pipeline_breakup_elements, or a new one
+static ringbuf_handle_t audio_pipeline_take_rb(audio_pipeline_handle_t pipeline, audio_element_handle_t host_el)
+{
+    ringbuf_item_t *rb_item;
+    STAILQ_FOREACH(rb_item, &pipeline->rb_list, next) {
+        if (!rb_item->linked) {
+            rb_reset(rb_item->rb);
+            rb_item->linked = true;
+            rb_item->host_el = host_el;
+            return rb_item->rb;
+        }
+    }
+    rb_item = audio_calloc(1, sizeof(ringbuf_item_t));
+    AUDIO_MEM_CHECK(TAG, rb_item, return NULL);
+    int size = audio_element_get_output_ringbuf_size(host_el);
+    rb_item->rb = rb_create(size > 0 ? size : pipeline->rb_size, 1);
+    AUDIO_MEM_CHECK(TAG, rb_item->rb, {
+        audio_free(rb_item);
+        return NULL;
+    });
+    rb_item->linked = true;
+    rb_item->host_el = host_el;
+    STAILQ_INSERT_TAIL(&pipeline->rb_list, rb_item, next);
+    return rb_item->rb;
+}
+
+static esp_err_t audio_pipeline_link_elements(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num)
+{
+    ringbuf_handle_t rb = NULL;
+    for (int i = 0; i < link_num; i++) {
+        audio_element_item_t *item = audio_pipeline_get_el_item_by_tag(pipeline, link_tag[i]);
+        if (item == NULL) {
+            ESP_LOGE(TAG, "There is no element with tag %s", link_tag[i]);
+            return ESP_FAIL;
+        }
+        item->linked = true;
+        if (i > 0) {
+            audio_element_set_input_ringbuf(item->el, rb);
+        }
+        if (i < link_num - 1) {
+            rb = audio_pipeline_take_rb(pipeline, item->el);
+            if (rb == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            audio_element_set_output_ringbuf(item->el, rb);
+        }
+    }
+    pipeline->linked = true;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num)
+{
+    if (pipeline->linked) {
+        audio_pipeline_unlink(pipeline);
+    }
+    return audio_pipeline_link_elements(pipeline, link_tag, link_num);
+}
+
+esp_err_t audio_pipeline_unlink(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        item->linked = false;
+    }
+    ringbuf_item_t *rb_item, *tmp;
+    STAILQ_FOREACH_SAFE(rb_item, &pipeline->rb_list, next, tmp) {
+        STAILQ_REMOVE(&pipeline->rb_list, rb_item, ringbuf_item, next);
+        rb_destroy(rb_item->rb);
+        audio_free(rb_item);
+    }
+    pipeline->linked = false;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_breakup_elements(audio_pipeline_handle_t pipeline, audio_element_handle_t kept_ctx_el)
+{
+    // the ringbuffers stay allocated for audio_pipeline_relink
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        item->linked = false;
+    }
+    ringbuf_item_t *rb_item;
+    STAILQ_FOREACH(rb_item, &pipeline->rb_list, next) {
+        rb_item->linked = false;
+        rb_item->host_el = NULL;
+    }
+    pipeline->linked = false;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_relink(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num)
+{
+    if (pipeline->linked) {
+        audio_pipeline_breakup_elements(pipeline, NULL);
+    }
+    return audio_pipeline_link_elements(pipeline, link_tag, link_num);
+}
+
+esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->state != AEL_STATE_INIT) {
+        ESP_LOGW(TAG, "Pipeline already started, state:%d", pipeline->state);
+        return ESP_FAIL;
+    }
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked && audio_element_run(item->el) != ESP_OK) {
+            audio_pipeline_change_state(pipeline, AEL_STATE_ERROR);
+            return ESP_FAIL;
+        }
+    }
+    if (audio_pipeline_resume(pipeline) != ESP_OK) {
+        // ADF ends the element tasks of a pipeline that failed to start
+        audio_pipeline_change_state(pipeline, AEL_STATE_ERROR);
+        audio_pipeline_terminate(pipeline);
+        return ESP_FAIL;
+    }
+    audio_pipeline_change_state(pipeline, AEL_STATE_RUNNING);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_terminate(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked) {
+            audio_element_terminate(item->el);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_stop(audio_pipeline_handle_t pipeline)
+{
+    xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+    if (pipeline->state != AEL_STATE_RUNNING) {
+        ESP_LOGD(TAG, "Without stop, st:%d", pipeline->state);
+        xSemaphoreGive(pipeline->lock);
+        return ESP_FAIL;
+    }
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked) {
+            audio_element_stop(item->el);
+        }
+    }
+    xSemaphoreGive(pipeline->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_wait_for_stop(audio_pipeline_handle_t pipeline)
+{
+    xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+    if (pipeline->state != AEL_STATE_RUNNING) {
+        xSemaphoreGive(pipeline->lock);
+        return ESP_FAIL;
+    }
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked) {
+            audio_element_wait_for_stop(item->el);
+        }
+    }
+    pipeline->state = AEL_STATE_STOPPED;
+    xSemaphoreGive(pipeline->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_pause(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked && audio_element_pause(item->el) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_resume(audio_pipeline_handle_t pipeline)
+{
+    esp_err_t ret = ESP_OK;
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked && audio_element_resume(item->el, 0, DEFAULT_MAX_WAIT_TIME) != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+    if (ret == ESP_OK) {
+        audio_pipeline_change_state(pipeline, AEL_STATE_RUNNING);
+    }
+    return ret;
+}
+
+esp_err_t audio_pipeline_change_state(audio_pipeline_handle_t pipeline, audio_element_state_t new_state)
+{
+    pipeline->state = new_state;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_reset_ringbuffer(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked) {
+            audio_element_reset_output_ringbuf(item->el);
+            audio_element_reset_input_ringbuf(item->el);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_reset_elements(audio_pipeline_handle_t pipeline)
+{
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked) {
+            audio_element_reset_state(item->el);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_set_listener(audio_pipeline_handle_t pipeline, audio_event_iface_handle_t evt)
+{
+    if (pipeline->listener) {
+        audio_pipeline_remove_listener(pipeline);
+    }
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        if (item->linked && audio_element_msg_set_listener(item->el, evt) != ESP_OK) {
+            ESP_LOGE(TAG, "Error register event with: %s", audio_element_get_tag(item->el));
+            return ESP_FAIL;
+        }
+    }
+    pipeline->listener = evt;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_remove_listener(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->listener == NULL) {
+        return ESP_FAIL;
+    }
+    // elements dropped by a relink may still be in the set, they all leave it
+    audio_element_item_t *item;
+    STAILQ_FOREACH(item, &pipeline->el_list, next) {
+        audio_element_msg_remove_listener(item->el, pipeline->listener);
+    }
+    pipeline->listener = NULL;
+    return ESP_OK;
+}
@@ -0,0 +1,286 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The ESP-ADF ringbuffer for the native tests: the same blocking, done and abort semantics,
+// on the host FreeRTOS semaphores
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "audio_mem.h"
+#include "ringbuf.h"
+
+struct ringbuf {
+    char *p_o;
+    char *p_r;
+    char *p_w;
+    int fill_cnt;
+    int size;
+    SemaphoreHandle_t can_read;
+    SemaphoreHandle_t can_write;
+    SemaphoreHandle_t lock;
+    bool abort_read;
+    bool abort_write;
+    bool is_done_write;
+    bool unblock_reader_flag;
+};
+
+ringbuf_handle_t rb_create(int block_size, int n_blocks)
+{
+    if (block_size < 2) {
+        return NULL;
+    }
+    ringbuf_handle_t rb = audio_calloc(1, sizeof(struct ringbuf));
+    if (rb == NULL) {
+        return NULL;
+    }
+    rb->size = block_size * n_blocks;
+    rb->p_o = audio_calloc(1, rb->size);
+    rb->can_read = xSemaphoreCreateBinary();
+    rb->can_write = xSemaphoreCreateBinary();
+    rb->lock = xSemaphoreCreateMutex();
+    if (rb->p_o == NULL || rb->can_read == NULL || rb->can_write == NULL || rb->lock == NULL) {
+        rb_destroy(rb);
+        return NULL;
+    }
+    rb_reset(rb);
+    return rb;
+}
+
+esp_err_t rb_destroy(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (rb->can_read) {
+        vSemaphoreDelete(rb->can_read);
+    }
+    if (rb->can_write) {
+        vSemaphoreDelete(rb->can_write);
+    }
+    if (rb->lock) {
+        vSemaphoreDelete(rb->lock);
+    }
+    audio_free(rb->p_o);
+    audio_free(rb);
+    return ESP_OK;
+}
+
+esp_err_t rb_reset(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    rb->p_r = rb->p_w = rb->p_o;
+    rb->fill_cnt = 0;
+    rb->is_done_write = false;
+    rb->unblock_reader_flag = false;
+    rb->abort_read = false;
+    rb->abort_write = false;
+    xSemaphoreGive(rb->lock);
+    return ESP_OK;
+}
+
+int rb_bytes_available(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    int ret = rb->size - rb->fill_cnt;
+    xSemaphoreGive(rb->lock);
+    return ret;
+}
+
+int rb_bytes_filled(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    int ret = rb->fill_cnt;
+    xSemaphoreGive(rb->lock);
+    return ret;
+}
+
+int rb_get_size(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return rb->size;
+}
+
+int rb_read(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks)
+{
+    if (rb == NULL || buf == NULL) {
+        return RB_FAIL;
+    }
+    int total = 0;
+    int ret = RB_OK;
+    while (buf_len > 0) {
+        xSemaphoreTake(rb->lock, portMAX_DELAY);
+        int read_size = rb->fill_cnt < buf_len ? rb->fill_cnt : buf_len;
+        if (read_size > 0) {
+            int tail = rb->p_o + rb->size - rb->p_r;
+            if (read_size <= tail) {
+                memcpy(buf, rb->p_r, read_size);
+            } else {
+                memcpy(buf, rb->p_r, tail);
+                memcpy(buf + tail, rb->p_o, read_size - tail);
+            }
+            rb->p_r += read_size;
+            if (rb->p_r >= rb->p_o + rb->size) {
+                rb->p_r -= rb->size;
+            }
+            rb->fill_cnt -= read_size;
+            total += read_size;
+            buf += read_size;
+            buf_len -= read_size;
+        }
+        bool done = rb->is_done_write;
+        bool abort = rb->abort_read;
+        bool unblock = rb->unblock_reader_flag;
+        xSemaphoreGive(rb->lock);
+        if (read_size > 0) {
+            xSemaphoreGive(rb->can_write);
+            continue;
+        }
+        // empty, the writer either said it is done or more data has to be waited for
+        if (done) {
+            ret = RB_DONE;
+            break;
+        }
+        if (abort) {
+            ret = RB_ABORT;
+            break;
+        }
+        if (unblock) {
+            xSemaphoreTake(rb->lock, portMAX_DELAY);
+            rb->unblock_reader_flag = false;
+            xSemaphoreGive(rb->lock);
+            ret = RB_OK;
+            break;
+        }
+        if (xSemaphoreTake(rb->can_read, ticks) != pdTRUE) {
+            ret = RB_TIMEOUT;
+            break;
+        }
+    }
+    return total > 0 ? total : ret;
+}
+
+int rb_write(ringbuf_handle_t rb, char *buf, int buf_len, TickType_t ticks)
+{
+    if (rb == NULL || buf == NULL) {
+        return RB_FAIL;
+    }
+    int total = 0;
+    int ret = RB_OK;
+    while (buf_len > 0) {
+        xSemaphoreTake(rb->lock, portMAX_DELAY);
+        int space = rb->size - rb->fill_cnt;
+        int write_size = space < buf_len ? space : buf_len;
+        if (write_size > 0 && !rb->abort_write) {
+            int tail = rb->p_o + rb->size - rb->p_w;
+            if (write_size <= tail) {
+                memcpy(rb->p_w, buf, write_size);
+            } else {
+                memcpy(rb->p_w, buf, tail);
+                memcpy(rb->p_o, buf + tail, write_size - tail);
+            }
+            rb->p_w += write_size;
+            if (rb->p_w >= rb->p_o + rb->size) {
+                rb->p_w -= rb->size;
+            }
+            rb->fill_cnt += write_size;
+            total += write_size;
+            buf += write_size;
+            buf_len -= write_size;
+        } else {
+            write_size = 0;
+        }
+        bool done = rb->is_done_write;
+        bool abort = rb->abort_write;
+        xSemaphoreGive(rb->lock);
+        if (write_size > 0) {
+            xSemaphoreGive(rb->can_read);
+            continue;
+        }
+        if (done) {
+            ret = RB_DONE;
+            break;
+        }
+        if (abort) {
+            ret = RB_ABORT;
+            break;
+        }
+        if (xSemaphoreTake(rb->can_write, ticks) != pdTRUE) {
+            ret = RB_TIMEOUT;
+            break;
+        }
+    }
+    return total > 0 ? total : ret;
+}
+
+esp_err_t rb_abort(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    rb->abort_read = true;
+    rb->abort_write = true;
+    xSemaphoreGive(rb->lock);
+    xSemaphoreGive(rb->can_read);
+    xSemaphoreGive(rb->can_write);
+    return ESP_OK;
+}
+
+esp_err_t rb_done_write(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    rb->is_done_write = true;
+    xSemaphoreGive(rb->lock);
+    xSemaphoreGive(rb->can_read);
+    return ESP_OK;
+}
+
+esp_err_t rb_unblock_reader(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(rb->lock, portMAX_DELAY);
+    rb->unblock_reader_flag = true;
+    xSemaphoreGive(rb->lock);
+    xSemaphoreGive(rb->can_read);
+    return ESP_OK;
+}
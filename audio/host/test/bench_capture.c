@@ -0,0 +1,229 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_decimator.h"
+#include "audio_element.h"
+#include "audio_mem_stats.h"
+#include "audio_pipeline.h"
+#include "audio_placement.h"
+#include "extmod/vfs_fat.h"
+#include "filter_resample.h"
+#include "i2s_stream.h"
+#include "raw_stream.h"
+#include "wav_encoder.h"
+
+#include "test_audio.h"
+
+// CPU and memory of the recorder's capture chain: the old 48 kHz stereo port with rsp_filter,
+// the port clocked at the target rate, and the 48 kHz port shared with the player feeding
+// the decimator. The allocations go through audio_placement.c as on the board.
+//   AUDIO_HOST_LOG=1 make -C audio/host/test bench
+// AMR is stubbed on the host, its rows are the 8 kHz capture without the encoder.
+// The host rsp_filter interpolates linearly without a low-pass, the decimator rows pay for
+// an anti-alias FIR it doesn't have; audio.stack_info() gives the board figures.
+
+#define BENCH_SECONDS (10)
+#define BENCH_RUNS (3)
+#define BENCH_PORT_RATE (48000)
+
+typedef enum {
+    BENCH_RESAMPLE,  // before: 48 kHz stereo and rsp_filter
+    BENCH_NATIVE,    // the port at the target rate, no filter
+    BENCH_DECIMATE,  // the port shared at 48 kHz stereo, audio_decimator
+} bench_capture_t;
+
+typedef struct {
+    const char *name;
+    bool wav;
+    int rate;
+    bench_capture_t capture;
+} bench_chain_t;
+
+typedef struct {
+    int tasks;
+    int stacks;         // configured task stacks, allocated from the heap on the board
+    size_t heap;        // element buffers and ringbuffers once linked
+    size_t heap_peak;   // and while running
+    double cpu_ms;      // all element tasks
+} bench_result_t;
+
+static const char *const bench_tags[] = { "i2s", "filter", "encoder" };
+
+static double bench_cpu_ms(void)
+{
+    double ms = 0;
+    for (size_t i = 0; i < sizeof(bench_tags) / sizeof(bench_tags[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(bench_tags[i]);
+        if (task != NULL) {
+            TaskStatus_t status;
+            vTaskGetInfo(task, &status, pdFALSE, eRunning);
+            ms += status.ulRunTimeCounter / 1000.0;
+        }
+    }
+    return ms;
+}
+
+// i2s -> [filter] -> [wav] -> raw, as audio_recorder_create_input and _encoder make it
+static int bench_run(const bench_chain_t *chain, bench_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    audio_mem_counter_t before;
+    audio_mem_stats_total(&before);
+    int port_rate = chain->capture == BENCH_NATIVE ? chain->rate : BENCH_PORT_RATE;
+    int port_ch = chain->capture == BENCH_NATIVE ? 1 : 2;
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    const char *link_tag[4];
+    int link_num = 0;
+
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_READER;
+    i2s_cfg.uninstall_drv = false;
+    i2s_cfg.i2s_config.sample_rate = port_rate;
+    i2s_cfg.i2s_config.channel_format = port_ch == 1 ? I2S_CHANNEL_FMT_ONLY_LEFT : I2S_CHANNEL_FMT_RIGHT_LEFT;
+    audio_placement_enter("i2s", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t i2s = i2s_stream_init(&i2s_cfg);
+    audio_placement_exit();
+    i2s_stream_set_clk(i2s, port_rate, 16, port_ch);
+    audio_pipeline_register(pipeline, i2s, "i2s");
+    link_tag[link_num++] = "i2s";
+    result->stacks += i2s_cfg.task_stack;
+
+    audio_element_handle_t filter = NULL;
+    if (chain->capture == BENCH_RESAMPLE) {
+        rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+        rsp_cfg.src_rate = BENCH_PORT_RATE;
+        rsp_cfg.src_ch = 2;
+        rsp_cfg.dest_rate = chain->rate;
+        rsp_cfg.dest_ch = 1;
+        audio_placement_enter("filter", AUDIO_PLACE_KIND_BUF);
+        filter = rsp_filter_init(&rsp_cfg);
+        audio_placement_exit();
+        result->stacks += rsp_cfg.task_stack;
+    } else if (chain->capture == BENCH_DECIMATE) {
+        audio_decimator_cfg_t dec_cfg = AUDIO_DECIMATOR_CFG_DEFAULT();
+        dec_cfg.src_rate = BENCH_PORT_RATE;
+        dec_cfg.src_ch = 2;
+        dec_cfg.dest_rate = chain->rate;
+        dec_cfg.dest_ch = 1;
+        audio_placement_enter("filter", AUDIO_PLACE_KIND_BUF);
+        filter = audio_decimator_init(&dec_cfg);
+        audio_placement_exit();
+        result->stacks += dec_cfg.task_stack;
+    }
+    if (filter != NULL) {
+        audio_pipeline_register(pipeline, filter, "filter");
+        link_tag[link_num++] = "filter";
+    }
+    if (chain->wav) {
+        wav_encoder_cfg_t wav_cfg = DEFAULT_WAV_ENCODER_CONFIG();
+        audio_placement_enter("encoder", AUDIO_PLACE_KIND_BUF);
+        audio_element_handle_t encoder = wav_encoder_init(&wav_cfg);
+        audio_placement_exit();
+        audio_pipeline_register(pipeline, encoder, "encoder");
+        link_tag[link_num++] = "encoder";
+        result->stacks += wav_cfg.task_stack;
+    }
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+    audio_pipeline_register(pipeline, raw, "raw");
+    link_tag[link_num++] = "raw";
+    result->tasks = link_num - 1;
+    audio_placement_enter("recorder", AUDIO_PLACE_KIND_RB);
+    audio_pipeline_link(pipeline, link_tag, link_num);
+    audio_placement_exit();
+
+    audio_mem_counter_t linked;
+    audio_mem_stats_total(&linked);
+    result->heap = linked.bytes - before.bytes;
+    audio_mem_stats_reset_peak();
+
+    long want = (long)chain->rate * 2 * BENCH_SECONDS;
+    long total = 0;
+    if (audio_pipeline_run(pipeline) == ESP_OK) {
+        static char buf[4096];
+        int n;
+        while (total < want && (n = raw_stream_read(raw, buf, sizeof(buf))) > 0) {
+            total += n;
+        }
+    }
+    result->cpu_ms = bench_cpu_ms();
+    audio_mem_counter_t running;
+    audio_mem_stats_total(&running);
+    result->heap_peak = running.peak - before.bytes;
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_deinit(pipeline);
+    return total >= want ? 0 : -1;
+}
+
+int main(void)
+{
+    test_dir_create();
+    test_wav_write(test_path("mic.wav"), BENCH_PORT_RATE, 1, BENCH_PORT_RATE);
+    setenv("AUDIO_HOST_I2S_IN", test_path("mic.wav"), 1);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+
+    static const bench_chain_t chains[] = {
+        { "PCM 16k, 48k/2 + rsp", false, 16000, BENCH_RESAMPLE },
+        { "PCM 16k, native", false, 16000, BENCH_NATIVE },
+        { "PCM 16k, 48k/2 + dec", false, 16000, BENCH_DECIMATE },
+        { "WAV 16k, 48k/2 + rsp", true, 16000, BENCH_RESAMPLE },
+        { "WAV 16k, native", true, 16000, BENCH_NATIVE },
+        { "WAV 16k, 48k/2 + dec", true, 16000, BENCH_DECIMATE },
+        { "AMR 8k, 48k/2 + rsp", false, 8000, BENCH_RESAMPLE },
+        { "AMR 8k, native", false, 8000, BENCH_NATIVE },
+        { "AMR 8k, 48k/2 + dec", false, 8000, BENCH_DECIMATE },
+    };
+    printf("%d s of audio per chain\n", BENCH_SECONDS);
+    printf("%-24s %6s %8s %10s %10s %8s\n", "chain", "tasks", "stacks", "heap", "heap peak", "cpu ms");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(chains) / sizeof(chains[0]); i++) {
+        bench_result_t best = { 0 };
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            bench_result_t r;
+            if (bench_run(&chains[i], &r) != 0) {
+                failed++;
+                break;
+            }
+            if (run == 0 || r.cpu_ms < best.cpu_ms) {
+                best = r;
+            }
+        }
+        printf("%-24s %6d %8d %10d %10d %8.1f\n", chains[i].name, best.tasks, best.stacks,
+               (int)best.heap, (int)best.heap_peak, best.cpu_ms);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
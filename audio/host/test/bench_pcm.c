@@ -0,0 +1,232 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "audio_mem_stats.h"
+#include "audio_pcm_out.h"
+#include "audio_probe.h"
+#include "esp_audio.h"
+#include "extmod/vfs_fat.h"
+#include "filter_resample.h"
+#include "i2s_stream.h"
+#include "py/stream.h"
+#include "vfs_stream.h"
+#include "wav_decoder.h"
+
+#include "test_audio.h"
+
+// Tasks, memory and CPU of audio.player playing a WAV at the output rate: through
+// esp_audio, file -> wav decoder -> resampler -> i2s, as before the passthrough, and
+// through audio_pcm_out, one task reading the file into the driver. Both start from
+// the player core audio_player_core_get creates either way, the allocations go through
+// audio_placement.c as on the board.
+//   AUDIO_HOST_LOG=1 make -C audio/host/test bench
+// The CPU time is the process time of the play, the pacing is free.
+
+#define BENCH_SECONDS (30)
+#define BENCH_RUNS (3)
+// audio_player.c PLAYER_OUTPUT_RATE
+#define BENCH_OUTPUT_RATE (48000)
+
+typedef struct {
+    int tasks;       // running while playing, besides the esp_audio task
+    int stacks;      // their configured stacks, allocated from the heap when they start
+    size_t heap;     // on top of the player core once the file has played
+    size_t heap_peak;
+    double cpu_ms;
+} bench_result_t;
+
+typedef struct {
+    FILE *file;
+    int remain;
+    SemaphoreHandle_t done;
+} bench_pcm_t;
+
+static double bench_cpu_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// audio_player_core_create
+static esp_audio_handle_t bench_core_create(void)
+{
+    esp_audio_cfg_t cfg = DEFAULT_ESP_AUDIO_CONFIG();
+    cfg.resample_rate = BENCH_OUTPUT_RATE;
+    cfg.prefer_type = ESP_AUDIO_PREFER_MEM;
+    esp_audio_handle_t player = esp_audio_create(&cfg);
+    i2s_stream_cfg_t i2s_writer = I2S_STREAM_CFG_DEFAULT();
+    i2s_writer.type = AUDIO_STREAM_WRITER;
+    i2s_writer.i2s_config.sample_rate = BENCH_OUTPUT_RATE;
+    i2s_writer.uninstall_drv = false;
+    esp_audio_output_stream_add(player, i2s_stream_init(&i2s_writer));
+    return player;
+}
+
+// audio_player_core_prepare, then esp_audio plays it through the resampler
+static int bench_decoder_run(esp_audio_handle_t player, const char *uri, bench_result_t *result)
+{
+    vfs_stream_cfg_t fs_reader = VFS_STREAM_CFG_DEFAULT();
+    fs_reader.type = AUDIO_STREAM_READER;
+    esp_audio_input_stream_add(player, vfs_stream_init(&fs_reader));
+    wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, wav_decoder_init(&wav_dec_cfg));
+    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    result->tasks = 4;
+    result->stacks = fs_reader.task_stack + wav_dec_cfg.task_stack + rsp_cfg.task_stack + i2s_cfg.task_stack;
+    return esp_audio_sync_play(player, uri, 0) == ESP_ERR_AUDIO_NO_ERROR ? 0 : -1;
+}
+
+// audio_player_pcm_read
+static int bench_pcm_read(uint8_t *buf, int len, void *ctx)
+{
+    bench_pcm_t *pcm = (bench_pcm_t *)ctx;
+    if (len > pcm->remain) {
+        len = pcm->remain;
+    }
+    if (len <= 0) {
+        return 0;
+    }
+    int rlen = mp_stream_posix_read(pcm->file, buf, len);
+    if (rlen > 0) {
+        pcm->remain -= rlen;
+    }
+    return rlen;
+}
+
+static void bench_pcm_done(audio_pcm_out_status_t status, void *ctx)
+{
+    xSemaphoreGive(((bench_pcm_t *)ctx)->done);
+}
+
+// audio_player_pcm_match and audio_player_pcm_play
+static int bench_pcm_run(esp_audio_handle_t player, const char *uri, bench_result_t *result)
+{
+    audio_probe_wav_t wav;
+    if (!audio_probe_wav_uri(uri, &wav) || wav.sample_rate != BENCH_OUTPUT_RATE
+        || !audio_pcm_out_supported(wav.channels, wav.bits)) {
+        return -1;
+    }
+    mp_obj_t args[2] = {
+        mp_obj_new_str(uri, strlen(uri)),
+        MP_OBJ_NEW_QSTR(MP_QSTR_rb),
+    };
+    bench_pcm_t pcm = {
+        .file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map),
+        .remain = wav.data_size,
+        .done = xSemaphoreCreateBinary(),
+    };
+    mp_stream_posix_lseek(pcm.file, wav.data_offset, SEEK_SET);
+
+    audio_pcm_out_cfg_t cfg = AUDIO_PCM_OUT_CFG_DEFAULT();
+    cfg.sample_rate = wav.sample_rate;
+    cfg.channels = wav.channels;
+    cfg.bits = wav.bits;
+    cfg.read = bench_pcm_read;
+    cfg.done = bench_pcm_done;
+    cfg.ctx = &pcm;
+    result->tasks = 1;
+    result->stacks = cfg.task_stack;
+    int ret = audio_pcm_out_start(&cfg);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(pcm.done, portMAX_DELAY);
+        // the task clears running after done()
+        while (audio_pcm_out_running()) {
+            vTaskDelay(1);
+        }
+    }
+    mp_stream_close(pcm.file);
+    vSemaphoreDelete(pcm.done);
+    return ret == ESP_OK && pcm.remain == 0 ? 0 : -1;
+}
+
+static int bench_run(const char *uri, bool passthrough, bench_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    esp_audio_handle_t player = bench_core_create();
+    audio_mem_counter_t before;
+    audio_mem_stats_total(&before);
+    audio_mem_stats_reset_peak();
+
+    double cpu = bench_cpu_ms();
+    int ret = passthrough ? bench_pcm_run(player, uri, result) : bench_decoder_run(player, uri, result);
+    result->cpu_ms = bench_cpu_ms() - cpu;
+
+    audio_mem_counter_t after;
+    audio_mem_stats_total(&after);
+    result->heap = after.bytes - before.bytes;
+    result->heap_peak = after.peak - before.bytes;
+    esp_audio_destroy(player);
+    return ret;
+}
+
+int main(void)
+{
+    test_dir_create();
+    test_wav_write(test_path("stereo.wav"), BENCH_OUTPUT_RATE, 2, BENCH_OUTPUT_RATE * BENCH_SECONDS);
+    test_wav_write(test_path("mono.wav"), BENCH_OUTPUT_RATE, 1, BENCH_OUTPUT_RATE * BENCH_SECONDS);
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+
+    static const struct {
+        const char *name;
+        const char *uri;
+        bool passthrough;
+    } cases[] = {
+        { "48k/2 16 bit, decoder", "/sdcard/stereo.wav", false },
+        { "48k/2 16 bit, pcm_out", "/sdcard/stereo.wav", true },
+        { "48k/1 16 bit, decoder", "/sdcard/mono.wav", false },
+        { "48k/1 16 bit, pcm_out", "/sdcard/mono.wav", true },
+    };
+    printf("%d s of audio per file, best of %d\n", BENCH_SECONDS, BENCH_RUNS);
+    printf("%-24s %6s %7s %8s %9s %8s\n", "play", "tasks", "stacks", "heap", "heap peak", "cpu ms");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_result_t best = { 0 };
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            bench_result_t r;
+            if (bench_run(cases[i].uri, cases[i].passthrough, &r) != 0) {
+                failed++;
+                break;
+            }
+            if (run == 0 || r.cpu_ms < best.cpu_ms) {
+                best = r;
+            }
+        }
+        printf("%-24s %6d %7d %8d %9d %8.1f\n", cases[i].name, best.tasks, best.stacks, (int)best.heap,
+               (int)best.heap_peak, best.cpu_ms);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
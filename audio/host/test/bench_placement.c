@@ -0,0 +1,177 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "audio_arena.h"
+#include "audio_element.h"
+#include "audio_mem_stats.h"
+#include "audio_pipeline.h"
+#include "audio_placement.h"
+#include "extmod/vfs_fat.h"
+#include "filter_resample.h"
+#include "raw_stream.h"
+#include "vfs_stream.h"
+#include "wav_decoder.h"
+
+#include "test_audio.h"
+
+// Where the player's file -> wav -> resample chain puts its memory under each audio.placement()
+// policy, with the allocations going through audio_placement.c as on the board (see the --wrap
+// flags). The host has one kind of memory, the audio arena stands in for PSRAM: this is the
+// accounting of the policy, not its speed. The decode time per placement is measured on the
+// board from the audio.stack_info() run times, see the README.
+//   AUDIO_HOST_LOG=1 make -C audio/host/test bench
+
+#define BENCH_SECONDS (5)
+#define BENCH_SRC_RATE (44100)
+#define BENCH_OUT_RATE (48000)
+
+typedef struct {
+    const char *name;
+    audio_place_t buf;
+    audio_place_t stack;
+    audio_place_t rb;
+} bench_placement_t;
+
+typedef struct {
+    size_t heap_bytes;   // internal RAM on the board
+    size_t arena_bytes;  // PSRAM on the board
+    int stacks_in_ext;
+} bench_result_t;
+
+static const char *const hot_tags[] = { "wav", "resample" };
+
+static void bench_apply(const bench_placement_t *p)
+{
+    for (size_t i = 0; i < sizeof(hot_tags) / sizeof(hot_tags[0]); i++) {
+        audio_placement_set(hot_tags[i], AUDIO_PLACE_KIND_BUF, p->buf);
+        audio_placement_set(hot_tags[i], AUDIO_PLACE_KIND_STACK, p->stack);
+    }
+    audio_placement_set("player", AUDIO_PLACE_KIND_RB, p->rb);
+}
+
+static int bench_run(bench_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    audio_arena_stats_t arena_before;
+    audio_arena_get_stats(&arena_before);
+    audio_mem_counter_t before;
+    audio_mem_stats_total(&before);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_READER;
+    audio_placement_enter("file", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t reader = vfs_stream_init(&vfs_cfg);
+    audio_placement_exit();
+    wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    wav_cfg.stack_in_ext = audio_placement_stack_in_ext("wav", wav_cfg.stack_in_ext);
+    result->stacks_in_ext += wav_cfg.stack_in_ext;
+    audio_placement_enter("wav", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t decoder = wav_decoder_init(&wav_cfg);
+    audio_placement_exit();
+    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+    rsp_cfg.src_rate = BENCH_SRC_RATE;
+    rsp_cfg.dest_rate = BENCH_OUT_RATE;
+    rsp_cfg.stack_in_ext = audio_placement_stack_in_ext("resample", rsp_cfg.stack_in_ext);
+    result->stacks_in_ext += rsp_cfg.stack_in_ext;
+    audio_placement_enter("resample", AUDIO_PLACE_KIND_BUF);
+    audio_element_handle_t filter = rsp_filter_init(&rsp_cfg);
+    audio_placement_exit();
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+
+    audio_pipeline_register(pipeline, reader, "file");
+    audio_pipeline_register(pipeline, decoder, "wav");
+    audio_pipeline_register(pipeline, filter, "resample");
+    audio_pipeline_register(pipeline, raw, "raw");
+    const char *link_tag[] = { "file", "wav", "resample", "raw" };
+    audio_placement_enter("player", AUDIO_PLACE_KIND_RB);
+    audio_pipeline_link(pipeline, link_tag, 4);
+    audio_placement_exit();
+    audio_element_set_uri(reader, "/sdcard/cd.wav");
+
+    // the buffers the elements open with are in once the chain runs
+    long total = 0;
+    if (audio_pipeline_run(pipeline) == ESP_OK) {
+        static char buf[4096];
+        int n;
+        while ((n = raw_stream_read(raw, buf, sizeof(buf))) > 0) {
+            total += n;
+        }
+    }
+    audio_arena_stats_t arena;
+    audio_arena_get_stats(&arena);
+    audio_mem_counter_t running;
+    audio_mem_stats_total(&running);
+    result->arena_bytes = arena.peak - arena_before.used;
+    result->heap_bytes = running.peak - before.bytes - result->arena_bytes;
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_deinit(pipeline);
+    // the last frames stay in the resampler
+    return total >= (long)BENCH_OUT_RATE * BENCH_SECONDS * 4 - 64 ? 0 : -1;
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    test_wav_write(test_path("cd.wav"), BENCH_SRC_RATE, 2, BENCH_SRC_RATE * BENCH_SECONDS);
+    if (!audio_arena_ready()) {
+        printf("the audio arena is off, PSRAM placements fall back to the heap\n");
+    }
+
+    static const bench_placement_t placements[] = {
+        { "default", AUDIO_PLACE_DEFAULT, AUDIO_PLACE_DEFAULT, AUDIO_PLACE_DEFAULT },
+        { "all internal", AUDIO_PLACE_INTERNAL, AUDIO_PLACE_INTERNAL, AUDIO_PLACE_INTERNAL },
+        { "all psram", AUDIO_PLACE_PSRAM, AUDIO_PLACE_PSRAM, AUDIO_PLACE_PSRAM },
+        { "hot internal, rb psram", AUDIO_PLACE_INTERNAL, AUDIO_PLACE_INTERNAL, AUDIO_PLACE_PSRAM },
+    };
+    printf("memory of the player chain per placement, no timings: one kind of memory on the host\n");
+    printf("%-24s %12s %12s %14s\n", "placement", "heap bytes", "arena bytes", "stacks in ext");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(placements) / sizeof(placements[0]); i++) {
+        bench_apply(&placements[i]);
+        audio_arena_reset_peak();
+        audio_mem_stats_reset_peak();
+        bench_result_t r;
+        if (bench_run(&r) != 0) {
+            failed++;
+            continue;
+        }
+        printf("%-24s %12d %12d %14d\n", placements[i].name, (int)r.heap_bytes, (int)r.arena_bytes, r.stacks_in_ext);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
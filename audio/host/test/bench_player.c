@@ -0,0 +1,463 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "amr_decoder.h"
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_mem_stats.h"
+#include "audio_pipeline.h"
+#include "audio_probe.h"
+#include "esp_audio.h"
+#include "esp_timer.h"
+#include "extmod/vfs_fat.h"
+#include "filter_resample.h"
+#include "http_stream.h"
+#include "i2s_stream.h"
+#include "mp3_decoder.h"
+#include "vfs_stream.h"
+#include "wav_decoder.h"
+
+#include "test_audio.h"
+
+// Construction time, memory and start latency of audio.player, esp_audio with its
+// decoders and readers added on the first play, against the player with all of them
+// created up front and against audio.pipeline_player, one reader -> decoder -> i2s
+// pipeline built up front. The players are set up as audio_player.c and
+// audio_pipeline_player.c do it, the allocations go through audio_placement.c as on
+// the board.
+//   AUDIO_HOST_LOG=0 make -C audio/host/test bench
+// The first sample is the first buffer handed to the I2S writer after play().
+// The second table plays WAV files named .wav, .mp3 and without a suffix, with the
+// decoder picked from the suffix as before audio_probe and from the probed content.
+// The failing plays log errors, AUDIO_HOST_LOG=0 keeps the tables apart.
+// mp3 and amr are stubbed on the host, their elements have the buffers and task stacks
+// of the real ones, not the decoder state the libraries allocate when they open.
+
+#define BENCH_RUNS (3)
+#define BENCH_RATE (44100)
+#define BENCH_FRAMES (BENCH_RATE * 2)
+// audio_player.c PLAYER_OUTPUT_RATE
+#define BENCH_OUTPUT_RATE (48000)
+// audio_pipeline_player.c PIPELINE_PLAYER_TASK_STACK
+#define BENCH_PIPELINE_TASK_STACK (3072)
+
+typedef struct {
+    int create_us;
+    size_t create_heap;  // after the constructor
+    size_t heap;         // resident once a file has played
+    size_t heap_peak;    // and while playing
+    int elements;        // held by the player
+    int tasks;           // running while playing
+    int stacks;          // their configured stacks, allocated from the heap when they start
+    int first_us;        // from play() to the first I2S write
+} bench_result_t;
+
+static stream_func bench_i2s_write;
+static volatile int64_t bench_first;
+
+static int bench_output_write(audio_element_handle_t el, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    if (bench_first == 0 && len > 0) {
+        bench_first = esp_timer_get_time();
+    }
+    return bench_i2s_write(el, buffer, len, ticks_to_wait, NULL);
+}
+
+static void bench_output_hook(audio_element_handle_t writer)
+{
+    bench_i2s_write = audio_element_get_write_cb(writer);
+    audio_element_set_write_cb(writer, bench_output_write, NULL);
+    bench_first = 0;
+}
+
+static size_t bench_heap(const audio_mem_counter_t *before)
+{
+    audio_mem_counter_t now;
+    audio_mem_stats_total(&now);
+    return now.bytes - before->bytes;
+}
+
+static size_t bench_heap_peak(const audio_mem_counter_t *before)
+{
+    audio_mem_counter_t now;
+    audio_mem_stats_total(&now);
+    return now.peak - before->bytes;
+}
+
+static void bench_player_add_reader(esp_audio_handle_t player, bool http, bool used, bench_result_t *result)
+{
+    int stack;
+    if (http) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = AUDIO_STREAM_READER;
+        http_cfg.enable_playlist_parser = true;
+        esp_audio_input_stream_add(player, http_stream_init(&http_cfg));
+        stack = http_cfg.task_stack;
+    } else {
+        vfs_stream_cfg_t fs_reader = VFS_STREAM_CFG_DEFAULT();
+        fs_reader.type = AUDIO_STREAM_READER;
+        esp_audio_input_stream_add(player, vfs_stream_init(&fs_reader));
+        stack = fs_reader.task_stack;
+    }
+    result->elements++;
+    if (used) {
+        result->tasks++;
+        result->stacks += stack;
+    }
+}
+
+// audio_player.c PLAYER_CODEC_*
+#define BENCH_CODEC_MP3 (1 << 0)
+#define BENCH_CODEC_AMR (1 << 1)
+#define BENCH_CODEC_WAV (1 << 2)
+#define BENCH_CODEC_ALL (BENCH_CODEC_MP3 | BENCH_CODEC_AMR | BENCH_CODEC_WAV)
+
+// the sources are WAV, the wav decoder is the one that runs
+static void bench_player_add_codecs(esp_audio_handle_t player, uint32_t codecs, bench_result_t *result)
+{
+    if (codecs & BENCH_CODEC_MP3) {
+        mp3_decoder_cfg_t mp3_dec_cfg = DEFAULT_MP3_DECODER_CONFIG();
+        esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, mp3_decoder_init(&mp3_dec_cfg));
+        result->elements++;
+    }
+    if (codecs & BENCH_CODEC_AMR) {
+        amr_decoder_cfg_t amr_dec_cfg = DEFAULT_AMR_DECODER_CONFIG();
+        esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, amr_decoder_init(&amr_dec_cfg));
+        result->elements++;
+    }
+    if (codecs & BENCH_CODEC_WAV) {
+        wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
+        esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, wav_decoder_init(&wav_dec_cfg));
+        result->elements++;
+        result->tasks++;
+        result->stacks += wav_dec_cfg.task_stack;
+    }
+}
+
+// audio_player_type_codecs, playlists and unknown formats may hold anything
+static uint32_t bench_player_type_codecs(audio_probe_type_t type)
+{
+    switch (type) {
+        case AUDIO_PROBE_MP3:
+            return BENCH_CODEC_MP3;
+        case AUDIO_PROBE_AMR:
+            return BENCH_CODEC_AMR;
+        case AUDIO_PROBE_WAV:
+            return BENCH_CODEC_WAV;
+        default:
+            return BENCH_CODEC_ALL;
+    }
+}
+
+typedef enum {
+    BENCH_EAGER,   // both readers and all decoders in the constructor
+    BENCH_SUFFIX,  // the reader and the decoders of the uri suffix on play()
+    BENCH_PROBE,   // the reader and the decoder of the probed content on play(), as now
+} bench_player_t;
+
+// audio_player_core_create, then audio_player_play_helper and audio_player_core_prepare
+static int bench_player_run(const char *uri, bench_player_t mode, bench_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    audio_mem_counter_t before;
+    audio_mem_stats_total(&before);
+    audio_mem_stats_reset_peak();
+    int64_t start = esp_timer_get_time();
+    bool http = strncasecmp(uri, "http", 4) == 0;
+
+    esp_audio_cfg_t cfg = DEFAULT_ESP_AUDIO_CONFIG();
+    cfg.resample_rate = BENCH_OUTPUT_RATE;
+    cfg.prefer_type = ESP_AUDIO_PREFER_MEM;
+    esp_audio_handle_t player = esp_audio_create(&cfg);
+    rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+    result->elements = 1;
+    result->tasks = 2;
+    result->stacks = cfg.task_stack + rsp_cfg.task_stack;
+    if (mode == BENCH_EAGER) {
+        bench_player_add_reader(player, false, !http, result);
+        bench_player_add_reader(player, true, http, result);
+        bench_player_add_codecs(player, BENCH_CODEC_ALL, result);
+    }
+
+    i2s_stream_cfg_t i2s_writer = I2S_STREAM_CFG_DEFAULT();
+    i2s_writer.type = AUDIO_STREAM_WRITER;
+    i2s_writer.i2s_config.sample_rate = BENCH_OUTPUT_RATE;
+    i2s_writer.uninstall_drv = false;
+    audio_element_handle_t writer = i2s_stream_init(&i2s_writer);
+    esp_audio_output_stream_add(player, writer);
+    bench_output_hook(writer);
+    result->elements++;
+    result->tasks++;
+    result->stacks += i2s_writer.task_stack;
+
+    result->create_us = (int)(esp_timer_get_time() - start);
+    result->create_heap = bench_heap(&before);
+
+    start = esp_timer_get_time();
+    char hinted[128];
+    if (mode == BENCH_PROBE) {
+        // esp_audio picks the decoder from the suffix, the probed one goes in a fragment
+        audio_probe_type_t type = audio_probe_uri(uri);
+        if (type != AUDIO_PROBE_UNKNOWN && type != audio_probe_suffix(uri)) {
+            snprintf(hinted, sizeof(hinted), "%s%s%s", uri, strchr(uri, '#') ? "." : "#.",
+                     audio_probe_suffix_name(type));
+            uri = hinted;
+        }
+        bench_player_add_reader(player, http, true, result);
+        bench_player_add_codecs(player, bench_player_type_codecs(type), result);
+    } else if (mode == BENCH_SUFFIX) {
+        bench_player_add_reader(player, http, true, result);
+        bench_player_add_codecs(player, bench_player_type_codecs(audio_probe_suffix(uri)), result);
+    }
+    int ret = esp_audio_sync_play(player, uri, 0);
+    result->first_us = bench_first ? (int)(bench_first - start) : -1;
+    result->heap = bench_heap(&before);
+    result->heap_peak = bench_heap_peak(&before);
+    esp_audio_destroy(player);
+    return ret == ESP_ERR_AUDIO_NO_ERROR && bench_first ? 0 : -1;
+}
+
+static int bench_lazy_run(const char *uri, bench_result_t *result)
+{
+    return bench_player_run(uri, BENCH_PROBE, result);
+}
+
+static int bench_eager_run(const char *uri, bench_result_t *result)
+{
+    return bench_player_run(uri, BENCH_EAGER, result);
+}
+
+typedef struct {
+    audio_element_handle_t decoder;
+    audio_element_handle_t writer;
+    audio_event_iface_handle_t evt;
+    SemaphoreHandle_t done;
+    bool failed;
+} bench_pipeline_t;
+
+// pipeline_player_task: the decoder music info clocks the writer, the writer tells the end
+static void bench_pipeline_task(void *arg)
+{
+    bench_pipeline_t *pl = (bench_pipeline_t *)arg;
+    while (1) {
+        audio_event_iface_msg_t msg;
+        if (audio_event_iface_listen(pl->evt, &msg, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        if (msg.source_type != AUDIO_ELEMENT_TYPE_ELEMENT) {
+            continue;
+        }
+        if (msg.source == (void *)pl->decoder && msg.cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
+            audio_element_info_t music_info = { 0 };
+            audio_element_getinfo(pl->decoder, &music_info);
+            audio_element_setinfo(pl->writer, &music_info);
+            i2s_stream_set_clk(pl->writer, music_info.sample_rates, music_info.bits, music_info.channels);
+            continue;
+        }
+        if (msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status >= AEL_STATUS_ERROR_OPEN && status <= AEL_STATUS_ERROR_UNKNOWN) {
+            pl->failed = true;
+            break;
+        }
+        if (msg.source == (void *)pl->writer && status == AEL_STATUS_STATE_FINISHED) {
+            break;
+        }
+    }
+    xSemaphoreGive(pl->done);
+    vTaskDelete(NULL);
+}
+
+// pipeline_player_create, play() only sets the uri and runs the pipeline
+static int bench_pipeline_run(const char *uri, bench_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    audio_mem_counter_t before;
+    audio_mem_stats_total(&before);
+    audio_mem_stats_reset_peak();
+    int64_t start = esp_timer_get_time();
+    bench_pipeline_t pl = { 0 };
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_element_handle_t reader;
+    if (strncasecmp(uri, "http", 4) == 0) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = AUDIO_STREAM_READER;
+        reader = http_stream_init(&http_cfg);
+        result->stacks += http_cfg.task_stack;
+    } else {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_READER;
+        reader = vfs_stream_init(&vfs_cfg);
+        result->stacks += vfs_cfg.task_stack;
+    }
+    wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    pl.decoder = wav_decoder_init(&wav_cfg);
+    result->stacks += wav_cfg.task_stack;
+
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_WRITER;
+    i2s_cfg.uninstall_drv = false;
+    pl.writer = i2s_stream_init(&i2s_cfg);
+    result->stacks += i2s_cfg.task_stack;
+    bench_output_hook(pl.writer);
+
+    audio_pipeline_register(pipeline, reader, "pl_in");
+    audio_pipeline_register(pipeline, pl.decoder, "pl_dec");
+    audio_pipeline_register(pipeline, pl.writer, "pl_i2s");
+    const char *link_tag[3] = { "pl_in", "pl_dec", "pl_i2s" };
+    audio_pipeline_link(pipeline, &link_tag[0], 3);
+
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    pl.evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(pipeline, pl.evt);
+    pl.done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(bench_pipeline_task, "pl_evt", BENCH_PIPELINE_TASK_STACK, &pl, 5, NULL, 1);
+    result->elements = 3;
+    result->tasks = 4;
+    result->stacks += BENCH_PIPELINE_TASK_STACK;
+
+    result->create_us = (int)(esp_timer_get_time() - start);
+    result->create_heap = bench_heap(&before);
+
+    start = esp_timer_get_time();
+    audio_element_set_uri(reader, uri);
+    int ret = audio_pipeline_run(pipeline);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(pl.done, portMAX_DELAY);
+    }
+    result->first_us = bench_first ? (int)(bench_first - start) : -1;
+    result->heap = bench_heap(&before);
+    result->heap_peak = bench_heap_peak(&before);
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_remove_listener(pipeline);
+    audio_pipeline_deinit(pipeline);
+    audio_event_iface_destroy(pl.evt);
+    vSemaphoreDelete(pl.done);
+    return ret == ESP_OK && !pl.failed && bench_first ? 0 : -1;
+}
+
+typedef struct {
+    const char *name;
+    const char *uri;
+    int (*run)(const char *uri, bench_result_t *result);
+} bench_case_t;
+
+int main(void)
+{
+    test_dir_create();
+    test_wav_write(test_path("tone.wav"), BENCH_RATE, 2, BENCH_FRAMES);
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_HTTP_ROOT", test_dir, 1);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+
+    static const bench_case_t cases[] = {
+        { "player eager, file", "/sdcard/tone.wav", bench_eager_run },
+        { "player, file", "/sdcard/tone.wav", bench_lazy_run },
+        { "pipeline_player, file", "/sdcard/tone.wav", bench_pipeline_run },
+        { "player eager, http", "http://loopback/tone.wav", bench_eager_run },
+        { "player, http", "http://loopback/tone.wav", bench_lazy_run },
+        { "pipeline_player, http", "http://loopback/tone.wav", bench_pipeline_run },
+    };
+    // the I2S driver stays installed between the players, as audio.recorder shares it on the board
+    bench_result_t warm;
+    bench_lazy_run(cases[0].uri, &warm);
+
+    printf("44.1 kHz stereo WAV, best of %d\n", BENCH_RUNS);
+    printf("%-24s %9s %8s %8s %9s %8s %6s %7s %9s\n", "player", "create us", "create", "heap", "heap peak",
+           "elements", "tasks", "stacks", "first us");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        // the memory is the same on every run, the times are the best ones
+        bench_result_t best = { 0 };
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            bench_result_t r;
+            if (cases[i].run(cases[i].uri, &r) != 0) {
+                failed++;
+                break;
+            }
+            if (run > 0) {
+                r.create_us = r.create_us < best.create_us ? r.create_us : best.create_us;
+                r.first_us = r.first_us < best.first_us ? r.first_us : best.first_us;
+            }
+            best = r;
+        }
+        printf("%-24s %9d %8d %8d %9d %8d %6d %7d %9d\n", cases[i].name, best.create_us, (int)best.create_heap,
+               (int)best.heap, (int)best.heap_peak, best.elements, best.tasks, best.stacks, best.first_us);
+    }
+
+    // WAV content under other names, the first play of each probes it, the others hit the cache
+    static const char *const sources[] = {
+        "/sdcard/song.wav", "/sdcard/song.mp3", "/sdcard/song",
+        "http://loopback/song.wav", "http://loopback/song.mp3", "http://loopback/song",
+    };
+    for (int i = 0; i < 3; i++) {
+        rename(test_path("tone.wav"), test_path(sources[i] + 8));
+        test_wav_write(test_path("tone.wav"), BENCH_RATE, 2, BENCH_FRAMES);
+    }
+    printf("\nfirst us, cold on the first play, warm the best of %d after it, - when it fails\n", BENCH_RUNS - 1);
+    printf("%-26s %11s %11s %11s %11s\n", "source", "suffix cold", "suffix warm", "probe cold", "probe warm");
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+        int first[2][2];
+        for (int mode = 0; mode < 2; mode++) {
+            first[mode][0] = first[mode][1] = -1;
+            for (int run = 0; run < BENCH_RUNS; run++) {
+                bench_result_t r;
+                if (bench_player_run(sources[i], mode ? BENCH_PROBE : BENCH_SUFFIX, &r) != 0) {
+                    break;
+                }
+                int *slot = &first[mode][run > 0];
+                *slot = *slot < 0 || r.first_us < *slot ? r.first_us : *slot;
+            }
+        }
+        printf("%-26s", sources[i]);
+        for (int mode = 0; mode < 2; mode++) {
+            for (int k = 0; k < 2; k++) {
+                if (first[mode][k] < 0) {
+                    printf(" %11s", "-");
+                } else {
+                    printf(" %11d", first[mode][k]);
+                }
+            }
+        }
+        printf("\n");
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
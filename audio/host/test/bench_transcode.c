@@ -0,0 +1,221 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_adpcm_encoder.h"
+#include "audio_element.h"
+#include "audio_pipeline.h"
+#include "extmod/vfs_fat.h"
+#include "filter_resample.h"
+#include "http_stream.h"
+#include "vfs_stream.h"
+#include "wav_decoder.h"
+#include "wav_encoder.h"
+
+#include "test_audio.h"
+
+// Throughput of the audio.transcode chain per format pair, in x realtime, on the host elements.
+// The elements are those audio_transcode.c creates, MP3/AMR/Opus are stubs on the host and left out.
+//   AUDIO_HOST_LOG=1 make -C audio/host/test bench
+
+#define BENCH_SECONDS (30)
+#define BENCH_RUNS (3)
+
+enum {
+    BENCH_PCM,
+    BENCH_WAV,
+    BENCH_ADPCM,
+};
+
+typedef struct {
+    const char *name;
+    const char *src;
+    int format;
+    int rate;
+    int channels;
+} bench_pair_t;
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    audio_element_handle_t decoder;
+    audio_element_handle_t filter;
+    audio_element_handle_t writer;
+} bench_chain_t;
+
+// transcode_event() without a filter, the writer takes the source format
+static esp_err_t bench_event(audio_element_handle_t el, audio_event_iface_msg_t *msg, void *ctx)
+{
+    bench_chain_t *c = ctx;
+    if (msg->cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
+        audio_element_info_t info;
+        audio_element_getinfo(el, &info);
+        if (c->filter != NULL) {
+            rsp_filter_set_src_info(c->filter, info.sample_rates, info.channels);
+        } else {
+            audio_element_set_music_info(c->writer, info.sample_rates, info.channels, 16);
+        }
+        return ESP_OK;
+    }
+    return audio_event_iface_cmd(c->evt, msg);
+}
+
+static void bench_chain_init(bench_chain_t *c, const bench_pair_t *pair, const char *dst)
+{
+    memset(c, 0, sizeof(*c));
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    c->pipeline = audio_pipeline_init(&pipeline_cfg);
+    const char *link_tag[5];
+    int link_num = 0;
+
+    audio_element_handle_t reader;
+    if (strncmp(pair->src, "http", 4) == 0) {
+        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+        http_cfg.type = AUDIO_STREAM_READER;
+        reader = http_stream_init(&http_cfg);
+    } else {
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_READER;
+        reader = vfs_stream_init(&vfs_cfg);
+    }
+    audio_element_set_uri(reader, pair->src);
+    audio_pipeline_register(c->pipeline, reader, "tc_in");
+    link_tag[link_num++] = "tc_in";
+
+    wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    c->decoder = wav_decoder_init(&wav_dec_cfg);
+    audio_element_set_event_callback(c->decoder, bench_event, c);
+    audio_pipeline_register(c->pipeline, c->decoder, "tc_dec");
+    link_tag[link_num++] = "tc_dec";
+
+    if (pair->rate > 0) {
+        rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+        rsp_cfg.dest_rate = pair->rate;
+        rsp_cfg.dest_ch = pair->channels;
+        c->filter = rsp_filter_init(&rsp_cfg);
+        audio_pipeline_register(c->pipeline, c->filter, "tc_rsp");
+        link_tag[link_num++] = "tc_rsp";
+    }
+    if (pair->format == BENCH_WAV) {
+        wav_encoder_cfg_t wav_enc_cfg = DEFAULT_WAV_ENCODER_CONFIG();
+        audio_pipeline_register(c->pipeline, wav_encoder_init(&wav_enc_cfg), "tc_enc");
+        link_tag[link_num++] = "tc_enc";
+    } else if (pair->format == BENCH_ADPCM) {
+        audio_adpcm_encoder_cfg_t adpcm_cfg = AUDIO_ADPCM_ENCODER_CFG_DEFAULT();
+        adpcm_cfg.sample_rate = pair->rate;
+        adpcm_cfg.channels = pair->channels;
+        audio_pipeline_register(c->pipeline, audio_adpcm_encoder_init(&adpcm_cfg), "tc_enc");
+        link_tag[link_num++] = "tc_enc";
+    }
+
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_WRITER;
+    c->writer = vfs_stream_init(&vfs_cfg);
+    audio_element_set_uri(c->writer, dst);
+    audio_element_info_t info;
+    audio_element_getinfo(c->writer, &info);
+    info.sample_rates = pair->rate;
+    info.channels = pair->channels;
+    info.bits = pair->format == BENCH_ADPCM ? AUDIO_ADPCM_WAV_BITS : 16;
+    audio_element_setinfo(c->writer, &info);
+    audio_pipeline_register(c->pipeline, c->writer, "tc_out");
+    link_tag[link_num++] = "tc_out";
+
+    audio_pipeline_link(c->pipeline, link_tag, link_num);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    c->evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(c->pipeline, c->evt);
+}
+
+static void bench_chain_deinit(bench_chain_t *c)
+{
+    audio_pipeline_stop(c->pipeline);
+    audio_pipeline_wait_for_stop(c->pipeline);
+    audio_pipeline_terminate(c->pipeline);
+    audio_pipeline_remove_listener(c->pipeline);
+    audio_pipeline_deinit(c->pipeline);
+    audio_event_iface_destroy(c->evt);
+}
+
+// the best of BENCH_RUNS, in x realtime, 0 when the conversion failed
+static double bench_run(const bench_pair_t *pair, long *out_bytes)
+{
+    const char *name = pair->format == BENCH_PCM ? "out.pcm" : "out.wav";
+    char dst[32];
+    snprintf(dst, sizeof(dst), "/sdcard/%s", name);
+    double best = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        bench_chain_t c;
+        bench_chain_init(&c, pair, dst);
+        int64_t start = esp_timer_get_time();
+        int status = audio_pipeline_run(c.pipeline) == ESP_OK ? test_wait_end(c.evt, c.writer, 60000) : -1;
+        int64_t elapsed = esp_timer_get_time() - start;
+        bench_chain_deinit(&c);
+        if (status != AEL_STATUS_STATE_FINISHED) {
+            return 0;
+        }
+        double speed = BENCH_SECONDS * 1e6 / (elapsed > 0 ? elapsed : 1);
+        best = speed > best ? speed : best;
+    }
+    FILE *f = fopen(test_path(name), "rb");
+    fseek(f, 0, SEEK_END);
+    *out_bytes = ftell(f);
+    fclose(f);
+    return best;
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_HTTP_ROOT", test_dir, 1);
+    test_wav_write(test_path("cd.wav"), 44100, 2, 44100 * BENCH_SECONDS);
+    test_wav_write(test_path("voice.wav"), 16000, 1, 16000 * BENCH_SECONDS);
+
+    static const bench_pair_t pairs[] = {
+        { "WAV 44.1k/2 -> WAV copy", "/sdcard/cd.wav", BENCH_WAV, 0, 0 },
+        { "WAV 44.1k/2 -> PCM copy", "/sdcard/cd.wav", BENCH_PCM, 0, 0 },
+        { "WAV 44.1k/2 -> WAV 16k/1", "/sdcard/cd.wav", BENCH_WAV, 16000, 1 },
+        { "WAV 44.1k/2 -> ADPCM 16k/1", "/sdcard/cd.wav", BENCH_ADPCM, 16000, 1 },
+        { "WAV 16k/1 -> WAV 48k/2", "/sdcard/voice.wav", BENCH_WAV, 48000, 2 },
+        { "WAV 16k/1 -> ADPCM 16k/1", "/sdcard/voice.wav", BENCH_ADPCM, 16000, 1 },
+        { "http WAV 44.1k/2 -> WAV 16k/1", "http://loopback/cd.wav", BENCH_WAV, 16000, 1 },
+    };
+    printf("%-32s %12s %12s\n", "pair", "x realtime", "out bytes");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        long out_bytes = 0;
+        double speed = bench_run(&pairs[i], &out_bytes);
+        if (speed == 0) {
+            printf("%-32s %12s\n", pairs[i].name, "failed");
+            failed++;
+            continue;
+        }
+        printf("%-32s %12.1f %12ld\n", pairs[i].name, speed, out_bytes);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+# Reference files of test_vad.c, harmonic speech bursts in Gaussian noise
+#   cd audio/host/test/data && python3 gen_vad.py
+# Each <name>.wav gets a <name>.wav.truth of "n|s start end" lines, noise or speech in frames
+import math
+import random
+import struct
+import wave
+
+random.seed(1)
+
+
+def make(name, rate, noise, segs, ch=1):
+    x = []
+    truth = []
+    t = 0
+    for kind, dur in segs:
+        n = int(rate * dur)
+        if kind == 's':
+            f0 = random.uniform(110, 220)
+            for i in range(n):
+                tt = i / rate
+                env = math.sin(math.pi * i / n) ** 0.5 * (0.6 + 0.4 * math.sin(2 * math.pi * 4 * tt))
+                v = sum(math.sin(2 * math.pi * f0 * k * tt) / k for k in range(1, 12)) * 3000 * env
+                x.append(v + random.gauss(0, noise))
+        else:
+            for i in range(n):
+                x.append(random.gauss(0, noise))
+        truth.append((kind, t, t + n))
+        t += n
+    w = wave.open(name, 'wb')
+    w.setnchannels(ch)
+    w.setsampwidth(2)
+    w.setframerate(rate)
+    w.writeframes(b''.join(struct.pack('<' + 'h' * ch, *([max(-32768, min(32767, int(v)))] * ch)) for v in x))
+    w.close()
+    with open(name + '.truth', 'w') as f:
+        f.write(''.join(f'{k} {a} {b}\n' for k, a, b in truth))
+
+
+make('quiet16k.wav', 16000, 60, [('n', 2.0), ('s', 0.8), ('n', 1.5), ('s', 1.2), ('n', 0.4), ('s', 0.6), ('n', 3.0)])
+make('noisy8k.wav', 8000, 400, [('n', 1.0), ('s', 1.0), ('n', 2.5), ('s', 0.9), ('n', 2.0)])
+make('stereo16k.wav', 16000, 100, [('n', 1.2), ('s', 1.0), ('n', 2.0), ('s', 0.7), ('n', 1.5)], ch=2)
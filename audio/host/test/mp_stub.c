@@ -0,0 +1,454 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The MicroPython calls of the C sources under test, on stdio
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "extmod/vfs.h"
+#include "py/objtuple.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#define STUB_STR_NUM (16)
+#define STUB_STR_LEN (256)
+// MICROPY_SCHEDULER_DEPTH
+#define STUB_SCHED_DEPTH (4)
+
+const int mp_const_none_obj;
+const int mp_const_false_obj;
+const int mp_const_true_obj;
+__thread nlr_buf_t *mp_stub_nlr_top;
+char mp_stub_sdcard[256] = ".";
+
+typedef struct {
+    mp_obj_base_t base;
+    size_t len;
+    mp_obj_t items[10];
+} mp_stub_tuple_t;
+const mp_map_t mp_const_empty_map;
+
+const mp_obj_type_t mp_type_type = { { &mp_type_type }, .name = "type" };
+const mp_obj_type_t mp_type_dict = { { &mp_type_type }, .name = "dict" };
+const mp_obj_type_t mp_type_attrtuple = { { &mp_type_type }, .name = "tuple" };
+const mp_obj_type_t mp_type_fun_builtin_0 = { { &mp_type_type }, .name = "function" };
+const mp_obj_type_t mp_type_fun_builtin_1 = { { &mp_type_type }, .name = "function" };
+const mp_obj_type_t mp_type_fun_builtin_2 = { { &mp_type_type }, .name = "function" };
+const mp_obj_type_t mp_type_fun_builtin_3 = { { &mp_type_type }, .name = "function" };
+const mp_obj_type_t mp_type_fun_builtin_var = { { &mp_type_type }, .name = "function" };
+const mp_obj_type_t mp_type_AttributeError = { { &mp_type_type }, .name = "AttributeError" };
+const mp_obj_type_t mp_type_ImportError = { { &mp_type_type }, .name = "ImportError" };
+const mp_obj_type_t mp_type_OSError = { { &mp_type_type }, .name = "OSError" };
+const mp_obj_type_t mp_type_TypeError = { { &mp_type_type }, .name = "TypeError" };
+const mp_obj_type_t mp_type_ValueError = { { &mp_type_type }, .name = "ValueError" };
+
+static struct {
+    mp_obj_t fun;
+    mp_obj_t arg;
+} mp_stub_sched[STUB_SCHED_DEPTH];
+static unsigned int mp_stub_sched_len;
+static pthread_mutex_t mp_stub_sched_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the strings only live until the next few calls, like short-lived objects before a collection
+mp_obj_t mp_obj_new_str(const char *data, size_t len)
+{
+    static __thread char strs[STUB_STR_NUM][STUB_STR_LEN];
+    static __thread int next;
+    char *str = strs[next++ % STUB_STR_NUM];
+    if (len >= STUB_STR_LEN) {
+        len = STUB_STR_LEN - 1;
+    }
+    memcpy(str, data, len);
+    str[len] = '\0';
+    return str;
+}
+
+void nlr_jump(void *val)
+{
+    nlr_buf_t *top = mp_stub_nlr_top;
+    if (top == NULL) {
+        fprintf(stderr, "uncaught exception\n");
+        abort();
+    }
+    mp_stub_nlr_top = top->prev;
+    top->ret_val = val;
+    longjmp(top->jmp, 1);
+}
+
+// an exception is its type, the message goes to stderr
+__attribute__((noreturn)) static void mp_stub_raise(const mp_obj_type_t *exc_type, const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", exc_type->name, msg);
+    nlr_jump((void *)exc_type);
+}
+
+void mp_raise_msg(const mp_obj_type_t *exc_type, mp_rom_error_text_t msg)
+{
+    mp_stub_raise(exc_type, msg);
+}
+
+void mp_raise_msg_varg(const mp_obj_type_t *exc_type, mp_rom_error_text_t fmt, ...)
+{
+    char msg[STUB_STR_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    mp_stub_raise(exc_type, msg);
+}
+
+void mp_raise_ValueError(mp_rom_error_text_t msg)
+{
+    mp_stub_raise(&mp_type_ValueError, msg);
+}
+
+void mp_raise_TypeError(mp_rom_error_text_t msg)
+{
+    mp_stub_raise(&mp_type_TypeError, msg);
+}
+
+void mp_raise_OSError(int errno_)
+{
+    mp_stub_raise(&mp_type_OSError, strerror(errno_));
+}
+
+void mp_arg_check_num(size_t n_args, size_t n_kw, size_t n_args_min, size_t n_args_max, bool takes_kw)
+{
+    if (n_args < n_args_min || n_args > n_args_max || (n_kw > 0 && !takes_kw)) {
+        mp_raise_TypeError("wrong number of arguments");
+    }
+}
+
+static mp_arg_val_t mp_stub_arg_val(const mp_arg_t *allowed, mp_obj_t obj)
+{
+    mp_arg_val_t val;
+    switch (allowed->flags & MP_ARG_KIND_MASK) {
+        case MP_ARG_BOOL:
+            val.u_bool = mp_obj_is_true(obj);
+            break;
+        case MP_ARG_INT:
+            val.u_int = mp_obj_get_int(obj);
+            break;
+        default:
+            val.u_obj = obj;
+            break;
+    }
+    return val;
+}
+
+void mp_arg_parse_all(size_t n_pos, const mp_obj_t *pos, mp_map_t *kws, size_t n_allowed,
+                      const mp_arg_t *allowed, mp_arg_val_t *out_vals)
+{
+    size_t used_kw = 0;
+    for (size_t i = 0; i < n_allowed; i++) {
+        mp_obj_t given = MP_OBJ_NULL;
+        if (i < n_pos) {
+            if (allowed[i].flags & MP_ARG_KW_ONLY) {
+                mp_raise_TypeError("extra positional arguments given");
+            }
+            given = pos[i];
+        } else {
+            for (size_t k = 0; kws != NULL && k < kws->used; k++) {
+                if (strcmp(kws->table[k].key, allowed[i].qst) == 0) {
+                    given = kws->table[k].value;
+                    used_kw++;
+                }
+            }
+        }
+        if (given != MP_OBJ_NULL) {
+            out_vals[i] = mp_stub_arg_val(&allowed[i], given);
+        } else if (allowed[i].flags & MP_ARG_REQUIRED) {
+            mp_raise_msg_varg(&mp_type_TypeError, "'%s' argument required", allowed[i].qst);
+        } else {
+            out_vals[i] = allowed[i].defval;
+        }
+    }
+    if (n_pos > n_allowed || (kws != NULL && used_kw < kws->used)) {
+        mp_raise_TypeError("extra arguments given");
+    }
+}
+
+void mp_arg_parse_all_kw_array(size_t n_pos, size_t n_kw, const mp_obj_t *args, size_t n_allowed,
+                               const mp_arg_t *allowed, mp_arg_val_t *out_vals)
+{
+    mp_map_t kw_args = { .used = n_kw, .table = (mp_map_elem_t *)(args + n_pos) };
+    mp_arg_parse_all(n_pos, args, &kw_args, n_allowed, allowed, out_vals);
+}
+
+// from any thread, as the ISRs and the element tasks do on the board
+bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg)
+{
+    pthread_mutex_lock(&mp_stub_sched_lock);
+    bool queued = mp_stub_sched_len < STUB_SCHED_DEPTH;
+    if (queued) {
+        mp_stub_sched[mp_stub_sched_len].fun = function;
+        mp_stub_sched[mp_stub_sched_len].arg = arg;
+        mp_stub_sched_len++;
+    }
+    pthread_mutex_unlock(&mp_stub_sched_lock);
+    return queued;
+}
+
+unsigned int mp_sched_num_pending(void)
+{
+    pthread_mutex_lock(&mp_stub_sched_lock);
+    unsigned int len = mp_stub_sched_len;
+    pthread_mutex_unlock(&mp_stub_sched_lock);
+    return len;
+}
+
+void mp_handle_pending(bool raise_exc)
+{
+    for (;;) {
+        pthread_mutex_lock(&mp_stub_sched_lock);
+        if (mp_stub_sched_len == 0) {
+            pthread_mutex_unlock(&mp_stub_sched_lock);
+            return;
+        }
+        mp_obj_t fun = mp_stub_sched[0].fun;
+        mp_obj_t arg = mp_stub_sched[0].arg;
+        mp_stub_sched_len--;
+        memmove(&mp_stub_sched[0], &mp_stub_sched[1], mp_stub_sched_len * sizeof(mp_stub_sched[0]));
+        pthread_mutex_unlock(&mp_stub_sched_lock);
+        mp_call_function_1(fun, arg);
+    }
+}
+
+// only the builtin functions of the C sources and the tests can be called
+mp_obj_t mp_call_function_1(mp_obj_t fun, mp_obj_t arg)
+{
+    const mp_obj_fun_builtin_fixed_t *builtin = fun;
+    if (builtin->base.type != &mp_type_fun_builtin_1) {
+        mp_raise_TypeError("object isn't callable");
+    }
+    return builtin->fun._1(arg);
+}
+
+// there are no Python modules to import, asyncio is never available
+qstr qstr_from_str(const char *str)
+{
+    return str;
+}
+
+mp_obj_t mp_import_name(qstr name, mp_obj_t fromlist, mp_obj_t level)
+{
+    mp_raise_msg_varg(&mp_type_ImportError, "no module named '%s'", name);
+}
+
+mp_obj_t mp_load_attr(mp_obj_t base, qstr attr)
+{
+    mp_raise_msg_varg(&mp_type_AttributeError, "no attribute '%s'", attr);
+}
+
+void mp_load_method(mp_obj_t base, qstr attr, mp_obj_t *dest)
+{
+    mp_load_attr(base, attr);
+}
+
+mp_obj_t mp_call_method_n_kw(size_t n_args, size_t n_kw, const mp_obj_t *args)
+{
+    mp_raise_TypeError("object isn't callable");
+}
+
+mp_obj_t mp_make_stop_iteration(mp_obj_t o)
+{
+    return MP_OBJ_STOP_ITERATION;
+}
+
+// the stream methods go through the protocol of the type, the tests call it directly
+static mp_obj_t mp_stub_stream_method(size_t n_args, const mp_obj_t *args)
+{
+    mp_raise_TypeError("stream methods aren't available");
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_read_obj, 1, 2, mp_stub_stream_method);
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_write_obj, 2, 4, mp_stub_stream_method);
+
+// the objects with a buffer are those of the module types with a buffer slot
+void mp_get_buffer_raise(mp_obj_t obj, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    const mp_obj_type_t *type = ((mp_obj_base_t *)obj)->type;
+    if (type == NULL || type->buffer == NULL || type->buffer(obj, bufinfo, flags) != 0) {
+        mp_raise_TypeError("object with buffer protocol required");
+    }
+}
+
+mp_obj_t mp_obj_new_bool(mp_int_t x)
+{
+    return x ? mp_const_true : mp_const_false;
+}
+
+bool mp_obj_is_true(mp_obj_t arg)
+{
+    return arg != mp_const_false && arg != mp_const_none && arg != MP_OBJ_NEW_SMALL_INT(0);
+}
+
+mp_obj_t mp_obj_new_int(mp_int_t value)
+{
+    return MP_OBJ_NEW_SMALL_INT(value);
+}
+
+mp_obj_t mp_obj_new_int_from_uint(mp_uint_t value)
+{
+    return MP_OBJ_NEW_SMALL_INT(value);
+}
+
+mp_obj_t mp_obj_new_int_from_ll(long long val)
+{
+    return MP_OBJ_NEW_SMALL_INT(val);
+}
+
+// a float is boxed on the C heap
+mp_obj_t mp_obj_new_float(mp_float_t value)
+{
+    mp_float_t *f = malloc(sizeof(mp_float_t));
+    *f = value;
+    return f;
+}
+
+mp_int_t mp_obj_get_int(mp_const_obj_t arg)
+{
+    return (mp_int_t)arg;
+}
+
+mp_int_t mp_obj_get_int_truncated(mp_const_obj_t arg)
+{
+    return (mp_int_t)arg;
+}
+
+const char *mp_obj_str_get_str(mp_obj_t self_in)
+{
+    return self_in;
+}
+
+const char *mp_obj_str_get_data(mp_obj_t self_in, size_t *len)
+{
+    *len = strlen(self_in);
+    return self_in;
+}
+
+void mp_obj_tuple_get(mp_obj_t self_in, size_t *len, mp_obj_t **items)
+{
+    mp_obj_tuple_t *tuple = self_in;
+    *len = tuple->len;
+    *items = tuple->items;
+}
+
+void mp_obj_get_array(mp_obj_t o, size_t *len, mp_obj_t **items)
+{
+    mp_obj_tuple_get(o, len, items);
+}
+
+// the tuples stay until the end of the test like everything on the C heap
+mp_obj_t mp_obj_new_tuple(size_t n, const mp_obj_t *items)
+{
+    mp_obj_tuple_t *tuple = malloc(sizeof(mp_obj_tuple_t) + n * sizeof(mp_obj_t));
+    tuple->base.type = &mp_type_attrtuple;
+    tuple->len = n;
+    if (items != NULL) {
+        memcpy(tuple->items, items, n * sizeof(mp_obj_t));
+    }
+    return tuple;
+}
+
+mp_obj_t mp_obj_new_attrtuple(const qstr *fields, size_t n, const mp_obj_t *items)
+{
+    return mp_obj_new_tuple(n, items);
+}
+
+static const char *mp_stub_path(const char *path, char *name, size_t size)
+{
+    if (strncmp(path, "/sdcard", 7) == 0) {
+        snprintf(name, size, "%s%s", mp_stub_sdcard, path + 7);
+        return name;
+    }
+    return path;
+}
+
+mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
+{
+    char name[512];
+    const char *path = mp_stub_path(args[0], name, sizeof(name));
+    FILE *file = fopen(path, n_args > 1 ? (const char *)args[1] : "r");
+    if (file == NULL) {
+        nlr_jump(NULL);
+    }
+    return file;
+}
+
+// st_mode, st_ino, st_dev, st_nlink, st_uid, st_gid, st_size, st_atime, st_mtime, st_ctime
+mp_obj_t mp_vfs_stat(mp_obj_t path_in)
+{
+    static __thread mp_stub_tuple_t tuple;
+    char name[512];
+    struct stat st;
+    if (stat(mp_stub_path(path_in, name, sizeof(name)), &st) != 0) {
+        nlr_jump(NULL);
+    }
+    memset(&tuple, 0, sizeof(tuple));
+    tuple.base.type = &mp_type_attrtuple;
+    tuple.len = 10;
+    tuple.items[0] = (mp_obj_t)(mp_int_t)st.st_mode;
+    tuple.items[6] = (mp_obj_t)(mp_int_t)st.st_size;
+    tuple.items[7] = (mp_obj_t)(mp_int_t)st.st_atime;
+    tuple.items[8] = (mp_obj_t)(mp_int_t)st.st_mtime;
+    tuple.items[9] = (mp_obj_t)(mp_int_t)st.st_ctime;
+    return &tuple;
+}
+
+ssize_t mp_stream_posix_write(void *stream, const void *buf, size_t len)
+{
+    size_t n = fwrite(buf, 1, len, stream);
+    return n > 0 || len == 0 ? (ssize_t)n : -1;
+}
+
+ssize_t mp_stream_posix_read(void *stream, void *buf, size_t len)
+{
+    size_t n = fread(buf, 1, len, stream);
+    return n > 0 || !ferror(stream) ? (ssize_t)n : -1;
+}
+
+off_t mp_stream_posix_lseek(void *stream, off_t offset, int whence)
+{
+    if (fseeko(stream, offset, whence) != 0) {
+        return -1;
+    }
+    return ftello(stream);
+}
+
+int mp_stream_posix_fsync(void *stream)
+{
+    return fflush(stream);
+}
+
+mp_obj_t mp_stream_close(mp_obj_t stream)
+{
+    fclose(stream);
+    return mp_const_none;
+}
@@ -0,0 +1,58 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef _TEST_PY_MISC_H_
+#define _TEST_PY_MISC_H_
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef unsigned char byte;
+
+#define MP_ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+// the GC heap is the C heap, cleared like the GC blocks, there is no collection to run a
+// finaliser or to retry after
+#define m_new(type, num) ((type *)calloc((num), sizeof(type)))
+#define m_new0(type, num) m_new(type, num)
+#define m_new_maybe(type, num) m_new(type, num)
+#define m_new_obj(type) m_new(type, 1)
+#define m_new_obj_with_finaliser(type) m_new(type, 1)
+#define m_del(type, ptr, num) ((void)(num), free(ptr))
+
+// a growable string, see mp_stub.c
+typedef struct _vstr_t {
+    size_t alloc;
+    size_t len;
+    char *buf;
+    bool fixed_buf;
+} vstr_t;
+
+void vstr_init(vstr_t *vstr, size_t alloc);
+void vstr_clear(vstr_t *vstr);
+char *vstr_add_len(vstr_t *vstr, size_t len);
+void vstr_add_str(vstr_t *vstr, const char *str);
+void vstr_add_strn(vstr_t *vstr, const char *str, size_t len);
+char *vstr_null_terminated_str(vstr_t *vstr);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef _TEST_PY_OBJ_H_
+#define _TEST_PY_OBJ_H_
+
+// The MicroPython objects the C sources under test touch, see mp_stub.c. A file object is
+// a stdio FILE, a str or a qstr is a C string, an int is the pointer value itself. The
+// types, functions and dicts are laid out enough for the module sources to compile.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "py/misc.h"
+#include "py/mpconfig.h"
+
+// MP_QSTR_xxx as "xxx", collected from the sources by the Makefile
+#include "genhdr/qstrdefs.generated.h"
+
+typedef void *mp_obj_t;
+typedef const void *mp_const_obj_t;
+typedef const void *mp_rom_obj_t;
+typedef const char *qstr;
+typedef const char *mp_rom_error_text_t;
+
+qstr qstr_from_str(const char *str);
+
+typedef struct _mp_obj_type_t mp_obj_type_t;
+typedef struct _mp_obj_dict_t mp_obj_dict_t;
+
+typedef struct _mp_obj_base_t {
+    const mp_obj_type_t *type;
+} mp_obj_base_t;
+
+typedef struct _mp_map_elem_t {
+    mp_obj_t key;
+    mp_obj_t value;
+} mp_map_elem_t;
+
+typedef struct _mp_rom_map_elem_t {
+    mp_rom_obj_t key;
+    mp_rom_obj_t value;
+} mp_rom_map_elem_t;
+
+typedef struct _mp_map_t {
+    size_t used;
+    mp_map_elem_t *table;
+} mp_map_t;
+
+struct _mp_obj_dict_t {
+    mp_obj_base_t base;
+    mp_map_t map;
+};
+
+typedef struct _mp_obj_module_t {
+    mp_obj_base_t base;
+    mp_obj_dict_t *globals;
+} mp_obj_module_t;
+
+typedef struct _mp_buffer_info_t {
+    void *buf;
+    size_t len;
+    int typecode;
+} mp_buffer_info_t;
+
+#define MP_BUFFER_READ (1)
+#define MP_BUFFER_WRITE (2)
+
+typedef enum {
+    MP_UNARY_OP_BOOL,
+    MP_UNARY_OP_LEN,
+} mp_unary_op_t;
+
+typedef enum {
+    MP_BINARY_OP_CONTAINS,
+} mp_binary_op_t;
+
+typedef mp_obj_t (*mp_make_new_fun_t)(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args);
+typedef mp_obj_t (*mp_unary_op_fun_t)(mp_unary_op_t op, mp_obj_t self_in);
+typedef mp_obj_t (*mp_subscr_fun_t)(mp_obj_t self_in, mp_obj_t index, mp_obj_t value);
+typedef mp_obj_t (*mp_iternext_fun_t)(mp_obj_t self_in);
+typedef mp_int_t (*mp_buffer_fun_t)(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags);
+
+#define MP_TYPE_FLAG_NONE (0x0000)
+#define MP_TYPE_FLAG_ITER_IS_ITERNEXT (0x0080)
+
+// the slots a module type sets, by name as in MP_DEFINE_CONST_OBJ_TYPE
+struct _mp_obj_type_t {
+    mp_obj_base_t base;
+    unsigned flags;
+    qstr name;
+    mp_make_new_fun_t make_new;
+    mp_unary_op_fun_t unary_op;
+    mp_subscr_fun_t subscr;
+    mp_iternext_fun_t iter;
+    mp_buffer_fun_t buffer;
+    const void *protocol;
+    const mp_obj_dict_t *locals_dict;
+};
+
+#define MP_TYPE_SLOT_1(slot, value) .slot = value
+#define MP_TYPE_SLOT_2(slot, value, ...) .slot = value, MP_TYPE_SLOT_1(__VA_ARGS__)
+#define MP_TYPE_SLOT_3(slot, value, ...) .slot = value, MP_TYPE_SLOT_2(__VA_ARGS__)
+#define MP_TYPE_SLOT_4(slot, value, ...) .slot = value, MP_TYPE_SLOT_3(__VA_ARGS__)
+#define MP_TYPE_SLOT_N(_1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define MP_TYPE_SLOTS(...) \
+    MP_TYPE_SLOT_N(__VA_ARGS__, MP_TYPE_SLOT_4, , MP_TYPE_SLOT_3, , MP_TYPE_SLOT_2, , MP_TYPE_SLOT_1, )(__VA_ARGS__)
+
+#define MP_DEFINE_CONST_OBJ_TYPE(_typename, _name, _flags, ...) \
+    const mp_obj_type_t _typename = { .base = { &mp_type_type }, .flags = _flags, .name = _name, MP_TYPE_SLOTS(__VA_ARGS__) }
+
+#define MP_DEFINE_CONST_DICT(dict_name, table_name) \
+    const mp_obj_dict_t dict_name = { \
+        .base = { &mp_type_dict }, \
+        .map = { .used = MP_ARRAY_SIZE(table_name), .table = (mp_map_elem_t *)(mp_rom_map_elem_t *)table_name }, \
+    }
+
+typedef mp_obj_t (*mp_fun_0_t)(void);
+typedef mp_obj_t (*mp_fun_1_t)(mp_obj_t);
+typedef mp_obj_t (*mp_fun_2_t)(mp_obj_t, mp_obj_t);
+typedef mp_obj_t (*mp_fun_3_t)(mp_obj_t, mp_obj_t, mp_obj_t);
+typedef mp_obj_t (*mp_fun_var_t)(size_t n, const mp_obj_t *);
+typedef mp_obj_t (*mp_fun_kw_t)(size_t n, const mp_obj_t *, mp_map_t *);
+
+typedef struct _mp_obj_fun_builtin_fixed_t {
+    mp_obj_base_t base;
+    union {
+        mp_fun_0_t _0;
+        mp_fun_1_t _1;
+        mp_fun_2_t _2;
+        mp_fun_3_t _3;
+    } fun;
+} mp_obj_fun_builtin_fixed_t;
+
+typedef struct _mp_obj_fun_builtin_var_t {
+    mp_obj_base_t base;
+    size_t n_args_min;
+    size_t n_args_max;
+    union {
+        mp_fun_var_t var;
+        mp_fun_kw_t kw;
+    } fun;
+} mp_obj_fun_builtin_var_t;
+
+#define MP_DECLARE_CONST_FUN_OBJ_0(obj_name) extern const mp_obj_fun_builtin_fixed_t obj_name
+#define MP_DECLARE_CONST_FUN_OBJ_1(obj_name) extern const mp_obj_fun_builtin_fixed_t obj_name
+#define MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(obj_name) extern const mp_obj_fun_builtin_var_t obj_name
+#define MP_DECLARE_CONST_FUN_OBJ_KW(obj_name) extern const mp_obj_fun_builtin_var_t obj_name
+
+#define MP_DEFINE_CONST_FUN_OBJ_0(obj_name, fun_name) \
+    const mp_obj_fun_builtin_fixed_t obj_name = { { &mp_type_fun_builtin_0 }, .fun._0 = fun_name }
+#define MP_DEFINE_CONST_FUN_OBJ_1(obj_name, fun_name) \
+    const mp_obj_fun_builtin_fixed_t obj_name = { { &mp_type_fun_builtin_1 }, .fun._1 = fun_name }
+#define MP_DEFINE_CONST_FUN_OBJ_2(obj_name, fun_name) \
+    const mp_obj_fun_builtin_fixed_t obj_name = { { &mp_type_fun_builtin_2 }, .fun._2 = fun_name }
+#define MP_DEFINE_CONST_FUN_OBJ_3(obj_name, fun_name) \
+    const mp_obj_fun_builtin_fixed_t obj_name = { { &mp_type_fun_builtin_3 }, .fun._3 = fun_name }
+#define MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(obj_name, n_min, n_max, fun_name) \
+    const mp_obj_fun_builtin_var_t obj_name = { { &mp_type_fun_builtin_var }, n_min, n_max, .fun.var = fun_name }
+#define MP_DEFINE_CONST_FUN_OBJ_KW(obj_name, n_min, fun_name) \
+    const mp_obj_fun_builtin_var_t obj_name = { { &mp_type_fun_builtin_var }, n_min, (size_t)-1, .fun.kw = fun_name }
+
+extern const mp_obj_type_t mp_type_type;
+extern const mp_obj_type_t mp_type_dict;
+extern const mp_obj_type_t mp_type_module;
+extern const mp_obj_type_t mp_type_fun_builtin_0;
+extern const mp_obj_type_t mp_type_fun_builtin_1;
+extern const mp_obj_type_t mp_type_fun_builtin_2;
+extern const mp_obj_type_t mp_type_fun_builtin_3;
+extern const mp_obj_type_t mp_type_fun_builtin_var;
+extern const mp_obj_type_t mp_type_ImportError;
+extern const mp_obj_type_t mp_type_KeyError;
+extern const mp_obj_type_t mp_type_OSError;
+extern const mp_obj_type_t mp_type_RuntimeError;
+extern const mp_obj_type_t mp_type_TypeError;
+extern const mp_obj_type_t mp_type_ValueError;
+
+extern const mp_map_t mp_const_empty_map;
+extern const int mp_const_none_obj;
+extern const int mp_const_false_obj;
+extern const int mp_const_true_obj;
+
+#define mp_const_none ((mp_obj_t)&mp_const_none_obj)
+#define mp_const_false ((mp_obj_t)&mp_const_false_obj)
+#define mp_const_true ((mp_obj_t)&mp_const_true_obj)
+#define MP_OBJ_NULL ((mp_obj_t)NULL)
+#define MP_OBJ_STOP_ITERATION ((mp_obj_t)NULL)
+#define MP_OBJ_SENTINEL ((mp_obj_t)4)
+#define MP_OBJ_NEW_QSTR(qst) ((mp_obj_t)(qst))
+#define MP_OBJ_NEW_SMALL_INT(small_int) ((mp_obj_t)(mp_int_t)(small_int))
+#define MP_OBJ_TO_PTR(o) ((void *)(o))
+#define MP_OBJ_FROM_PTR(p) ((mp_obj_t)(p))
+
+#define MP_ROM_INT(i) MP_OBJ_NEW_SMALL_INT(i)
+#define MP_ROM_QSTR(q) MP_OBJ_NEW_QSTR(q)
+#define MP_ROM_PTR(p) ((mp_obj_t)(p))
+
+// only the module objects have a type, an int is told apart as a value below any address
+#define mp_obj_is_type(o, t) (((const mp_obj_base_t *)(o))->type == (t))
+#define mp_obj_is_int(o) ((mp_uint_t)(o) + 0x10000 < 0x20000)
+
+mp_obj_t mp_obj_new_str(const char *data, size_t len);
+mp_obj_t mp_obj_new_int(mp_int_t value);
+mp_obj_t mp_obj_new_int_from_uint(mp_uint_t value);
+mp_obj_t mp_obj_new_int_from_ll(long long val);
+mp_obj_t mp_obj_new_bool(mp_int_t x);
+mp_obj_t mp_obj_new_float(mp_float_t value);
+mp_obj_t mp_obj_new_tuple(size_t n, const mp_obj_t *items);
+mp_obj_t mp_obj_new_attrtuple(const qstr *fields, size_t n, const mp_obj_t *items);
+mp_obj_t mp_obj_new_dict(size_t n_args);
+mp_obj_t mp_obj_dict_store(mp_obj_t self_in, mp_obj_t key, mp_obj_t value);
+
+bool mp_obj_is_true(mp_obj_t arg);
+mp_int_t mp_obj_get_int(mp_const_obj_t arg);
+mp_int_t mp_obj_get_int_truncated(mp_const_obj_t arg);
+void mp_obj_get_array(mp_obj_t o, size_t *len, mp_obj_t **items);
+void mp_obj_tuple_get(mp_obj_t self_in, size_t *len, mp_obj_t **items);
+const char *mp_obj_str_get_str(mp_obj_t self_in);
+const char *mp_obj_str_get_data(mp_obj_t self_in, size_t *len);
+void mp_get_buffer_raise(mp_obj_t obj, mp_buffer_info_t *bufinfo, mp_uint_t flags);
+size_t mp_get_index(const mp_obj_type_t *type, size_t len, mp_obj_t index, bool is_slice);
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef _TEST_PY_RUNTIME_H_
+#define _TEST_PY_RUNTIME_H_
+
+#include <setjmp.h>
+
+#include "py/mperrno.h"
+#include "py/obj.h"
+
+typedef struct _nlr_buf_t nlr_buf_t;
+struct _nlr_buf_t {
+    nlr_buf_t *prev;
+    void *ret_val;
+    jmp_buf jmp;
+};
+
+extern __thread nlr_buf_t *mp_stub_nlr_top;
+
+#define nlr_push(buf) ((buf)->prev = mp_stub_nlr_top, mp_stub_nlr_top = (buf), setjmp((buf)->jmp))
+#define nlr_pop() (mp_stub_nlr_top = mp_stub_nlr_top->prev)
+
+/**
+ * @brief      Raise to the innermost nlr_push of the thread, abort without one like an
+ *             uncaught exception on a task without a handler
+ */
+void nlr_jump(void *val) __attribute__((noreturn));
+
+#define MP_THREAD_GIL_EXIT()
+#define MP_THREAD_GIL_ENTER()
+
+#define MP_ERROR_TEXT(x) (x)
+
+// a root pointer is a global of its own, the host has no collector to scan it
+#define MP_REGISTER_ROOT_POINTER(decl) decl
+#define MP_STATE_VM(x) (x)
+#define MP_REGISTER_MODULE(module_name, obj_module)
+
+#define MP_ARG_BOOL (0x001)
+#define MP_ARG_INT (0x002)
+#define MP_ARG_OBJ (0x003)
+#define MP_ARG_KIND_MASK (0x0ff)
+#define MP_ARG_REQUIRED (0x100)
+#define MP_ARG_KW_ONLY (0x200)
+
+typedef union _mp_arg_val_t {
+    bool u_bool;
+    mp_int_t u_int;
+    mp_obj_t u_obj;
+    mp_rom_obj_t u_rom_obj;
+} mp_arg_val_t;
+
+typedef struct _mp_arg_t {
+    qstr qst;
+    unsigned flags;
+    mp_arg_val_t defval;
+} mp_arg_t;
+
+/**
+ * @brief      Check the argument count of a call, raise TypeError outside [min, max]
+ */
+void mp_arg_check_num(size_t n_args, size_t n_kw, size_t n_args_min, size_t n_args_max, bool takes_kw);
+
+/**
+ * @brief      Fill out[] from the positional args and the keyword map in the order of allowed[],
+ *             a missing argument takes its default, a missing required one raises TypeError
+ */
+void mp_arg_parse_all(size_t n_pos, const mp_obj_t *pos, mp_map_t *kws, size_t n_allowed,
+                      const mp_arg_t *allowed, mp_arg_val_t *out_vals);
+void mp_arg_parse_all_kw_array(size_t n_pos, size_t n_kw, const mp_obj_t *args, size_t n_allowed,
+                               const mp_arg_t *allowed, mp_arg_val_t *out_vals);
+
+void mp_raise_msg(const mp_obj_type_t *exc_type, mp_rom_error_text_t msg) __attribute__((noreturn));
+void mp_raise_msg_varg(const mp_obj_type_t *exc_type, mp_rom_error_text_t fmt, ...) __attribute__((noreturn));
+void mp_raise_ValueError(mp_rom_error_text_t msg) __attribute__((noreturn));
+void mp_raise_TypeError(mp_rom_error_text_t msg) __attribute__((noreturn));
+void mp_raise_OSError(int errno_) __attribute__((noreturn));
+
+/**
+ * @brief      Queue a call for the interpreter, the host runs it at mp_handle_pending
+ */
+bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg);
+
+/**
+ * @brief      Number of calls mp_sched_schedule queued and mp_handle_pending did not run yet
+ */
+unsigned int mp_sched_num_pending(void);
+
+/**
+ * @brief      Run the calls mp_sched_schedule queued, as the VM does between bytecodes
+ */
+void mp_handle_pending(bool raise_exc);
+
+mp_obj_t mp_call_function_1(mp_obj_t fun, mp_obj_t arg);
+mp_obj_t mp_call_method_n_kw(size_t n_args, size_t n_kw, const mp_obj_t *args);
+void mp_load_method(mp_obj_t base, qstr attr, mp_obj_t *dest);
+mp_obj_t mp_load_attr(mp_obj_t base, qstr attr);
+mp_obj_t mp_import_name(qstr name, mp_obj_t fromlist, mp_obj_t level);
+mp_obj_t mp_iternext(mp_obj_t o);
+mp_obj_t mp_make_stop_iteration(mp_obj_t o);
+mp_obj_t mp_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs);
+
+#endif
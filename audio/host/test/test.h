@@ -0,0 +1,63 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef _AUDIO_HOST_TEST_H_
+#define _AUDIO_HOST_TEST_H_
+
+// Minimal assertion helpers of the native tests, every test_*.c is its own program
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int test_failures;
+
+#define TEST_ASSERT(cond)                                                               \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            printf("%s:%d: %s: assertion failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+            test_failures++;                                                            \
+            return;                                                                     \
+        }                                                                               \
+    } while (0)
+
+#define TEST_ASSERT_EQ(a, b)                                                            \
+    do {                                                                                \
+        long long _a = (long long)(a), _b = (long long)(b);                             \
+        if (_a != _b) {                                                                 \
+            printf("%s:%d: %s: %s == %lld, expected %s == %lld\n", __FILE__, __LINE__,   \
+                   __func__, #a, _a, #b, _b);                                           \
+            test_failures++;                                                            \
+            return;                                                                     \
+        }                                                                               \
+    } while (0)
+
+#define TEST_RUN(fn)                     \
+    do {                                 \
+        int _before = test_failures;     \
+        fn();                            \
+        printf("%-40s %s\n", #fn, test_failures == _before ? "ok" : "FAIL"); \
+    } while (0)
+
+#define TEST_EXIT() return test_failures ? EXIT_FAILURE : EXIT_SUCCESS
+
+#endif
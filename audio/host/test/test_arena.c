@@ -0,0 +1,333 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_arena.h"
+#include "test.h"
+
+#define ARENA_TEST_SIZE (256 * 1024)
+
+static uint8_t region[ARENA_TEST_SIZE + AUDIO_ARENA_ALIGN];
+
+static void arena_reset(void)
+{
+    audio_arena_init(region, ARENA_TEST_SIZE);
+}
+
+static audio_arena_stats_t arena_stats(void)
+{
+    audio_arena_stats_t stats;
+    audio_arena_get_stats(&stats);
+    return stats;
+}
+
+static void test_init_too_small(void)
+{
+    audio_arena_init(region, AUDIO_ARENA_PAGE_SIZE);
+    TEST_ASSERT(!audio_arena_ready());
+    TEST_ASSERT(audio_arena_malloc(16) == NULL);
+    TEST_ASSERT(!audio_arena_contains(region));
+    // an unaligned base is rounded up, the arena stays inside the region
+    audio_arena_init(region + 3, ARENA_TEST_SIZE);
+    TEST_ASSERT(audio_arena_ready());
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT(stats.size <= ARENA_TEST_SIZE - 3);
+    TEST_ASSERT_EQ(stats.size % AUDIO_ARENA_ALIGN, 0);
+}
+
+static void test_size_classes(void)
+{
+    arena_reset();
+    static const size_t sizes[] = { 1, 16, 17, 32, 33, 100, 512, 513, AUDIO_ARENA_SMALL_MAX };
+    static const size_t rounded[] = { 16, 16, 32, 32, 64, 128, 512, 1024, 1024 };
+    void *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+    size_t used = 0;
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        ptrs[i] = audio_arena_malloc(sizes[i]);
+        TEST_ASSERT(ptrs[i] != NULL);
+        TEST_ASSERT(audio_arena_contains(ptrs[i]));
+        TEST_ASSERT_EQ((uintptr_t)ptrs[i] % AUDIO_ARENA_ALIGN, 0);
+        memset(ptrs[i], i, sizes[i]);
+        used += rounded[i];
+        TEST_ASSERT_EQ(arena_stats().used, used);
+    }
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+            TEST_ASSERT_EQ(((uint8_t *)ptrs[i])[j], i);
+        }
+    }
+    TEST_ASSERT_EQ(arena_stats().alloc_count, sizeof(sizes) / sizeof(sizes[0]));
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        audio_arena_free(ptrs[i]);
+    }
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.alloc_count, 0);
+    TEST_ASSERT_EQ(stats.free, stats.size);
+    TEST_ASSERT(audio_arena_malloc(0) == NULL);
+}
+
+static void test_small_page_reuse(void)
+{
+    arena_reset();
+    // more 64 byte objects than one page holds, freed in a different order than taken
+    enum { COUNT = AUDIO_ARENA_PAGE_SIZE / 64 + 10 };
+    void *ptrs[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        ptrs[i] = audio_arena_malloc(64);
+        TEST_ASSERT(ptrs[i] != NULL);
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT(ptrs[i] != ptrs[j]);
+        }
+    }
+    for (int i = 0; i < COUNT; i += 2) {
+        audio_arena_free(ptrs[i]);
+    }
+    for (int i = 0; i < COUNT; i += 2) {
+        ptrs[i] = audio_arena_malloc(64);
+        TEST_ASSERT(ptrs[i] != NULL);
+    }
+    for (int i = COUNT - 1; i >= 0; i--) {
+        audio_arena_free(ptrs[i]);
+    }
+    TEST_ASSERT_EQ(arena_stats().used, 0);
+    // emptied pages go back to the pool and take another size class
+    void *big = audio_arena_malloc(AUDIO_ARENA_SMALL_MAX);
+    void *small = audio_arena_malloc(16);
+    TEST_ASSERT(big && small);
+    TEST_ASSERT((uint8_t *)big < region + ARENA_TEST_SIZE / AUDIO_ARENA_SLAB_SHARE + AUDIO_ARENA_ALIGN);
+    audio_arena_free(big);
+    audio_arena_free(small);
+    TEST_ASSERT_EQ(arena_stats().used, 0);
+}
+
+static void test_block_coalescing(void)
+{
+    arena_reset();
+    audio_arena_stats_t empty = arena_stats();
+    TEST_ASSERT_EQ(empty.fragmentation, 0);
+
+    void *a = audio_arena_malloc(8000);
+    void *b = audio_arena_malloc(8000);
+    void *c = audio_arena_malloc(8000);
+    void *d = audio_arena_malloc(8000);
+    TEST_ASSERT(a && b && c && d);
+    TEST_ASSERT((uint8_t *)a < (uint8_t *)b && (uint8_t *)b < (uint8_t *)c && (uint8_t *)c < (uint8_t *)d);
+
+    // two holes that are not neighbours fragment the heap
+    audio_arena_free(a);
+    audio_arena_free(c);
+    audio_arena_stats_t holes = arena_stats();
+    TEST_ASSERT(holes.fragmentation > 0);
+    TEST_ASSERT(holes.largest_free < empty.largest_free);
+
+    // a 16000 byte request fits neither hole until b joins them, the tail takes it
+    void *e = audio_arena_malloc(16000);
+    TEST_ASSERT(e != NULL);
+    TEST_ASSERT((uint8_t *)e > (uint8_t *)d);
+    audio_arena_free(e);
+    audio_arena_free(b);
+    e = audio_arena_malloc(16000);
+    TEST_ASSERT(e == a);
+    audio_arena_free(e);
+
+    // freeing d merges with the hole before and the tail after
+    audio_arena_free(d);
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.largest_free, empty.largest_free);
+    TEST_ASSERT_EQ(stats.fragmentation, 0);
+}
+
+static void test_realloc(void)
+{
+    arena_reset();
+    uint8_t *p = audio_arena_realloc(NULL, 20);
+    TEST_ASSERT(p != NULL);
+    for (int i = 0; i < 20; i++) {
+        p[i] = i;
+    }
+    // growing within the size class keeps the pointer
+    TEST_ASSERT(audio_arena_realloc(p, 32) == p);
+    TEST_ASSERT(audio_arena_realloc(p, 8) == p);
+    // growing out of the slab into the block heap copies
+    uint8_t *q = audio_arena_realloc(p, 3000);
+    TEST_ASSERT(q != NULL && q != p);
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQ(q[i], i);
+    }
+    memset(q + 20, 0x5a, 3000 - 20);
+    uint8_t *r = audio_arena_realloc(q, 6000);
+    TEST_ASSERT(r != NULL);
+    TEST_ASSERT_EQ(r[19], 19);
+    TEST_ASSERT_EQ(r[2999], 0x5a);
+    TEST_ASSERT_EQ(arena_stats().alloc_count, 1);
+    // a failed realloc leaves the old block alone
+    TEST_ASSERT(audio_arena_realloc(r, ARENA_TEST_SIZE) == NULL);
+    TEST_ASSERT_EQ(r[2999], 0x5a);
+    audio_arena_free(r);
+    TEST_ASSERT_EQ(arena_stats().used, 0);
+}
+
+static void test_calloc(void)
+{
+    arena_reset();
+    uint8_t *p = audio_arena_malloc(256);
+    memset(p, 0xff, 256);
+    audio_arena_free(p);
+    uint8_t *q = audio_arena_calloc(64, 4);
+    TEST_ASSERT(q != NULL);
+    for (int i = 0; i < 256; i++) {
+        TEST_ASSERT_EQ(q[i], 0);
+    }
+    audio_arena_free(q);
+    TEST_ASSERT(audio_arena_calloc(SIZE_MAX / 2, 4) == NULL);
+}
+
+static void test_peak(void)
+{
+    arena_reset();
+    void *a = audio_arena_malloc(4000);
+    void *b = audio_arena_malloc(100);
+    size_t high = arena_stats().used;
+    audio_arena_free(a);
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT_EQ(stats.peak, high);
+    TEST_ASSERT(stats.used < high);
+    audio_arena_reset_peak();
+    TEST_ASSERT_EQ(arena_stats().peak, stats.used);
+    audio_arena_free(b);
+    TEST_ASSERT_EQ(arena_stats().peak, stats.used);
+    TEST_ASSERT_EQ(arena_stats().used, 0);
+}
+
+static void test_exhaustion(void)
+{
+    arena_reset();
+    audio_arena_stats_t empty = arena_stats();
+    TEST_ASSERT(audio_arena_malloc(empty.largest_free + 1) == NULL);
+    TEST_ASSERT_EQ(arena_stats().fail_count, 1);
+
+    // small objects spill into the block heap once the slab pages are gone
+    enum { MAX_PTRS = ARENA_TEST_SIZE / 16 };
+    static void *ptrs[MAX_PTRS];
+    int count = 0;
+    bool spilled = false;
+    while (count < MAX_PTRS) {
+        void *p = audio_arena_malloc(AUDIO_ARENA_SMALL_MAX);
+        if (p == NULL) {
+            break;
+        }
+        spilled |= (uint8_t *)p >= region + empty.size / AUDIO_ARENA_SLAB_SHARE + AUDIO_ARENA_ALIGN;
+        ptrs[count++] = p;
+    }
+    TEST_ASSERT(spilled);
+    TEST_ASSERT(count > 0 && count < MAX_PTRS);
+    audio_arena_stats_t full = arena_stats();
+    TEST_ASSERT_EQ(full.fail_count, 2);
+    TEST_ASSERT_EQ(full.alloc_count, count);
+    TEST_ASSERT(full.largest_free < AUDIO_ARENA_SMALL_MAX);
+    // foreign pointers are not the arena's to free
+    int local;
+    audio_arena_free(&local);
+    audio_arena_free(NULL);
+    TEST_ASSERT_EQ(arena_stats().alloc_count, count);
+
+    for (int i = 0; i < count; i++) {
+        audio_arena_free(ptrs[i]);
+    }
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.largest_free, empty.largest_free);
+    TEST_ASSERT_EQ(stats.fail_count, 2);
+}
+
+#define STRESS_THREADS (4)
+#define STRESS_ROUNDS (20000)
+
+static void *stress_thread(void *arg)
+{
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    void *ptrs[32] = { 0 };
+    size_t sizes[32] = { 0 };
+    for (int i = 0; i < STRESS_ROUNDS; i++) {
+        int slot = rand_r(&seed) % 32;
+        if (ptrs[slot]) {
+            for (size_t j = 0; j < sizes[slot]; j++) {
+                if (((uint8_t *)ptrs[slot])[j] != (uint8_t)slot) {
+                    return (void *)1;
+                }
+            }
+            audio_arena_free(ptrs[slot]);
+            ptrs[slot] = NULL;
+        } else {
+            sizes[slot] = rand_r(&seed) % 2 ? rand_r(&seed) % 200 + 1 : rand_r(&seed) % 1500 + 1;
+            ptrs[slot] = audio_arena_malloc(sizes[slot]);
+            if (ptrs[slot]) {
+                memset(ptrs[slot], slot, sizes[slot]);
+            }
+        }
+    }
+    for (int i = 0; i < 32; i++) {
+        audio_arena_free(ptrs[i]);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    arena_reset();
+    pthread_t threads[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_thread, (void *)(uintptr_t)(i + 1));
+    }
+    bool corrupt = false;
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        void *ret;
+        pthread_join(threads[i], &ret);
+        corrupt |= ret != NULL;
+    }
+    TEST_ASSERT(!corrupt);
+    audio_arena_stats_t stats = arena_stats();
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.alloc_count, 0);
+    TEST_ASSERT_EQ(stats.fragmentation, 0);
+}
+
+int main(void)
+{
+    TEST_RUN(test_init_too_small);
+    TEST_RUN(test_size_classes);
+    TEST_RUN(test_small_page_reuse);
+    TEST_RUN(test_block_coalescing);
+    TEST_RUN(test_realloc);
+    TEST_RUN(test_calloc);
+    TEST_RUN(test_peak);
+    TEST_RUN(test_exhaustion);
+    TEST_RUN(test_threads);
+    TEST_EXIT();
+}
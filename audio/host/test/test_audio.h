@@ -0,0 +1,183 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef _AUDIO_HOST_TEST_AUDIO_H_
+#define _AUDIO_HOST_TEST_AUDIO_H_
+
+// Files, signals and pipeline waits shared by the native tests that run elements
+
+#include <dirent.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "esp_timer.h"
+#include "wav_head.h"
+
+#define TEST_TONE_HZ (440)
+#define TEST_TONE_AMPLITUDE (8000)
+
+static char test_dir[64];
+
+static void test_dir_remove(void)
+{
+    DIR *dir = opendir(test_dir);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            snprintf(path, sizeof(path), "%s/%s", test_dir, entry->d_name);
+            remove(path);
+        }
+    }
+    closedir(dir);
+    rmdir(test_dir);
+}
+
+// a scratch directory removed at exit, also the /sdcard and the loopback root of the test
+static inline const char *test_dir_create(void)
+{
+    strcpy(test_dir, "/tmp/audio_test_XXXXXX");
+    if (mkdtemp(test_dir) == NULL) {
+        perror("mkdtemp");
+        exit(EXIT_FAILURE);
+    }
+    atexit(test_dir_remove);
+    return test_dir;
+}
+
+static inline const char *test_path(const char *name)
+{
+    static char paths[4][256];
+    static int next;
+    char *path = paths[next++ % 4];
+    snprintf(path, sizeof(paths[0]), "%s/%s", test_dir, name);
+    return path;
+}
+
+static inline int16_t test_tone(int frame, int rate)
+{
+    return (int16_t)(TEST_TONE_AMPLITUDE * sin(2 * M_PI * TEST_TONE_HZ * frame / rate));
+}
+
+// 16 bit PCM of the test tone, every channel the same
+static inline int16_t *test_tone_pcm(int rate, int channels, int frames)
+{
+    int16_t *pcm = malloc((size_t)frames * channels * sizeof(int16_t));
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            pcm[i * channels + c] = test_tone(i, rate);
+        }
+    }
+    return pcm;
+}
+
+static inline void test_write_file(const char *path, const void *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL || fwrite(data, 1, len, f) != len) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+}
+
+static inline void test_wav_write(const char *path, int rate, int channels, int frames)
+{
+    int16_t *pcm = test_tone_pcm(rate, channels, frames);
+    size_t size = (size_t)frames * channels * sizeof(int16_t);
+    uint8_t *file = malloc(sizeof(wav_header_t) + size);
+    wav_head_init((wav_header_t *)file, rate, 16, channels);
+    wav_head_size((wav_header_t *)file, size);
+    memcpy(file + sizeof(wav_header_t), pcm, size);
+    test_write_file(path, file, sizeof(wav_header_t) + size);
+    free(file);
+    free(pcm);
+}
+
+// the whole file, NULL when it is missing
+static inline uint8_t *test_read_file(const char *path, long *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        *len = -1;
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*len > 0 ? *len : 1);
+    *len = fread(data, 1, *len, f);
+    fclose(f);
+    return data;
+}
+
+static inline uint32_t test_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// peak of 16 bit PCM, 0 for silence
+static inline int test_peak(const uint8_t *data, long len)
+{
+    int peak = 0;
+    for (long i = 0; i + 1 < len; i += 2) {
+        int v = abs((int16_t)test_le(data + i, 2));
+        peak = v > peak ? v : peak;
+    }
+    return peak;
+}
+
+// the next status el reports that ends its run, -1 after timeout_ms
+static inline int test_wait_end(audio_event_iface_handle_t evt, audio_element_handle_t el, int timeout_ms)
+{
+    int64_t end = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (esp_timer_get_time() < end) {
+        audio_event_iface_msg_t msg;
+        if (audio_event_iface_listen(evt, &msg, pdMS_TO_TICKS(50)) != ESP_OK) {
+            continue;
+        }
+        if (msg.source != (void *)el || msg.cmd != AEL_MSG_CMD_REPORT_STATUS) {
+            continue;
+        }
+        int status = (int)(intptr_t)msg.data;
+        if (status != AEL_STATUS_STATE_RUNNING && status != AEL_STATUS_STATE_PAUSED) {
+            return status;
+        }
+    }
+    return -1;
+}
+
+#endif
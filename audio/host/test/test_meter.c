@@ -0,0 +1,286 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// The level meter on generated tones, as an element and hooked into an I2S writer
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_meter.h"
+#include "audio_pipeline.h"
+#include "extmod/vfs_fat.h"
+#include "i2s_stream.h"
+#include "raw_stream.h"
+#include "vfs_stream.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+#define METER_TEST_RATE (16000)
+#define METER_TEST_BANDS (16)
+#define METER_TEST_INTERVAL_MS (50)
+
+static int16_t meter_test_pcm[2 * METER_TEST_RATE];
+
+// one second of a stereo sine
+static void meter_test_sine(double hz, double amplitude)
+{
+    for (int i = 0; i < METER_TEST_RATE; i++) {
+        int16_t v = (int16_t)lrint(amplitude * sin(2 * M_PI * hz * i / METER_TEST_RATE));
+        meter_test_pcm[2 * i] = v;
+        meter_test_pcm[2 * i + 1] = v;
+    }
+}
+
+// in chunks that don't line up with the interval
+static void meter_test_feed(audio_meter_t *meter, int frames)
+{
+    for (int off = 0; off < frames; off += 333) {
+        int n = frames - off < 333 ? frames - off : 333;
+        audio_meter_feed(meter, meter_test_pcm + 2 * off, n, 2, METER_TEST_RATE);
+    }
+}
+
+static int meter_test_band_of(const audio_meter_t *meter, double hz)
+{
+    int bin = (int)(hz * AUDIO_METER_FFT_SIZE / METER_TEST_RATE);
+    for (int b = 0; b < meter->bands_num; b++) {
+        if (bin >= meter->edges[b] && bin < meter->edges[b + 1]) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+// peak and RMS of a sine, and its amplitude in the band of its frequency only
+static void test_meter_tones(void)
+{
+    static const double freqs[] = { 440, 1000, 3000, 7000 };
+    static const double amps[] = { 32000, 10000, 1000 };
+    static audio_meter_t meter;
+    for (int f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+        for (int a = 0; a < sizeof(amps) / sizeof(amps[0]); a++) {
+            meter_test_sine(freqs[f], amps[a]);
+            audio_meter_setup(&meter, METER_TEST_BANDS, METER_TEST_INTERVAL_MS);
+            meter_test_feed(&meter, METER_TEST_RATE);
+            int rms = (int)lrint(amps[a] / M_SQRT2);
+            TEST_ASSERT(abs(meter.levels.peak - (int)amps[a]) <= 1);
+            TEST_ASSERT(abs(meter.levels.rms - rms) <= rms / 100 + 1);
+            int band = meter_test_band_of(&meter, freqs[f]);
+            TEST_ASSERT(band >= 0);
+            TEST_ASSERT(abs(meter.levels.bands[band] - (int)amps[a]) <= amps[a] / 20 + 16);
+            // the Hann window leaks into the next bands, not further
+            for (int b = 0; b < METER_TEST_BANDS; b++) {
+                if (abs(b - band) > 1) {
+                    TEST_ASSERT(meter.levels.bands[b] <= amps[a] / 50 + 32);
+                }
+            }
+        }
+    }
+}
+
+// an update per interval, seq even once it is written
+static void test_meter_interval(void)
+{
+    static audio_meter_t meter;
+    meter_test_sine(TEST_TONE_HZ, TEST_TONE_AMPLITUDE);
+    audio_meter_setup(&meter, METER_TEST_BANDS, METER_TEST_INTERVAL_MS);
+    TEST_ASSERT_EQ(meter.levels.bands_num, METER_TEST_BANDS);
+    meter_test_feed(&meter, METER_TEST_RATE / 2);
+    TEST_ASSERT_EQ(meter.levels.seq, 2 * (500 / METER_TEST_INTERVAL_MS));
+    // below the minimum interval
+    audio_meter_setup(&meter, 0, 1);
+    meter_test_feed(&meter, METER_TEST_RATE / 2);
+    TEST_ASSERT_EQ(meter.levels.seq, 2 * (500 / AUDIO_METER_MIN_INTERVAL_MS));
+    TEST_ASSERT_EQ(meter.levels.bands_num, 0);
+    TEST_ASSERT_EQ(meter.levels.peak, TEST_TONE_AMPLITUDE);
+}
+
+static void test_meter_silence(void)
+{
+    static audio_meter_t meter;
+    memset(meter_test_pcm, 0, sizeof(meter_test_pcm));
+    audio_meter_setup(&meter, 8, 20);
+    meter_test_feed(&meter, METER_TEST_RATE);
+    TEST_ASSERT_EQ(meter.levels.seq, 2 * (1000 / 20));
+    TEST_ASSERT_EQ(meter.levels.peak, 0);
+    TEST_ASSERT_EQ(meter.levels.rms, 0);
+    for (int b = 0; b < 8; b++) {
+        TEST_ASSERT_EQ(meter.levels.bands[b], 0);
+    }
+}
+
+// a full scale square wave is the worst case of the fixed point transform
+static void test_meter_full_scale(void)
+{
+    static audio_meter_t meter;
+    for (int i = 0; i < METER_TEST_RATE; i++) {
+        meter_test_pcm[2 * i] = (i / 20) % 2 ? 32767 : -32768;
+        meter_test_pcm[2 * i + 1] = meter_test_pcm[2 * i];
+    }
+    audio_meter_setup(&meter, METER_TEST_BANDS, METER_TEST_INTERVAL_MS);
+    meter_test_feed(&meter, METER_TEST_RATE);
+    TEST_ASSERT_EQ(meter.levels.peak, 32767);
+    TEST_ASSERT_EQ(meter.levels.rms, 32767);
+    int loudest = 0;
+    for (int b = 0; b < METER_TEST_BANDS; b++) {
+        TEST_ASSERT(meter.levels.bands[b] >= 0);
+        loudest = meter.levels.bands[b] > meter.levels.bands[loudest] ? b : loudest;
+    }
+    // the fundamental, a period of 40 frames
+    TEST_ASSERT_EQ(loudest, meter_test_band_of(&meter, (double)METER_TEST_RATE / 40));
+}
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    audio_element_handle_t last;
+} meter_test_chain_t;
+
+static void meter_test_chain(meter_test_chain_t *t, audio_element_handle_t el, const char *tag)
+{
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t file = vfs_stream_init(&vfs_cfg);
+    audio_element_set_uri(file, "/sdcard/tone.wav");
+    audio_element_set_byte_pos(file, sizeof(wav_header_t));
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    t->pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_pipeline_register(t->pipeline, file, "file");
+    audio_pipeline_register(t->pipeline, el, tag);
+    const char *link_tag[] = { "file", tag };
+    audio_pipeline_link(t->pipeline, link_tag, 2);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    t->evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(t->pipeline, t->evt);
+    t->last = el;
+}
+
+static void meter_test_chain_deinit(meter_test_chain_t *t)
+{
+    audio_pipeline_stop(t->pipeline);
+    audio_pipeline_wait_for_stop(t->pipeline);
+    audio_pipeline_terminate(t->pipeline);
+    audio_pipeline_remove_listener(t->pipeline);
+    audio_pipeline_deinit(t->pipeline);
+    audio_event_iface_destroy(t->evt);
+}
+
+// file -> meter -> raw, the data passes unchanged
+static void test_meter_element(void)
+{
+    static audio_meter_t meter;
+    audio_meter_setup(&meter, METER_TEST_BANDS, METER_TEST_INTERVAL_MS);
+    audio_meter_cfg_t meter_cfg = AUDIO_METER_CFG_DEFAULT();
+    meter_cfg.meter = &meter;
+    meter_cfg.channels = 2;
+    meter_cfg.sample_rate = METER_TEST_RATE;
+    audio_element_handle_t el = audio_meter_init(&meter_cfg);
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+
+    meter_test_chain_t t;
+    meter_test_chain(&t, el, "meter");
+    audio_pipeline_register(t.pipeline, raw, "raw");
+    const char *link_tag[] = { "file", "meter", "raw" };
+    audio_pipeline_link(t.pipeline, link_tag, 3);
+
+    size_t size = METER_TEST_RATE * 2 * sizeof(int16_t);
+    uint8_t *out = malloc(size + 4096);
+    long out_len = 0;
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    int r;
+    while ((r = raw_stream_read(raw, (char *)out + out_len, 4096)) > 0 && out_len + r <= size) {
+        out_len += r;
+    }
+    int status = test_wait_end(t.evt, el, 5000);
+    meter_test_chain_deinit(&t);
+
+    int16_t *pcm = test_tone_pcm(METER_TEST_RATE, 2, METER_TEST_RATE);
+    int same = out_len == size && memcmp(out, pcm, size) == 0;
+    free(pcm);
+    free(out);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT(same);
+    TEST_ASSERT_EQ(meter.levels.seq, 2 * (1000 / METER_TEST_INTERVAL_MS));
+    TEST_ASSERT(abs(meter.levels.peak - TEST_TONE_AMPLITUDE) <= 1);
+    int band = meter_test_band_of(&meter, TEST_TONE_HZ);
+    TEST_ASSERT(abs(meter.levels.bands[band] - TEST_TONE_AMPLITUDE) <= TEST_TONE_AMPLITUDE / 10);
+}
+
+// the slot of an I2S writer, as the player meters its output
+static void test_meter_hook_writer(void)
+{
+    static audio_meter_t meter;
+    static audio_meter_slot_t slot = { .rate = METER_TEST_RATE, .channels = 2 };
+    audio_meter_setup(&meter, 0, METER_TEST_INTERVAL_MS);
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_WRITER;
+    i2s_cfg.i2s_config.sample_rate = METER_TEST_RATE;
+    audio_element_handle_t i2s = i2s_stream_init(&i2s_cfg);
+    TEST_ASSERT_EQ(audio_meter_hook_writer(i2s, &slot), ESP_OK);
+    // hooking twice keeps the writer's own callback
+    TEST_ASSERT_EQ(audio_meter_hook_writer(i2s, &slot), ESP_OK);
+    audio_meter_slot_set(&slot, &meter);
+
+    meter_test_chain_t t;
+    meter_test_chain(&t, i2s, "i2s");
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    int status = test_wait_end(t.evt, i2s, 5000);
+    meter_test_chain_deinit(&t);
+    audio_meter_slot_set(&slot, NULL);
+
+    long len;
+    uint8_t *out = test_read_file(test_path("i2s.raw"), &len);
+    int peak = out ? test_peak(out, len) : 0;
+    free(out);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(len, METER_TEST_RATE * 2 * sizeof(int16_t));
+    TEST_ASSERT_EQ(peak, TEST_TONE_AMPLITUDE);
+    TEST_ASSERT_EQ(meter.levels.seq, 2 * (1000 / METER_TEST_INTERVAL_MS));
+    TEST_ASSERT(abs(meter.levels.peak - TEST_TONE_AMPLITUDE) <= 1);
+    TEST_ASSERT(abs(meter.levels.rms - (int)lrint(TEST_TONE_AMPLITUDE / M_SQRT2)) <= TEST_TONE_AMPLITUDE / 100);
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    test_wav_write(test_path("tone.wav"), METER_TEST_RATE, 2, METER_TEST_RATE);
+    setenv("AUDIO_HOST_I2S_OUT", test_path("i2s.raw"), 1);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+    TEST_RUN(test_meter_tones);
+    TEST_RUN(test_meter_interval);
+    TEST_RUN(test_meter_silence);
+    TEST_RUN(test_meter_full_scale);
+    TEST_RUN(test_meter_element);
+    TEST_RUN(test_meter_hook_writer);
+    TEST_EXIT();
+}
@@ -0,0 +1,183 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_audio.h"
+#include "extmod/vfs_fat.h"
+#include "http_stream.h"
+#include "i2s_stream.h"
+#include "vfs_stream.h"
+#include "wav_decoder.h"
+
+#include "audio_probe.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+// the rates of audio_player.c, a 16 kHz mono file comes out 48 kHz stereo
+#define PLAYER_TEST_OUTPUT_RATE (48000)
+#define PLAYER_TEST_RATE (16000)
+#define PLAYER_TEST_FRAMES (PLAYER_TEST_RATE / 2)
+#define PLAYER_TEST_OUT_BYTES (PLAYER_TEST_FRAMES * (PLAYER_TEST_OUTPUT_RATE / PLAYER_TEST_RATE) * 2 * 2)
+// the resampler holds back the frames past the last input one
+#define PLAYER_TEST_SLACK (4 * 2 * 2)
+
+static esp_audio_handle_t player;
+
+// esp_audio set up as audio_player_core_create and audio_player_core_add_* do it
+static void player_test_create(void)
+{
+    esp_audio_cfg_t cfg = DEFAULT_ESP_AUDIO_CONFIG();
+    cfg.resample_rate = PLAYER_TEST_OUTPUT_RATE;
+    cfg.prefer_type = ESP_AUDIO_PREFER_MEM;
+    player = esp_audio_create(&cfg);
+
+    i2s_stream_cfg_t i2s_writer = I2S_STREAM_CFG_DEFAULT();
+    i2s_writer.type = AUDIO_STREAM_WRITER;
+    i2s_writer.i2s_config.sample_rate = PLAYER_TEST_OUTPUT_RATE;
+    i2s_writer.uninstall_drv = false;
+    esp_audio_output_stream_add(player, i2s_stream_init(&i2s_writer));
+
+    vfs_stream_cfg_t fs_reader = VFS_STREAM_CFG_DEFAULT();
+    fs_reader.type = AUDIO_STREAM_READER;
+    esp_audio_input_stream_add(player, vfs_stream_init(&fs_reader));
+
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.type = AUDIO_STREAM_READER;
+    http_cfg.enable_playlist_parser = true;
+    esp_audio_input_stream_add(player, http_stream_init(&http_cfg));
+
+    wav_decoder_cfg_t wav_dec_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    esp_audio_codec_lib_add(player, AUDIO_CODEC_TYPE_DECODER, wav_decoder_init(&wav_dec_cfg));
+}
+
+static long player_test_out_size(void)
+{
+    struct stat st;
+    return stat(test_path("out.wav"), &st) == 0 ? (long)st.st_size : -1;
+}
+
+// the samples the last play added to the I2S output file
+static void player_test_play(const char *uri, long *bytes, int *peak)
+{
+    long before = player_test_out_size();
+    *bytes = -1;
+    *peak = 0;
+    if (esp_audio_sync_play(player, uri, 0) != ESP_ERR_AUDIO_NO_ERROR) {
+        return;
+    }
+    long len;
+    uint8_t *file = test_read_file(test_path("out.wav"), &len);
+    if (file == NULL) {
+        return;
+    }
+    *bytes = len - before;
+    *peak = test_peak(file + before, *bytes);
+    free(file);
+}
+
+static void test_output_header(void)
+{
+    long len;
+    uint8_t *file = test_read_file(test_path("out.wav"), &len);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT(len >= sizeof(wav_header_t));
+    TEST_ASSERT(memcmp(file, "RIFF", 4) == 0 && memcmp(file + 8, "WAVE", 4) == 0);
+    TEST_ASSERT_EQ(test_le(file + 22, 2), 2);
+    TEST_ASSERT_EQ(test_le(file + 24, 4), PLAYER_TEST_OUTPUT_RATE);
+    free(file);
+}
+
+static void test_play_file(void)
+{
+    long bytes;
+    int peak;
+    player_test_play("/sdcard/tone.wav", &bytes, &peak);
+    // the first buffer after the format change is resampled as the new format too
+    TEST_ASSERT(bytes >= PLAYER_TEST_OUT_BYTES - PLAYER_TEST_SLACK && bytes <= PLAYER_TEST_OUT_BYTES);
+    TEST_ASSERT(peak > TEST_TONE_AMPLITUDE / 2);
+}
+
+static void test_play_http(void)
+{
+    long bytes;
+    int peak;
+    player_test_play("http://loopback/tone.wav", &bytes, &peak);
+    TEST_ASSERT(bytes >= PLAYER_TEST_OUT_BYTES - PLAYER_TEST_SLACK && bytes <= PLAYER_TEST_OUT_BYTES);
+    TEST_ASSERT(peak > TEST_TONE_AMPLITUDE / 2);
+}
+
+static void test_play_missing(void)
+{
+    TEST_ASSERT(esp_audio_sync_play(player, "/sdcard/missing.wav", 0) != ESP_ERR_AUDIO_NO_ERROR);
+    // the player is still usable afterwards
+    long bytes;
+    int peak;
+    player_test_play("/sdcard/tone.wav", &bytes, &peak);
+    TEST_ASSERT(bytes >= PLAYER_TEST_OUT_BYTES - PLAYER_TEST_SLACK);
+}
+
+static void test_probe_http_mislabelled(void)
+{
+    // the loopback host labels it audio/mpeg from the suffix, the content says WAV
+    test_wav_write(test_path("song.mp3"), PLAYER_TEST_RATE, 1, PLAYER_TEST_FRAMES);
+    TEST_ASSERT_EQ(audio_probe_uri("http://loopback/song.mp3"), AUDIO_PROBE_WAV);
+    TEST_ASSERT_EQ(audio_probe_uri("http://loopback/song.mp3"), AUDIO_PROBE_WAV);
+}
+
+static void test_probe_file_changed(void)
+{
+    test_wav_write(test_path("voice.mp3"), PLAYER_TEST_RATE, 1, PLAYER_TEST_FRAMES);
+    TEST_ASSERT_EQ(audio_probe_uri("/sdcard/voice.mp3"), AUDIO_PROBE_WAV);
+    // replaced by an AMR file under the same name, the cached entry is stale
+    FILE *file = fopen(test_path("voice.mp3"), "wb");
+    TEST_ASSERT(file != NULL);
+    fputs("#!AMR\n", file);
+    fclose(file);
+    TEST_ASSERT_EQ(audio_probe_uri("/sdcard/voice.mp3"), AUDIO_PROBE_AMR);
+    remove(test_path("voice.mp3"));
+    TEST_ASSERT_EQ(audio_probe_uri("/sdcard/voice.mp3"), AUDIO_PROBE_UNKNOWN);
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_HTTP_ROOT", test_dir, 1);
+    setenv("AUDIO_HOST_I2S_OUT", test_path("out.wav"), 1);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+    test_wav_write(test_path("tone.wav"), PLAYER_TEST_RATE, 1, PLAYER_TEST_FRAMES);
+    player_test_create();
+    TEST_RUN(test_play_file);
+    TEST_RUN(test_play_http);
+    TEST_RUN(test_play_missing);
+    TEST_RUN(test_output_header);
+    TEST_RUN(test_probe_http_mislabelled);
+    TEST_RUN(test_probe_file_changed);
+    esp_audio_destroy(player);
+    TEST_EXIT();
+}
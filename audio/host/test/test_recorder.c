@@ -0,0 +1,272 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_timer.h"
+#include "extmod/vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "py/runtime.h"
+#include "wav_head.h"
+
+#include "modaudio.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+// the port rate of audio_recorder.c, the file is recorded at 16 kHz mono for maxtime
+#define RECORDER_TEST_PORT_RATE (48000)
+#define RECORDER_TEST_RATE (16000)
+#define RECORDER_TEST_MAXTIME (1)
+#define RECORDER_TEST_FRAMES (RECORDER_TEST_RATE * RECORDER_TEST_MAXTIME)
+#define RECORDER_TEST_SEGMENT_MS (300)
+#define RECORDER_TEST_SEGMENT_FRAMES (RECORDER_TEST_RATE * RECORDER_TEST_SEGMENT_MS / 1000)
+
+extern const mp_obj_type_t audio_recorder_type;
+
+// the player is not built in, the port is free for the recorder
+bool audio_player_output_busy(void)
+{
+    return false;
+}
+
+audio_meter_t *audio_meter_from_obj(mp_obj_t obj)
+{
+    return NULL;
+}
+
+static int recorder_test_ended;
+
+static mp_obj_t recorder_test_endcb(mp_obj_t rec)
+{
+    recorder_test_ended++;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(recorder_test_endcb_obj, recorder_test_endcb);
+
+// an attribute of audio.recorder, looked up in its locals dict as the VM does
+static mp_obj_t recorder_test_attr(const char *name)
+{
+    const mp_map_t *map = &audio_recorder_type.locals_dict->map;
+    for (size_t i = 0; i < map->used; i++) {
+        if (strcmp(map->table[i].key, name) == 0) {
+            return map->table[i].value;
+        }
+    }
+    return MP_OBJ_NULL;
+}
+
+// rec.name() of a method without arguments
+static mp_obj_t recorder_test_call(mp_obj_t rec, const char *name)
+{
+    const mp_obj_fun_builtin_fixed_t *fun = recorder_test_attr(name);
+    return fun->fun._1(rec);
+}
+
+// rec.start(uri, recorder.WAV, maxtime, endcb, segment=segment_ms)
+static bool recorder_test_start(mp_obj_t rec, const char *uri, int maxtime, int segment_ms)
+{
+    const mp_obj_fun_builtin_var_t *start = recorder_test_attr("start");
+    mp_obj_t args[] = {
+        rec, mp_obj_new_str(uri, strlen(uri)), recorder_test_attr("WAV"), MP_OBJ_NEW_SMALL_INT(maxtime),
+        MP_OBJ_FROM_PTR(&recorder_test_endcb_obj),
+    };
+    mp_map_elem_t kw[] = {
+        { MP_OBJ_NEW_QSTR(MP_QSTR_segment), MP_OBJ_NEW_SMALL_INT(segment_ms) },
+    };
+    mp_map_t kw_args = { .used = segment_ms > 0, .table = kw };
+    return start->fun.kw(MP_ARRAY_SIZE(args), args, &kw_args) == mp_const_true;
+}
+
+// until the writer finished and the end is scheduled, false on timeout
+static bool recorder_test_wait_end(int timeout_ms)
+{
+    for (int ms = 0; mp_sched_num_pending() == 0; ms += 10) {
+        if (ms >= timeout_ms) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+// the scheduled end stops the recording and calls endcb, as between two bytecodes
+static bool recorder_test_end(mp_obj_t rec)
+{
+    int ended = recorder_test_ended;
+    mp_handle_pending(true);
+    return recorder_test_ended == ended + 1 && recorder_test_call(rec, "is_running") == mp_const_false;
+}
+
+static bool recorder_test_record(mp_obj_t rec, const char *uri, int maxtime)
+{
+    return recorder_test_start(rec, uri, maxtime, 0) && recorder_test_wait_end(5000) && recorder_test_end(rec);
+}
+
+// maxtime ends the recording, the file is complete once it is stopped
+static void test_record_wav(void)
+{
+    mp_obj_t rec = audio_recorder_type.make_new(&audio_recorder_type, 0, 0, NULL);
+    TEST_ASSERT(recorder_test_record(rec, "/sdcard/rec.wav", RECORDER_TEST_MAXTIME));
+
+    long len;
+    uint8_t *file = test_read_file(test_path("rec.wav"), &len);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT_EQ(len, sizeof(wav_header_t) + RECORDER_TEST_FRAMES * 2);
+    TEST_ASSERT(memcmp(file, "RIFF", 4) == 0 && memcmp(file + 8, "WAVE", 4) == 0);
+    TEST_ASSERT_EQ(test_le(file + 22, 2), 1);
+    TEST_ASSERT_EQ(test_le(file + 24, 4), RECORDER_TEST_RATE);
+    TEST_ASSERT_EQ(test_le(file + 40, 4), RECORDER_TEST_FRAMES * 2);
+    // the tone passes the low-pass filter, past its delay line
+    int peak = test_peak(file + len / 2, len / 2);
+    free(file);
+    TEST_ASSERT(peak > TEST_TONE_AMPLITUDE * 9 / 10 && peak < TEST_TONE_AMPLITUDE * 11 / 10);
+}
+
+// the microphone goes on with silence after the end of the input file
+static void test_record_past_input(void)
+{
+    mp_obj_t rec = audio_recorder_type.make_new(&audio_recorder_type, 0, 0, NULL);
+    TEST_ASSERT(recorder_test_record(rec, "/sdcard/long.wav", RECORDER_TEST_MAXTIME * 3));
+
+    long len;
+    uint8_t *file = test_read_file(test_path("long.wav"), &len);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT_EQ(len, sizeof(wav_header_t) + RECORDER_TEST_FRAMES * 3 * 2);
+    int tail = test_peak(file + len - RECORDER_TEST_FRAMES, RECORDER_TEST_FRAMES);
+    free(file);
+    TEST_ASSERT_EQ(tail, 0);
+}
+
+// data of a recording, NULL when it is missing
+static uint8_t *recorder_test_data(const char *name, long *len)
+{
+    uint8_t *file = test_read_file(test_path(name), len);
+    if (file == NULL || *len < sizeof(wav_header_t) || test_le(file + 40, 4) != *len - sizeof(wav_header_t)) {
+        free(file);
+        return NULL;
+    }
+    *len -= sizeof(wav_header_t);
+    memmove(file, file + sizeof(wav_header_t), *len);
+    return file;
+}
+
+static long recorder_test_size(const char *name)
+{
+    struct stat st;
+    return stat(test_path(name), &st) == 0 ? (long)st.st_size : -1;
+}
+
+// the writer rotates files while the capture runs on, the segments add up to one recording
+static void test_record_segments(void)
+{
+    mp_obj_t rec = audio_recorder_type.make_new(&audio_recorder_type, 0, 0, NULL);
+    TEST_ASSERT(recorder_test_record(rec, "/sdcard/whole.wav", RECORDER_TEST_MAXTIME));
+    // a segment needs a numbered file name
+    TEST_ASSERT(!recorder_test_start(rec, "/sdcard/seg.wav", RECORDER_TEST_MAXTIME, RECORDER_TEST_SEGMENT_MS));
+    TEST_ASSERT(recorder_test_call(rec, "segment") == mp_const_none);
+
+    TEST_ASSERT(recorder_test_start(rec, "/sdcard/seg_%02d.wav", RECORDER_TEST_MAXTIME, RECORDER_TEST_SEGMENT_MS));
+    TEST_ASSERT(recorder_test_wait_end(5000));
+    int segment = mp_obj_get_int(recorder_test_call(rec, "segment"));
+    TEST_ASSERT(recorder_test_end(rec));
+    TEST_ASSERT_EQ(segment, RECORDER_TEST_FRAMES / RECORDER_TEST_SEGMENT_FRAMES);
+
+    long whole_len;
+    uint8_t *whole = recorder_test_data("whole.wav", &whole_len);
+    TEST_ASSERT(whole != NULL);
+    long offset = 0;
+    for (int i = 0; i <= segment; i++) {
+        char name[24];
+        snprintf(name, sizeof(name), "seg_%02d.wav", i);
+        long len;
+        uint8_t *data = recorder_test_data(name, &len);
+        long expected = i < segment ? RECORDER_TEST_SEGMENT_FRAMES * 2 : whole_len - offset;
+        int same = data != NULL && len == expected && memcmp(data, whole + offset, len) == 0;
+        free(data);
+        if (!same) {
+            free(whole);
+        }
+        TEST_ASSERT(same);
+        offset += len;
+    }
+    free(whole);
+    TEST_ASSERT_EQ(offset, RECORDER_TEST_FRAMES * 2);
+}
+
+// pause() holds the I2S reader without closing the file, nothing is lost at resume()
+static void test_record_pause(void)
+{
+    // at the wall clock, so the recording is still running when it is paused
+    setenv("AUDIO_HOST_PACING", "wall", 1);
+    mp_obj_t rec = audio_recorder_type.make_new(&audio_recorder_type, 0, 0, NULL);
+    TEST_ASSERT(recorder_test_call(rec, "pause") == mp_const_false);
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT(recorder_test_start(rec, "/sdcard/paused.wav", RECORDER_TEST_MAXTIME, 0));
+    vTaskDelay(pdMS_TO_TICKS(300));
+    TEST_ASSERT(recorder_test_call(rec, "pause") == mp_const_true);
+    TEST_ASSERT(recorder_test_call(rec, "pause") == mp_const_false);
+    // what was read before the pause drains, then the file stops growing
+    vTaskDelay(pdMS_TO_TICKS(100));
+    long held = recorder_test_size("paused.wav");
+    vTaskDelay(pdMS_TO_TICKS(200));
+    long still = recorder_test_size("paused.wav");
+    TEST_ASSERT(recorder_test_call(rec, "resume") == mp_const_true);
+    TEST_ASSERT(recorder_test_call(rec, "resume") == mp_const_false);
+    bool ended = recorder_test_wait_end(5000) && recorder_test_end(rec);
+    int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+    setenv("AUDIO_HOST_PACING", "free", 1);
+    TEST_ASSERT(ended);
+    TEST_ASSERT(held > (long)sizeof(wav_header_t) && held < (long)sizeof(wav_header_t) + RECORDER_TEST_FRAMES * 2);
+    TEST_ASSERT_EQ(still, held);
+    // the 300 ms paused, less what the DMA and the ring buffers had read ahead
+    TEST_ASSERT(elapsed_ms >= 1000 * RECORDER_TEST_MAXTIME + 200);
+
+    // the same data as the recording without a pause
+    long len, whole_len;
+    uint8_t *data = recorder_test_data("paused.wav", &len);
+    uint8_t *whole = recorder_test_data("whole.wav", &whole_len);
+    int same = data != NULL && whole != NULL && len == whole_len && memcmp(data, whole, len) == 0;
+    free(data);
+    free(whole);
+    TEST_ASSERT(same);
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    // a mono file feeds both channels of the port
+    test_wav_write(test_path("mic.wav"), RECORDER_TEST_PORT_RATE, 1, RECORDER_TEST_PORT_RATE);
+    setenv("AUDIO_HOST_I2S_IN", test_path("mic.wav"), 1);
+    setenv("AUDIO_HOST_PACING", "free", 1);
+    TEST_RUN(test_record_wav);
+    TEST_RUN(test_record_past_input);
+    TEST_RUN(test_record_segments);
+    TEST_RUN(test_record_pause);
+    TEST_EXIT();
+}
@@ -0,0 +1,259 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// audio_tee feeding several outputs from one paced input, as audio_recorder_create_branch
+// sets them up, with a slow output that must not hold up the others
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "audio_tee.h"
+#include "extmod/vfs_fat.h"
+#include "http_stream.h"
+#include "vfs_stream.h"
+#include "wav_encoder.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+// the loopback host serves the input at the byte rate of 16 kHz stereo
+#define TEE_TEST_BYTE_RATE "64000"
+#define TEE_TEST_SAMPLES (32000)
+#define TEE_TEST_BYTES (TEE_TEST_SAMPLES * 2)
+#define TEE_TEST_SLOW_WRITE_MS (100)
+#define TEE_TEST_MAX_BRANCHES (3)
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    audio_element_handle_t out;
+    int64_t end_us;
+    int status;
+} tee_test_branch_t;
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t tee;
+    int branch_num;
+    tee_test_branch_t branch[TEE_TEST_MAX_BRANCHES];
+} tee_test_t;
+
+static stream_func vfs_write;
+
+// a card that takes TEE_TEST_SLOW_WRITE_MS per write
+static int tee_test_slow_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    usleep(TEE_TEST_SLOW_WRITE_MS * 1000);
+    return vfs_write(self, buffer, len, ticks_to_wait, NULL);
+}
+
+// http -> tee, each output in a pipeline of its own: [wav ->] file
+static void tee_test_init(tee_test_t *t, const char *const *uris, int num, int depth)
+{
+    memset(t, 0, sizeof(*t));
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t http = http_stream_init(&http_cfg);
+    audio_element_set_uri(http, "http://loopback/in.pcm");
+    audio_tee_cfg_t tee_cfg = AUDIO_TEE_CFG_DEFAULT();
+    tee_cfg.branches = num;
+    tee_cfg.depth = depth;
+    t->tee = audio_tee_init(&tee_cfg);
+    t->branch_num = num;
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    t->pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_pipeline_register(t->pipeline, http, "http");
+    audio_pipeline_register(t->pipeline, t->tee, "tee");
+    const char *link_tag[] = { "http", "tee" };
+    audio_pipeline_link(t->pipeline, link_tag, 2);
+
+    for (int i = 0; i < num; i++) {
+        tee_test_branch_t *b = &t->branch[i];
+        b->pipeline = audio_pipeline_init(&pipeline_cfg);
+        vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+        vfs_cfg.type = AUDIO_STREAM_WRITER;
+        b->out = vfs_stream_init(&vfs_cfg);
+        audio_element_set_uri(b->out, uris[i]);
+        audio_element_set_music_info(b->out, 16000, 2, 16);
+        bool wav = strstr(uris[i], ".wav") != NULL;
+        if (strstr(uris[i], "slow") != NULL) {
+            vfs_write = audio_element_get_write_cb(b->out);
+            audio_element_set_write_cb(b->out, tee_test_slow_write, NULL);
+        }
+        if (wav) {
+            wav_encoder_cfg_t wav_cfg = DEFAULT_WAV_ENCODER_CONFIG();
+            audio_element_handle_t encoder = wav_encoder_init(&wav_cfg);
+            audio_pipeline_register(b->pipeline, encoder, "encoder");
+            audio_pipeline_register(b->pipeline, b->out, "out");
+            const char *branch_tag[] = { "encoder", "out" };
+            audio_pipeline_link(b->pipeline, branch_tag, 2);
+            audio_tee_connect(t->tee, i, encoder);
+        } else {
+            audio_pipeline_register(b->pipeline, b->out, "out");
+            const char *branch_tag[] = { "out" };
+            audio_pipeline_link(b->pipeline, branch_tag, 1);
+            audio_tee_connect(t->tee, i, b->out);
+        }
+        audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+        b->evt = audio_event_iface_init(&evt_cfg);
+        audio_pipeline_set_listener(b->pipeline, b->evt);
+    }
+}
+
+// the outputs first, they wait for the tee, then each output's end in order
+static void tee_test_run(tee_test_t *t)
+{
+    for (int i = 0; i < t->branch_num; i++) {
+        audio_pipeline_run(t->branch[i].pipeline);
+    }
+    int64_t start = esp_timer_get_time();
+    audio_pipeline_run(t->pipeline);
+    for (int i = 0; i < t->branch_num; i++) {
+        tee_test_branch_t *b = &t->branch[i];
+        b->status = test_wait_end(b->evt, b->out, 10000);
+        b->end_us = esp_timer_get_time() - start;
+    }
+}
+
+static void tee_test_deinit(tee_test_t *t)
+{
+    audio_pipeline_stop(t->pipeline);
+    audio_pipeline_wait_for_stop(t->pipeline);
+    for (int i = 0; i < t->branch_num; i++) {
+        audio_pipeline_stop(t->branch[i].pipeline);
+        audio_pipeline_wait_for_stop(t->branch[i].pipeline);
+    }
+    // the outputs read from the blocks of the tee, release them first
+    for (int i = 0; i < t->branch_num; i++) {
+        audio_pipeline_deinit(t->branch[i].pipeline);
+        audio_event_iface_destroy(t->branch[i].evt);
+    }
+    audio_pipeline_deinit(t->pipeline);
+}
+
+// the samples of an output, NULL when the file is missing
+static uint16_t *tee_test_samples(const char *name, int *samples)
+{
+    long len;
+    uint8_t *file = test_read_file(test_path(name), &len);
+    int skip = strstr(name, ".wav") != NULL ? sizeof(wav_header_t) : 0;
+    if (file == NULL || len < skip) {
+        free(file);
+        return NULL;
+    }
+    *samples = (len - skip) / 2;
+    memmove(file, file + skip, len - skip);
+    return (uint16_t *)file;
+}
+
+// every output gets every byte, each in its own format
+static void test_tee_outputs(void)
+{
+    static const char *const uris[] = { "/sdcard/a.wav", "/sdcard/b.pcm", "/sdcard/c.wav" };
+    tee_test_t t;
+    tee_test_init(&t, uris, 3, AUDIO_TEE_DEPTH);
+    tee_test_run(&t);
+    audio_tee_stats_t stats[3];
+    for (int i = 0; i < 3; i++) {
+        audio_tee_get_stats(t.tee, i, &stats[i]);
+    }
+    tee_test_deinit(&t);
+
+    static const char *const names[] = { "a.wav", "b.pcm", "c.wav" };
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQ(t.branch[i].status, AEL_STATUS_STATE_FINISHED);
+        TEST_ASSERT_EQ(stats[i].dropped, 0);
+        TEST_ASSERT(stats[i].blocks >= TEE_TEST_BYTES / AUDIO_TEE_BLOCK_SIZE);
+        int samples = 0;
+        uint16_t *pcm = tee_test_samples(names[i], &samples);
+        int ramp = pcm != NULL && samples == TEE_TEST_SAMPLES;
+        for (int s = 0; ramp && s < samples; s++) {
+            ramp = pcm[s] == s;
+        }
+        free(pcm);
+        TEST_ASSERT(ramp);
+    }
+}
+
+// a slow card loses whole blocks once `depth` behind, the other output gets everything on time
+static void test_tee_slow_output(void)
+{
+    static const char *const uris[] = { "/sdcard/fast.pcm", "/sdcard/slow.wav" };
+    tee_test_t t;
+    tee_test_init(&t, uris, 2, 4);
+    tee_test_run(&t);
+    audio_tee_stats_t fast, slow;
+    audio_tee_get_stats(t.tee, 0, &fast);
+    audio_tee_get_stats(t.tee, 1, &slow);
+    tee_test_deinit(&t);
+    TEST_ASSERT_EQ(t.branch[0].status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(t.branch[1].status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(fast.dropped, 0);
+    TEST_ASSERT(slow.dropped > 0);
+    TEST_ASSERT(slow.peak <= 4);
+    // the input takes a second, the slow output about as long again to drain its queue
+    TEST_ASSERT(t.branch[0].end_us < 1500 * 1000);
+
+    int samples = 0;
+    uint16_t *pcm = tee_test_samples("fast.pcm", &samples);
+    int ramp = pcm != NULL && samples == TEE_TEST_SAMPLES;
+    for (int s = 0; ramp && s < samples; s++) {
+        ramp = pcm[s] == s;
+    }
+    free(pcm);
+    TEST_ASSERT(ramp);
+
+    // what the slow output kept is in order, and with the drops adds up to the input
+    pcm = tee_test_samples("slow.wav", &samples);
+    int ordered = pcm != NULL && samples + slow.dropped / 2 == TEE_TEST_SAMPLES;
+    for (int s = 1; ordered && s < samples; s++) {
+        ordered = pcm[s] > pcm[s - 1];
+    }
+    free(pcm);
+    TEST_ASSERT(ordered);
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_HTTP_ROOT", test_dir, 1);
+    setenv("AUDIO_HOST_HTTP_RATE", TEE_TEST_BYTE_RATE, 1);
+    // a ramp shows every lost or repeated sample
+    uint16_t *ramp = malloc(TEE_TEST_BYTES);
+    for (int i = 0; i < TEE_TEST_SAMPLES; i++) {
+        ramp[i] = i;
+    }
+    test_write_file(test_path("in.pcm"), ramp, TEE_TEST_BYTES);
+    free(ramp);
+    TEST_RUN(test_tee_outputs);
+    TEST_RUN(test_tee_slow_output);
+    TEST_EXIT();
+}
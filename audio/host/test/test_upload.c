@@ -0,0 +1,345 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// audio_upload streaming a file to the loopback host and to a local HTTP server on a
+// socket, one that can hang up in the middle of the body
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "audio_upload.h"
+#include "extmod/vfs_fat.h"
+#include "ringbuf.h"
+#include "vfs_stream.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+#define UPLOAD_TEST_BYTES (100000)
+#define UPLOAD_TEST_RATE (16000)
+#define UPLOAD_TEST_DROP_AFTER (20000)
+#define UPLOAD_TEST_COPY_RB_SIZE (8 * 1024)
+
+static uint8_t pattern[UPLOAD_TEST_BYTES];
+
+// the server end, one request per start
+typedef struct {
+    int fd;
+    int port;
+    pthread_t thread;
+    long drop_after;    // hang up once the body passed this many bytes, 0 never
+    char headers[2048];
+    uint8_t *body;
+    long body_len;
+    int chunks;
+    bool complete;      // the terminating chunk arrived
+    bool joined;
+} upload_test_server_t;
+
+static void *upload_test_serve(void *arg)
+{
+    upload_test_server_t *s = (upload_test_server_t *)arg;
+    int fd = accept(s->fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+    FILE *in = fdopen(fd, "rb");
+    char line[256];
+    size_t used = 0;
+    while (fgets(line, sizeof(line), in) != NULL && strcmp(line, "\r\n") != 0) {
+        used += snprintf(s->headers + used, sizeof(s->headers) - used, "%s", line);
+        used = used < sizeof(s->headers) ? used : sizeof(s->headers) - 1;
+    }
+    s->body = malloc(UPLOAD_TEST_BYTES + 4096);
+    while (fgets(line, sizeof(line), in) != NULL) {
+        long n = strtol(line, NULL, 16);
+        if (n == 0) {
+            s->complete = fgets(line, sizeof(line), in) != NULL && strcmp(line, "\r\n") == 0;
+            break;
+        }
+        if (s->drop_after && s->body_len > s->drop_after) {
+            // closing with unread data resets the connection
+            fclose(in);
+            return NULL;
+        }
+        if (s->body_len + n > UPLOAD_TEST_BYTES + 4096 || fread(s->body + s->body_len, 1, n, in) != n
+            || fgets(line, sizeof(line), in) == NULL || strcmp(line, "\r\n") != 0) {
+            break;
+        }
+        s->body_len += n;
+        s->chunks++;
+    }
+    static const char resp[] = "HTTP/1.1 201 Created\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+    if (write(fd, resp, sizeof(resp) - 1) < 0) {
+        perror("write");
+    }
+    fclose(in);
+    return NULL;
+}
+
+static void upload_test_server_start(upload_test_server_t *s, long drop_after)
+{
+    memset(s, 0, sizeof(*s));
+    s->drop_after = drop_after;
+    s->fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t len = sizeof(addr);
+    // a small window, so the body can't all be in flight before the server hangs up
+    int rcvbuf = 4096;
+    setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (s->fd < 0 || bind(s->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(s->fd, 1) != 0
+        || getsockname(s->fd, (struct sockaddr *)&addr, &len) != 0) {
+        perror("server");
+        exit(EXIT_FAILURE);
+    }
+    s->port = ntohs(addr.sin_port);
+    pthread_create(&s->thread, NULL, upload_test_serve, s);
+}
+
+// the request has been served, or the server hung up
+static void upload_test_server_wait(upload_test_server_t *s)
+{
+    if (!s->joined) {
+        pthread_join(s->thread, NULL);
+        s->joined = true;
+    }
+}
+
+static void upload_test_server_stop(upload_test_server_t *s)
+{
+    upload_test_server_wait(s);
+    close(s->fd);
+    free(s->body);
+}
+
+static bool upload_test_header(const upload_test_server_t *s, const char *header)
+{
+    return strstr(s->headers, header) != NULL;
+}
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    audio_element_handle_t out;
+    // the local copy, as audio_recorder_create_copy makes it
+    audio_pipeline_handle_t copy;
+    audio_element_handle_t copy_stream;
+    ringbuf_handle_t copy_rb;
+} upload_test_t;
+
+// file -> upload, the recording played back from the card
+static void upload_test_init(upload_test_t *t, const char *uri, audio_upload_t *up, audio_upload_head_t head, bool copy)
+{
+    memset(t, 0, sizeof(*t));
+    if (copy) {
+        audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+        t->copy = audio_pipeline_init(&pipeline_cfg);
+        vfs_stream_cfg_t copy_cfg = VFS_STREAM_CFG_DEFAULT();
+        copy_cfg.type = AUDIO_STREAM_WRITER;
+        t->copy_stream = vfs_stream_init(&copy_cfg);
+        audio_element_set_uri(t->copy_stream, "/sdcard/copy.wav");
+        audio_element_set_music_info(t->copy_stream, UPLOAD_TEST_RATE, 1, 16);
+        audio_pipeline_register(t->copy, t->copy_stream, "copy");
+        const char *copy_tag[] = { "copy" };
+        audio_pipeline_link(t->copy, copy_tag, 1);
+        t->copy_rb = rb_create(UPLOAD_TEST_COPY_RB_SIZE, 1);
+        audio_element_set_input_ringbuf(t->copy_stream, t->copy_rb);
+    }
+
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t file = vfs_stream_init(&vfs_cfg);
+    audio_element_set_uri(file, "/sdcard/rec.pcm");
+
+    audio_upload_cfg_t up_cfg = AUDIO_UPLOAD_CFG_DEFAULT();
+    up_cfg.upload = up;
+    up_cfg.content_type = head == AUDIO_UPLOAD_HEAD_WAV ? "audio/wav" : "audio/L16";
+    up_cfg.head = head;
+    up_cfg.sample_rate = UPLOAD_TEST_RATE;
+    up_cfg.copy_rb = t->copy_rb;
+    t->out = audio_upload_init(&up_cfg);
+    audio_element_set_uri(t->out, uri);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    t->pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_pipeline_register(t->pipeline, file, "file");
+    audio_pipeline_register(t->pipeline, t->out, "upload");
+    const char *link_tag[] = { "file", "upload" };
+    audio_pipeline_link(t->pipeline, link_tag, 2);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    t->evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(t->pipeline, t->evt);
+}
+
+static int upload_test_run(upload_test_t *t)
+{
+    if (t->copy != NULL) {
+        audio_pipeline_run(t->copy);
+    }
+    if (audio_pipeline_run(t->pipeline) != ESP_OK) {
+        return -1;
+    }
+    return test_wait_end(t->evt, t->out, 5000);
+}
+
+static void upload_test_deinit(upload_test_t *t)
+{
+    audio_pipeline_stop(t->pipeline);
+    audio_pipeline_wait_for_stop(t->pipeline);
+    audio_pipeline_terminate(t->pipeline);
+    audio_pipeline_remove_listener(t->pipeline);
+    audio_pipeline_deinit(t->pipeline);
+    audio_event_iface_destroy(t->evt);
+    if (t->copy != NULL) {
+        // as audio_recorder_release_copy, the copy writes out what it holds
+        rb_done_write(t->copy_rb);
+        audio_element_wait_for_stop_ms(t->copy_stream, pdMS_TO_TICKS(2000));
+        audio_pipeline_stop(t->copy);
+        audio_pipeline_wait_for_stop(t->copy);
+        audio_pipeline_deinit(t->copy);
+        rb_destroy(t->copy_rb);
+    }
+}
+
+// the stored body is a WAV header of unknown length and the data
+static void test_upload_loopback(void)
+{
+    static audio_upload_t up;
+    upload_test_t t;
+    upload_test_init(&t, "http://loopback/up.wav", &up, AUDIO_UPLOAD_HEAD_WAV, false);
+    int status = upload_test_run(&t);
+    upload_test_deinit(&t);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(up.status, 200);
+    TEST_ASSERT_EQ(up.sent, UPLOAD_TEST_BYTES);
+    TEST_ASSERT(!up.failed);
+
+    long len;
+    uint8_t *file = test_read_file(test_path("up.wav"), &len);
+    int same = file != NULL && len == sizeof(wav_header_t) + UPLOAD_TEST_BYTES
+               && memcmp(file + sizeof(wav_header_t), pattern, UPLOAD_TEST_BYTES) == 0;
+    uint32_t data_size = file != NULL ? test_le(file + 40, 4) : 0;
+    int rate = file != NULL ? test_le(file + 24, 4) : 0;
+    free(file);
+    TEST_ASSERT(same);
+    TEST_ASSERT_EQ(data_size, AUDIO_UPLOAD_STREAM_SIZE);
+    TEST_ASSERT_EQ(rate, UPLOAD_TEST_RATE);
+}
+
+// the request on the wire, chunked with the format headers
+static void test_upload_server(void)
+{
+    static audio_upload_t up;
+    upload_test_server_t s;
+    upload_test_server_start(&s, 0);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "http://127.0.0.1:%d/rec", s.port);
+    upload_test_t t;
+    upload_test_init(&t, uri, &up, AUDIO_UPLOAD_HEAD_NONE, false);
+    int status = upload_test_run(&t);
+    upload_test_deinit(&t);
+    upload_test_server_wait(&s);
+    int body_ok = s.complete && s.chunks > 1 && s.body_len == UPLOAD_TEST_BYTES
+                  && memcmp(s.body, pattern, UPLOAD_TEST_BYTES) == 0;
+    upload_test_server_stop(&s);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(up.status, 201);
+    TEST_ASSERT(strncmp(s.headers, "POST /rec HTTP/1.1\r\n", 20) == 0);
+    TEST_ASSERT(upload_test_header(&s, "Transfer-Encoding: chunked\r\n"));
+    TEST_ASSERT(upload_test_header(&s, "Content-Type: audio/L16\r\n"));
+    TEST_ASSERT(upload_test_header(&s, "x-audio-sample-rates: 16000\r\n"));
+    TEST_ASSERT(upload_test_header(&s, "x-audio-channel: 1\r\n"));
+    TEST_ASSERT(body_ok);
+}
+
+// a broken connection is an output error without a copy
+static void test_upload_drop(void)
+{
+    static audio_upload_t up;
+    upload_test_server_t s;
+    upload_test_server_start(&s, UPLOAD_TEST_DROP_AFTER);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "http://127.0.0.1:%d/rec", s.port);
+    upload_test_t t;
+    upload_test_init(&t, uri, &up, AUDIO_UPLOAD_HEAD_WAV, false);
+    int status = upload_test_run(&t);
+    upload_test_deinit(&t);
+    upload_test_server_stop(&s);
+    TEST_ASSERT(status != AEL_STATUS_STATE_FINISHED && status != -1);
+    TEST_ASSERT(up.failed);
+    TEST_ASSERT(up.sent < UPLOAD_TEST_BYTES);
+}
+
+// with a copy the recording goes on, and the whole of it lands in the copy
+static void test_upload_drop_copy(void)
+{
+    static audio_upload_t up;
+    upload_test_server_t s;
+    upload_test_server_start(&s, UPLOAD_TEST_DROP_AFTER);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "http://127.0.0.1:%d/rec", s.port);
+    upload_test_t t;
+    upload_test_init(&t, uri, &up, AUDIO_UPLOAD_HEAD_WAV, true);
+    upload_test_run(&t);
+    upload_test_deinit(&t);
+    upload_test_server_stop(&s);
+    TEST_ASSERT(up.failed);
+    TEST_ASSERT(up.sent < UPLOAD_TEST_BYTES);
+    TEST_ASSERT_EQ(up.copy_dropped, 0);
+
+    long len;
+    uint8_t *file = test_read_file(test_path("copy.wav"), &len);
+    int same = file != NULL && len == sizeof(wav_header_t) + UPLOAD_TEST_BYTES
+               && test_le(file + 40, 4) == UPLOAD_TEST_BYTES
+               && memcmp(file + sizeof(wav_header_t), pattern, UPLOAD_TEST_BYTES) == 0;
+    free(file);
+    TEST_ASSERT(same);
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    setenv("AUDIO_HOST_HTTP_ROOT", test_dir, 1);
+    for (int i = 0; i < UPLOAD_TEST_BYTES; i++) {
+        pattern[i] = (uint8_t)(i * 31 + (i >> 9));
+    }
+    test_write_file(test_path("rec.pcm"), pattern, UPLOAD_TEST_BYTES);
+    TEST_RUN(test_upload_loopback);
+    TEST_RUN(test_upload_server);
+    TEST_RUN(test_upload_drop);
+    TEST_RUN(test_upload_drop_copy);
+    TEST_EXIT();
+}
@@ -0,0 +1,281 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// audio_vad on the reference files in data/, made by data/gen_vad.py with the speech segments
+// marked in <name>.wav.truth
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "audio_vad.h"
+#include "extmod/vfs_fat.h"
+#include "raw_stream.h"
+#include "vfs_stream.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+// make runs the tests in their directory
+#define VAD_TEST_DATA "data"
+#define VAD_TEST_SEGS (8)
+// a speech segment may lose its faded edges
+#define VAD_TEST_KEPT_PERCENT (90)
+// false starts in the noise, on top of the hangover and kept silence after each segment
+#define VAD_TEST_NOISE_SLACK (10)
+
+typedef struct {
+    char kind;
+    long start; // in frames
+    long end;
+} vad_test_seg_t;
+
+typedef struct {
+    uint8_t *file;
+    const int16_t *pcm;
+    long pcm_len;
+    int rate;
+    int channels;
+    int frame_bytes;    // one 10 ms frame of the detector
+    vad_test_seg_t segs[VAD_TEST_SEGS];
+    int seg_num;
+} vad_test_ref_t;
+
+typedef struct {
+    uint8_t *out;
+    long out_len;
+    int status;
+    audio_vad_stats_t stats;
+} vad_test_run_t;
+
+static const char *vad_test_data(const char *name, const char *ext)
+{
+    static char path[256];
+    snprintf(path, sizeof(path), "%s/%s%s", VAD_TEST_DATA, name, ext);
+    return path;
+}
+
+static bool vad_test_ref_load(vad_test_ref_t *ref, const char *name)
+{
+    long len;
+    memset(ref, 0, sizeof(*ref));
+    ref->file = test_read_file(vad_test_data(name, ""), &len);
+    if (ref->file == NULL || len < sizeof(wav_header_t)) {
+        return false;
+    }
+    ref->channels = test_le(ref->file + 22, 2);
+    ref->rate = test_le(ref->file + 24, 4);
+    ref->pcm = (const int16_t *)(ref->file + sizeof(wav_header_t));
+    ref->pcm_len = len - sizeof(wav_header_t);
+    ref->frame_bytes = ref->rate * AUDIO_VAD_FRAME_MS / 1000 * ref->channels * sizeof(int16_t);
+
+    FILE *f = fopen(vad_test_data(name, ".truth"), "r");
+    if (f == NULL) {
+        return false;
+    }
+    vad_test_seg_t *seg = ref->segs;
+    while (ref->seg_num < VAD_TEST_SEGS && fscanf(f, " %c %ld %ld", &seg->kind, &seg->start, &seg->end) == 3) {
+        ref->seg_num++;
+        seg++;
+    }
+    fclose(f);
+    return ref->seg_num > 0;
+}
+
+// file -> vad -> raw as audio_recorder_create_vad places the detector, the output read whole
+static void vad_test_run(vad_test_run_t *run, const char *name, audio_vad_cfg_t *vad_cfg)
+{
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t file = vfs_stream_init(&vfs_cfg);
+    char uri[128];
+    snprintf(uri, sizeof(uri), "/sdcard/%s", name);
+    audio_element_set_uri(file, uri);
+    audio_element_set_byte_pos(file, sizeof(wav_header_t));
+
+    audio_element_handle_t vad = audio_vad_init(vad_cfg);
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t raw = raw_stream_init(&raw_cfg);
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_pipeline_register(pipeline, file, "file");
+    audio_pipeline_register(pipeline, vad, "vad");
+    audio_pipeline_register(pipeline, raw, "raw");
+    const char *link_tag[] = { "file", "vad", "raw" };
+    audio_pipeline_link(pipeline, link_tag, 3);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    audio_event_iface_handle_t evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(pipeline, evt);
+
+    long size = 64 * 1024;
+    run->out = malloc(size);
+    run->out_len = 0;
+    audio_pipeline_run(pipeline);
+    int r;
+    do {
+        if (run->out_len + 4096 > size) {
+            size *= 2;
+            run->out = realloc(run->out, size);
+        }
+        r = raw_stream_read(raw, (char *)run->out + run->out_len, 4096);
+        run->out_len += r > 0 ? r : 0;
+    } while (r > 0);
+    run->status = test_wait_end(evt, vad, 5000);
+    audio_vad_get_stats(vad, &run->stats);
+
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_remove_listener(pipeline);
+    audio_pipeline_deinit(pipeline);
+    audio_event_iface_destroy(evt);
+}
+
+// the detector passes whole frames unchanged, in order, so each output frame is found in the input
+static char *vad_test_passed(const vad_test_ref_t *ref, const vad_test_run_t *run)
+{
+    long frames = ref->pcm_len / ref->frame_bytes;
+    char *passed = calloc(frames, 1);
+    long in = 0;
+    for (long out = 0; out + ref->frame_bytes <= run->out_len; out += ref->frame_bytes) {
+        while (in < frames && memcmp((const uint8_t *)ref->pcm + in * ref->frame_bytes,
+                                     run->out + out, ref->frame_bytes) != 0) {
+            in++;
+        }
+        if (in == frames) {
+            free(passed);
+            return NULL;
+        }
+        passed[in++] = 1;
+    }
+    return passed;
+}
+
+static int vad_test_count(const vad_test_ref_t *ref, const char *passed, const vad_test_seg_t *seg)
+{
+    int fs = ref->rate * AUDIO_VAD_FRAME_MS / 1000;
+    int kept = 0;
+    for (long i = seg->start / fs; i < seg->end / fs; i++) {
+        kept += passed[i];
+    }
+    return kept;
+}
+
+// the speech is kept, the leading noise dropped and each gap cut to the hangover and keep_ms
+static void vad_test_trim(const char *name, int min_trimmed_percent)
+{
+    vad_test_ref_t ref;
+    TEST_ASSERT(vad_test_ref_load(&ref, name));
+    audio_vad_cfg_t cfg = AUDIO_VAD_CFG_DEFAULT();
+    cfg.sample_rate = ref.rate;
+    cfg.channels = ref.channels;
+    vad_test_run_t run;
+    vad_test_run(&run, name, &cfg);
+    char *passed = vad_test_passed(&ref, &run);
+    long frames = ref.pcm_len / ref.frame_bytes;
+    int fs = ref.rate * AUDIO_VAD_FRAME_MS / 1000;
+    int gap_max = (cfg.hangover_ms + cfg.keep_ms) / AUDIO_VAD_FRAME_MS + VAD_TEST_NOISE_SLACK;
+
+    int ok = run.status == AEL_STATUS_STATE_FINISHED && passed != NULL
+             && run.stats.frames_in == frames && run.stats.frames_out == run.out_len / ref.frame_bytes
+             && run.out_len % ref.frame_bytes == 0;
+    for (int i = 0; ok && i < ref.seg_num; i++) {
+        const vad_test_seg_t *seg = &ref.segs[i];
+        int total = (seg->end - seg->start) / fs;
+        int kept = vad_test_count(&ref, passed, seg);
+        if (seg->kind == 's') {
+            ok = kept * 100 >= total * VAD_TEST_KEPT_PERCENT;
+        } else {
+            ok = kept <= (i == 0 ? VAD_TEST_NOISE_SLACK : gap_max);
+        }
+        if (!ok) {
+            printf("%s: %c %.2f-%.2f s passed %d/%d frames\n", name, seg->kind,
+                   (double)seg->start / ref.rate, (double)seg->end / ref.rate, kept, total);
+        }
+    }
+    int trimmed = frames ? (frames - run.stats.frames_out) * 100 / frames : 0;
+    free(passed);
+    free(run.out);
+    free(ref.file);
+    TEST_ASSERT(ok);
+    TEST_ASSERT(trimmed >= min_trimmed_percent);
+}
+
+static void test_vad_quiet(void)
+{
+    vad_test_trim("quiet16k.wav", 50);
+}
+
+static void test_vad_noisy(void)
+{
+    vad_test_trim("noisy8k.wav", 50);
+}
+
+static void test_vad_stereo(void)
+{
+    vad_test_trim("stereo16k.wav", 50);
+}
+
+// stop_ms finishes the stream in the first gap longer than the hangover and stop_ms
+static void test_vad_stop(void)
+{
+    vad_test_ref_t ref;
+    TEST_ASSERT(vad_test_ref_load(&ref, "quiet16k.wav"));
+    audio_vad_cfg_t cfg = AUDIO_VAD_CFG_DEFAULT();
+    cfg.sample_rate = ref.rate;
+    cfg.channels = ref.channels;
+    cfg.stop_ms = 1000;
+    vad_test_run_t run;
+    vad_test_run(&run, "quiet16k.wav", &cfg);
+    char *passed = vad_test_passed(&ref, &run);
+    int fs = ref.rate * AUDIO_VAD_FRAME_MS / 1000;
+    // the first speech segment, then its 1.5 s gap
+    const vad_test_seg_t *speech = &ref.segs[1];
+    long stop = speech->end / fs + (cfg.hangover_ms + cfg.stop_ms) / AUDIO_VAD_FRAME_MS;
+    int kept = passed ? vad_test_count(&ref, passed, speech) : 0;
+    int later = passed ? vad_test_count(&ref, passed, &ref.segs[3]) : -1;
+    free(passed);
+    free(run.out);
+    free(ref.file);
+    TEST_ASSERT_EQ(run.status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT(kept * 100 >= (speech->end - speech->start) / fs * VAD_TEST_KEPT_PERCENT);
+    TEST_ASSERT_EQ(later, 0);
+    TEST_ASSERT(run.stats.frames_in <= stop + 1 && run.stats.frames_in + VAD_TEST_NOISE_SLACK >= stop);
+}
+
+int main(void)
+{
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", VAD_TEST_DATA);
+    TEST_RUN(test_vad_quiet);
+    TEST_RUN(test_vad_noisy);
+    TEST_RUN(test_vad_stereo);
+    TEST_RUN(test_vad_stop);
+    TEST_EXIT();
+}
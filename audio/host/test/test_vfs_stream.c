@@ -0,0 +1,215 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "audio_pipeline.h"
+#include "extmod/vfs_fat.h"
+#include "raw_stream.h"
+#include "vfs_stream.h"
+
+#include "test.h"
+#include "test_audio.h"
+
+#define VFS_TEST_BYTES (50000)
+#define VFS_TEST_RATE (16000)
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_event_iface_handle_t evt;
+    audio_element_handle_t vfs;
+    audio_element_handle_t raw;
+} vfs_test_t;
+
+static uint8_t pattern[VFS_TEST_BYTES];
+
+// file -> raw for a reader, raw -> file for a writer
+static void vfs_test_init(vfs_test_t *t, audio_stream_type_t type, const char *uri)
+{
+    vfs_stream_cfg_t vfs_cfg = VFS_STREAM_CFG_DEFAULT();
+    vfs_cfg.type = type;
+    t->vfs = vfs_stream_init(&vfs_cfg);
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = type;
+    t->raw = raw_stream_init(&raw_cfg);
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    t->pipeline = audio_pipeline_init(&pipeline_cfg);
+    audio_pipeline_register(t->pipeline, t->vfs, "file");
+    audio_pipeline_register(t->pipeline, t->raw, "raw");
+    const char *reader[] = { "file", "raw" };
+    const char *writer[] = { "raw", "file" };
+    audio_pipeline_link(t->pipeline, type == AUDIO_STREAM_READER ? reader : writer, 2);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    t->evt = audio_event_iface_init(&evt_cfg);
+    audio_pipeline_set_listener(t->pipeline, t->evt);
+    audio_element_set_uri(t->vfs, uri);
+}
+
+static void vfs_test_deinit(vfs_test_t *t)
+{
+    audio_pipeline_stop(t->pipeline);
+    audio_pipeline_wait_for_stop(t->pipeline);
+    audio_pipeline_terminate(t->pipeline);
+    audio_pipeline_remove_listener(t->pipeline);
+    audio_pipeline_deinit(t->pipeline);
+    audio_event_iface_destroy(t->evt);
+}
+
+static long vfs_test_read_all(vfs_test_t *t, uint8_t *buf, long len)
+{
+    long total = 0;
+    while (total < len) {
+        int n = raw_stream_read(t->raw, (char *)buf + total, len - total < 1000 ? len - total : 1000);
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
+
+static void vfs_test_write_all(vfs_test_t *t, const uint8_t *buf, long len)
+{
+    for (long done = 0; done < len; done += 1000) {
+        raw_stream_write(t->raw, (char *)buf + done, len - done < 1000 ? len - done : 1000);
+    }
+    audio_element_set_ringbuf_done(t->raw);
+}
+
+static void test_read(void)
+{
+    test_write_file(test_path("in.raw"), pattern, sizeof(pattern));
+    vfs_test_t t;
+    vfs_test_init(&t, AUDIO_STREAM_READER, "/sdcard/in.raw");
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    static uint8_t buf[VFS_TEST_BYTES + 1];
+    long n = vfs_test_read_all(&t, buf, sizeof(buf));
+    int status = test_wait_end(t.evt, t.vfs, 2000);
+    audio_element_info_t info;
+    audio_element_getinfo(t.vfs, &info);
+    vfs_test_deinit(&t);
+    TEST_ASSERT_EQ(n, VFS_TEST_BYTES);
+    TEST_ASSERT(memcmp(buf, pattern, VFS_TEST_BYTES) == 0);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(info.total_bytes, VFS_TEST_BYTES);
+}
+
+static void test_read_from_pos(void)
+{
+    test_write_file(test_path("in.raw"), pattern, sizeof(pattern));
+    vfs_test_t t;
+    vfs_test_init(&t, AUDIO_STREAM_READER, "/sdcard/in.raw#wav");
+    audio_element_info_t info;
+    audio_element_getinfo(t.vfs, &info);
+    info.byte_pos = 1000;
+    audio_element_setinfo(t.vfs, &info);
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    static uint8_t buf[VFS_TEST_BYTES];
+    long n = vfs_test_read_all(&t, buf, sizeof(buf));
+    vfs_test_deinit(&t);
+    TEST_ASSERT_EQ(n, VFS_TEST_BYTES - 1000);
+    TEST_ASSERT(memcmp(buf, pattern + 1000, n) == 0);
+}
+
+// the element task has nothing to catch an exception, a missing file has to fail the open
+static void test_missing_file(void)
+{
+    vfs_test_t t;
+    vfs_test_init(&t, AUDIO_STREAM_READER, "/sdcard/missing.raw");
+    TEST_ASSERT(audio_pipeline_run(t.pipeline) != ESP_OK);
+    int status = test_wait_end(t.evt, t.vfs, 2000);
+    vfs_test_deinit(&t);
+    TEST_ASSERT_EQ(status, AEL_STATUS_ERROR_OPEN);
+}
+
+static void test_write_wav(void)
+{
+    vfs_test_t t;
+    vfs_test_init(&t, AUDIO_STREAM_WRITER, "/sdcard/out.wav");
+    audio_element_set_music_info(t.vfs, VFS_TEST_RATE, 1, 16);
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    vfs_test_write_all(&t, pattern, VFS_TEST_BYTES);
+    int status = test_wait_end(t.evt, t.vfs, 2000);
+    vfs_test_deinit(&t);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+
+    long len;
+    uint8_t *file = test_read_file(test_path("out.wav"), &len);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT_EQ(len, sizeof(wav_header_t) + VFS_TEST_BYTES);
+    TEST_ASSERT(memcmp(file, "RIFF", 4) == 0 && memcmp(file + 8, "WAVE", 4) == 0);
+    TEST_ASSERT_EQ(test_le(file + 4, 4), len - 8);
+    TEST_ASSERT_EQ(test_le(file + 22, 2), 1);
+    TEST_ASSERT_EQ(test_le(file + 24, 4), VFS_TEST_RATE);
+    TEST_ASSERT_EQ(test_le(file + 40, 4), VFS_TEST_BYTES);
+    TEST_ASSERT(memcmp(file + sizeof(wav_header_t), pattern, VFS_TEST_BYTES) == 0);
+    free(file);
+}
+
+static void test_write_segments(void)
+{
+    vfs_test_t t;
+    vfs_test_init(&t, AUDIO_STREAM_WRITER, "/sdcard/seg%d.wav");
+    audio_element_set_music_info(t.vfs, VFS_TEST_RATE, 1, 16);
+    TEST_ASSERT_EQ(vfs_stream_set_segment(t.vfs, 20000, 0), ESP_OK);
+    TEST_ASSERT_EQ(audio_pipeline_run(t.pipeline), ESP_OK);
+    vfs_test_write_all(&t, pattern, VFS_TEST_BYTES);
+    int status = test_wait_end(t.evt, t.vfs, 2000);
+    int segment = vfs_stream_get_segment(t.vfs);
+    vfs_test_deinit(&t);
+    TEST_ASSERT_EQ(status, AEL_STATUS_STATE_FINISHED);
+    TEST_ASSERT_EQ(segment, 2);
+
+    static const long sizes[] = { 20000, 20000, VFS_TEST_BYTES - 40000 };
+    long offset = 0;
+    for (int i = 0; i < 3; i++) {
+        char name[24];
+        snprintf(name, sizeof(name), "seg%d.wav", i);
+        long len;
+        uint8_t *file = test_read_file(test_path(name), &len);
+        TEST_ASSERT(file != NULL);
+        TEST_ASSERT_EQ(len, sizeof(wav_header_t) + sizes[i]);
+        TEST_ASSERT_EQ(test_le(file + 40, 4), sizes[i]);
+        TEST_ASSERT(memcmp(file + sizeof(wav_header_t), pattern + offset, sizes[i]) == 0);
+        offset += sizes[i];
+        free(file);
+    }
+}
+
+int main(void)
+{
+    test_dir_create();
+    snprintf(mp_stub_sdcard, sizeof(mp_stub_sdcard), "%s", test_dir);
+    for (int i = 0; i < VFS_TEST_BYTES; i++) {
+        pattern[i] = (uint8_t)(i * 7 + i / 251);
+    }
+    TEST_RUN(test_read);
+    TEST_RUN(test_read_from_pos);
+    TEST_RUN(test_missing_file);
+    TEST_RUN(test_write_wav);
+    TEST_RUN(test_write_segments);
+    TEST_EXIT();
+}
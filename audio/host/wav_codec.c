@@ -0,0 +1,194 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "audio_element.h"
+#include "audio_error.h"
+#include "audio_mem.h"
+#include "esp_log.h"
+#include "wav_decoder.h"
+#include "wav_encoder.h"
+#include "wav_head.h"
+
+static const char *TAG = "WAV_DECODER";
+
+// the chunks before the data of any sane file fit, a LIST chunk included
+#define WAV_HEAD_MAX (2048)
+#define WAV_BUFFER_SIZE (2048)
+
+typedef struct wav_decoder {
+    uint8_t head[WAV_HEAD_MAX];
+    int head_len;
+    bool parsed;
+    wav_info_t info;
+    int64_t remain;
+} wav_decoder_t;
+
+static esp_err_t _wav_decoder_open(audio_element_handle_t self)
+{
+    wav_decoder_t *wav = (wav_decoder_t *)audio_element_getdata(self);
+    wav->head_len = 0;
+    wav->parsed = false;
+    return ESP_OK;
+}
+
+// the data after the header, a data size of 0 runs to the end of the input
+static int _wav_decoder_output(wav_decoder_t *wav, audio_element_handle_t self, char *data, int len)
+{
+    if (wav->info.data_size > 0) {
+        if (wav->remain <= 0) {
+            return 0;
+        }
+        if (len > wav->remain) {
+            len = wav->remain;
+        }
+        wav->remain -= len;
+    }
+    return len > 0 ? audio_element_output(self, data, len) : 0;
+}
+
+static int _wav_decoder_header(wav_decoder_t *wav, audio_element_handle_t self, char *data, int len)
+{
+    int n = len < WAV_HEAD_MAX - wav->head_len ? len : WAV_HEAD_MAX - wav->head_len;
+    memcpy(wav->head + wav->head_len, data, n);
+    wav->head_len += n;
+    int ret = wav_head_parser(wav->head, wav->head_len, &wav->info);
+    if (ret < 0 || (ret > 0 && wav->head_len == WAV_HEAD_MAX)) {
+        ESP_LOGE(TAG, "Not a PCM WAV stream");
+        return AEL_PROCESS_FAIL;
+    }
+    if (ret > 0) {
+        return n;
+    }
+    wav->parsed = true;
+    wav->remain = wav->info.data_size;
+    audio_element_info_t info;
+    audio_element_getinfo(self, &info);
+    info.sample_rates = wav->info.sample_rate;
+    info.channels = wav->info.channels;
+    info.bits = wav->info.bits;
+    info.bps = wav->info.sample_rate * wav->info.channels * wav->info.bits;
+    info.total_bytes = wav->info.data_size;
+    info.codec_fmt = ESP_CODEC_TYPE_WAV;
+    audio_element_setinfo(self, &info);
+    audio_element_report_info(self);
+    ESP_LOGI(TAG, "%d Hz, %d bits, %d ch, %d bytes", wav->info.sample_rate, wav->info.bits, wav->info.channels,
+             wav->info.data_size);
+
+    // the data that came in with the header
+    int held = wav->head_len - wav->info.data_offset;
+    if (held > 0 && _wav_decoder_output(wav, self, (char *)wav->head + wav->info.data_offset, held) < 0) {
+        return AEL_IO_FAIL;
+    }
+    return n;
+}
+
+static int _wav_decoder_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    wav_decoder_t *wav = (wav_decoder_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    int used = 0;
+    if (!wav->parsed) {
+        used = _wav_decoder_header(wav, self, in_buffer, r_size);
+        if (used < 0) {
+            return used;
+        }
+    }
+    int w_size = _wav_decoder_output(wav, self, in_buffer + used, r_size - used);
+    // 0 would finish the element, a header or trailing chunks are input consumed
+    return w_size < 0 ? w_size : r_size;
+}
+
+static esp_err_t _wav_decoder_close(audio_element_handle_t self)
+{
+    if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
+        audio_element_report_pos(self);
+        audio_element_set_byte_pos(self, 0);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _wav_decoder_destroy(audio_element_handle_t self)
+{
+    wav_decoder_t *wav = (wav_decoder_t *)audio_element_getdata(self);
+    audio_free(wav);
+    return ESP_OK;
+}
+
+audio_element_handle_t wav_decoder_init(wav_decoder_cfg_t *config)
+{
+    wav_decoder_t *wav = audio_calloc(1, sizeof(wav_decoder_t));
+    AUDIO_MEM_CHECK(TAG, wav, return NULL);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _wav_decoder_open;
+    cfg.close = _wav_decoder_close;
+    cfg.process = _wav_decoder_process;
+    cfg.destroy = _wav_decoder_destroy;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = WAV_BUFFER_SIZE;
+    cfg.tag = "wav";
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        audio_free(wav);
+        return NULL;
+    });
+    audio_element_setdata(el, wav);
+    return el;
+}
+
+static int _wav_encoder_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    int w_size = 0;
+    if (r_size > 0) {
+        w_size = audio_element_output(self, in_buffer, r_size);
+    } else {
+        w_size = r_size;
+    }
+    return w_size;
+}
+
+audio_element_handle_t wav_encoder_init(wav_encoder_cfg_t *config)
+{
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.process = _wav_encoder_process;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.buffer_len = WAV_BUFFER_SIZE;
+    cfg.tag = "wav";
+    return audio_element_init(&cfg);
+}
@@ -0,0 +1,105 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "wav_head.h"
+
+// the host is little endian like the ESP32, the header is filled in place
+_Static_assert(sizeof(wav_header_t) == 44, "wav_header_t must be the 44 byte file header");
+
+#define WAV_FORMAT_PCM (1)
+#define WAV_FORMAT_EXTENSIBLE (0xfffe)
+
+static uint32_t wav_get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+void wav_head_init(wav_header_t *wavhead, int sample_rate, int bits, int channels)
+{
+    memset(wavhead, 0, sizeof(wav_header_t));
+    memcpy(wavhead->chunk_id, "RIFF", 4);
+    memcpy(wavhead->format, "WAVE", 4);
+    memcpy(wavhead->subchunk_id, "fmt ", 4);
+    memcpy(wavhead->data_chunk_id, "data", 4);
+    wavhead->chunk_size = sizeof(wav_header_t) - 8;
+    wavhead->subchunk1_size = 16;
+    wavhead->audio_format = WAV_FORMAT_PCM;
+    wavhead->num_of_channels = channels;
+    wavhead->sample_rate = sample_rate;
+    wavhead->bits_per_sample = bits;
+    wavhead->block_align = channels * bits / 8;
+    wavhead->byte_rate = sample_rate * wavhead->block_align;
+}
+
+void wav_head_size(wav_header_t *wavhead, uint32_t data_size)
+{
+    wavhead->data_chunk_size = data_size;
+    wavhead->chunk_size = data_size + sizeof(wav_header_t) - 8;
+}
+
+int wav_head_parser(const uint8_t *data, int len, wav_info_t *info)
+{
+    if (len < 12) {
+        return 1;
+    }
+    if (memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+    memset(info, 0, sizeof(wav_info_t));
+    int pos = 12;
+    while (pos + 8 <= len) {
+        uint32_t size = wav_get_le(data + pos + 4, 4);
+        if (memcmp(data + pos, "data", 4) == 0) {
+            if (info->channels == 0) {
+                return -1;
+            }
+            info->data_offset = pos + 8;
+            // a streamed file leaves the size at 0 or all ones
+            info->data_size = size == 0xffffffff ? 0 : size;
+            return 0;
+        }
+        if (memcmp(data + pos, "fmt ", 4) == 0) {
+            if (size < 16 || pos + 8 + 16 > len) {
+                return size < 16 ? -1 : 1;
+            }
+            const uint8_t *fmt = data + pos + 8;
+            info->audio_format = wav_get_le(fmt, 2);
+            info->channels = wav_get_le(fmt + 2, 2);
+            info->sample_rate = wav_get_le(fmt + 4, 4);
+            info->bits = wav_get_le(fmt + 14, 2);
+            if ((info->audio_format != WAV_FORMAT_PCM && info->audio_format != WAV_FORMAT_EXTENSIBLE)
+                || info->channels == 0 || info->bits == 0) {
+                return -1;
+            }
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return 1;
+}
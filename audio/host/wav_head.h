@@ -0,0 +1,86 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2019 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _WAV_HEAD_H_
+#define _WAV_HEAD_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      The 44 byte header of a PCM WAV file
+ */
+typedef struct {
+    char chunk_id[4];        /*!< "RIFF" */
+    int32_t chunk_size;      /*!< File size - 8 */
+    char format[4];          /*!< "WAVE" */
+    char subchunk_id[4];     /*!< "fmt " */
+    int32_t subchunk1_size;  /*!< 16 for PCM */
+    int16_t audio_format;    /*!< 1 for PCM */
+    int16_t num_of_channels; /*!< Channels */
+    int32_t sample_rate;     /*!< Sample rate */
+    int32_t byte_rate;       /*!< Bytes per second */
+    int16_t block_align;     /*!< Bytes per frame */
+    int16_t bits_per_sample; /*!< Bits per sample */
+    char data_chunk_id[4];   /*!< "data" */
+    int32_t data_chunk_size; /*!< Data size */
+} wav_header_t;
+
+/**
+ * @brief      What a WAV header tells about the data
+ */
+typedef struct {
+    int audio_format; /*!< 1 for PCM, 0xfffe for extensible PCM */
+    int channels;     /*!< Channels */
+    int sample_rate;  /*!< Sample rate */
+    int bits;         /*!< Bits per sample */
+    int data_offset;  /*!< Offset of the data in the file */
+    int data_size;    /*!< Size of the data, 0 when unknown */
+} wav_info_t;
+
+/**
+ * @brief      Fill a header for PCM data of the given format
+ */
+void wav_head_init(wav_header_t *wavhead, int sample_rate, int bits, int channels);
+
+/**
+ * @brief      Set the data size in a header
+ */
+void wav_head_size(wav_header_t *wavhead, uint32_t data_size);
+
+/**
+ * @brief      Parse the chunks of a WAV file up to its data
+ *
+ * @return     0 when the header is complete, 1 when more data is needed, -1 when it is not WAV
+ */
+int wav_head_parser(const uint8_t *data, int len, wav_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
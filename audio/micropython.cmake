@@ -3,8 +3,26 @@ add_library(usermod_audio INTERFACE)
 
 # Add our source files to the lib
 target_sources(usermod_audio INTERFACE
+    ${CMAKE_CURRENT_LIST_DIR}/audio_adpcm_encoder.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_arena.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_async.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_catalog.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_decimator.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_graph.c
     ${CMAKE_CURRENT_LIST_DIR}/audio_player.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_mem_stats.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_meter.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_pcm_out.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_pipeline_player.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_placement.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_preroll.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_probe.c
     ${CMAKE_CURRENT_LIST_DIR}/audio_recorder.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_stack.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_tee.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_transcode.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_upload.c
+    ${CMAKE_CURRENT_LIST_DIR}/audio_vad.c
     ${CMAKE_CURRENT_LIST_DIR}/modaudio.c
     ${CMAKE_CURRENT_LIST_DIR}/vfs_stream.c
 )
@@ -26,5 +44,13 @@ target_include_directories(usermod_audio INTERFACE
     $ENV{ADF_PATH}/components/esp_dispatcher/include
 )
 
+# Route the ADF allocations through the placement policy and the audio arena in audio_placement.c
+target_link_options(usermod_audio INTERFACE
+    "-Wl,--wrap=audio_malloc"
+    "-Wl,--wrap=audio_calloc"
+    "-Wl,--wrap=audio_realloc"
+    "-Wl,--wrap=audio_free"
+)
+
 # Link our INTERFACE library to the usermod target.
 target_link_libraries(usermod INTERFACE usermod_audio)
\ No newline at end of file
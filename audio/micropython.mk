@@ -0,0 +1,79 @@
+# Host (Linux) build of the audio module for the unix port, the ESP32 port uses micropython.cmake.
+#   make -C ports/unix USER_C_MODULES=<this repo> ADF_PATH=<esp-adf checkout>
+# The ADF pipeline, ringbuffer and event sources are built as they are, the FreeRTOS, IDF,
+# I2S, HTTP, board and codec pieces they sit on are simulated by the sources in host/.
+AUDIO_MOD_DIR := $(USERMOD_DIR)
+AUDIO_HOST_DIR := $(AUDIO_MOD_DIR)/host
+ADF_PATH ?= $(HOME)/esp-adf
+ADF_COMPONENTS := $(ADF_PATH)/components
+
+# Add our source files to the module
+SRC_USERMOD_C += \
+	$(AUDIO_MOD_DIR)/audio_adpcm_encoder.c \
+	$(AUDIO_MOD_DIR)/audio_arena.c \
+	$(AUDIO_MOD_DIR)/audio_async.c \
+	$(AUDIO_MOD_DIR)/audio_catalog.c \
+	$(AUDIO_MOD_DIR)/audio_decimator.c \
+	$(AUDIO_MOD_DIR)/audio_graph.c \
+	$(AUDIO_MOD_DIR)/audio_player.c \
+	$(AUDIO_MOD_DIR)/audio_mem_stats.c \
+	$(AUDIO_MOD_DIR)/audio_meter.c \
+	$(AUDIO_MOD_DIR)/audio_pcm_out.c \
+	$(AUDIO_MOD_DIR)/audio_pipeline_player.c \
+	$(AUDIO_MOD_DIR)/audio_placement.c \
+	$(AUDIO_MOD_DIR)/audio_preroll.c \
+	$(AUDIO_MOD_DIR)/audio_probe.c \
+	$(AUDIO_MOD_DIR)/audio_recorder.c \
+	$(AUDIO_MOD_DIR)/audio_stack.c \
+	$(AUDIO_MOD_DIR)/audio_tee.c \
+	$(AUDIO_MOD_DIR)/audio_transcode.c \
+	$(AUDIO_MOD_DIR)/audio_upload.c \
+	$(AUDIO_MOD_DIR)/audio_vad.c \
+	$(AUDIO_MOD_DIR)/modaudio.c \
+	$(AUDIO_MOD_DIR)/vfs_stream.c
+
+# The simulated backends, no qstrs in there
+SRC_USERMOD_LIB_C += \
+	$(AUDIO_HOST_DIR)/board.c \
+	$(AUDIO_HOST_DIR)/codec_stub.c \
+	$(AUDIO_HOST_DIR)/esp_audio.c \
+	$(AUDIO_HOST_DIR)/esp_http_client.c \
+	$(AUDIO_HOST_DIR)/esp_system.c \
+	$(AUDIO_HOST_DIR)/esp_timer.c \
+	$(AUDIO_HOST_DIR)/filter_resample.c \
+	$(AUDIO_HOST_DIR)/freertos.c \
+	$(AUDIO_HOST_DIR)/http_stream.c \
+	$(AUDIO_HOST_DIR)/i2s.c \
+	$(AUDIO_HOST_DIR)/i2s_stream.c \
+	$(AUDIO_HOST_DIR)/wav_codec.c \
+	$(AUDIO_HOST_DIR)/wav_head.c
+
+# The portable ADF sources
+SRC_USERMOD_LIB_C += \
+	$(ADF_COMPONENTS)/audio_pipeline/audio_element.c \
+	$(ADF_COMPONENTS)/audio_pipeline/audio_event_iface.c \
+	$(ADF_COMPONENTS)/audio_pipeline/audio_pipeline.c \
+	$(ADF_COMPONENTS)/audio_pipeline/ringbuf.c \
+	$(ADF_COMPONENTS)/audio_sal/audio_mem.c \
+	$(ADF_COMPONENTS)/audio_sal/audio_mutex.c \
+	$(ADF_COMPONENTS)/audio_sal/audio_queue.c \
+	$(ADF_COMPONENTS)/audio_sal/audio_thread.c \
+	$(ADF_COMPONENTS)/audio_stream/raw_stream.c
+
+# host/ comes first so its headers shadow the IDF and ADF ones of the same name
+CFLAGS_USERMOD += \
+	-DAUDIO_HOST \
+	-I$(AUDIO_HOST_DIR) \
+	-I$(AUDIO_MOD_DIR) \
+	-I$(ADF_COMPONENTS)/audio_pipeline/include \
+	-I$(ADF_COMPONENTS)/audio_sal/include \
+	-I$(ADF_COMPONENTS)/audio_stream/include
+
+# Route the ADF allocations through the placement policy and the audio arena in audio_placement.c
+LDFLAGS_USERMOD += \
+	-lpthread \
+	-lm \
+	-Wl,--wrap=audio_malloc \
+	-Wl,--wrap=audio_calloc \
+	-Wl,--wrap=audio_realloc \
+	-Wl,--wrap=audio_free
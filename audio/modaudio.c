@@ -30,27 +30,232 @@
 #include "py/objstr.h"
 #include "py/runtime.h"
 
+#include "freertos/FreeRTOS.h"
+
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+
 #include "esp_audio.h"
 
+#include "audio_arena.h"
 #include "audio_mem.h"
+#include "audio_mem_stats.h"
+#include "audio_placement.h"
+#include "audio_stack.h"
 
 const char *verno = "0.5-beta1";
 
-STATIC mp_obj_t audio_mem_info(void)
+STATIC mp_obj_t audio_mem_counter(const audio_mem_counter_t *counter)
+{
+    mp_obj_t items[3] = {
+        mp_obj_new_int(counter->bytes),
+        mp_obj_new_int(counter->count),
+        mp_obj_new_int(counter->peak),
+    };
+    return mp_obj_new_tuple(3, items);
+}
+
+STATIC mp_obj_t audio_mem_info(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
+    enum {
+        ARG_reset,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_reset, MP_ARG_BOOL, { .u_bool = false } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
 #ifdef CONFIG_SPIRAM_BOOT_INIT
-    mp_obj_dict_t *dict = mp_obj_new_dict(3);
+    mp_obj_dict_t *dict = mp_obj_new_dict(10);
 
     mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_mem_total), MP_OBJ_TO_PTR(mp_obj_new_int(esp_get_free_heap_size())));
     mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_inter), MP_OBJ_TO_PTR(mp_obj_new_int(heap_caps_get_free_size(MALLOC_CAP_INTERNAL))));
     mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_dram), MP_OBJ_TO_PTR(mp_obj_new_int(heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT))));
+
+    multi_heap_info_t psram;
+    heap_caps_get_info(&psram, MALLOC_CAP_SPIRAM);
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_psram), mp_obj_new_int(psram.total_free_bytes));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_psram_frag),
+        mp_obj_new_int(psram.total_free_bytes ? 100 - (int)((uint64_t)psram.largest_free_block * 100 / psram.total_free_bytes) : 0));
+
+    mp_obj_t largest = mp_obj_new_dict(3);
+    mp_obj_dict_store(largest, MP_ROM_QSTR(MP_QSTR_inter), mp_obj_new_int(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)));
+    mp_obj_dict_store(largest, MP_ROM_QSTR(MP_QSTR_dram), mp_obj_new_int(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)));
+    mp_obj_dict_store(largest, MP_ROM_QSTR(MP_QSTR_psram), mp_obj_new_int(psram.largest_free_block));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_largest), largest);
 #else
-    mp_obj_dict_t *dict = mp_obj_new_dict(1);
+    mp_obj_dict_t *dict = mp_obj_new_dict(5);
     mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_mem_total), MP_OBJ_TO_PTR(mp_obj_new_int(esp_get_free_heap_size())));
+
+    mp_obj_t largest = mp_obj_new_dict(1);
+    mp_obj_dict_store(largest, MP_ROM_QSTR(MP_QSTR_inter), mp_obj_new_int(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_largest), largest);
 #endif
+
+    // (bytes, count, peak) of the memory allocated through audio_malloc and friends
+    audio_mem_counter_t counter;
+    audio_mem_stats_total(&counter);
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_audio), audio_mem_counter(&counter));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_untracked), mp_obj_new_int(audio_mem_stats_untracked()));
+
+    const char *name = NULL;
+    const char *subsystem = NULL;
+    mp_obj_t subsystems = mp_obj_new_dict(0);
+    for (int i = 0; audio_mem_stats_subsystem_get(i, &name, &counter); i++) {
+        mp_obj_dict_store(subsystems, mp_obj_new_str(name, strlen(name)), audio_mem_counter(&counter));
+    }
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_subsystems), subsystems);
+
+    mp_obj_t tags = mp_obj_new_dict(0);
+    for (int i = 0; audio_mem_stats_owner(i, &name, &subsystem, &counter); i++) {
+        mp_obj_dict_store(tags, mp_obj_new_str(name, strlen(name)), audio_mem_counter(&counter));
+    }
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_tags), tags);
+
+    if (args[ARG_reset].u_bool) {
+        audio_mem_stats_reset_peak();
+        audio_arena_reset_peak();
+    }
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_mem_info_obj, 0, audio_mem_info);
+
+STATIC mp_obj_t audio_arena_info(void)
+{
+    audio_arena_stats_t stats;
+    audio_arena_get_stats(&stats);
+
+    mp_obj_dict_t *dict = mp_obj_new_dict(8);
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_size), mp_obj_new_int(stats.size));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_used), mp_obj_new_int(stats.used));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_peak), mp_obj_new_int(stats.peak));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_free), mp_obj_new_int(stats.free));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_largest), mp_obj_new_int(stats.largest_free));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_frag), mp_obj_new_int(stats.fragmentation));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_count), mp_obj_new_int(stats.alloc_count));
+    mp_obj_dict_store(dict, MP_ROM_QSTR(MP_QSTR_fails), mp_obj_new_int(stats.fail_count));
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(audio_arena_info_obj, audio_arena_info);
+
+STATIC mp_obj_t audio_stack_info(void)
+{
+    audio_stack_sample();
+
+    mp_obj_t dict = mp_obj_new_dict(0);
+    const char *tag = NULL;
+    const char *kind = NULL;
+    int size = 0;
+    int max_used = 0;
+    uint32_t run_time = 0;
+    for (int i = 0; audio_stack_get(i, &tag, &kind, &size, &max_used, &run_time); i++) {
+        // "encoder/wav_enc" when a tag holds several element types
+        char key[configMAX_TASK_NAME_LEN + AUDIO_STACK_KIND_LEN + 1];
+        int len = snprintf(key, sizeof(key), kind[0] ? "%s/%s" : "%s", tag, kind);
+        mp_obj_t item[3] = { mp_obj_new_int(size), mp_obj_new_int(max_used), mp_obj_new_int_from_uint(run_time) };
+        mp_obj_dict_store(dict, mp_obj_new_str(key, len), mp_obj_new_tuple(3, item));
+    }
     return dict;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_0(audio_mem_info_obj, audio_mem_info);
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(audio_stack_info_obj, audio_stack_info);
+
+STATIC mp_obj_t audio_stack_autosize(size_t n_args, const mp_obj_t *args)
+{
+    if (n_args > 0) {
+        audio_stack_set_margin(mp_obj_get_int(args[0]));
+    }
+    return mp_obj_new_int(audio_stack_get_margin());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(audio_stack_autosize_obj, 0, 1, audio_stack_autosize);
+
+STATIC mp_obj_t audio_placement(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum {
+        ARG_tag,
+        ARG_stack,
+        ARG_rb,
+        ARG_buf,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tag, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_stack, MP_ARG_INT, { .u_int = -1 } },
+        { MP_QSTR_rb, MP_ARG_INT, { .u_int = -1 } },
+        { MP_QSTR_buf, MP_ARG_INT, { .u_int = -1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    const char *tag = mp_obj_str_get_str(args[ARG_tag].u_obj);
+    mp_obj_t items[AUDIO_PLACE_KIND_MAX];
+    for (int kind = 0; kind < AUDIO_PLACE_KIND_MAX; kind++) {
+        int place = args[ARG_stack + kind].u_int;
+        if (place > AUDIO_PLACE_PSRAM) {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid placement"));
+        }
+        if (place >= 0 && !audio_placement_set(tag, kind, place)) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("too many placement policies"));
+        }
+        items[kind] = mp_obj_new_int(audio_placement_get(tag, kind));
+    }
+    return mp_obj_new_tuple(AUDIO_PLACE_KIND_MAX, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(audio_placement_obj, 1, audio_placement);
+
+// Meter(bands=0, interval=50), memoryview(meter) is an int16 view of audio_meter_levels_t:
+// [0] update count, odd while writing, [1] peak, [2] RMS, [3] bands, [4:] band levels
+STATIC mp_obj_t audio_meter_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_bands,
+        ARG_interval,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_bands, MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_interval, MP_ARG_INT, { .u_int = 50 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_bands].u_int < 0 || args[ARG_bands].u_int > AUDIO_METER_MAX_BANDS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("bands out of range"));
+    }
+    audio_meter_obj_t *self = m_new_obj(audio_meter_obj_t);
+    self->base.type = type;
+    audio_meter_setup(&self->meter, args[ARG_bands].u_int, args[ARG_interval].u_int);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_int_t audio_meter_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    audio_meter_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (flags & MP_BUFFER_WRITE) {
+        return 1;
+    }
+    bufinfo->buf = (void *)&self->meter.levels;
+    bufinfo->len = sizeof(audio_meter_levels_t);
+    bufinfo->typecode = 'h';
+    return 0;
+}
+
+audio_meter_t *audio_meter_from_obj(mp_obj_t obj)
+{
+    if (obj == mp_const_none) {
+        return NULL;
+    }
+    if (!mp_obj_is_type(obj, &audio_meter_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("expected audio.Meter"));
+    }
+    return &((audio_meter_obj_t *)MP_OBJ_TO_PTR(obj))->meter;
+}
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    audio_meter_type,
+    MP_QSTR_Meter,
+    MP_TYPE_FLAG_NONE,
+    make_new, audio_meter_make_new,
+    buffer, audio_meter_get_buffer
+    );
 
 STATIC mp_obj_t audio_mod_verno(void)
 {
@@ -59,15 +264,33 @@ STATIC mp_obj_t audio_mod_verno(void)
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(audio_mod_verno_obj, audio_mod_verno);
 
 extern const mp_obj_type_t audio_player_type;
+extern const mp_obj_type_t audio_pipeline_player_type;
+extern const mp_obj_type_t audio_graph_type;
 extern const mp_obj_type_t audio_recorder_type;
+extern const mp_obj_type_t audio_catalog_type;
 
 STATIC const mp_rom_map_elem_t audio_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_audio) },
     { MP_ROM_QSTR(MP_QSTR_mem_info), MP_ROM_PTR(&audio_mem_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_verno), MP_ROM_PTR(&audio_mod_verno_obj) },
+    { MP_ROM_QSTR(MP_QSTR_arena_info), MP_ROM_PTR(&audio_arena_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stack_info), MP_ROM_PTR(&audio_stack_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stack_autosize), MP_ROM_PTR(&audio_stack_autosize_obj) },
+    { MP_ROM_QSTR(MP_QSTR_placement), MP_ROM_PTR(&audio_placement_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_player), MP_ROM_PTR(&audio_player_type) },
+    { MP_ROM_QSTR(MP_QSTR_pipeline_player), MP_ROM_PTR(&audio_pipeline_player_type) },
+    { MP_ROM_QSTR(MP_QSTR_Pipeline), MP_ROM_PTR(&audio_graph_type) },
     { MP_ROM_QSTR(MP_QSTR_recorder), MP_ROM_PTR(&audio_recorder_type) },
+    { MP_ROM_QSTR(MP_QSTR_Meter), MP_ROM_PTR(&audio_meter_type) },
+    { MP_ROM_QSTR(MP_QSTR_transcode), MP_ROM_PTR(&audio_transcode_obj) },
+    { MP_ROM_QSTR(MP_QSTR_probe), MP_ROM_PTR(&audio_probe_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Catalog), MP_ROM_PTR(&audio_catalog_type) },
+
+    // audio_place_t
+    { MP_ROM_QSTR(MP_QSTR_MEM_DEFAULT), MP_ROM_INT(AUDIO_PLACE_DEFAULT) },
+    { MP_ROM_QSTR(MP_QSTR_MEM_INTERNAL), MP_ROM_INT(AUDIO_PLACE_INTERNAL) },
+    { MP_ROM_QSTR(MP_QSTR_MEM_PSRAM), MP_ROM_INT(AUDIO_PLACE_PSRAM) },
 
     // audio_err_t
     { MP_ROM_QSTR(MP_QSTR_AUDIO_OK), MP_ROM_INT(ESP_ERR_AUDIO_NO_ERROR) },
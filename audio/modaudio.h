@@ -27,4 +27,51 @@
 
 #include "py/obj.h"
 
+#include "audio_meter.h"
+
+/**
+ * @brief   audio.Meter, Python reads the levels in place through the buffer protocol
+ */
+typedef struct _audio_meter_obj_t {
+    mp_obj_base_t base;
+    audio_meter_t meter;
+} audio_meter_obj_t;
+
+extern const mp_obj_type_t audio_meter_type;
+
+/**
+ * @brief      Get the meter of an audio.Meter argument
+ *
+ * @return     NULL for None, raises TypeError for anything else
+ */
+audio_meter_t *audio_meter_from_obj(mp_obj_t obj);
+
+/**
+ * @brief      Check whether the player is driving the shared I2S port, the recorder
+ *             only retimes the port for native rate capture while it is idle
+ *
+ * @return     true while a file, stream or written PCM is playing or paused
+ */
+bool audio_player_output_busy(void);
+
+/**
+ * @brief      Check whether a recording captures at its native rate on the shared I2S port,
+ *             the player refuses play() and pcm() until it is released
+ *
+ * @return     true from the start of a native rate capture until its stop
+ */
+bool audio_recorder_port_held(void);
+
+/**
+ * @brief   audio.transcode(src, dst, format, rate), converts a file or stream into a file
+ *          without pacing and returns an audio.Transcode following the conversion
+ */
+MP_DECLARE_CONST_FUN_OBJ_KW(audio_transcode_obj);
+
+/**
+ * @brief   audio.probe(uri), reads the duration, format and tags from the headers without
+ *          decoding, None when the format is unknown
+ */
+MP_DECLARE_CONST_FUN_OBJ_1(audio_probe_obj);
+
 #endif //__MODAUDIO_H_
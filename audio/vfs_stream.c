@@ -23,6 +23,7 @@
  */
 
 #include "errno.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -30,6 +31,7 @@
 #include "audio_error.h"
 #include "audio_mem.h"
 
+#include "audio_adpcm_encoder.h"
 #include "esp_log.h"
 #include "vfs_stream.h"
 #include "wav_head.h"
@@ -43,6 +45,7 @@
 #define FILE_OPUS_SUFFIX_TYPE "opus"
 #define FILE_AMR_SUFFIX_TYPE "amr"
 #define FILE_AMRWB_SUFFIX_TYPE "Wamr"
+#define VFS_STREAM_PATH_MAX (128)
 
 static const char *TAG = "VFS_STREAM";
 
@@ -60,8 +63,20 @@ typedef struct vfs_stream {
     bool is_open;
     mp_obj_t file;
     wr_stream_type_t w_type;
+    // segmented writing, the uri is a pattern for the segment index
+    uint32_t seg_max_bytes;
+    uint32_t seg_max_frames;
+    volatile int seg_index;
+    uint32_t seg_frames;
+    int unit_size;     // bytes of the units a segment may end after, 0 for sized AMR frames
+    int unit_frames;
+    int unit_left;     // rest of the AMR frame being written
 } vfs_stream_t;
 
+// AMR frame bytes with the header byte, by frame type
+static const uint8_t amrnb_frame_size[16] = { 13, 14, 16, 18, 20, 21, 27, 32, 6, 1, 1, 1, 1, 1, 1, 1 };
+static const uint8_t amrwb_frame_size[16] = { 18, 24, 33, 37, 41, 47, 51, 59, 61, 6, 1, 1, 1, 1, 1, 1 };
+
 static wr_stream_type_t get_type(const char *str)
 {
     char *relt = strrchr(str, '.');
@@ -86,12 +101,116 @@ static wr_stream_type_t get_type(const char *str)
 
 static int get_len(mp_obj_t stream)
 {
-    mp_obj_t tell;
-    mp_load_method(stream, MP_QSTR_tell, &tell);
-    mp_stream_posix_lseek(stream, 0, SEEK_END);
-    mp_obj_t len = mp_call_function_1(tell, stream);
+    off_t len = mp_stream_posix_lseek(stream, 0, SEEK_END);
     mp_stream_posix_lseek(stream, 0, SEEK_SET);
-    return (int)mp_obj_get_int(len);
+    return len < 0 ? 0 : (int)len;
+}
+
+// the element task has no handler above it, a missing file or a full card gives mp_const_none
+static mp_obj_t vfs_open_file(const char *path, size_t len, qstr mode)
+{
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t args[2] = { mp_obj_new_str(path, len), MP_OBJ_NEW_QSTR(mode) };
+        mp_obj_t file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
+        nlr_pop();
+        return file;
+    }
+    return mp_const_none;
+}
+
+// open the writer's file, or the current segment's, and leave room for the header
+static void _vfs_create(vfs_stream_t *vfs, const char *path, audio_element_info_t *info)
+{
+    char name[VFS_STREAM_PATH_MAX];
+    if (vfs->seg_max_bytes || vfs->seg_max_frames) {
+        snprintf(name, sizeof(name), path, vfs->seg_index);
+        path = name;
+    }
+    vfs->file = vfs_open_file(path, strlen(path), MP_QSTR_wb);
+    vfs->w_type = get_type(path);
+    if (vfs->file != mp_const_none && STREAM_TYPE_WAV == vfs->w_type && info->bits == AUDIO_ADPCM_WAV_BITS) {
+        // IMA-ADPCM carries a longer fmt chunk and a fact chunk
+        uint8_t head[AUDIO_ADPCM_WAV_HEADER_SIZE] = { 0 };
+        mp_stream_posix_write(vfs->file, head, sizeof(head));
+        mp_stream_posix_fsync(vfs->file);
+    } else if (vfs->file != mp_const_none && STREAM_TYPE_WAV == vfs->w_type) {
+        wav_header_t info = { 0 };
+        mp_stream_posix_write(vfs->file, &info, sizeof(wav_header_t));
+        mp_stream_posix_fsync(vfs->file);
+    } else if (vfs->file != mp_const_none && (STREAM_TYPE_AMR == vfs->w_type)) {
+        mp_stream_posix_write(vfs->file, "#!AMR\n", 6);
+        mp_stream_posix_fsync(vfs->file);
+    } else if (vfs->file != mp_const_none && (STREAM_TYPE_AMRWB == vfs->w_type)) {
+        mp_stream_posix_write(vfs->file, "#!AMR-WB\n", 9);
+        mp_stream_posix_fsync(vfs->file);
+    }
+}
+
+// segments end on whole PCM frames, ADPCM blocks or AMR frames, each file plays on its own
+static void _vfs_segment_units(vfs_stream_t *vfs, audio_element_info_t *info)
+{
+    vfs->seg_frames = 0;
+    vfs->unit_left = 0;
+    if (STREAM_TYPE_AMR == vfs->w_type || STREAM_TYPE_AMRWB == vfs->w_type) {
+        // 20 ms per frame
+        vfs->unit_size = 0;
+        vfs->unit_frames = STREAM_TYPE_AMR == vfs->w_type ? 160 : 320;
+    } else if (STREAM_TYPE_WAV == vfs->w_type && info->bits == AUDIO_ADPCM_WAV_BITS) {
+        vfs->unit_size = audio_adpcm_block_align(info->sample_rates, info->channels);
+        vfs->unit_frames = audio_adpcm_block_frames(vfs->unit_size, info->channels);
+    } else if (STREAM_TYPE_OPUS == vfs->w_type) {
+        ESP_LOGW(TAG, "Opus can't be split, writing one file");
+        vfs->seg_max_bytes = 0;
+        vfs->seg_max_frames = 0;
+    } else {
+        vfs->unit_size = info->channels * info->bits / 8;
+        vfs->unit_frames = 1;
+    }
+}
+
+// write the final header of the writer's file and close it
+static void _vfs_finish(audio_element_handle_t self)
+{
+    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
+
+    audio_element_info_t w_info;
+    audio_element_getinfo(self, &w_info);
+    if (AUDIO_STREAM_WRITER == vfs->type
+        && vfs->is_open
+        && STREAM_TYPE_WAV == vfs->w_type
+        && w_info.bits == AUDIO_ADPCM_WAV_BITS) {
+        uint8_t head[AUDIO_ADPCM_WAV_HEADER_SIZE];
+        audio_adpcm_wav_header(head, w_info.sample_rates, w_info.channels, (uint32_t)w_info.byte_pos);
+        if (mp_stream_posix_lseek(vfs->file, 0, SEEK_SET) != 0) {
+            ESP_LOGE(TAG, "Error seek file ,line=%d", __LINE__);
+        }
+        mp_stream_posix_write(vfs->file, head, sizeof(head));
+        mp_stream_posix_fsync(vfs->file);
+    } else if (AUDIO_STREAM_WRITER == vfs->type
+        && vfs->is_open
+        && STREAM_TYPE_WAV == vfs->w_type) {
+        wav_header_t *wav_info = (wav_header_t *)audio_malloc(sizeof(wav_header_t));
+
+        AUDIO_MEM_CHECK(TAG, wav_info, return);
+
+        if (mp_stream_posix_lseek(vfs->file, 0, SEEK_SET) != 0) {
+            ESP_LOGE(TAG, "Error seek file ,line=%d", __LINE__);
+        }
+        audio_element_info_t info;
+        audio_element_getinfo(self, &info);
+        wav_head_init(wav_info, info.sample_rates, info.bits, info.channels);
+        wav_head_size(wav_info, (uint32_t)info.byte_pos);
+        mp_stream_posix_write(vfs->file, wav_info, sizeof(wav_header_t));
+        mp_stream_posix_fsync(vfs->file);
+        audio_free(wav_info);
+    }
+
+    if (vfs->is_open) {
+        mp_stream_close(vfs->file);
+        vfs->file = mp_const_none;
+        vfs->is_open = false;
+    }
 }
 
 static esp_err_t _vfs_open(audio_element_handle_t self)
@@ -116,34 +235,16 @@ static esp_err_t _vfs_open(audio_element_handle_t self)
         return ESP_FAIL;
     }
     if (vfs->type == AUDIO_STREAM_READER) {
-        mp_obj_t args[2];
-        args[0] = mp_obj_new_str(path, strlen(path));
-        args[1] = mp_obj_new_str("rb", strlen("rb"));
-        vfs->file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
-        info.total_bytes = get_len(vfs->file);
-        ESP_LOGI(TAG, "File size is %d byte,pos:%d", (int)info.total_bytes, (int)info.byte_pos);
-        if (vfs->file != mp_const_none && (info.byte_pos > 0)) {
-            if (mp_stream_posix_lseek(vfs->file, info.byte_pos, SEEK_SET) != 0) {
-                ESP_LOGE(TAG, "Error seek file");
-                return ESP_FAIL;
-            }
+        // a fragment only carries the format hint for esp_audio
+        vfs->file = vfs_open_file(path, strcspn(path, "#"), MP_QSTR_rb);
+        if (vfs->file != mp_const_none) {
+            info.total_bytes = get_len(vfs->file);
+            ESP_LOGI(TAG, "File size is %d byte,pos:%d", (int)info.total_bytes, (int)info.byte_pos);
         }
     } else if (vfs->type == AUDIO_STREAM_WRITER) {
-        mp_obj_t args[2];
-        args[0] = mp_obj_new_str(path, strlen(path));
-        args[1] = mp_obj_new_str("wb", strlen("wb"));
-        vfs->file = mp_vfs_open(2, args, (mp_map_t *)&mp_const_empty_map);
-        vfs->w_type = get_type(path);
-        if (vfs->file != mp_const_none && STREAM_TYPE_WAV == vfs->w_type) {
-            wav_header_t info = { 0 };
-            mp_stream_posix_write(vfs->file, &info, sizeof(wav_header_t));
-            mp_stream_posix_fsync(vfs->file);
-        } else if (vfs->file != mp_const_none && (STREAM_TYPE_AMR == vfs->w_type)) {
-            mp_stream_posix_write(vfs->file, "#!AMR\n", 6);
-            mp_stream_posix_fsync(vfs->file);
-        } else if (vfs->file != mp_const_none && (STREAM_TYPE_AMRWB == vfs->w_type)) {
-            mp_stream_posix_write(vfs->file, "#!AMR-WB\n", 9);
-            mp_stream_posix_fsync(vfs->file);
+        _vfs_create(vfs, path, &info);
+        if (vfs->seg_max_bytes || vfs->seg_max_frames) {
+            _vfs_segment_units(vfs, &info);
         }
     } else {
         ESP_LOGE(TAG, "vfs must be Reader or Writer");
@@ -154,7 +255,7 @@ static esp_err_t _vfs_open(audio_element_handle_t self)
         return ESP_FAIL;
     }
     vfs->is_open = true;
-    if (info.byte_pos && mp_stream_posix_lseek(vfs->file, info.byte_pos, SEEK_SET) != 0) {
+    if (info.byte_pos && mp_stream_posix_lseek(vfs->file, info.byte_pos, SEEK_SET) < 0) {
         ESP_LOGE(TAG, "Failed to seek to %d/%d", (int)info.byte_pos, (int)info.total_bytes);
         return ESP_FAIL;
     }
@@ -180,7 +281,7 @@ static int _vfs_read(audio_element_handle_t self, char *buffer, int len, TickTyp
     return rlen;
 }
 
-static int _vfs_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+static int _vfs_write_file(audio_element_handle_t self, char *buffer, int len)
 {
     vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
     audio_element_info_t info;
@@ -195,6 +296,93 @@ static int _vfs_write(audio_element_handle_t self, char *buffer, int len, TickTy
     return wlen;
 }
 
+// only at the end of a unit, and never on an empty segment
+static bool _vfs_segment_full(vfs_stream_t *vfs, uint32_t bytes)
+{
+    if (bytes == 0 || (vfs->unit_size == 0 ? vfs->unit_left != 0 : bytes % vfs->unit_size != 0)) {
+        return false;
+    }
+    uint32_t frames = vfs->unit_size ? bytes / vfs->unit_size * vfs->unit_frames : vfs->seg_frames;
+    return (vfs->seg_max_bytes && bytes >= vfs->seg_max_bytes)
+           || (vfs->seg_max_frames && frames >= vfs->seg_max_frames);
+}
+
+// bytes of buf that belong to the current segment
+static int _vfs_segment_room(vfs_stream_t *vfs, const uint8_t *buf, int len, uint32_t bytes)
+{
+    if (vfs->unit_size == 0) {
+        if (vfs->unit_left == 0) {
+            const uint8_t *sizes = STREAM_TYPE_AMRWB == vfs->w_type ? amrwb_frame_size : amrnb_frame_size;
+            vfs->unit_left = sizes[(buf[0] >> 3) & 0x0f];
+            vfs->seg_frames += vfs->unit_frames;
+        }
+        return len < vfs->unit_left ? len : vfs->unit_left;
+    }
+    // up to the first unit boundary at or past a limit
+    uint32_t end = UINT32_MAX;
+    if (vfs->seg_max_bytes) {
+        end = (vfs->seg_max_bytes + vfs->unit_size - 1) / vfs->unit_size * vfs->unit_size;
+    }
+    if (vfs->seg_max_frames) {
+        uint32_t units = (vfs->seg_max_frames + vfs->unit_frames - 1) / vfs->unit_frames;
+        if (units * vfs->unit_size < end) {
+            end = units * vfs->unit_size;
+        }
+    }
+    return end - bytes < (uint32_t)len ? (int)(end - bytes) : len;
+}
+
+static esp_err_t _vfs_rotate(audio_element_handle_t self)
+{
+    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
+    _vfs_finish(self);
+
+    audio_element_info_t info;
+    audio_element_getinfo(self, &info);
+    info.byte_pos = 0;
+    audio_element_setinfo(self, &info);
+    vfs->seg_index++;
+    vfs->seg_frames = 0;
+    _vfs_create(vfs, strstr(audio_element_get_uri(self), "/sdcard"), &info);
+    if (vfs->file == mp_const_none) {
+        ESP_LOGE(TAG, "Failed to open segment %d", vfs->seg_index);
+        return ESP_FAIL;
+    }
+    vfs->is_open = true;
+    return ESP_OK;
+}
+
+static int _vfs_write(audio_element_handle_t self, char *buffer, int len, TickType_t ticks_to_wait, void *context)
+{
+    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
+    if (vfs->seg_max_bytes == 0 && vfs->seg_max_frames == 0) {
+        return _vfs_write_file(self, buffer, len);
+    }
+    // the chunk may span a segment end, the rest goes to the next file
+    int done = 0;
+    while (done < len) {
+        audio_element_info_t info;
+        audio_element_getinfo(self, &info);
+        uint32_t bytes = (uint32_t)info.byte_pos;
+        if (_vfs_segment_full(vfs, bytes)) {
+            if (_vfs_rotate(self) != ESP_OK) {
+                return done > 0 ? done : ESP_FAIL;
+            }
+            bytes = 0;
+        }
+        int n = _vfs_segment_room(vfs, (const uint8_t *)buffer + done, len - done, bytes);
+        int wlen = _vfs_write_file(self, buffer + done, n);
+        if (wlen <= 0) {
+            return done > 0 ? done : wlen;
+        }
+        if (vfs->unit_size == 0) {
+            vfs->unit_left -= wlen;
+        }
+        done += wlen;
+    }
+    return done;
+}
+
 static int _vfs_process(audio_element_handle_t self, char *in_buffer, int in_len)
 {
     int r_size = audio_element_input(self, in_buffer, in_len);
@@ -209,34 +397,7 @@ static int _vfs_process(audio_element_handle_t self, char *in_buffer, int in_len
 
 static esp_err_t _vfs_close(audio_element_handle_t self)
 {
-    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
-
-    if (AUDIO_STREAM_WRITER == vfs->type
-        && vfs->file
-        && STREAM_TYPE_WAV == vfs->w_type) {
-        wav_header_t *wav_info = (wav_header_t *)audio_malloc(sizeof(wav_header_t));
-
-        AUDIO_MEM_CHECK(TAG, wav_info, return ESP_ERR_NO_MEM);
-
-        if (mp_stream_posix_lseek(vfs->file, 0, SEEK_SET) != 0) {
-            ESP_LOGE(TAG, "Error seek file ,line=%d", __LINE__);
-        }
-        audio_element_info_t info;
-        audio_element_getinfo(self, &info);
-        wav_head_init(wav_info, info.sample_rates, info.bits, info.channels);
-        wav_head_size(wav_info, (uint32_t)info.byte_pos);
-        mp_stream_posix_write(vfs->file, wav_info, sizeof(wav_header_t));
-        mp_stream_posix_fsync(vfs->file);
-        mp_stream_close(vfs->file);
-        audio_free(wav_info);
-    }
-
-    if (vfs->is_open) {
-        mp_obj_t close;
-        mp_load_method(vfs->file, MP_QSTR_close, &close);
-        mp_call_function_1(close, vfs->file);
-        vfs->is_open = false;
-    }
+    _vfs_finish(self);
     if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
         audio_element_report_info(self);
         audio_element_info_t info = { 0 };
@@ -254,6 +415,46 @@ static esp_err_t _vfs_destroy(audio_element_handle_t self)
     return ESP_OK;
 }
 
+bool vfs_stream_segment_uri_ok(const char *uri)
+{
+    int conversions = 0;
+    for (const char *p = uri; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p != 'd') {
+            return false;
+        }
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+esp_err_t vfs_stream_set_segment(audio_element_handle_t self, uint32_t max_bytes, uint32_t max_frames)
+{
+    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
+    if (vfs->type != AUDIO_STREAM_WRITER || vfs->is_open) {
+        return ESP_FAIL;
+    }
+    vfs->seg_max_bytes = max_bytes;
+    vfs->seg_max_frames = max_frames;
+    vfs->seg_index = 0;
+    return ESP_OK;
+}
+
+int vfs_stream_get_segment(audio_element_handle_t self)
+{
+    vfs_stream_t *vfs = (vfs_stream_t *)audio_element_getdata(self);
+    return vfs->seg_index;
+}
+
 audio_element_handle_t vfs_stream_init(vfs_stream_cfg_t *config)
 {
     audio_element_handle_t el;
@@ -269,6 +470,7 @@ audio_element_handle_t vfs_stream_init(vfs_stream_cfg_t *config)
     cfg.task_stack = config->task_stack;
     cfg.task_prio = config->task_prio;
     cfg.task_core = config->task_core;
+    cfg.stack_in_ext = config->stack_in_ext;
     cfg.out_rb_size = config->out_rb_size;
     cfg.buffer_len = config->buf_sz;
     if (cfg.buffer_len == 0) {
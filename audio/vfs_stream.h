@@ -41,6 +41,7 @@ typedef struct {
     int task_stack;           /*!< Task stack size */
     int task_core;            /*!< Task running in core (0 or 1) */
     int task_prio;            /*!< Task priority (based on freeRTOS priority) */
+    bool stack_in_ext;        /*!< Try to allocate stack in external memory */
 } vfs_stream_cfg_t;
 
 #define VFS_STREAM_BUF_SIZE (2048)
@@ -57,6 +58,7 @@ typedef struct {
     .task_stack = VFS_STREAM_TASK_STACK,       \
     .task_core = VFS_STREAM_TASK_CORE,         \
     .task_prio = VFS_STREAM_TASK_PRIO,         \
+    .stack_in_ext = false,                     \
 }
 
 /**
@@ -70,6 +72,30 @@ typedef struct {
  */
 audio_element_handle_t vfs_stream_init(vfs_stream_cfg_t *config);
 
+/**
+ * @brief      Split what a writer writes into numbered files, the uri is then a pattern with
+ *             one %d conversion for the segment index, counting from 0. A segment ends at the
+ *             first PCM frame, IMA-ADPCM block or AMR frame boundary at or past either limit,
+ *             and each file gets its own header. Set before the element runs. The audio
+ *             format in the element info has to be set for PCM, WAV and ADPCM.
+ *
+ * @param      max_bytes   Data bytes per segment, 0 for no limit
+ * @param      max_frames  Sample frames per segment, 0 for no limit
+ *
+ * @return     ESP_FAIL for a reader or a writer already running
+ */
+esp_err_t vfs_stream_set_segment(audio_element_handle_t self, uint32_t max_bytes, uint32_t max_frames);
+
+/**
+ * @brief      Index of the segment being written
+ */
+int vfs_stream_get_segment(audio_element_handle_t self);
+
+/**
+ * @brief      Check that a segment uri has exactly one %d conversion, with an optional width
+ */
+bool vfs_stream_segment_uri_ok(const char *uri);
+
 #ifdef __cplusplus
 }
 #endif